@@ -0,0 +1,5 @@
+name Default
+# Ascend to 3m at 1.5s and roll -20 degrees at 5s.
+step thrust 1.5 * 1.0
+step height 1.5 * 3.0
+step roll   5.0 * -20.0
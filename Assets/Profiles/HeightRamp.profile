@@ -0,0 +1,7 @@
+name Height ramp
+# Slow climb to 2m, hold and come back down.
+step thrust 0.5 * 1.0
+ramp height 0.5 4.0  0.0 2.0
+step height 4.0 8.0  2.0
+ramp height 8.0 12.0 2.0 0.2
+step height 12.0 *   0.2
@@ -0,0 +1,6 @@
+name Pitch chirp
+# Hover at 1m and sweep the pitch set point from 0.2Hz to 5Hz. The height hold of the Unity
+# controller only needs a thrust to fly, the Quad one flies the thrust (about the hover command).
+step  thrust 0.5 * 0.71
+step  height 0.5 * 1.0
+chirp pitch  3.0 * 0.0 5.0 0.2 5.0
@@ -0,0 +1,87 @@
+#include "AttitudeEstimator.h"
+
+#include <math.h>
+
+static const float k_DegToRad = 0.017453292519943295769236907684886f;
+static const float k_RadToDeg = 57.295779513082320876798154814105f;
+
+AttitudeEstimator::AttitudeEstimator()
+	:AccelWeight(0.0004f)
+{
+	AccelOffset[0] = 0.02f;
+	AccelOffset[1] = 0.01f;
+	AccelOffset[2] = -0.01f;
+	GyroOffset[0] = -1.0f;
+	GyroOffset[1] = -0.3f;
+	GyroOffset[2] = -0.5f;
+	Reset();
+}
+
+void AttitudeEstimator::Reset()
+{
+	mState.LastAccel[0] = 0.0f;
+	mState.LastAccel[1] = 0.0f;
+	mState.LastAccel[2] = 1.0f;
+	mState.LastGyro[0] = 0.0f;
+	mState.LastGyro[1] = 0.0f;
+	mState.LastGyro[2] = 0.0f;
+	mState.AcumYaw = 0.0f;
+	mState.AcumPitch = 0.0f;
+	mState.AcumRoll = 0.0f;
+	mState.FirstTime = true;
+}
+
+void AttitudeEstimator::Update(const float* accel, const float* gyro, float deltaTime, float& yaw, float& pitch, float& roll)
+{
+	for (int i = 0; i < 3; ++i)
+	{
+		mState.LastAccel[i] = accel ? accel[i] + AccelOffset[i] : mState.LastAccel[i];
+		mState.LastGyro[i] = gyro ? gyro[i] + GyroOffset[i] : mState.LastGyro[i];
+	}
+	const float ax = mState.LastAccel[0];
+	const float ay = mState.LastAccel[1];
+	const float az = mState.LastAccel[2];
+	const float wx = mState.LastGyro[0];
+	const float wy = mState.LastGyro[1];
+	const float wz = mState.LastGyro[2];
+
+	float accMagnitude = sqrtf((ax * ax) + (ay * ay) + (az * az));
+	float rawPitch = atan2f((ax / accMagnitude), (az / accMagnitude)) * k_RadToDeg;
+	float rawRoll = atan2f((-ay / accMagnitude), (az / accMagnitude)) * k_RadToDeg;
+
+	if (mState.FirstTime)
+	{
+		mState.FirstTime = false;
+		mState.AcumYaw = 0.0f;
+		mState.AcumPitch = rawPitch;
+		mState.AcumRoll = rawRoll;
+	}
+	else
+	{
+		mState.AcumYaw -= wz * deltaTime;
+		mState.AcumPitch -= wy * deltaTime;
+		mState.AcumRoll -= wx * deltaTime;
+	}
+
+	// Transfer angle as we have yawed:
+	mState.AcumPitch -= mState.AcumRoll * sinf((-wz * deltaTime) * k_DegToRad);
+	mState.AcumRoll += mState.AcumPitch * sinf((-wz * deltaTime) * k_DegToRad);
+
+	// Combine raw accel and gyro, this adds noise but removes gyro drift over time:
+	mState.AcumPitch = mState.AcumPitch * (1.0f - AccelWeight) + rawPitch * AccelWeight;
+	mState.AcumRoll = mState.AcumRoll * (1.0f - AccelWeight) + rawRoll * AccelWeight;
+
+	yaw = mState.AcumYaw;
+	pitch = -mState.AcumPitch;
+	roll = -mState.AcumRoll;
+}
+
+const AttitudeEstimator::State& AttitudeEstimator::GetState() const
+{
+	return mState;
+}
+
+void AttitudeEstimator::SetState(const State& state)
+{
+	mState = state;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "CommonFlyController.h"
+
+// Attitude from the LSM9DS1 samples, shared by the firmware (one instance) and the simulation
+// (one per vehicle). Complementary filter: the integrated gyro, pulled slowly towards the
+// accelerometer tilt. Samples in the sensor frame and units: x forward, y right, z up, g and
+// dps. Outputs degrees, same signs as the simulation.
+// All the state is in State, an estimator can be copied, reset and replayed.
+class AttitudeEstimator
+{
+public:
+	struct State
+	{
+		float LastAccel[3];	// Calibrated
+		float LastGyro[3];
+		float AcumYaw;
+		float AcumPitch;
+		float AcumRoll;
+		bool FirstTime;
+	};
+
+	AttitudeEstimator();
+	void Reset();
+
+	// One loop of the board. accel and gyro are the new raw samples (x y z), nullptr if there
+	// is no new one and the last one is used again. deltaTime is the duration of the previous
+	// loop (s).
+	void Update(const float* accel, const float* gyro, float deltaTime, float& yaw, float& pitch, float& roll);
+
+	const State& GetState()const;
+	void SetState(const State& state);
+
+	// Added to the raw samples, defaults to the calibration of our board.
+	float AccelOffset[3];	// g
+	float GyroOffset[3];	// dps
+	float AccelWeight;		// Pull towards the accelerometer tilt per update
+
+private:
+	State mState;
+};
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "BlackBox.h"
+#include "GainSet.h"
+
+#include <string.h>
+
+static_assert(sizeof(BlackBox::Report) == 52, "BlackBox::Report must not have padding");
+static_assert(sizeof(BlackBox::Report) <= FlightRecorder::k_BlockSize, "The report must fit in a chunk");
+
+BlackBox::BlackBox()
+	:mLoopSumUs(0)
+	,mRecordSumUs(0)
+	,mFrozen(false)
+{
+	memset(&mReport, 0, sizeof(mReport));
+	mReport.LoopMinUs = 0xFFFFFFFF;
+	Recorder.SampleIntervalUs = 1000;
+}
+
+void BlackBox::Init(uint8_t* buffer, uint32_t size)
+{
+	Recorder.Init(buffer, size);
+}
+
+void BlackBox::Record(const FlightSample& sample)
+{
+	if (!mFrozen)
+	{
+		Recorder.Record(sample);
+	}
+}
+
+void BlackBox::AddLoop(uint32_t loopUs, uint32_t recordUs)
+{
+	if (mFrozen)
+	{
+		return;
+	}
+	mReport.NumLoops++;
+	mReport.LoopMinUs = loopUs < mReport.LoopMinUs ? loopUs : mReport.LoopMinUs;
+	mReport.LoopMaxUs = loopUs > mReport.LoopMaxUs ? loopUs : mReport.LoopMaxUs;
+	mReport.NumOverruns += loopUs > k_OverrunUs ? 1 : 0;
+	mReport.RecordMaxUs = recordUs > mReport.RecordMaxUs ? recordUs : mReport.RecordMaxUs;
+	mLoopSumUs += loopUs;
+	mRecordSumUs += recordUs;
+}
+
+void BlackBox::Trigger(HaltReason::T reason, uint32_t timeUs)
+{
+	if (mFrozen)
+	{
+		return;
+	}
+	mFrozen = true;
+	mReport.Reason = (uint8_t)reason;
+	mReport.TriggerTimeUs = timeUs;
+}
+
+bool BlackBox::IsFrozen() const
+{
+	return mFrozen;
+}
+
+uint32_t BlackBox::GetNumChunks() const
+{
+	return 1 + Recorder.GetNumBlocks();
+}
+
+const uint8_t* BlackBox::GetChunk(uint32_t idx, uint32_t& size)
+{
+	if (idx > 0)
+	{
+		size = FlightRecorder::k_BlockSize;
+		return Recorder.GetBlock(idx - 1);
+	}
+
+	// Also before a trigger, the reason is None then:
+	mReport.Magic = k_Magic;
+	mReport.Version = k_Version;
+	mReport.LoopMinUs = mReport.NumLoops > 0 ? mReport.LoopMinUs : 0;
+	mReport.LoopMeanUs = mReport.NumLoops > 0 ? (uint32_t)(mLoopSumUs / mReport.NumLoops) : 0;
+	mReport.RecordMeanUs = mReport.NumLoops > 0 ? (uint32_t)(mRecordSumUs / mReport.NumLoops) : 0;
+	mReport.SampleIntervalUs = Recorder.SampleIntervalUs;
+	mReport.NumBlocks = Recorder.GetNumBlocks();
+	mReport.Crc = ComputeCrc32(&mReport, offsetof(Report, Crc));
+	size = sizeof(Report);
+	return (const uint8_t*)&mReport;
+}
+
+bool BlackBox::ReadReport(const uint8_t* data, uint32_t size, Report& report)
+{
+	if (size < sizeof(Report))
+	{
+		return false;
+	}
+	memcpy(&report, data, sizeof(Report));
+	return report.Magic == k_Magic && report.Version == k_Version && report.Crc == ComputeCrc32(&report, offsetof(Report, Crc));
+}
\ No newline at end of file
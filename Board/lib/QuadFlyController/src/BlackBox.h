@@ -0,0 +1,91 @@
+#pragma once
+
+#include "FlightRecorder.h"
+
+// Why the black box was frozen.
+struct HaltReason
+{
+	enum T
+	{
+		None,
+		Disconnect,		// Lost the BLE central
+		Stop,			// Emergency stop from the controller app
+		Tilt,			// QuadFlyController fail safe (> 45 degrees)
+		COUNT
+	};
+	static const char* ToStr(T t)
+	{
+		switch (t)
+		{
+		case None:			return "None";
+		case Disconnect:	return "Disconnect";
+		case Stop:			return "Stop";
+		case Tilt:			return "Tilt";
+		default:			return "Invalid";
+		}
+	}
+};
+
+// Crash forensics: every loop goes into a FlightRecorder ring at a high rate, the first
+// Trigger() freezes it with the reason and the loop timing statistics, so the window before
+// the halt survives whatever the board does afterwards. Retrieved in chunks of at most
+// k_BlockSize bytes: the report first, then the recorder blocks oldest first.
+// The overhead is a Record() per loop (constant time, no allocations), measured by the
+// firmware and reported as RecordMaxUs/RecordMeanUs.
+class BlackBox
+{
+public:
+	static const uint32_t k_Magic = 0x58424251;	// "QBBX"
+	static const uint16_t k_Version = 1;
+	static const uint32_t k_OverrunUs = 5000;	// Loops longer than this are counted as overruns
+
+	// First chunk, copied as is (little endian), no padding.
+	struct Report
+	{
+		uint32_t Magic;
+		uint16_t Version;
+		uint8_t Reason;			// HaltReason
+		uint8_t Reserved;
+		uint32_t TriggerTimeUs;	// micros() of the trigger
+		uint32_t NumLoops;		// Since Init()
+		uint32_t LoopMinUs;
+		uint32_t LoopMaxUs;
+		uint32_t LoopMeanUs;
+		uint32_t NumOverruns;
+		uint32_t RecordMaxUs;	// Cost of the black box in a loop
+		uint32_t RecordMeanUs;
+		uint32_t SampleIntervalUs;
+		uint32_t NumBlocks;		// Chunks after this one
+		uint32_t Crc;			// ComputeCrc32 of the bytes before it
+	};
+
+	BlackBox();
+
+	// ~3 s at 1 kHz with 64 KB.
+	void Init(uint8_t* buffer, uint32_t size);
+
+	// Does nothing once frozen.
+	void Record(const FlightSample& sample);
+
+	// Duration of a whole loop and the part of it spent in Record().
+	void AddLoop(uint32_t loopUs, uint32_t recordUs);
+
+	// Freezes the ring, later triggers are ignored.
+	void Trigger(HaltReason::T reason, uint32_t timeUs);
+	bool IsFrozen()const;
+
+	uint32_t GetNumChunks()const;
+	// Chunk idx of GetNumChunks(), size is set to its length.
+	const uint8_t* GetChunk(uint32_t idx, uint32_t& size);
+
+	// Checks the report of a dump, false if it is not one of this version or corrupt.
+	static bool ReadReport(const uint8_t* data, uint32_t size, Report& report);
+
+	FlightRecorder Recorder;
+
+private:
+	Report mReport;
+	uint64_t mLoopSumUs;
+	uint64_t mRecordSumUs;
+	bool mFrozen;
+};
\ No newline at end of file
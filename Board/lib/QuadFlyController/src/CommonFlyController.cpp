@@ -1,50 +1,66 @@
 #include "CommonFlyController.h"
 
-#ifdef _WIN32 
+#include <math.h>
+
+#ifdef FC_UI
 	#include "Graphics/UI/IMGUI/imgui.h"
 #endif
 
-PID::PID(float kp, float ki, float kd)
-	:KP(kp)
-	, KI(ki)
-	, KD(kd)
-{
-	Reset();
-}
-
-float PID::Get(float error, float deltaTime)
+void UnpackControlCommands(uint32_t packed, int32_t* throttle, int32_t* yaw, int32_t* pitch, int32_t* roll)
 {
-	float P = error;
+	/*
+		result |= ((byte)throttle)     << 0 ;   8 bits (unsigned)
+		result |= ((byte)yaw >> 1)     << 8 ;   7 bits (signed)
+		result |= ((byte)pitch >> 1)   << 16;   7 bits (signed)
+		result |= ((byte)roll >> 1)    << 24    7 bits (signed)
 
-	mIntegral = mIntegral + error * deltaTime;
+		result |= (yawNegative    ? 1 : 0) << 15;
+		result |= (pitchNegative  ? 1 : 0) << 23;
+		result |= (rollNegative   ? 1 : 0) << 31;
+	*/
+	*throttle = (int32_t)((packed >> 0) & 0xFF);
+	*yaw = (int32_t)((packed >> 8) & 0x7F);
+	*pitch = (int32_t)((packed >> 16) & 0x7F);
+	*roll = (int32_t)((packed >> 24) & 0x7F);
 
-	float D = mFirst ? 0.0f : (error - mPrevError) / deltaTime;
-	mFirst = false;
-	mPrevError = error;
-
-	LastP = P * KP;
-	LastI = mIntegral * KI;
-	LastD = D * KD;
-
-	return LastP + LastI + LastD;
+	*yaw *= ((packed >> 15) & 0x1) ? -1 : 1;
+	*pitch *= ((packed >> 23) & 0x1) ? -1 : 1;
+	*roll *= ((packed >> 31) & 0x1) ? -1 : 1;
 }
 
-void PID::Reset()
+FCSetPoints ControlCommandsToSetPoints(int32_t throttle, int32_t yaw, int32_t pitch, int32_t roll)
 {
-	mFirst = true;
-	mPrevError = 0.0f;
-	mIntegral = 0.0f;
+	const float maxCommand = 10.0f * 0.017453292519943295769236907684886f; // 10 degrees
+
+	FCSetPoints setPoints = {};
+	setPoints.Thrust = fminf(fmaxf((float)throttle / 255.0f, 0.0f), 0.9f); // Clamp so we dont saturate PIDs
 
-	LastP = 0.0f;
-	LastI = 0.0f;
-	LastD = 0.0f;
+	// Reversed to match sim frame or reference:
+	setPoints.Yaw = -fminf(fmaxf(((float)yaw / 127.0f) * maxCommand, -maxCommand), maxCommand);
+	setPoints.Pitch = fminf(fmaxf(((float)pitch / 127.0f) * maxCommand, -maxCommand), maxCommand);
+	setPoints.Roll = -fminf(fmaxf(((float)roll / 127.0f) * maxCommand, -maxCommand), maxCommand);
+	return setPoints;
 }
 
-void PID::RenderUI()
+template<>
+void PIDT<float>::RenderUI()
 {
-#ifdef _WIN32 
+#ifdef FC_UI
 	ImGui::SliderFloat("KP", &KP, 0.0f, 5.0f);
 	ImGui::SliderFloat("KI", &KI, 0.0f, 5.0f);
 	ImGui::SliderFloat("KD", &KD, 0.0f, 1.0f);
+	if (ImGui::TreeNode("Advanced"))
+	{
+		ImGui::SliderFloat("KF", &KF, 0.0f, 5.0f);
+		ImGui::SliderFloat("Set Point Weight P", &SetPointWeightP, 0.0f, 1.0f);
+		ImGui::SliderFloat("Set Point Weight D", &SetPointWeightD, 0.0f, 1.0f);
+		ImGui::InputFloat("Integral Limit", &IntegralLimit);
+		ImGui::InputFloat("Back Calculation Gain", &BackCalcGain);
+		ImGui::InputFloat("D Cut-off (Hz)", &DCutoffHz);
+		ImGui::InputFloat("Slew Rate", &SlewRate);
+		ImGui::InputFloat("Output Min", &OutputMin);
+		ImGui::InputFloat("Output Max", &OutputMax);
+		ImGui::TreePop();
+	}
 #endif
 }
@@ -1,5 +1,18 @@
 #pragma once
 
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+
+// Host builds run the controllers against the simulation (FC_SIM) and, unless
+// built HEADLESS for the batch tools, expose ImGui panels (FC_UI).
+#ifndef ARDUINO
+	#define FC_SIM
+	#ifndef HEADLESS
+		#define FC_UI
+	#endif
+#endif
+
 // Output commands from the flight controller. Motor thrust 0-1.
 struct FCCommands
 {
@@ -9,48 +22,298 @@ struct FCCommands
 	float RearRightThr;
 };
 
-// Requested set points, the FC will generate commands to reach these set points. Units: radians
-struct FCSetPoints
+// Requested set points, the FC will generate commands to reach these set points. Units: radians, meters
+template<typename Scalar>
+struct FCSetPointsT
 {
-	float Thrust;
-	float Yaw;
-	float Pitch;
-	float Roll;
+	Scalar Thrust;
+	Scalar Yaw;
+	Scalar Pitch;
+	Scalar Roll;
+	Scalar Height;	// Only used by the altitude hold controllers
 };
+typedef FCSetPointsT<float> FCSetPoints;
 
 // State required to iterate and generate commands. Units: meters, radians, seconds.
-struct FCQuadState
-{
-	float Height;
-	float Pitch;
-	float Yaw;
-	float Roll;
-	float DeltaTime;
-	float Time;
+template<typename Scalar>
+struct FCQuadStateT
+{
+	Scalar Height;
+	Scalar Pitch;
+	Scalar Yaw;
+	Scalar Roll;
+	Scalar DeltaTime;
+	Scalar Time;
 };
+typedef FCQuadStateT<float> FCQuadState;
 
-class PID
+// Tunable parameters of a PID, the unit stored in gain sets (see GainSet.h).
+struct PIDGains
 {
-public:
-	PID(float kp, float ki, float kd);
-	float Get(float error, float deltaTime);
-	void Reset();
-	void RenderUI();
 	float KP;
 	float KI;
 	float KD;
+	float KF;
+	float SetPointWeightP;
+	float SetPointWeightD;
+	float IntegralLimit;
+	float BackCalcGain;
+	float DCutoffHz;
+	float SlewRate;
+	float OutputMin;
+	float OutputMax;
+};
 
-	float LastP;
-	float LastI;
-	float LastD;
+// PID block with integrator clamping, back-calculation anti-windup, low-passed derivative,
+// set point weighting, feed-forward and output/slew limits. The update is straight line code
+// (selects instead of branches) so it runs the same on the board FPU and in host sweeps.
+// Cost per Get(): 2 divisions + ~30 FP ops, ~100 cycles on the nRF52840 (Cortex-M4F, estimated
+// from the instruction mix, 14 cycle VDIV).
+// Templated on the scalar: the firmware and the simulation use PID (float), the gain optimizer
+// runs it with dual numbers to differentiate a run with respect to the gains (Source/Optimize).
+template<typename Scalar>
+class PIDT
+{
+public:
+	// Values carried between iterations, the gains are not part of it.
+	struct State
+	{
+		Scalar HasPrev;
+		Scalar PrevError;
+		Scalar Integral;
+		Scalar FilteredD;
+		Scalar PrevOutput;
+	};
+
+	PIDT(Scalar kp, Scalar ki, Scalar kd);
+	explicit PIDT(const PIDGains& gains);
+
+	// Error form, all weights are implicitly 1.
+	Scalar Get(Scalar error, Scalar deltaTime);
+
+	// Set point / measurement form, required for set point weighting.
+	Scalar Get(Scalar setPoint, Scalar measurement, Scalar feedForward, Scalar deltaTime);
+
+	void SetOutputLimits(Scalar minOutput, Scalar maxOutput);
+	void SetGains(const PIDGains& gains);
+	PIDGains GetGains()const;
+	State GetState()const;
+	void SetState(const State& state);
+	void Reset();
+	void RenderUI();	// PID only
+	Scalar KP;
+	Scalar KI;
+	Scalar KD;
+	Scalar KF;				// Feed-forward gain
+	Scalar SetPointWeightP;	// Weight of the set point in the P term (b)
+	Scalar SetPointWeightD;	// Weight of the set point in the D term (c), 0 = derivative on measurement
+	Scalar IntegralLimit;	// Max absolute value of the I term
+	Scalar BackCalcGain;	// Anti-windup back-calculation gain (1/s), 0 disables it
+	Scalar DCutoffHz;		// Cut-off of the D term low-pass filter, 0 disables it
+	Scalar SlewRate;		// Max output change per second
+	Scalar OutputMin;
+	Scalar OutputMax;
+
+	Scalar LastP;
+	Scalar LastI;
+	Scalar LastD;
+	Scalar LastF;
 
 private:
-	bool mFirst = true;
-	float mPrevError = 0.0f;
-	float mIntegral = 0.0f;
+	Scalar Compute(Scalar errorP, Scalar errorI, Scalar errorD, Scalar feedForward, Scalar deltaTime);
+
+	Scalar mHasPrev = 0.0f;	// 0 on the first iteration, 1 afterwards (used as a multiplier)
+	Scalar mPrevError = 0.0f;
+	Scalar mIntegral = 0.0f;	// Already scaled by KI
+	Scalar mFilteredD = 0.0f;
+	Scalar mPrevOutput = 0.0f;
+};
+
+typedef PIDT<float> PID;
+
+template<typename Scalar>
+PIDT<Scalar>::PIDT(Scalar kp, Scalar ki, Scalar kd)
+	:KP(kp)
+	, KI(ki)
+	, KD(kd)
+	, KF(0.0f)
+	, SetPointWeightP(1.0f)
+	, SetPointWeightD(1.0f)
+	, IntegralLimit(FLT_MAX)
+	, BackCalcGain(0.0f)
+	, DCutoffHz(0.0f)
+	, SlewRate(FLT_MAX)
+	, OutputMin(-FLT_MAX)
+	, OutputMax(FLT_MAX)
+{
+	Reset();
+}
+
+template<typename Scalar>
+PIDT<Scalar>::PIDT(const PIDGains& gains)
+{
+	SetGains(gains);
+	Reset();
+}
+
+template<typename Scalar>
+Scalar PIDT<Scalar>::Get(Scalar error, Scalar deltaTime)
+{
+	return Compute(error, error, error, 0.0f, deltaTime);
+}
+
+template<typename Scalar>
+Scalar PIDT<Scalar>::Get(Scalar setPoint, Scalar measurement, Scalar feedForward, Scalar deltaTime)
+{
+	Scalar errorP = SetPointWeightP * setPoint - measurement;
+	Scalar errorI = setPoint - measurement;
+	Scalar errorD = SetPointWeightD * setPoint - measurement;
+	return Compute(errorP, errorI, errorD, feedForward, deltaTime);
+}
+
+template<typename Scalar>
+Scalar PIDT<Scalar>::Compute(Scalar errorP, Scalar errorI, Scalar errorD, Scalar feedForward, Scalar deltaTime)
+{
+	// Derivative, zero on the first iteration and low-passed (first order, RC). The firmware
+	// starts with a zero step, the divisions take at least FLT_MIN so they never give 0/0:
+	const Scalar dt = fmaxf(deltaTime, FLT_MIN);
+	Scalar rawD = mHasPrev * (errorD - mPrevError) / dt;
+	Scalar rc = DCutoffHz > 0.0f ? 1.0f / (2.0f * 3.14159265f * DCutoffHz) : Scalar(0.0f);
+	Scalar alpha = dt / (dt + rc);
+	mFilteredD = mFilteredD + alpha * (rawD - mFilteredD);
+	mPrevError = errorD;
+
+	mIntegral = mIntegral + KI * errorI * deltaTime;
+	mIntegral = fminf(fmaxf(mIntegral, -IntegralLimit), IntegralLimit);
+
+	LastP = KP * errorP;
+	LastI = mIntegral;
+	LastD = KD * mFilteredD;
+	LastF = KF * feedForward;
+
+	// Output limits, then slew limits (not applied on the first iteration):
+	Scalar unclamped = LastP + LastI + LastD + LastF;
+	Scalar output = fminf(fmaxf(unclamped, OutputMin), OutputMax);
+	Scalar maxStep = SlewRate * deltaTime + (1.0f - mHasPrev) * FLT_MAX;
+	output = fminf(fmaxf(output, mPrevOutput - maxStep), mPrevOutput + maxStep);
+
+	// Back-calculation: bleed the integrator by the amount we could not deliver.
+	float integralEnabled = KI != 0.0f ? 1.0f : 0.0f;
+	mIntegral = mIntegral + integralEnabled * BackCalcGain * (output - unclamped) * deltaTime;
+	mIntegral = fminf(fmaxf(mIntegral, -IntegralLimit), IntegralLimit);
+
+	mPrevOutput = output;
+	mHasPrev = 1.0f;
+
+	return output;
+}
+
+template<typename Scalar>
+void PIDT<Scalar>::SetOutputLimits(Scalar minOutput, Scalar maxOutput)
+{
+	OutputMin = minOutput;
+	OutputMax = maxOutput;
+}
+
+template<typename Scalar>
+void PIDT<Scalar>::SetGains(const PIDGains& gains)
+{
+	KP = gains.KP;
+	KI = gains.KI;
+	KD = gains.KD;
+	KF = gains.KF;
+	SetPointWeightP = gains.SetPointWeightP;
+	SetPointWeightD = gains.SetPointWeightD;
+	IntegralLimit = gains.IntegralLimit;
+	BackCalcGain = gains.BackCalcGain;
+	DCutoffHz = gains.DCutoffHz;
+	SlewRate = gains.SlewRate;
+	OutputMin = gains.OutputMin;
+	OutputMax = gains.OutputMax;
+}
+
+template<typename Scalar>
+PIDGains PIDT<Scalar>::GetGains() const
+{
+	PIDGains gains;
+	gains.KP = KP;
+	gains.KI = KI;
+	gains.KD = KD;
+	gains.KF = KF;
+	gains.SetPointWeightP = SetPointWeightP;
+	gains.SetPointWeightD = SetPointWeightD;
+	gains.IntegralLimit = IntegralLimit;
+	gains.BackCalcGain = BackCalcGain;
+	gains.DCutoffHz = DCutoffHz;
+	gains.SlewRate = SlewRate;
+	gains.OutputMin = OutputMin;
+	gains.OutputMax = OutputMax;
+	return gains;
+}
+
+template<typename Scalar>
+typename PIDT<Scalar>::State PIDT<Scalar>::GetState() const
+{
+	State state;
+	state.HasPrev = mHasPrev;
+	state.PrevError = mPrevError;
+	state.Integral = mIntegral;
+	state.FilteredD = mFilteredD;
+	state.PrevOutput = mPrevOutput;
+	return state;
+}
+
+template<typename Scalar>
+void PIDT<Scalar>::SetState(const State& state)
+{
+	mHasPrev = state.HasPrev;
+	mPrevError = state.PrevError;
+	mIntegral = state.Integral;
+	mFilteredD = state.FilteredD;
+	mPrevOutput = state.PrevOutput;
+}
+
+template<typename Scalar>
+void PIDT<Scalar>::Reset()
+{
+	mHasPrev = 0.0f;
+	mPrevError = 0.0f;
+	mIntegral = 0.0f;
+	mFilteredD = 0.0f;
+	mPrevOutput = 0.0f;
+
+	LastP = 0.0f;
+	LastI = 0.0f;
+	LastD = 0.0f;
+	LastF = 0.0f;
+}
+
+template<>
+void PIDT<float>::RenderUI();
+
+// Unpacks the 32 bit command written by the controller app over BLE:
+//   Throttle [0,255]
+//   Yaw      [-127,127]
+//   Pitch    [-127,127]
+//   Roll     [-127,127]
+void UnpackControlCommands(uint32_t packed, int32_t* throttle, int32_t* yaw, int32_t* pitch, int32_t* roll);
+
+// Remaps the raw commands to set points (thrust 0-0.9, orientation in radians).
+FCSetPoints ControlCommandsToSetPoints(int32_t throttle, int32_t yaw, int32_t pitch, int32_t roll);
+
+#ifdef FC_SIM
+// Values a controller carries between iterations (PID state, state machine), saved and
+// restored by the simulation snapshots. Each controller defines its own layout. Also holds
+// the settings of BaseFlyController::SaveSettings.
+struct FCSnapshot
+{
+	static const int k_MaxSize = 128;
+	uint8_t Data[k_MaxSize];
 };
+#endif
 
 struct SimulationFrame;
+struct GainSet;
 class BaseFlyController
 {
 public:
@@ -61,7 +324,16 @@ public:
 	virtual FCCommands Iterate(const FCQuadState& state, const FCSetPoints& setPoints) = 0;
 	virtual void Halt() = 0;
 
-#ifdef _WIN32 
+	// Gains of the PIDs the controller uses, the other slots are left untouched.
+	virtual void SetGainSet(const GainSet& gainSet) = 0;
+	virtual void GetGainSet(GainSet& gainSet)const = 0;
+
+#ifdef FC_SIM
 	virtual void QuerySimState(SimulationFrame* simFrame) = 0;
+	virtual void SaveState(FCSnapshot& snapshot)const = 0;
+	virtual void LoadState(const FCSnapshot& snapshot) = 0;
+	// Everything besides the gains that changes the commands (mixer frame, air mode), written
+	// to a zeroed buffer. Part of the simulation result cache key.
+	virtual void SaveSettings(FCSnapshot& settings)const = 0;
 #endif
 };
\ No newline at end of file
@@ -0,0 +1,19 @@
+#pragma once
+
+// Generated by GainGen from Default.gainset, do not edit.
+// Fields: KP, KI, KD, KF, SetPointWeightP, SetPointWeightD, IntegralLimit, BackCalcGain,
+//         DCutoffHz, SlewRate, OutputMin, OutputMax
+
+#include "GainSet.h"
+
+constexpr GainSet k_DefaultGainSet =
+{
+	0x4E494147, 1, 204,
+	{
+		{ 1.0f, 0.5f, 0.5f, 0.0f, 1.0f, 1.0f, 0.9f, 2.0f, 0.0f, 3.4028235e+38f, 0.0f, 0.9f }, // Height
+		{ 0.121f, 0.0f, 0.016f, 0.0f, 1.0f, 1.0f, 3.4028235e+38f, 0.0f, 0.0f, 3.4028235e+38f, -1.0f, 1.0f }, // Pitch
+		{ 0.121f, 0.0f, 0.016f, 0.0f, 1.0f, 1.0f, 3.4028235e+38f, 0.0f, 0.0f, 3.4028235e+38f, -1.0f, 1.0f }, // Roll
+		{ 0.121f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 3.4028235e+38f, 0.0f, 0.0f, 3.4028235e+38f, -1.0f, 1.0f } // Yaw
+	},
+	0x2C559A85
+};
\ No newline at end of file
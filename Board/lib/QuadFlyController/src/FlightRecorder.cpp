@@ -0,0 +1,320 @@
+#include "FlightRecorder.h"
+#include "GainSet.h"
+
+#include <string.h>
+
+const float FlightRecorder::k_AngleScale = 1e-4f;
+const float FlightRecorder::k_TermScale = 1e-4f;
+
+static_assert(sizeof(FlightRecorder::BlockHeader) == FlightRecorder::k_HeaderSize, "BlockHeader must not have padding");
+
+// Fixed point values are kept within +-2^30 so their differences fit in an int32.
+static const float k_MaxQuantized = 1073741823.0f;
+
+// Rounds to nearest, no floorf (a libm call on the board).
+static int32_t ToFixed(float value, float invScale)
+{
+	float scaled = value * invScale;
+	scaled = scaled > k_MaxQuantized ? k_MaxQuantized : scaled;
+	scaled = scaled < -k_MaxQuantized ? -k_MaxQuantized : scaled;
+	return (int32_t)(scaled + (scaled < 0.0f ? -0.5f : 0.5f));
+}
+
+static int WriteVarint(uint32_t value, uint8_t* out)
+{
+	int numBytes = 0;
+	while (value >= 0x80)
+	{
+		out[numBytes++] = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	out[numBytes++] = (uint8_t)value;
+	return numBytes;
+}
+
+// Returns false past end or on a varint longer than 5 bytes.
+static bool ReadVarint(const uint8_t*& in, const uint8_t* end, uint32_t& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 35 && in < end; shift += 7)
+	{
+		uint8_t byte = *in++;
+		value |= (uint32_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static uint32_t ZigZag(int32_t value)
+{
+	return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t UnZigZag(uint32_t value)
+{
+	return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+FlightRecorder::FlightRecorder()
+	:SampleIntervalUs(10000)
+	,mBuffer(nullptr)
+	,mNumSlots(0)
+{
+	Clear();
+}
+
+void FlightRecorder::Init(uint8_t* buffer, uint32_t size)
+{
+	mNumSlots = size / k_BlockSize;
+	mBuffer = mNumSlots >= 2 ? buffer : nullptr;
+	Clear();
+}
+
+void FlightRecorder::Clear()
+{
+	mCurSlot = 0;
+	mNumFull = 0;
+	mSequence = 0;
+	mNumSamples = 0;
+	mLastTimeUs = 0;
+	mHasRecorded = false;
+	if (mBuffer)
+	{
+		StartBlock();
+	}
+}
+
+bool FlightRecorder::Record(const FlightSample& sample)
+{
+	if (!mBuffer || (mHasRecorded && sample.TimeUs - mLastTimeUs < SampleIntervalUs))
+	{
+		return false;
+	}
+	mHasRecorded = true;
+	mLastTimeUs = sample.TimeUs;
+
+	Quantized cur;
+	Quantize(sample, cur);
+
+	// Packed against the previous sample of the block, or zero if it starts one:
+	uint8_t packed[k_MaxSampleSize];
+	BlockHeader header = ReadHeader(mCurSlot);
+	for (int attempt = 0; attempt < 2; ++attempt)
+	{
+		const int size = Pack(cur, header.NumSamples == 0 ? nullptr : &mPrev, packed);
+		if (k_HeaderSize + header.NumBytes + size <= k_BlockSize)
+		{
+			memcpy(GetSlot(mCurSlot) + k_HeaderSize + header.NumBytes, packed, size);
+			header.NumSamples++;
+			header.NumBytes = (uint16_t)(header.NumBytes + size);
+			WriteHeader(mCurSlot, header);
+			mPrev = cur;
+			mNumSamples++;
+			return true;
+		}
+
+		// Full, the next block (the oldest one once the ring wrapped) takes it:
+		mCurSlot = (mCurSlot + 1) % mNumSlots;
+		mSequence++;
+		if (mNumFull == mNumSlots - 1)
+		{
+			mNumSamples -= ReadHeader(mCurSlot).NumSamples;
+		}
+		else
+		{
+			mNumFull++;
+		}
+		StartBlock();
+		header = ReadHeader(mCurSlot);
+	}
+	return false;
+}
+
+uint32_t FlightRecorder::GetNumSamples() const
+{
+	return mNumSamples;
+}
+
+uint32_t FlightRecorder::GetNumBlocks() const
+{
+	return mBuffer ? mNumFull + (ReadHeader(mCurSlot).NumSamples > 0 ? 1 : 0) : 0;
+}
+
+uint32_t FlightRecorder::GetCapacity() const
+{
+	return mBuffer ? mNumSlots : 0;
+}
+
+const uint8_t* FlightRecorder::GetBlock(uint32_t idx)
+{
+	const uint32_t slot = (mCurSlot + mNumSlots - mNumFull + idx) % mNumSlots;
+	BlockHeader header = ReadHeader(slot);
+	uint8_t* block = GetSlot(slot);
+
+	// CRC of the header bytes before it and the samples, computed in place:
+	header.Crc = 0;
+	WriteHeader(slot, header);
+	uint32_t crc = ComputeCrc32(block, k_BlockSize);
+	header.Crc = crc;
+	WriteHeader(slot, header);
+	return block;
+}
+
+int FlightRecorder::DecodeBlock(const uint8_t* block, FlightSample* samples, int maxSamples)
+{
+	BlockHeader header;
+	memcpy(&header, block, sizeof(header));
+	if (k_HeaderSize + header.NumBytes > k_BlockSize)
+	{
+		return -1;
+	}
+	uint8_t copy[k_BlockSize];
+	memcpy(copy, block, k_BlockSize);
+	memset(copy + 8, 0, 4);
+	if (ComputeCrc32(copy, k_BlockSize) != header.Crc)
+	{
+		return -1;
+	}
+
+	const uint8_t* in = block + k_HeaderSize;
+	const uint8_t* end = in + header.NumBytes;
+	Quantized prev = {};
+	int numSamples = 0;
+	for (int s = 0; s < header.NumSamples; ++s)
+	{
+		Quantized cur;
+		if (!Unpack(in, end, s == 0 ? nullptr : &prev, cur))
+		{
+			return -1;
+		}
+		if (numSamples < maxSamples)
+		{
+			Dequantize(cur, samples[numSamples++]);
+		}
+		prev = cur;
+	}
+	return numSamples;
+}
+
+int FlightRecorder::PackSample(const FlightSample& sample, uint8_t* out)
+{
+	Quantized quantized;
+	Quantize(sample, quantized);
+	return Pack(quantized, nullptr, out);
+}
+
+bool FlightRecorder::UnpackSample(const uint8_t* data, int size, FlightSample& sample)
+{
+	const uint8_t* in = data;
+	Quantized quantized;
+	if (!Unpack(in, data + size, nullptr, quantized) || in != data + size)
+	{
+		return false;
+	}
+	Dequantize(quantized, sample);
+	return true;
+}
+
+int FlightRecorder::Pack(const Quantized& cur, const Quantized* prev, uint8_t* out)
+{
+	int size = WriteVarint(prev ? cur.TimeUs - prev->TimeUs : cur.TimeUs, out);
+	for (int f = 0; f < k_NumFields; ++f)
+	{
+		size += WriteVarint(ZigZag(prev ? cur.Fields[f] - prev->Fields[f] : cur.Fields[f]), out + size);
+	}
+	return size;
+}
+
+bool FlightRecorder::Unpack(const uint8_t*& in, const uint8_t* end, const Quantized* prev, Quantized& cur)
+{
+	uint32_t value;
+	if (!ReadVarint(in, end, value))
+	{
+		return false;
+	}
+	cur.TimeUs = prev ? prev->TimeUs + value : value;
+	for (int f = 0; f < k_NumFields; ++f)
+	{
+		if (!ReadVarint(in, end, value))
+		{
+			return false;
+		}
+		cur.Fields[f] = (prev ? prev->Fields[f] : 0) + UnZigZag(value);
+	}
+	return true;
+}
+
+void FlightRecorder::Quantize(const FlightSample& sample, Quantized& quantized)
+{
+	const float angles[7] = { sample.Yaw, sample.Pitch, sample.Roll, sample.Thrust, sample.YawSetPoint, sample.PitchSetPoint, sample.RollSetPoint };
+	const float invAngleScale = 1.0f / k_AngleScale;
+	const float invTermScale = 1.0f / k_TermScale;
+	int f = 0;
+	quantized.TimeUs = sample.TimeUs;
+	for (int a = 0; a < 7; ++a)
+	{
+		quantized.Fields[f++] = ToFixed(angles[a], invAngleScale);
+	}
+	for (int p = 0; p < 3; ++p)
+	{
+		for (int t = 0; t < 3; ++t)
+		{
+			quantized.Fields[f++] = ToFixed(sample.PIDTerms[p][t], invTermScale);
+		}
+	}
+	for (int m = 0; m < 4; ++m)
+	{
+		quantized.Fields[f++] = sample.Motors[m];
+	}
+}
+
+void FlightRecorder::Dequantize(const Quantized& quantized, FlightSample& sample)
+{
+	float* angles[7] = { &sample.Yaw, &sample.Pitch, &sample.Roll, &sample.Thrust, &sample.YawSetPoint, &sample.PitchSetPoint, &sample.RollSetPoint };
+	int f = 0;
+	sample.TimeUs = quantized.TimeUs;
+	for (int a = 0; a < 7; ++a)
+	{
+		*angles[a] = (float)quantized.Fields[f++] * k_AngleScale;
+	}
+	for (int p = 0; p < 3; ++p)
+	{
+		for (int t = 0; t < 3; ++t)
+		{
+			sample.PIDTerms[p][t] = (float)quantized.Fields[f++] * k_TermScale;
+		}
+	}
+	for (int m = 0; m < 4; ++m)
+	{
+		const int32_t motor = quantized.Fields[f++];
+		sample.Motors[m] = (uint8_t)(motor < 0 ? 0 : motor > 255 ? 255 : motor);
+	}
+}
+
+uint8_t* FlightRecorder::GetSlot(uint32_t slot) const
+{
+	return mBuffer + slot * k_BlockSize;
+}
+
+FlightRecorder::BlockHeader FlightRecorder::ReadHeader(uint32_t slot) const
+{
+	BlockHeader header;
+	memcpy(&header, GetSlot(slot), sizeof(header));
+	return header;
+}
+
+void FlightRecorder::WriteHeader(uint32_t slot, const BlockHeader& header)
+{
+	memcpy(GetSlot(slot), &header, sizeof(header));
+}
+
+void FlightRecorder::StartBlock()
+{
+	BlockHeader header = {};
+	header.Sequence = mSequence;
+	memset(GetSlot(mCurSlot), 0, k_BlockSize);
+	WriteHeader(mCurSlot, header);
+}
\ No newline at end of file
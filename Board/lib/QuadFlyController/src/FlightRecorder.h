@@ -0,0 +1,102 @@
+#pragma once
+
+#include "CommonFlyController.h"
+
+// One control loop as recorded on the board.
+struct FlightSample
+{
+	uint32_t TimeUs;		// micros() of the loop
+	float Yaw;				// Estimated attitude (rad)
+	float Pitch;
+	float Roll;
+	float Thrust;			// Set points (0-1, rad)
+	float YawSetPoint;
+	float PitchSetPoint;
+	float RollSetPoint;
+	float PIDTerms[3][3];	// Pitch, roll and yaw PID, P I D each
+	uint8_t Motors[4];		// PWM written to the motors, FCCommands order
+};
+
+// Flight recorder in a fixed RAM buffer, the newest samples overwrite the oldest ones.
+// The buffer is split in blocks of k_BlockSize bytes. A block starts with a header and then
+// holds the samples packed: the fields are fixed point (k_AngleScale, k_TermScale), stored as
+// the difference with the previous sample of the block (the first one against zero) as a
+// zigzag varint. A steady sample takes ~25 bytes instead of 72, and every block decodes on
+// its own, so the ring can drop whole blocks. Samples are taken at most every
+// SampleIntervalUs, ~150 ns each on a desktop CPU (~15 us on the nRF52840 estimated, 0.15%
+// of the CPU at 100 Hz).
+// The same code decodes the dumps on the host (DecodeBlock).
+class FlightRecorder
+{
+public:
+	static const uint32_t k_Version = 1;
+	static const uint32_t k_BlockSize = 256;
+	static const uint32_t k_HeaderSize = 12;
+	static const int k_NumFields = 20;			// Packed values of a sample besides the time
+	static const int k_MaxSampleSize = (1 + k_NumFields) * 5;
+	static const float k_AngleScale;			// Resolution of angles and thrust
+	static const float k_TermScale;				// Resolution of the PID terms
+
+	// Start of every block, copied as is (both the board and the hosts are little endian).
+	struct BlockHeader
+	{
+		uint32_t Sequence;		// Blocks written before this one since the last Clear()
+		uint16_t NumSamples;
+		uint16_t NumBytes;		// Packed samples after the header
+		uint32_t Crc;			// ComputeCrc32 of the whole block with this field at 0, set by GetBlock
+	};
+
+	FlightRecorder();
+
+	// size is rounded down to whole blocks, at least 2 are needed.
+	void Init(uint8_t* buffer, uint32_t size);
+	void Clear();
+
+	// Returns false if the sample was skipped (interval) or the recorder has no buffer.
+	bool Record(const FlightSample& sample);
+
+	uint32_t GetNumSamples()const;	// In the ring
+	uint32_t GetNumBlocks()const;	// With samples, the current one included
+	uint32_t GetCapacity()const;	// Blocks of the buffer
+
+	// Block idx of GetNumBlocks(), oldest first. Fills the CRC, k_BlockSize bytes.
+	const uint8_t* GetBlock(uint32_t idx);
+
+	// Unpacks a dumped block. Returns the number of samples, -1 if the block is corrupt.
+	static int DecodeBlock(const uint8_t* block, FlightSample* samples, int maxSamples);
+
+	// A single sample packed on its own (against zero), for streaming. Returns the size, at
+	// most k_MaxSampleSize. Unpacking fails unless the data is exactly one sample.
+	static int PackSample(const FlightSample& sample, uint8_t* out);
+	static bool UnpackSample(const uint8_t* data, int size, FlightSample& sample);
+
+	uint32_t SampleIntervalUs;	// 0 records every call
+
+private:
+	// A sample in fixed point, what the deltas are taken of.
+	struct Quantized
+	{
+		uint32_t TimeUs;
+		int32_t Fields[k_NumFields];
+	};
+
+	static void Quantize(const FlightSample& sample, Quantized& quantized);
+	static void Dequantize(const Quantized& quantized, FlightSample& sample);
+	// Against prev, or zero if there is none. Unpack advances in.
+	static int Pack(const Quantized& cur, const Quantized* prev, uint8_t* out);
+	static bool Unpack(const uint8_t*& in, const uint8_t* end, const Quantized* prev, Quantized& cur);
+	uint8_t* GetSlot(uint32_t slot)const;
+	BlockHeader ReadHeader(uint32_t slot)const;
+	void WriteHeader(uint32_t slot, const BlockHeader& header);
+	void StartBlock();
+
+	uint8_t* mBuffer;
+	uint32_t mNumSlots;
+	uint32_t mCurSlot;		// Block being filled
+	uint32_t mNumFull;		// Closed blocks in the ring, before the current one
+	uint32_t mSequence;		// Of the current block
+	uint32_t mNumSamples;
+	uint32_t mLastTimeUs;	// Of the last recorded sample, for the interval
+	bool mHasRecorded;
+	Quantized mPrev;		// Last sample of the current block
+};
\ No newline at end of file
@@ -0,0 +1,33 @@
+#include "GainSet.h"
+
+uint32_t ComputeCrc32(const void* data, size_t size)
+{
+	static const uint32_t k_Table[16] =
+	{
+		0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+		0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+	};
+
+	const uint8_t* bytes = (const uint8_t*)data;
+	uint32_t crc = 0xFFFFFFFF;
+	for (size_t i = 0; i < size; ++i)
+	{
+		crc = k_Table[(crc ^ bytes[i]) & 0x0F] ^ (crc >> 4);
+		crc = k_Table[(crc ^ (bytes[i] >> 4)) & 0x0F] ^ (crc >> 4);
+	}
+	return ~crc;
+}
+
+void SealGainSet(GainSet& gainSet)
+{
+	gainSet.Magic = GainSet::k_Magic;
+	gainSet.Version = GainSet::k_Version;
+	gainSet.Size = (uint16_t)sizeof(GainSet);
+	gainSet.Crc = ComputeCrc32(&gainSet, offsetof(GainSet, Crc));
+}
+
+bool IsValidGainSet(const GainSet& gainSet)
+{
+	return gainSet.Magic == GainSet::k_Magic && gainSet.Version == GainSet::k_Version && gainSet.Size == sizeof(GainSet) &&
+		gainSet.Crc == ComputeCrc32(&gainSet, offsetof(GainSet, Crc));
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "CommonFlyController.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// PID slots of a gain set. Each controller uses the slots it needs.
+struct GainSlot
+{
+	enum T
+	{
+		Height,
+		Pitch,
+		Roll,
+		Yaw,
+		COUNT
+	};
+	static const char* ToStr(T t)
+	{
+		switch (t)
+		{
+		case Height:	return "Height";
+		case Pitch:		return "Pitch";
+		case Roll:		return "Roll";
+		case Yaw:		return "Yaw";
+		default:		return "Invalid";
+		}
+	}
+};
+
+// Versioned gain set, the same bytes are stored in .gainset files, pushed over BLE and emitted
+// as a constexpr table for the firmware (Tools/GainGen). Little endian, no padding.
+// Bump k_Version when the layout changes, Crc covers every byte before it.
+struct GainSet
+{
+	static const uint32_t k_Magic = 0x4E494147; // "GAIN"
+	static const uint16_t k_Version = 1;
+
+	uint32_t Magic;
+	uint16_t Version;
+	uint16_t Size;
+	PIDGains Gains[GainSlot::COUNT];
+	uint32_t Crc;
+};
+
+static_assert(sizeof(GainSet) == 8 + GainSlot::COUNT * sizeof(PIDGains) + 4, "GainSet must not have padding");
+
+// CRC-32 (IEEE 802.3, reflected), nibble table so it stays small on the board.
+uint32_t ComputeCrc32(const void* data, size_t size);
+
+// Fills the header and the CRC.
+void SealGainSet(GainSet& gainSet);
+
+// Magic, version, size and CRC match.
+bool IsValidGainSet(const GainSet& gainSet);
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "Mixer.h"
+
+#ifdef FC_UI
+	#include "Graphics/UI/IMGUI/imgui.h"
+#endif
+
+static const float k_Sin60 = 0.866025404f;
+
+static const Mixer::Rule k_QuadXRules[] =
+{
+	{ -1.0f, -1.0f,  1.0f },	// FrontLeft
+	{  1.0f, -1.0f, -1.0f },	// FrontRight
+	{ -1.0f,  1.0f, -1.0f },	// RearLeft
+	{  1.0f,  1.0f,  1.0f }		// RearRight
+};
+
+static const Mixer::Rule k_QuadPlusRules[] =
+{
+	{  0.0f, -1.0f,  1.0f },	// Front
+	{  1.0f,  0.0f, -1.0f },	// Right
+	{  0.0f,  1.0f,  1.0f },	// Rear
+	{ -1.0f,  0.0f, -1.0f }		// Left
+};
+
+static const Mixer::Rule k_HexXRules[] =
+{
+	{ -0.5f, -k_Sin60,  1.0f },	// FrontLeft
+	{  0.5f, -k_Sin60, -1.0f },	// FrontRight
+	{  1.0f,  0.0f,     1.0f },	// Right
+	{  0.5f,  k_Sin60, -1.0f },	// RearRight
+	{ -0.5f,  k_Sin60,  1.0f },	// RearLeft
+	{ -1.0f,  0.0f,    -1.0f }	// Left
+};
+
+Mixer::Mixer()
+	:AirMode(false)
+{
+	SetFrame(MixerFrame::QuadX);
+}
+
+void Mixer::SetFrame(MixerFrame::T frame)
+{
+	mFrame = frame;
+	switch (frame)
+	{
+	case MixerFrame::QuadPlus:
+		mRules = k_QuadPlusRules;
+		mNumMotors = 4;
+		break;
+	case MixerFrame::HexX:
+		mRules = k_HexXRules;
+		mNumMotors = 6;
+		break;
+	case MixerFrame::QuadX:
+	default:
+		mFrame = MixerFrame::QuadX;
+		mRules = k_QuadXRules;
+		mNumMotors = 4;
+		break;
+	}
+}
+
+MixerFrame::T Mixer::GetFrame() const
+{
+	return mFrame;
+}
+
+int Mixer::GetNumMotors() const
+{
+	return mNumMotors;
+}
+
+bool Mixer::FitsCommands(MixerFrame::T frame)
+{
+	return frame == MixerFrame::QuadX;
+}
+
+void Mixer::RenderUI()
+{
+#ifdef FC_UI
+	if (ImGui::BeginCombo("Frame", MixerFrame::ToStr(mFrame)))
+	{
+		for (int f = 0; f < MixerFrame::COUNT; ++f)
+		{
+			MixerFrame::T cur = (MixerFrame::T)f;
+			if (FitsCommands(cur) && ImGui::Selectable(MixerFrame::ToStr(cur), cur == mFrame))
+			{
+				SetFrame(cur);
+			}
+		}
+		ImGui::EndCombo();
+	}
+	ImGui::Checkbox("Air Mode", &AirMode);
+#endif
+}
+
+FCCommands Mixer::Mix(float thrust, float roll, float pitch, float yaw) const
+{
+	float outputs[k_MaxMotors] = {};
+	Mix(thrust, roll, pitch, yaw, outputs);
+
+	FCCommands commands;
+	commands.FrontLeftThr = outputs[0];
+	commands.FrontRightThr = outputs[1];
+	commands.RearLeftThr = outputs[2];
+	commands.RearRightThr = outputs[3];
+	return commands;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "CommonFlyController.h"
+
+#include <math.h>
+
+// Mixer tables. Motor order:
+//   QuadX:    FrontLeft, FrontRight, RearLeft, RearRight (same as FCCommands)
+//   QuadPlus: Front, Right, Rear, Left
+//   HexX:     FrontLeft, FrontRight, Right, RearRight, RearLeft, Left
+// FCCommands, the board and the simulation only have the Quad X layout, the other tables are
+// only reachable through the array form of Mix() (see Mixer::FitsCommands).
+struct MixerFrame
+{
+	enum T
+	{
+		QuadX,
+		QuadPlus,
+		HexX,
+		COUNT
+	};
+	static const char* ToStr(T t)
+	{
+		switch (t)
+		{
+		case QuadX:		return "Quad X";
+		case QuadPlus:	return "Quad +";
+		case HexX:		return "Hex X";
+		default:		return "Invalid";
+		}
+	}
+};
+
+// Table driven motor mixer. Attitude has priority over thrust: when the requested actions
+// don't fit in [0,1], roll/pitch are kept, yaw is reduced and then the thrust is shifted.
+// With AirMode the thrust can also be raised so we keep attitude authority at zero throttle,
+// without it the attitude actions are scaled down with the thrust.
+class Mixer
+{
+public:
+	static const int k_MaxMotors = 6;
+
+	// Contribution of each action to a motor.
+	struct Rule
+	{
+		float Roll;
+		float Pitch;
+		float Yaw;
+	};
+
+	Mixer();
+	void SetFrame(MixerFrame::T frame);
+	MixerFrame::T GetFrame()const;
+	int GetNumMotors()const;
+	// True if the frame flies through FCCommands, the only ones the frame combo offers.
+	static bool FitsCommands(MixerFrame::T frame);
+	void RenderUI();
+
+	// Thrust in [0,1], actions in [-1,1]. Writes GetNumMotors() outputs in [0,1]. Templated on
+	// the scalar for the gain optimizer (see PIDT).
+	template<typename Scalar>
+	void Mix(Scalar thrust, Scalar roll, Scalar pitch, Scalar yaw, Scalar* outputs)const;
+
+	// Same as above, to the motors of FCCommands. Quad X only (FitsCommands).
+	FCCommands Mix(float thrust, float roll, float pitch, float yaw)const;
+
+	bool AirMode;
+
+private:
+	MixerFrame::T mFrame;
+	const Rule* mRules;
+	int mNumMotors;
+};
+
+template<typename Scalar>
+void Mixer::Mix(Scalar thrust, Scalar roll, Scalar pitch, Scalar yaw, Scalar* outputs) const
+{
+	Scalar rollPitch[k_MaxMotors];
+	Scalar yawOnly[k_MaxMotors];
+	Scalar rpMin = 0.0f, rpMax = 0.0f;
+	Scalar allMin = 0.0f, allMax = 0.0f;
+	for (int i = 0; i < mNumMotors; ++i)
+	{
+		rollPitch[i] = roll * mRules[i].Roll + pitch * mRules[i].Pitch;
+		yawOnly[i] = yaw * mRules[i].Yaw;
+		rpMin = fminf(rpMin, rollPitch[i]);
+		rpMax = fmaxf(rpMax, rollPitch[i]);
+		allMin = fminf(allMin, rollPitch[i] + yawOnly[i]);
+		allMax = fmaxf(allMax, rollPitch[i] + yawOnly[i]);
+	}
+
+	// Desaturate: roll/pitch first, then yaw. The range is convex in the yaw scale so a
+	// linear estimate of the scale always brings it back under 1.
+	Scalar rpScale = 1.0f;
+	Scalar yawScale = 1.0f;
+	Scalar rpRange = rpMax - rpMin;
+	Scalar allRange = allMax - allMin;
+	if (rpRange > 1.0f)
+	{
+		rpScale = 1.0f / rpRange;
+		yawScale = 0.0f;
+	}
+	else if (allRange > 1.0f)
+	{
+		yawScale = (1.0f - rpRange) / (allRange - rpRange);
+	}
+
+	Scalar attMin = 0.0f, attMax = 0.0f;
+	for (int i = 0; i < mNumMotors; ++i)
+	{
+		outputs[i] = rollPitch[i] * rpScale + yawOnly[i] * yawScale;
+		attMin = fminf(attMin, outputs[i]);
+		attMax = fmaxf(attMax, outputs[i]);
+	}
+
+	// Without air mode we never raise the thrust, shrink the attitude instead:
+	thrust = fminf(fmaxf(thrust, 0.0f), 1.0f);
+	Scalar attScale = 1.0f;
+	if (!AirMode && thrust + attMin < 0.0f)
+	{
+		attScale = thrust / -attMin;
+	}
+	attMin *= attScale;
+	attMax *= attScale;
+
+	// Shift the thrust so all the motors stay in range (attitude over thrust):
+	thrust = fminf(fmaxf(thrust, -attMin), 1.0f - attMax);
+
+	for (int i = 0; i < mNumMotors; ++i)
+	{
+		outputs[i] = fminf(fmaxf(thrust + outputs[i] * attScale, 0.0f), 1.0f);
+	}
+}
@@ -1,9 +1,13 @@
 #include "QuadFlyController.h"
 
-#ifdef _WIN32 
+#include <string.h>
+
+#ifdef FC_SIM
 	#include "Simulation.h"
 	#include <cmath>
-	#include "Graphics/UI/IMGUI/imgui.h"
+	#ifdef FC_UI
+		#include "Graphics/UI/IMGUI/imgui.h"
+	#endif
 	#include "glm/glm.hpp"
 	#define DEG_TO_RAD  0.017453292519943295769236907684886f
 	#define RAD_TO_DEG  57.295779513082320876798154814105f
@@ -19,6 +23,13 @@ QuadFlyController::QuadFlyController()
 
 void QuadFlyController::RenderUI()
 {
+#ifdef FC_UI
+	if (ImGui::TreeNode("Mixer"))
+	{
+		MotorMixer.RenderUI();
+		ImGui::TreePop();
+	}
+#endif
 }
 
 void QuadFlyController::Reset()
@@ -65,39 +76,10 @@ FCCommands QuadFlyController::Iterate(const FCQuadState& state, const FCSetPoint
 	// Get PID adjustments:
 	if (runPID)
 	{
-		// Pitch PID
-		float pitchAction = 0.0f;
-		if (runPID)
-		{
-			float pitchError = setPoints.Pitch - state.Pitch;
-			pitchAction = PitchPID.Get(pitchError, state.DeltaTime);
-		}
-
-		// Roll PID
-		float rollAction = 0.0f;
-		if (runPID)
-		{
-			float rollError = setPoints.Roll - state.Roll;
-			rollAction = RollPID.Get(rollError, state.DeltaTime);
-		}
-
-		// Yaw PID
-		float yawAction = 0.0f;
-		if (runPID)
-		{
-			float yawError = setPoints.Yaw - state.Yaw;
-			yawAction = YawPID.Get(yawError, state.DeltaTime);
-		}
-
-		pitchAction = constrain(pitchAction, -1.0f, 1.0f);
-		rollAction = constrain(rollAction, -1.0f, 1.0f);
-		yawAction = constrain(yawAction, -1.0f, 1.0f);
-
-		commands.FrontLeftThr = setPoints.Thrust - rollAction - pitchAction + yawAction;
-		commands.RearLeftThr = setPoints.Thrust - rollAction + pitchAction - yawAction;
-		
-		commands.FrontRightThr = setPoints.Thrust + rollAction - pitchAction - yawAction;
-		commands.RearRightThr = setPoints.Thrust + rollAction + pitchAction + yawAction;
+		PID* pids[GainSlot::COUNT] = { nullptr, &PitchPID, &RollPID, &YawPID };
+		float thrust, rollAction, pitchAction, yawAction;
+		ComputeActions(pids, state, setPoints, thrust, rollAction, pitchAction, yawAction);
+		commands = MotorMixer.Mix(thrust, rollAction, pitchAction, yawAction);
 	}
 
 	return commands;
@@ -108,7 +90,26 @@ void QuadFlyController::Halt()
 	mState = State::FailSafe;
 }
 
-#ifdef _WIN32 
+bool QuadFlyController::IsFailSafe() const
+{
+	return mState == State::FailSafe;
+}
+
+void QuadFlyController::SetGainSet(const GainSet& gainSet)
+{
+	PitchPID.SetGains(gainSet.Gains[GainSlot::Pitch]);
+	RollPID.SetGains(gainSet.Gains[GainSlot::Roll]);
+	YawPID.SetGains(gainSet.Gains[GainSlot::Yaw]);
+}
+
+void QuadFlyController::GetGainSet(GainSet& gainSet) const
+{
+	gainSet.Gains[GainSlot::Pitch] = PitchPID.GetGains();
+	gainSet.Gains[GainSlot::Roll] = RollPID.GetGains();
+	gainSet.Gains[GainSlot::Yaw] = YawPID.GetGains();
+}
+
+#ifdef FC_SIM
 void QuadFlyController::QuerySimState(SimulationFrame* simFrame)
 {
 
@@ -121,4 +122,34 @@ void QuadFlyController::QuerySimState(SimulationFrame* simFrame)
 	simFrame->RollPIDState.I = RollPID.LastI;
 	simFrame->RollPIDState.D = RollPID.LastD;
 }
-#endif
+
+void QuadFlyController::SaveState(FCSnapshot& snapshot) const
+{
+	static_assert(sizeof(SavedState) <= FCSnapshot::k_MaxSize, "Controller state does not fit in a snapshot");
+	SavedState saved;
+	saved.Mode = mState;
+	saved.PitchPID = PitchPID.GetState();
+	saved.RollPID = RollPID.GetState();
+	saved.YawPID = YawPID.GetState();
+	memcpy(snapshot.Data, &saved, sizeof(saved));
+}
+
+void QuadFlyController::LoadState(const FCSnapshot& snapshot)
+{
+	SavedState saved;
+	memcpy(&saved, snapshot.Data, sizeof(saved));
+	mState = saved.Mode;
+	PitchPID.SetState(saved.PitchPID);
+	RollPID.SetState(saved.RollPID);
+	YawPID.SetState(saved.YawPID);
+}
+
+void QuadFlyController::SaveSettings(FCSnapshot& settings) const
+{
+	static_assert(sizeof(SavedSettings) <= FCSnapshot::k_MaxSize, "Controller settings do not fit in a snapshot");
+	SavedSettings saved;
+	saved.Frame = (uint8_t)MotorMixer.GetFrame();
+	saved.AirMode = MotorMixer.AirMode ? 1 : 0;
+	memcpy(settings.Data, &saved, sizeof(saved));
+}
+#endif
\ No newline at end of file
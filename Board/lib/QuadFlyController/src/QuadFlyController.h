@@ -1,6 +1,8 @@
 #pragma once
 
 #include "CommonFlyController.h"
+#include "DefaultGainSet.h"
+#include "Mixer.h"
 
 class QuadFlyController : public BaseFlyController
 {
@@ -10,14 +12,33 @@ public:
 	void Reset() override;
 	FCCommands Iterate(const FCQuadState& state, const FCSetPoints& setPoints) override;
 	void Halt() override;
+	bool IsFailSafe()const;	// Halted, by Halt() or the tilt limit, until the next Reset()
+	void SetGainSet(const GainSet& gainSet) override;
+	void GetGainSet(GainSet& gainSet)const override;
 
-#ifdef _WIN32 
+#ifdef FC_SIM
 	void QuerySimState(SimulationFrame* simFrame) override;
+	void SaveState(FCSnapshot& snapshot)const override;
+	void LoadState(const FCSnapshot& snapshot) override;
+	void SaveSettings(FCSnapshot& settings)const override;
 #endif
 
-	PID PitchPID = PID(0.121f, 0.0f, 0.016f);
-	PID RollPID = PID(0.121f, 0.0f, 0.016f);
-	PID YawPID = PID(0.121f, 0.0f, 0.0f);
+	// Flight law of Iterate(): the PID actions the mixer takes (thrust in [0,1], the others in
+	// [-1,1]). pids is indexed by GainSlot, the Height slot is not used. Templated on the scalar
+	// so the gain optimizer flies the same law with dual numbers.
+	template<typename Scalar>
+	static void ComputeActions(PIDT<Scalar>* const* pids, const FCQuadStateT<Scalar>& state, const FCSetPointsT<Scalar>& setPoints, Scalar& thrust, Scalar& roll, Scalar& pitch, Scalar& yaw)
+	{
+		pitch = pids[GainSlot::Pitch]->Get(setPoints.Pitch, state.Pitch, 0.0f, state.DeltaTime);
+		roll = pids[GainSlot::Roll]->Get(setPoints.Roll, state.Roll, 0.0f, state.DeltaTime);
+		yaw = pids[GainSlot::Yaw]->Get(setPoints.Yaw, state.Yaw, 0.0f, state.DeltaTime);
+		thrust = setPoints.Thrust;
+	}
+
+	PID PitchPID = PID(k_DefaultGainSet.Gains[GainSlot::Pitch]);
+	PID RollPID = PID(k_DefaultGainSet.Gains[GainSlot::Roll]);
+	PID YawPID = PID(k_DefaultGainSet.Gains[GainSlot::Yaw]);
+	Mixer MotorMixer;
 
 private:
 	struct State
@@ -30,4 +51,20 @@ private:
 		};
 	};
 	State::T mState;   // State of the flight controller
+
+#ifdef FC_SIM
+	// Layout of the snapshot data:
+	struct SavedState
+	{
+		State::T Mode;
+		PID::State PitchPID, RollPID, YawPID;
+	};
+
+	// Layout of the settings data, no padding:
+	struct SavedSettings
+	{
+		uint8_t Frame;
+		uint8_t AirMode;
+	};
+#endif
 };
\ No newline at end of file
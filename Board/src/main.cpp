@@ -3,10 +3,29 @@
 #include <Arduino_LSM9DS1.h>
 
 #include "QuadFlyController.h"
+#include "AttitudeEstimator.h"
+#include "FlightRecorder.h"
+#include "BlackBox.h"
+#include "GainSet.h"
 
 //#define DISABLE_BLE
 
 QuadFlyController FC;
+AttitudeEstimator g_Estimator; // Calibrated for this board, see AttitudeEstimator.cpp
+
+// Flight recorder, ~20s at the default 100Hz. Dumped over serial after landing and on Halt():
+uint8_t g_RecorderBuffer[48 * 1024];
+FlightRecorder g_Recorder;
+
+// Black box, every loop of the last ~3s frozen by the first halt. Retrieved over serial ('b')
+// and BLE (see ServeBlackBox) while idle and after Halt():
+uint8_t g_BlackBoxBuffer[64 * 1024];
+BlackBox g_BlackBox;
+uint32_t g_BlackBoxCostUs = 0; // Of the current loop
+
+// Live telemetry for the QuadExplorerApp (see StreamTelemetry), 50Hz:
+//#define DISABLE_TELEMETRY_STREAM
+const uint32_t k_TelemetryIntervalUs = 20000;
 
 float g_TotalTime = 0.0f; // in s
 float g_DeltaTime = 0.0f; // in s
@@ -21,23 +40,25 @@ BLEDevice g_CentralDevice;
 BLEService g_CommandsService("1101");
 BLEByteCharacteristic g_StopCharacteristic("2206", BLEWrite);
 BLEUnsignedLongCharacteristic g_PackedCharacteristic("2207", BLERead | BLEWrite);
+BLECharacteristic g_GainsCharacteristic("2208", BLEWrite, sizeof(GainSet), true); // Raw GainSet, see GainSet.h
 
 BLEService g_TelemetryService("1102");
 BLEFloatCharacteristic g_YawCharacteristic("3301", BLERead);
 BLEFloatCharacteristic g_PitchCharacteristic("3302", BLERead);
 BLEFloatCharacteristic g_RollCharacteristic("3303", BLERead);
 
-const float k_AccXOff = 0.02f;
-const float k_AccYOff = 0.01f;
-const float k_AccZOff = -0.01f;
-
-const float k_GyroXOff = -1.0f;
-const float k_GyroYOff = -0.3f;
-const float k_GyroZOff = -0.5f;
+// Black box: the central writes a chunk index and reads the chunk (see BlackBox.h).
+BLEService g_BlackBoxService("1103");
+BLEUnsignedLongCharacteristic g_BlackBoxIndexCharacteristic("4401", BLEWrite);
+BLECharacteristic g_BlackBoxChunkCharacteristic("4402", BLERead, FlightRecorder::k_BlockSize);
 
 void InitBLE();
 void InitIMU();
-void Halt();
+void Halt(HaltReason::T reason);
+void DumpRecorder();
+void DumpBlackBox();
+void ServeBlackBox();
+void StreamTelemetry(const FlightSample& sample);
 
 bool GetRawAccel(float& x, float& y, float& z);
 bool GetRawGyro(float& x, float& y, float& z);
@@ -52,8 +73,11 @@ void GetOrientation(float& yaw, float& pitch, float& roll);
 //   Roll     [-100,100]
 void GetControlCommandsRaw(int32_t* throttle, int32_t* yaw, int32_t* pitch, int32_t* roll);
 
-// Returns controls remaped (throt 0-100). Orientation in radians
-void GetControlCommands(float& throttle, float& yaw, float& pitch, float& roll);
+// Returns controls remaped (throt 0-0.9). Orientation in radians
+void GetControlCommands(FCSetPoints& setPoints);
+
+// Returns true if the controller app pushed a valid gain set.
+bool GetPushedGains(GainSet& gains);
 
 void setup() 
 {
@@ -90,11 +114,13 @@ void setup()
   InitBLE();
 #endif
   InitIMU();
+  g_Recorder.Init(g_RecorderBuffer, sizeof(g_RecorderBuffer));
+  g_BlackBox.Init(g_BlackBoxBuffer, sizeof(g_BlackBoxBuffer));
 }
 
 void loop() 
 {
-  unsigned long startTime = millis();
+  unsigned long startTime = micros();
 
   {
 #ifndef DISABLE_BLE
@@ -102,7 +128,7 @@ void loop()
     if(!g_CentralDevice.connected())
     {
       Serial.println("[HALT!] Lost connection with central device");
-      Halt();
+      Halt(HaltReason::Disconnect);
     }
 
     // Check if controller requested emergency stop:
@@ -111,7 +137,7 @@ void loop()
     if(stop == 0x1)
     {
       Serial.println("[HALT!] Controller requested STOP");
-      Halt();
+      Halt(HaltReason::Stop);
     }
 #endif
     // Setup quad state for this iteration:
@@ -125,13 +151,34 @@ void loop()
 
     // Query commands:
     FCSetPoints setPoints;
-    GetControlCommands(setPoints.Thrust, setPoints.Yaw, setPoints.Pitch, setPoints.Roll);
+    GetControlCommands(setPoints);
+
+    // Gains pushed while flying wait until the quad is idle:
+    static GainSet k_PendingGains;
+    static bool k_HasPendingGains = false;
+    if(GetPushedGains(k_PendingGains))
+    {
+      k_HasPendingGains = true;
+    }
 
     static bool k_WasIdle = true;
     static float k_CurYawPoint = 0.0f;
     if(setPoints.Thrust <= 0.0f)
     {
+      // Landed, the motors are stopped so there is time to dump the flight:
+      if(!k_WasIdle)
+      {
+        DumpRecorder();
+        g_Recorder.Clear();
+      }
       k_WasIdle = true;
+      ServeBlackBox();
+      if(k_HasPendingGains)
+      {
+        k_HasPendingGains = false;
+        FC.SetGainSet(k_PendingGains);
+        Serial.println("Applied the pushed gain set");
+      }
       FC.Reset();
     }
     else
@@ -147,6 +194,12 @@ void loop()
     // Iterate FC
     FCCommands curCommands = FC.Iterate(curState, setPoints);
 
+    // The FC cuts the motors itself past the tilt limit, we keep looping:
+    if(FC.IsFailSafe() && !k_WasIdle)
+    {
+      g_BlackBox.Trigger(HaltReason::Tilt, micros());
+    }
+
     // Ug, reverse it to match sim frame of reference:
     curCommands.FrontLeftThr = curCommands.FrontLeftThr;
     curCommands.FrontRightThr = curCommands.FrontRightThr;
@@ -162,6 +215,39 @@ void loop()
     analogWrite(k_PinMotorRL, rl);
     analogWrite(k_PinMotorRR, rr);
 
+    {
+      FlightSample sample;
+      sample.TimeUs = startTime;
+      sample.Yaw = curState.Yaw;
+      sample.Pitch = curState.Pitch;
+      sample.Roll = curState.Roll;
+      sample.Thrust = setPoints.Thrust;
+      sample.YawSetPoint = setPoints.Yaw;
+      sample.PitchSetPoint = setPoints.Pitch;
+      sample.RollSetPoint = setPoints.Roll;
+      const PID* pids[3] = { &FC.PitchPID, &FC.RollPID, &FC.YawPID };
+      for(int p = 0; p < 3; ++p)
+      {
+        sample.PIDTerms[p][0] = pids[p]->LastP;
+        sample.PIDTerms[p][1] = pids[p]->LastI;
+        sample.PIDTerms[p][2] = pids[p]->LastD;
+      }
+      sample.Motors[0] = (uint8_t)fl;
+      sample.Motors[1] = (uint8_t)fr;
+      sample.Motors[2] = (uint8_t)rl;
+      sample.Motors[3] = (uint8_t)rr;
+      if(!k_WasIdle)
+      {
+        g_Recorder.Record(sample);
+      }
+      unsigned long recordStart = micros();
+      g_BlackBox.Record(sample);
+      g_BlackBoxCostUs = (uint32_t)(micros() - recordStart);
+#ifndef DISABLE_TELEMETRY_STREAM
+      StreamTelemetry(sample);
+#endif
+    }
+
     // Debug:
 #if 0
     Serial.print(curCommands.FrontLeftThr);Serial.print(",\t");
@@ -179,8 +265,10 @@ void loop()
   }
 
   // End of the iteration, compute delta, acum total:
-  g_DeltaTime = ((float)startTime - (float)millis()) / 1000.0f;
+  unsigned long loopUs = micros() - startTime;
+  g_DeltaTime = (float)loopUs / 1000000.0f; // micros(), a loop takes less than 1ms
   g_TotalTime += g_DeltaTime;
+  g_BlackBox.AddLoop((uint32_t)loopUs, g_BlackBoxCostUs);
 }
 
 void InitBLE()
@@ -205,6 +293,7 @@ void InitBLE()
   BLE.setAdvertisedService(g_CommandsService);
   g_CommandsService.addCharacteristic(g_StopCharacteristic);
   g_CommandsService.addCharacteristic(g_PackedCharacteristic);
+  g_CommandsService.addCharacteristic(g_GainsCharacteristic);
   BLE.addService(g_CommandsService);
 
   // Telemetry:
@@ -216,6 +305,10 @@ void InitBLE()
   BLE.addService(g_TelemetryService);
 #endif
 
+  g_BlackBoxService.addCharacteristic(g_BlackBoxIndexCharacteristic);
+  g_BlackBoxService.addCharacteristic(g_BlackBoxChunkCharacteristic);
+  BLE.addService(g_BlackBoxService);
+
   BLE.advertise();
 
   // Wait until the central device connects:
@@ -320,7 +413,7 @@ void InitIMU()
 #endif
 }
 
-void Halt()
+void Halt(HaltReason::T reason)
 {
   FC.Halt();
   
@@ -329,13 +422,138 @@ void Halt()
   analogWrite(k_PinMotorRL, 0);
   analogWrite(k_PinMotorRR, 0);
 
+  g_BlackBox.Trigger(reason, micros());
+  DumpRecorder();
+  DumpBlackBox();
+
+#ifndef DISABLE_BLE
+  // The central may be gone, let it connect again to read the black box:
+  BLE.advertise();
+#endif
   while(1)
   {
     digitalWrite(LED_BUILTIN, HIGH);
-    delay(250); 
+    for(int i = 0; i < 25; ++i)
+    {
+      ServeBlackBox();
+      delay(10);
+    }
     digitalWrite(LED_BUILTIN, LOW);
-    delay(250); 
+    for(int i = 0; i < 25; ++i)
+    {
+      ServeBlackBox();
+      delay(10);
+    }
+  }
+}
+
+// Text so any serial capture can be decoded on the host (see Source/Replay/FlightLog.h):
+//   QREC begin <version> <block size> <blocks> <sample interval us>
+//   QREC <block in hex>   One line per block, oldest first
+//   QREC end
+void DumpRecorder()
+{
+  const uint32_t numBlocks = g_Recorder.GetNumBlocks();
+  Serial.print("QREC begin "); Serial.print(FlightRecorder::k_Version);
+  Serial.print(" "); Serial.print(FlightRecorder::k_BlockSize);
+  Serial.print(" "); Serial.print(numBlocks);
+  Serial.print(" "); Serial.println(g_Recorder.SampleIntervalUs);
+
+  static const char k_Hex[] = "0123456789ABCDEF";
+  static char k_Line[5 + 2 * FlightRecorder::k_BlockSize + 1] = "QREC ";
+  for(uint32_t b = 0; b < numBlocks; ++b)
+  {
+    const uint8_t* block = g_Recorder.GetBlock(b);
+    for(uint32_t i = 0; i < FlightRecorder::k_BlockSize; ++i)
+    {
+      k_Line[5 + 2 * i] = k_Hex[block[i] >> 4];
+      k_Line[6 + 2 * i] = k_Hex[block[i] & 0x0F];
+    }
+    Serial.println(k_Line);
   }
+  Serial.println("QREC end");
+}
+
+// Same as DumpRecorder, the report is the first hex line:
+//   QBOX begin <version> <reason> <chunks>
+//   QBOX <chunk in hex>   One line per chunk
+//   QBOX end
+void DumpBlackBox()
+{
+  const uint32_t numChunks = g_BlackBox.GetNumChunks();
+  Serial.print("QBOX begin "); Serial.print((unsigned int)BlackBox::k_Version);
+  Serial.print(" "); Serial.print(g_BlackBox.IsFrozen() ? "frozen" : "live");
+  Serial.print(" "); Serial.println(numChunks);
+
+  static const char k_Hex[] = "0123456789ABCDEF";
+  static char k_Line[5 + 2 * FlightRecorder::k_BlockSize + 1] = "QBOX ";
+  for(uint32_t c = 0; c < numChunks; ++c)
+  {
+    uint32_t size = 0;
+    const uint8_t* chunk = g_BlackBox.GetChunk(c, size);
+    for(uint32_t i = 0; i < size; ++i)
+    {
+      k_Line[5 + 2 * i] = k_Hex[chunk[i] >> 4];
+      k_Line[6 + 2 * i] = k_Hex[chunk[i] & 0x0F];
+    }
+    k_Line[5 + 2 * size] = 0;
+    Serial.println(k_Line);
+  }
+  Serial.println("QBOX end");
+}
+
+// Black box requests, only while idle or halted (a dump takes a while): 'b' on the serial
+// port dumps it, a chunk index written over BLE sets the chunk characteristic.
+void ServeBlackBox()
+{
+  while(Serial.available() > 0)
+  {
+    if(Serial.read() == 'b')
+    {
+      DumpBlackBox();
+    }
+  }
+#ifndef DISABLE_BLE
+  BLE.poll();
+  if(g_BlackBoxIndexCharacteristic.written())
+  {
+    uint32_t idx = 0;
+    g_BlackBoxIndexCharacteristic.readValue(idx);
+    uint32_t size = 0;
+    const uint8_t* chunk = idx < g_BlackBox.GetNumChunks() ? g_BlackBox.GetChunk(idx, size) : nullptr;
+    g_BlackBoxChunkCharacteristic.setValue(chunk, (int)size);
+  }
+#endif
+}
+
+// One sample per line, packed on its own (FlightRecorder::PackSample) with its CRC32 after:
+//   QTEL <packed sample><crc> in hex
+// Only while a host has the port open, ~110 bytes per line.
+void StreamTelemetry(const FlightSample& sample)
+{
+  static bool k_HasStreamed = false;
+  static uint32_t k_LastStreamUs = 0;
+  if(!Serial || (k_HasStreamed && sample.TimeUs - k_LastStreamUs < k_TelemetryIntervalUs))
+  {
+    return;
+  }
+  k_HasStreamed = true;
+  k_LastStreamUs = sample.TimeUs;
+
+  uint8_t packed[FlightRecorder::k_MaxSampleSize + 4];
+  const int size = FlightRecorder::PackSample(sample, packed);
+  const uint32_t crc = ComputeCrc32(packed, size);
+  memcpy(packed + size, &crc, 4);
+
+  static const char k_Hex[] = "0123456789ABCDEF";
+  static char k_Line[5 + 2 * (FlightRecorder::k_MaxSampleSize + 4) + 1] = "QTEL ";
+  for(int i = 0; i < size + 4; ++i)
+  {
+    k_Line[5 + 2 * i] = k_Hex[packed[i] >> 4];
+    k_Line[6 + 2 * i] = k_Hex[packed[i] & 0x0F];
+  }
+  k_Line[5 + 2 * (size + 4)] = 0;
+  Serial.println(k_Line);
 }
 
 bool GetRawAccel(float& x, float& y, float& z)
@@ -347,9 +565,6 @@ bool GetRawAccel(float& x, float& y, float& z)
     z = 0.0f;
     return false;
   }
-  x += k_AccXOff;
-  y += k_AccYOff;
-  z += k_AccZOff;
   return true;
 }
 
@@ -362,86 +577,17 @@ bool GetRawGyro(float& x, float& y, float& z)
     z = 0.0f;
     return false;
   }
-  x += k_GyroXOff;
-  y += k_GyroYOff;
-  z += k_GyroZOff;
   return true;
 }
 
 void GetOrientation(float& yaw, float& pitch, float& roll)
 {
-  static float k_LastAx = 0.0f;
-  static float k_LastAy = 0.0f;
-  static float k_LastAz = 1.0f;
-
-  float ax, ay, az;
-  if(GetRawAccel(ax, ay, az))
-  {   
-    k_LastAx = ax;
-    k_LastAy = ay;
-    k_LastAz = az;
-  }
-  else
-  {
-    ax = k_LastAx;
-    ay = k_LastAy;
-    az = k_LastAz;
-    //Serial.println("ERROR READING ACCEL"); // Atm, we should stop the drone if we get this
-  }
-  float accMagnitude = sqrt((ax*ax) + (ay*ay) + (az*az));
-  float rawPitch = atan2((ax / accMagnitude) , (az / accMagnitude)) * RAD_TO_DEG;
-  float rawRoll = atan2((-ay / accMagnitude) , (az / accMagnitude)) * RAD_TO_DEG;
-  
+  float accel[3];
+  float gyro[3];
+  bool hasAccel = GetRawAccel(accel[0], accel[1], accel[2]);
+  bool hasGyro = GetRawGyro(gyro[0], gyro[1], gyro[2]);
   // TO-DO: if we detec huge dps, Halt FC.
-  static float k_LastWx = 0.0f;
-  static float k_LastWy = 0.0f;
-  static float k_LastWz = 0.0f;
-
-  float wx, wy, wz;
-  if(GetRawGyro(wx, wy, wz))
-  {
-    k_LastWx = wx;
-    k_LastWy = wy;
-    k_LastWz = wz;
-  }
-  else
-  {
-    wx = k_LastWx;
-    wy = k_LastWy;
-    wz = k_LastWz;
-    //Serial.println("ERROR READING GYR"); // Atm, we should stop the drone if we get this
-  }
-  
-  static float s_AcumYaw = 0.0f;
-  static float s_AcumPitch = 0.0f;
-  static float s_AcumRoll = 0.0f;
-  static bool s_FirstTime = true;
-
-  if(s_FirstTime)
-  {
-    s_FirstTime =  false;
-    s_AcumYaw = 0.0f;
-    s_AcumPitch = rawPitch;
-    s_AcumRoll = rawRoll;
-  }
-  else
-  {
-    s_AcumYaw -= wz * g_DeltaTime;
-    s_AcumPitch -= wy * g_DeltaTime;
-    s_AcumRoll -= wx * g_DeltaTime;
-  }
-  
-  // Transfer angle as we have yawed:
-  s_AcumPitch -= s_AcumRoll * sin((-wz * g_DeltaTime) * DEG_TO_RAD);
-  s_AcumRoll += s_AcumPitch * sin((-wz * g_DeltaTime) * DEG_TO_RAD);
-
-  // Combine raw accel and gyro, this adds noise but removes gyro drift over time:
-  s_AcumPitch = s_AcumPitch * 0.9996f + rawPitch * 0.0004f;
-  s_AcumRoll = s_AcumRoll * 0.9996f + rawRoll * 0.0004f;
-
-  yaw = s_AcumYaw;
-  pitch = -s_AcumPitch;
-  roll = -s_AcumRoll;
+  g_Estimator.Update(hasAccel ? accel : nullptr, hasGyro ? gyro : nullptr, g_DeltaTime, yaw, pitch, roll);
 
   // Debug:
 #if 0
@@ -459,30 +605,12 @@ void GetOrientation(float& yaw, float& pitch, float& roll)
 
 void GetControlCommandsRaw(int32_t* throttle, int32_t* yaw, int32_t* pitch, int32_t* roll)
 {    
-  /*
-    result |= ((byte)throttle)     << 0 ;   8 bits (unsigned)
-    result |= ((byte)yaw >> 1)     << 8 ;   7 bits (signed)
-    result |= ((byte)pitch >> 1)   << 16;   7 bits (signed)
-    result |= ((byte)roll >> 1)    << 24    7 bits (signed)
-
-    result |= (yawNegative    ? 1 : 0) << 15;
-    result |= (pitchNegative  ? 1 : 0) << 23;
-    result |= (rollNegative   ? 1 : 0) << 31;
-  */
-
   uint32_t packed = 0;
 #ifndef DISABLE_BLE
   g_PackedCharacteristic.readValue(packed);
 #endif
 
-  *throttle = (int32_t)((packed >> 0 ) & 0xFF);
-  *yaw      = (int32_t)((packed >> 8)  & 0x7F);
-  *pitch    = (int32_t)((packed >> 16) & 0x7F);
-  *roll     = (int32_t)((packed >> 24) & 0x7F);
-
-  *yaw    *= ((packed >> 15) & 0x1) ? -1 : 1;
-  *pitch  *= ((packed >> 23) & 0x1) ? -1 : 1;
-  *roll   *= ((packed >> 31) & 0x1) ? -1 : 1;
+  UnpackControlCommands(packed, throttle, yaw, pitch, roll);
 
   // Debug:
 #if 0
@@ -493,17 +621,36 @@ void GetControlCommandsRaw(int32_t* throttle, int32_t* yaw, int32_t* pitch, int3
 #endif
 }
 
-void GetControlCommands(float& throttle, float& yaw, float& pitch, float& roll)
+void GetControlCommands(FCSetPoints& setPoints)
 {
   int32_t rawThrottle, rawYaw, rawPitch, rawRoll;
   GetControlCommandsRaw(&rawThrottle, &rawYaw, &rawPitch, &rawRoll);
 
-  float maxCommand = 10.0f; // Degrees
-
-  throttle = constrain((float)rawThrottle/255.0f, 0.0f, 0.9f); // Clamp so we dont saturate PIDs
+  setPoints = ControlCommandsToSetPoints(rawThrottle, rawYaw, rawPitch, rawRoll);
+}
 
-  // Reversed to match sim frame or reference:
-  yaw = -constrain(((float)rawYaw / 127.0f) * maxCommand, -maxCommand, maxCommand) * DEG_TO_RAD;
-  pitch = constrain(((float)rawPitch / 127.0f) * maxCommand, -maxCommand, maxCommand) * DEG_TO_RAD;
-  roll = -constrain(((float)rawRoll / 127.0f) * maxCommand, -maxCommand, maxCommand) * DEG_TO_RAD;
+bool GetPushedGains(GainSet& gains)
+{
+#ifndef DISABLE_BLE
+  if(!g_GainsCharacteristic.written())
+  {
+    return false;
+  }
+  GainSet pushed;
+  if(g_GainsCharacteristic.valueLength() != sizeof(GainSet))
+  {
+    Serial.println("Rejected gain set: wrong size");
+    return false;
+  }
+  memcpy(&pushed, g_GainsCharacteristic.value(), sizeof(GainSet));
+  if(!IsValidGainSet(pushed))
+  {
+    Serial.println("Rejected gain set: bad version or CRC");
+    return false;
+  }
+  gains = pushed;
+  return true;
+#else
+  return false;
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,208 @@
+// Saturation and air mode corner cases of the motor mixer, host only: pio test -e native
+#include <unity.h>
+
+#include "Mixer.h"
+// The library is not built for the native env (see platformio.ini), build the mixer here:
+#include "Mixer.cpp"
+
+static const float k_Tolerance = 1e-5f;
+
+static void AssertInRange(const float* outputs, int numMotors)
+{
+	for (int i = 0; i < numMotors; ++i)
+	{
+		TEST_ASSERT_TRUE(outputs[i] >= 0.0f && outputs[i] <= 1.0f);
+	}
+}
+
+static float MinOf(const float* outputs, int numMotors)
+{
+	float result = outputs[0];
+	for (int i = 1; i < numMotors; ++i)
+	{
+		result = fminf(result, outputs[i]);
+	}
+	return result;
+}
+
+static float MaxOf(const float* outputs, int numMotors)
+{
+	float result = outputs[0];
+	for (int i = 1; i < numMotors; ++i)
+	{
+		result = fmaxf(result, outputs[i]);
+	}
+	return result;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// No actions: every motor gets the thrust.
+static void test_thrust_only()
+{
+	Mixer mixer;
+	FCCommands commands = mixer.Mix(0.4f, 0.0f, 0.0f, 0.0f);
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.4f, commands.FrontLeftThr);
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.4f, commands.FrontRightThr);
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.4f, commands.RearLeftThr);
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.4f, commands.RearRightThr);
+}
+
+// Unsaturated actions go through the Quad X table unchanged, in the FCCommands order.
+static void test_quad_x_unsaturated()
+{
+	Mixer mixer;
+	FCCommands commands = mixer.Mix(0.5f, 0.1f, 0.05f, 0.02f);
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.5f - 0.1f - 0.05f + 0.02f, commands.FrontLeftThr);
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.5f + 0.1f - 0.05f - 0.02f, commands.FrontRightThr);
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.5f - 0.1f + 0.05f - 0.02f, commands.RearLeftThr);
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.5f + 0.1f + 0.05f + 0.02f, commands.RearRightThr);
+}
+
+// Full throttle with roll: the thrust comes down so the roll difference is kept.
+static void test_full_throttle_keeps_attitude()
+{
+	Mixer mixer;
+	FCCommands commands = mixer.Mix(1.0f, 0.2f, 0.0f, 0.0f);
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 1.0f, commands.FrontRightThr);
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.4f, commands.FrontRightThr - commands.FrontLeftThr);
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.4f, commands.RearRightThr - commands.RearLeftThr);
+}
+
+// Zero throttle without air mode: the attitude scales down with the thrust, motors stay off.
+static void test_zero_throttle_no_air_mode()
+{
+	Mixer mixer;
+	mixer.AirMode = false;
+	float outputs[Mixer::k_MaxMotors];
+	mixer.Mix(0.0f, 0.3f, -0.2f, 0.1f, outputs);
+	for (int i = 0; i < mixer.GetNumMotors(); ++i)
+	{
+		TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.0f, outputs[i]);
+	}
+
+	// Low throttle: the lowest motor touches 0 and the attitude is scaled, not clipped.
+	mixer.Mix(0.1f, 0.3f, 0.0f, 0.0f, outputs);
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.0f, MinOf(outputs, 4));
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.2f, MaxOf(outputs, 4));
+}
+
+// Zero throttle with air mode: the thrust is raised so the full attitude is delivered.
+static void test_zero_throttle_air_mode()
+{
+	Mixer mixer;
+	mixer.AirMode = true;
+	FCCommands commands = mixer.Mix(0.0f, 0.3f, 0.0f, 0.0f);
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.0f, commands.FrontLeftThr);
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.6f, commands.FrontRightThr);
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.0f, commands.RearLeftThr);
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.6f, commands.RearRightThr);
+}
+
+// Roll and pitch over the motor range: scaled to fit, yaw dropped, the balance kept.
+static void test_roll_pitch_over_range()
+{
+	Mixer mixer;
+	float outputs[Mixer::k_MaxMotors];
+	mixer.Mix(0.5f, 0.8f, 0.4f, 0.5f, outputs);
+	AssertInRange(outputs, 4);
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 1.0f, MaxOf(outputs, 4) - MinOf(outputs, 4));
+	// No yaw left, the two diagonals add up the same:
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.0f, outputs[0] + outputs[3] - outputs[1] - outputs[2]);
+	// Roll over pitch ratio kept:
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 2.0f * (outputs[2] - outputs[0]), outputs[1] - outputs[0]);
+}
+
+// Roll and pitch fit but yaw does not: yaw is reduced until the range fits.
+static void test_yaw_desaturation()
+{
+	Mixer mixer;
+	float outputs[Mixer::k_MaxMotors];
+	mixer.Mix(0.5f, 0.2f, 0.1f, 0.5f, outputs);
+	AssertInRange(outputs, 4);
+	TEST_ASSERT_TRUE(MaxOf(outputs, 4) - MinOf(outputs, 4) <= 1.0f + k_Tolerance);
+	// Roll and pitch untouched:
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.4f, (outputs[1] + outputs[3] - outputs[0] - outputs[2]) * 0.5f);
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.2f, (outputs[2] + outputs[3] - outputs[0] - outputs[1]) * 0.5f);
+	// Yaw reduced, same sign (the diagonals differ by twice the yaw action):
+	const float yaw = (outputs[0] + outputs[3] - outputs[1] - outputs[2]) * 0.25f;
+	TEST_ASSERT_TRUE(yaw > 0.0f && yaw < 0.5f);
+}
+
+// Out of range inputs on every frame: outputs stay in [0,1] and are never NaN.
+static void test_outputs_in_range()
+{
+	static const float k_Values[] = { -4.0f, -1.0f, -0.5f, 0.0f, 0.5f, 1.0f, 4.0f };
+	static const int k_NumValues = sizeof(k_Values) / sizeof(k_Values[0]);
+	Mixer mixer;
+	float outputs[Mixer::k_MaxMotors];
+	for (int f = 0; f < MixerFrame::COUNT; ++f)
+	{
+		mixer.SetFrame((MixerFrame::T)f);
+		for (int airMode = 0; airMode < 2; ++airMode)
+		{
+			mixer.AirMode = airMode != 0;
+			for (int t = 0; t < k_NumValues; ++t)
+			for (int r = 0; r < k_NumValues; ++r)
+			for (int p = 0; p < k_NumValues; ++p)
+			for (int y = 0; y < k_NumValues; ++y)
+			{
+				mixer.Mix(k_Values[t], k_Values[r], k_Values[p], k_Values[y], outputs);
+				AssertInRange(outputs, mixer.GetNumMotors());
+			}
+		}
+	}
+}
+
+// Every table is balanced: a pure roll, pitch or yaw action adds no net thrust.
+static void test_tables_balanced()
+{
+	Mixer mixer;
+	float outputs[Mixer::k_MaxMotors];
+	for (int f = 0; f < MixerFrame::COUNT; ++f)
+	{
+		mixer.SetFrame((MixerFrame::T)f);
+		const int numMotors = mixer.GetNumMotors();
+		const float actions[3][3] = { { 0.1f, 0.0f, 0.0f }, { 0.0f, 0.1f, 0.0f }, { 0.0f, 0.0f, 0.1f } };
+		for (int a = 0; a < 3; ++a)
+		{
+			mixer.Mix(0.5f, actions[a][0], actions[a][1], actions[a][2], outputs);
+			float sum = 0.0f;
+			for (int i = 0; i < numMotors; ++i)
+			{
+				sum += outputs[i];
+			}
+			TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.5f * numMotors, sum);
+		}
+	}
+}
+
+// Only the frames with the FCCommands motor layout are offered.
+static void test_frames_fit_commands()
+{
+	TEST_ASSERT_TRUE(Mixer::FitsCommands(MixerFrame::QuadX));
+	TEST_ASSERT_FALSE(Mixer::FitsCommands(MixerFrame::QuadPlus));
+	TEST_ASSERT_FALSE(Mixer::FitsCommands(MixerFrame::HexX));
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_thrust_only);
+	RUN_TEST(test_quad_x_unsaturated);
+	RUN_TEST(test_full_throttle_keeps_attitude);
+	RUN_TEST(test_zero_throttle_no_air_mode);
+	RUN_TEST(test_zero_throttle_air_mode);
+	RUN_TEST(test_roll_pitch_over_range);
+	RUN_TEST(test_yaw_desaturation);
+	RUN_TEST(test_outputs_in_range);
+	RUN_TEST(test_tables_balanced);
+	RUN_TEST(test_frames_fit_commands);
+	return UNITY_END();
+}
\ No newline at end of file
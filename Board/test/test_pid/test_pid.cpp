@@ -0,0 +1,60 @@
+// First iteration and zero time step cases of the PID, host only: pio test -e native
+#include <unity.h>
+
+#include "CommonFlyController.h"
+
+static const float k_Tolerance = 1e-5f;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// The firmware starts with a zero time step: no NaN, no derivative kick.
+static void test_zero_delta_time_first_call()
+{
+	PID pid(0.5f, 0.2f, 0.1f);
+	const float output = pid.Get(1.0f, 0.0f, 0.0f, 0.0f);
+	TEST_ASSERT_FALSE(isnan(output));
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.5f, output);
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.0f, pid.LastD);
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.0f, pid.LastI);
+
+	// The filter state stays finite, the next steps are unaffected:
+	const float next = pid.Get(1.0f, 0.0f, 0.0f, 0.01f);
+	TEST_ASSERT_FALSE(isnan(next));
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.0f, pid.LastD);
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.2f * 0.01f, pid.LastI);
+}
+
+// Same with the derivative low-pass filter on.
+static void test_zero_delta_time_filtered_derivative()
+{
+	PID pid(0.5f, 0.0f, 0.1f);
+	pid.DCutoffHz = 20.0f;
+	TEST_ASSERT_FALSE(isnan(pid.Get(1.0f, 0.0f, 0.0f, 0.0f)));
+	TEST_ASSERT_FALSE(isnan(pid.Get(1.0f, 0.2f, 0.0f, 0.01f)));
+	TEST_ASSERT_TRUE(pid.LastD < 0.0f);
+}
+
+// Derivative on the second call, unfiltered: KD times the error change over the step.
+static void test_derivative()
+{
+	PID pid(0.0f, 0.0f, 0.1f);
+	pid.Get(1.0f, 0.0f, 0.0f, 0.01f);
+	TEST_ASSERT_FLOAT_WITHIN(k_Tolerance, 0.0f, pid.LastD);
+	pid.Get(1.0f, 0.5f, 0.0f, 0.01f);
+	TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.1f * -0.5f / 0.01f, pid.LastD);
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_zero_delta_time_first_call);
+	RUN_TEST(test_zero_delta_time_filtered_derivative);
+	RUN_TEST(test_derivative);
+	return UNITY_END();
+}
\ No newline at end of file
@@ -35,6 +35,11 @@ public class Controller : MonoBehaviour
     public string CommandsServiceUID = "1101";
     public string StopCharacteristicUID = "2206";
     public string PackedCharacteristicUID = "2207";
+    public string GainsCharacteristicUID = "2208";
+
+    // Gain set saved by the simulator (raw GainSet, see GainSet.h), read from the persistent data path.
+    public string GainSetFileName = "Default.gainset";
+    private const int GainSetSize = 204;
 
     public string TelemetryServiceUID =  "1102";
     public string YawTelemetryCharacteristicUID = "3301";
@@ -247,6 +252,34 @@ public class Controller : MonoBehaviour
         });
     }
 
+    public void OnPushGainsClicked()
+    {
+        if(CurState != States.Connected)
+        {
+            return;
+        }
+
+        string path = System.IO.Path.Combine(Application.persistentDataPath, GainSetFileName);
+        if(!System.IO.File.Exists(path))
+        {
+            Debug.Log("Gain set not found: " + path);
+            return;
+        }
+        byte[] data = System.IO.File.ReadAllBytes(path);
+        if(data.Length != GainSetSize)
+        {
+            Debug.Log("Invalid gain set size: " + data.Length);
+            return;
+        }
+
+        // With response, the board checks the version and CRC and applies it when idle:
+        BluetoothLEHardwareInterface.WriteCharacteristic(ConnectedToAdr, FullUUID(CommandsServiceUID), FullUUID(GainsCharacteristicUID), data, data.Length, true, 
+        (msg)=>
+        {
+            Debug.Log("Gain set pushed: " + msg);
+        });
+    }
+
     string FullUUID (string uuid)
 	{
 		return "0000" + uuid + "-0000-1000-8000-00805F9B34FB";
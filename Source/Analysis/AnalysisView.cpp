@@ -0,0 +1,215 @@
+#include "AnalysisView.h"
+#include "Simulation.h"
+#include "Graphics/UI/IMGUI/imgui.h"
+#include "Core/Logging.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+static float GetChannel(const SimulationFrame& frame, AnalysisView::Channel::T channel, bool setPoint)
+{
+	switch (channel)
+	{
+	case AnalysisView::Channel::Pitch:	return setPoint ? frame.SetPoints.Pitch : frame.QuadOrientation.x;
+	case AnalysisView::Channel::Roll:	return setPoint ? frame.SetPoints.Roll : frame.QuadOrientation.z;
+	case AnalysisView::Channel::Height:
+	default:							return setPoint ? frame.SetPoints.Height : frame.QuadPosition.y;
+	}
+}
+
+AnalysisView::AnalysisView()
+	:mChannel(Channel::Pitch)
+	,mAmplitude(5.0f)
+	,mMinFreq(0.2f)
+	,mMaxFreq(5.0f)
+	,mStartTime(3.0f)
+	,mSegmentSize(128)
+	,mStepStart(5.0f)
+	,mStepEnd(10.0f)
+	,mLogSampleRate(119.0f)
+	,mHasResponse(false)
+	,mHasStep(false)
+{
+	mCSVPath[0] = 0;
+}
+
+bool AnalysisView::RenderUI(Simulation& simulation)
+{
+	bool ranSimulation = false;
+	ImGui::Begin("Analysis");
+	{
+		if (ImGui::BeginCombo("Channel", Channel::ToStr(mChannel)))
+		{
+			for (int c = 0; c < Channel::COUNT; ++c)
+			{
+				if (ImGui::Selectable(Channel::ToStr((Channel::T)c), c == mChannel))
+				{
+					mChannel = (Channel::T)c;
+				}
+			}
+			ImGui::EndCombo();
+		}
+		ImGui::InputInt("Segment Size", &mSegmentSize);
+
+		if (ImGui::CollapsingHeader("Frequency Response"))
+		{
+			ImGui::InputFloat("Amplitude", &mAmplitude);
+			ImGui::InputFloat("Start Time", &mStartTime);
+			ImGui::InputFloat("Min Freq (Hz)", &mMinFreq);
+			ImGui::InputFloat("Max Freq (Hz)", &mMaxFreq);
+			if (ImGui::Button("Run Chirp"))
+			{
+				RunExcitation(simulation, true);
+				ranSimulation = true;
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Run PRBS"))
+			{
+				RunExcitation(simulation, false);
+				ranSimulation = true;
+			}
+
+			// Board logs, one "input,output" pair per line:
+			ImGui::InputText("Log CSV", mCSVPath, sizeof(mCSVPath));
+			ImGui::InputFloat("Log Sample Rate", &mLogSampleRate);
+			if (ImGui::Button("Analyze Log"))
+			{
+				std::vector<float> input, output;
+				if (LoadCSV(mCSVPath, input, output))
+				{
+					AnalyzeFrequency(input, output, mLogSampleRate);
+				}
+			}
+
+			if (mHasResponse)
+			{
+				int numBins = (int)mResponse.Frequency.size();
+				ImGui::Text("Resolution: %.3f Hz, %i bins", numBins > 1 ? mResponse.Frequency[1] : 0.0f, numBins);
+				ImGui::PlotLines("Magnitude (dB)", mResponse.MagnitudeDb.data(), numBins, 0, nullptr, FLT_MAX, FLT_MAX, ImVec2(512, 128));
+				ImGui::PlotLines("Phase (deg)", mResponse.PhaseDeg.data(), numBins, 0, nullptr, FLT_MAX, FLT_MAX, ImVec2(512, 128));
+				ImGui::PlotLines("Coherence", mResponse.Coherence.data(), numBins, 0, nullptr, 0.0f, 1.0f, ImVec2(512, 64));
+				ImGui::Text("Gain margin: %.2f dB at %.2f Hz", mResponse.GainMarginDb, mResponse.PhaseCrossoverHz);
+				ImGui::Text("Phase margin: %.2f deg at %.2f Hz", mResponse.PhaseMarginDeg, mResponse.GainCrossoverHz);
+			}
+		}
+
+		if (ImGui::CollapsingHeader("Step Response"))
+		{
+			ImGui::InputFloat("Step Start", &mStepStart);
+			ImGui::InputFloat("Step End", &mStepEnd);
+			if (ImGui::Button("Analyze Step") && simulation.HasResults())
+			{
+				AnalyzeStep(simulation.GetSimulationResults());
+			}
+			if (mHasStep)
+			{
+				ImGui::Text("Rise time: %.3f s", mStep.RiseTime);
+				ImGui::Text("Overshoot: %.1f %%", mStep.Overshoot);
+				ImGui::Text("Peak time: %.3f s", mStep.PeakTime);
+				ImGui::Text("Settling time (2%%): %.3f s", mStep.SettlingTime);
+				ImGui::Text("Steady state error: %.4f", mStep.SteadyStateError);
+			}
+		}
+	}
+	ImGui::End();
+	return ranSimulation;
+}
+
+void AnalysisView::RunExcitation(Simulation& simulation, bool chirp)
+{
+	// Hover at 1m, then excite the selected channel:
+	char excitation[256];
+	const char* channel = Channel::ToStr(mChannel);
+	float offset = mChannel == Channel::Height ? 1.0f : 0.0f;
+	if (chirp)
+	{
+		snprintf(excitation, sizeof(excitation), "chirp %s %f * %f %f %f %f\n", channel, mStartTime, offset, mAmplitude, mMinFreq, mMaxFreq);
+	}
+	else
+	{
+		// Bit time so the PRBS has power up to the max frequency:
+		float bitTime = 1.0f / (2.0f * mMaxFreq);
+		snprintf(excitation, sizeof(excitation), "prbs %s %f * %f %f %f 1\n", channel, mStartTime, offset, mAmplitude, bitTime);
+	}
+
+	std::string profile = "name Excitation\nstep thrust 0.5 * 1.0\nstep height 0.5 * 1.0\n";
+	profile += excitation;
+	std::string error;
+	if (!simulation.Profile.LoadFromString(profile, &error))
+	{
+		ERR("Invalid excitation profile: %s", error.c_str());
+		return;
+	}
+	simulation.RunSimulation();
+
+	std::vector<float> input, output;
+	ExtractSignals(simulation.GetSimulationResults(), mStartTime, input, output);
+	AnalyzeFrequency(input, output, 1.0f / simulation.DeltaTime);
+}
+
+void AnalysisView::ExtractSignals(const SimulationResult& result, float startTime, std::vector<float>& input, std::vector<float>& output)
+{
+	int first = (int)(startTime / result.DeltaTime);
+	input.clear();
+	output.clear();
+	for (int i = first; i < (int)result.Frames.size(); ++i)
+	{
+		input.push_back(GetChannel(result.Frames[i], mChannel, true));
+		output.push_back(GetChannel(result.Frames[i], mChannel, false));
+	}
+}
+
+void AnalysisView::AnalyzeFrequency(const std::vector<float>& input, const std::vector<float>& output, float sampleRate)
+{
+	mHasResponse = ResponseAnalysis::EstimateFrequencyResponse(input.data(), output.data(), (int)input.size(), sampleRate, mSegmentSize, mResponse);
+	if (!mHasResponse)
+	{
+		ERR("Frequency response needs at least %i samples and a power of two segment size", mSegmentSize);
+	}
+}
+
+void AnalysisView::AnalyzeStep(const SimulationResult& result)
+{
+	int first = (int)(mStepStart / result.DeltaTime);
+	int last = std::min((int)(mStepEnd / result.DeltaTime), (int)result.Frames.size());
+	if (first < 1 || last - first < 2)
+	{
+		mHasStep = false;
+		return;
+	}
+
+	std::vector<float> response;
+	for (int i = first; i < last; ++i)
+	{
+		response.push_back(GetChannel(result.Frames[i], mChannel, false));
+	}
+	float initial = GetChannel(result.Frames[first - 1], mChannel, false);
+	float target = GetChannel(result.Frames[first], mChannel, true);
+	mStep = ResponseAnalysis::ComputeStepMetrics(response.data(), (int)response.size(), result.DeltaTime, initial, target);
+	mHasStep = true;
+}
+
+bool AnalysisView::LoadCSV(const char* path, std::vector<float>& input, std::vector<float>& output)
+{
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		ERR("Could not open %s", path);
+		return false;
+	}
+	std::string line;
+	while (std::getline(file, line))
+	{
+		float in, out;
+		if (sscanf(line.c_str(), "%f,%f", &in, &out) == 2)
+		{
+			input.push_back(in);
+			output.push_back(out);
+		}
+	}
+	return !input.empty();
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "ResponseAnalysis.h"
+
+#include <vector>
+
+class Simulation;
+struct SimulationResult;
+
+// Analysis window: runs chirp/PRBS excitation through the simulation (or loads a board log
+// exported as CSV) and shows the Bode plots, margins and step response metrics.
+class AnalysisView
+{
+public:
+	struct Channel
+	{
+		enum T
+		{
+			Pitch,
+			Roll,
+			Height,
+			COUNT
+		};
+		static const char* ToStr(T t)
+		{
+			switch (t)
+			{
+			case Pitch:		return "pitch";
+			case Roll:		return "roll";
+			case Height:	return "height";
+			default:		return "invalid";
+			}
+		}
+	};
+
+	AnalysisView();
+
+	// Returns true if it ran a simulation (the caller may want to restart the visualization).
+	bool RenderUI(Simulation& simulation);
+
+private:
+	void RunExcitation(Simulation& simulation, bool chirp);
+	void ExtractSignals(const SimulationResult& result, float startTime, std::vector<float>& input, std::vector<float>& output);
+	void AnalyzeFrequency(const std::vector<float>& input, const std::vector<float>& output, float sampleRate);
+	void AnalyzeStep(const SimulationResult& result);
+	bool LoadCSV(const char* path, std::vector<float>& input, std::vector<float>& output);
+
+	Channel::T mChannel;
+	float mAmplitude;		// Degrees for the angles, meters for the height
+	float mMinFreq;
+	float mMaxFreq;
+	float mStartTime;		// Excitation starts after the take off
+	int mSegmentSize;
+	float mStepStart;
+	float mStepEnd;
+	float mLogSampleRate;
+	char mCSVPath[256];
+
+	bool mHasResponse;
+	FrequencyResponse mResponse;
+	bool mHasStep;
+	StepMetrics mStep;
+};
\ No newline at end of file
@@ -0,0 +1,430 @@
+#include "Comparison.h"
+#include "FFT.h"
+#include "Simulation.h"
+#include "Replay/FlightLog.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#include <xmmintrin.h>
+	#define COMPARISON_USE_SSE 1
+#else
+	#define COMPARISON_USE_SSE 0
+#endif
+
+static const float k_RadToDeg = 57.2957795f;
+
+ComparisonTrace ComparisonTrace::FromResult(const std::string& name, const SimulationResult& result)
+{
+	ComparisonTrace trace;
+	trace.Name = name;
+	trace.DeltaTime = result.DeltaTime;
+	trace.Offset = 0.0f;
+	const int numFrames = (int)result.Frames.size();
+	trace.Time.resize(numFrames);
+	for (int c = 0; c < Channel::COUNT; ++c)
+	{
+		trace.Values[c].resize(numFrames);
+	}
+	for (int f = 0; f < numFrames; ++f)
+	{
+		const SimulationFrame& frame = result.Frames[f];
+		trace.Time[f] = (float)((double)f * (double)result.DeltaTime);
+		trace.Values[Channel::Pitch][f] = frame.QuadOrientation.x * k_RadToDeg;
+		trace.Values[Channel::Roll][f] = frame.QuadOrientation.z * k_RadToDeg;
+		trace.Values[Channel::Yaw][f] = -frame.QuadOrientation.y * k_RadToDeg;	// As the board measures it
+		trace.Values[Channel::Height][f] = frame.QuadPosition.y;
+		trace.Values[Channel::Thrust][f] = frame.SetPoints.Thrust;
+		trace.Values[Channel::PitchSetPoint][f] = frame.SetPoints.Pitch * k_RadToDeg;
+		trace.Values[Channel::RollSetPoint][f] = frame.SetPoints.Roll * k_RadToDeg;
+	}
+	return trace;
+}
+
+ComparisonTrace ComparisonTrace::FromLog(const std::string& name, const FlightLogRecord* records, int numRecords)
+{
+	ComparisonTrace trace;
+	trace.Name = name;
+	trace.DeltaTime = 0.0f;
+	trace.Offset = 0.0f;
+	for (int r = 0; r < numRecords; ++r)
+	{
+		const FlightLogRecord& record = records[r];
+		if (!trace.Time.empty() && record.State.Time <= trace.Time.back())
+		{
+			continue;
+		}
+		trace.Time.push_back(record.State.Time);
+		trace.Values[Channel::Pitch].push_back(record.State.Pitch * k_RadToDeg);
+		trace.Values[Channel::Roll].push_back(record.State.Roll * k_RadToDeg);
+		trace.Values[Channel::Yaw].push_back(record.State.Yaw * k_RadToDeg);
+		trace.Values[Channel::Height].push_back(record.State.Height);
+		trace.Values[Channel::Thrust].push_back(record.SetPoints.Thrust);
+		trace.Values[Channel::PitchSetPoint].push_back(record.SetPoints.Pitch * k_RadToDeg);
+		trace.Values[Channel::RollSetPoint].push_back(record.SetPoints.Roll * k_RadToDeg);
+	}
+	return trace;
+}
+
+float ComparisonTrace::GetStartTime() const
+{
+	return Time.empty() ? 0.0f : Time.front();
+}
+
+float ComparisonTrace::GetEndTime() const
+{
+	return Time.empty() ? 0.0f : Time.back();
+}
+
+Comparison::Comparison()
+	:Reference(0)
+	,DeltaTime(0.01f)
+	,MaxLag(2.0f)
+	,Align(true)
+	,mNumSamples(0)
+	,mStartTime(0.0f)
+{
+}
+
+int Comparison::Add(const ComparisonTrace& trace)
+{
+	mTraces.push_back(trace);
+	return (int)mTraces.size() - 1;
+}
+
+void Comparison::Remove(int idx)
+{
+	mTraces.erase(mTraces.begin() + idx);
+	Reference = Reference > idx ? Reference - 1 : Reference;
+	Reference = std::min(Reference, std::max((int)mTraces.size() - 1, 0));
+	mNumSamples = 0;
+}
+
+void Comparison::Clear()
+{
+	mTraces.clear();
+	Reference = 0;
+	mNumSamples = 0;
+}
+
+int Comparison::GetNumTraces() const
+{
+	return (int)mTraces.size();
+}
+
+const ComparisonTrace& Comparison::GetTrace(int idx) const
+{
+	return mTraces[idx];
+}
+
+bool Comparison::Run()
+{
+	mNumSamples = 0;
+	mError.clear();
+	if (Reference < 0 || Reference >= (int)mTraces.size() || DeltaTime <= 0.0f)
+	{
+		mError = "No reference trace";
+		return false;
+	}
+	for (const ComparisonTrace& trace : mTraces)
+	{
+		if (trace.Time.empty())
+		{
+			mError = trace.Name + " is empty";
+			return false;
+		}
+	}
+
+	// Offsets from the alignment of pitch and roll, each trace resampled on its own span:
+	const int numTraces = (int)mTraces.size();
+	ComparisonTrace& reference = mTraces[Reference];
+	reference.Offset = 0.0f;
+	mScores.assign(numTraces, 1.0f);
+	std::vector<float> referenceValues[ComparisonTrace::Channel::COUNT];
+	std::vector<float> values[ComparisonTrace::Channel::COUNT];
+	if (Align)
+	{
+		const int numReference = (int)((reference.GetEndTime() - reference.GetStartTime()) / DeltaTime) + 1;
+		Resample(reference, reference.GetStartTime(), DeltaTime, numReference, referenceValues);
+	}
+	for (int t = 0; t < numTraces; ++t)
+	{
+		ComparisonTrace& trace = mTraces[t];
+		if (t == Reference)
+		{
+			continue;
+		}
+		trace.Offset = 0.0f;
+		if (Align)
+		{
+			const int numValues = (int)((trace.GetEndTime() - trace.GetStartTime()) / DeltaTime) + 1;
+			Resample(trace, trace.GetStartTime(), DeltaTime, numValues, values);
+			const float lag = EstimateLag(referenceValues, values, 2, DeltaTime, MaxLag, mScores[t]);
+			trace.Offset = reference.GetStartTime() - trace.GetStartTime() + lag;
+		}
+	}
+
+	// Common timebase over the span they all cover:
+	float start = -INFINITY;
+	float end = INFINITY;
+	for (const ComparisonTrace& trace : mTraces)
+	{
+		start = std::max(start, trace.GetStartTime() + trace.Offset);
+		end = std::min(end, trace.GetEndTime() + trace.Offset);
+	}
+	if (end < start)
+	{
+		mError = "The traces do not overlap";
+		return false;
+	}
+	mStartTime = start;
+	mNumSamples = (int)((end - start) / DeltaTime) + 1;
+	mResampled.resize(numTraces * ComparisonTrace::Channel::COUNT);
+	for (int t = 0; t < numTraces; ++t)
+	{
+		Resample(mTraces[t], start, DeltaTime, mNumSamples, &mResampled[t * ComparisonTrace::Channel::COUNT]);
+	}
+
+	// Errors against the reference:
+	mErrors.resize(numTraces * ComparisonTrace::Channel::COUNT);
+	for (int t = 0; t < numTraces; ++t)
+	{
+		for (int c = 0; c < ComparisonTrace::Channel::COUNT; ++c)
+		{
+			const float* ref = mResampled[Reference * ComparisonTrace::Channel::COUNT + c].data();
+			const float* cur = mResampled[t * ComparisonTrace::Channel::COUNT + c].data();
+			double sum = 0.0, sumSq = 0.0, maxAbs = 0.0;
+			double sumR = 0.0, sumC = 0.0, sumRR = 0.0, sumCC = 0.0, sumRC = 0.0;
+			for (int s = 0; s < mNumSamples; ++s)
+			{
+				const double r = ref[s];
+				const double v = cur[s];
+				const double d = v - r;
+				sum += d;
+				sumSq += d * d;
+				maxAbs = std::max(maxAbs, std::abs(d));
+				sumR += r;
+				sumC += v;
+				sumRR += r * r;
+				sumCC += v * v;
+				sumRC += r * v;
+			}
+			const double n = (double)mNumSamples;
+			const double varR = sumRR - sumR * sumR / n;
+			const double varC = sumCC - sumC * sumC / n;
+			const double cov = sumRC - sumR * sumC / n;
+			ComparisonError& error = mErrors[t * ComparisonTrace::Channel::COUNT + c];
+			error.Bias = (float)(sum / n);
+			error.Rmse = (float)std::sqrt(sumSq / n);
+			error.MaxAbs = (float)maxAbs;
+			error.Correlation = varR > 1e-12 && varC > 1e-12 ? (float)(cov / std::sqrt(varR * varC)) : 0.0f;
+		}
+	}
+	return true;
+}
+
+const std::string& Comparison::GetError() const
+{
+	return mError;
+}
+
+int Comparison::GetNumSamples() const
+{
+	return mNumSamples;
+}
+
+float Comparison::GetStartTime() const
+{
+	return mStartTime;
+}
+
+const float* Comparison::GetResampled(int trace, ComparisonTrace::Channel::T channel) const
+{
+	return mResampled[trace * ComparisonTrace::Channel::COUNT + channel].data();
+}
+
+const ComparisonError& Comparison::GetError(int trace, ComparisonTrace::Channel::T channel) const
+{
+	return mErrors[trace * ComparisonTrace::Channel::COUNT + channel];
+}
+
+float Comparison::GetAlignmentScore(int trace) const
+{
+	return mScores[trace];
+}
+
+void Comparison::Resample(const ComparisonTrace& trace, float start, float deltaTime, int numOut, std::vector<float>* out)
+{
+	// Segment and weight of every output sample, shared by the channels:
+	const int numIn = (int)trace.Time.size();
+	const int last = std::max(numIn - 1, 0);
+	std::vector<int> index(numOut);
+	std::vector<float> weight(numOut);
+	const double first = (double)trace.GetStartTime() + (double)trace.Offset;
+	if (trace.DeltaTime > 0.0f)
+	{
+		for (int k = 0; k < numOut; ++k)
+		{
+			const double x = std::min(std::max(((double)start + (double)k * deltaTime - first) / trace.DeltaTime, 0.0), (double)last);
+			index[k] = std::min((int)x, std::max(last - 1, 0));
+			weight[k] = (float)(x - (double)index[k]);
+		}
+	}
+	else
+	{
+		int j = 0;
+		for (int k = 0; k < numOut; ++k)
+		{
+			const double time = (double)start + (double)k * deltaTime - (double)trace.Offset;
+			while (j + 1 < last && (double)trace.Time[j + 1] <= time)
+			{
+				++j;
+			}
+			index[k] = j;
+			if (numIn < 2 || time <= (double)trace.Time[0])
+			{
+				weight[k] = 0.0f;
+			}
+			else if (time >= (double)trace.Time[last])
+			{
+				weight[k] = 1.0f;
+			}
+			else
+			{
+				weight[k] = (float)((time - trace.Time[j]) / ((double)trace.Time[j + 1] - trace.Time[j]));
+			}
+		}
+	}
+
+	// Per channel a gather and the lerps:
+	const int next = numIn > 1 ? 1 : 0;
+	std::vector<float> lo(numOut);
+	std::vector<float> hi(numOut);
+	for (int c = 0; c < ComparisonTrace::Channel::COUNT; ++c)
+	{
+		out[c].resize(numOut);
+		const std::vector<float>& values = trace.Values[c];
+		if (values.empty())
+		{
+			std::fill(out[c].begin(), out[c].end(), 0.0f);
+			continue;
+		}
+		for (int k = 0; k < numOut; ++k)
+		{
+			lo[k] = values[index[k]];
+			hi[k] = values[index[k] + next];
+		}
+		float* result = out[c].data();
+		int k = 0;
+#if COMPARISON_USE_SSE
+		for (; k + 4 <= numOut; k += 4)
+		{
+			const __m128 a = _mm_loadu_ps(&lo[k]);
+			const __m128 b = _mm_loadu_ps(&hi[k]);
+			const __m128 w = _mm_loadu_ps(&weight[k]);
+			_mm_storeu_ps(result + k, _mm_add_ps(a, _mm_mul_ps(w, _mm_sub_ps(b, a))));
+		}
+#endif
+		for (; k < numOut; ++k)
+		{
+			result[k] = lo[k] + weight[k] * (hi[k] - lo[k]);
+		}
+	}
+}
+
+float Comparison::EstimateLag(const std::vector<float>* reference, const std::vector<float>* signal, int numSignals, float deltaTime, float maxLag, float& score)
+{
+	score = 0.0f;
+	const int numReference = (int)reference[0].size();
+	const int numSignal = (int)signal[0].size();
+	if (numReference < 2 || numSignal < 2)
+	{
+		return 0.0f;
+	}
+
+	// Linear (zero padded) cross-correlation c[k] = sum r[n] s[n + k], summed over the signals:
+	int size = 1;
+	while (size < numReference + numSignal)
+	{
+		size *= 2;
+	}
+	FFT fft(size);
+	std::vector<float> refRe(size), refIm(size), sigRe(size), sigIm(size);
+	std::vector<float> corrRe(size, 0.0f), corrIm(size, 0.0f);
+	std::vector<float> means(2 * numSignals);
+	for (int s = 0; s < numSignals; ++s)
+	{
+		double refMean = 0.0, sigMean = 0.0;
+		for (float v : reference[s])
+		{
+			refMean += v;
+		}
+		for (float v : signal[s])
+		{
+			sigMean += v;
+		}
+		means[2 * s] = (float)(refMean / numReference);
+		means[2 * s + 1] = (float)(sigMean / numSignal);
+
+		std::fill(refRe.begin(), refRe.end(), 0.0f);
+		std::fill(refIm.begin(), refIm.end(), 0.0f);
+		std::fill(sigRe.begin(), sigRe.end(), 0.0f);
+		std::fill(sigIm.begin(), sigIm.end(), 0.0f);
+		for (int n = 0; n < numReference; ++n)
+		{
+			refRe[n] = reference[s][n] - means[2 * s];
+		}
+		for (int n = 0; n < numSignal; ++n)
+		{
+			sigRe[n] = signal[s][n] - means[2 * s + 1];
+		}
+		fft.Forward(refRe.data(), refIm.data());
+		fft.Forward(sigRe.data(), sigIm.data());
+
+		// conj(R) * S, conjugated again for the inverse below:
+		for (int k = 0; k < size; ++k)
+		{
+			corrRe[k] += refRe[k] * sigRe[k] + refIm[k] * sigIm[k];
+			corrIm[k] -= refRe[k] * sigIm[k] - refIm[k] * sigRe[k];
+		}
+	}
+
+	// Inverse as the conjugate of the forward transform of the conjugate (scale not needed):
+	fft.Forward(corrRe.data(), corrIm.data());
+
+	const int maxSamples = std::min((int)(maxLag / deltaTime), size / 2 - 1);
+	const int minK = -std::min(maxSamples, numReference - 1);
+	const int maxK = std::min(maxSamples, numSignal - 1);
+	auto at = [&](int k) { return corrRe[(k + size) % size]; };
+	int best = 0;
+	for (int k = minK; k <= maxK; ++k)
+	{
+		best = at(k) > at(best) ? k : best;
+	}
+
+	// Normalized correlation over the overlap at that lag:
+	double sumRS = 0.0, sumRR = 0.0, sumSS = 0.0;
+	for (int s = 0; s < numSignals; ++s)
+	{
+		for (int n = std::max(0, -best); n < numReference && n + best < numSignal; ++n)
+		{
+			const double r = reference[s][n] - means[2 * s];
+			const double v = signal[s][n + best] - means[2 * s + 1];
+			sumRS += r * v;
+			sumRR += r * r;
+			sumSS += v * v;
+		}
+	}
+	score = sumRR > 0.0 && sumSS > 0.0 ? (float)(sumRS / std::sqrt(sumRR * sumSS)) : 0.0f;
+
+	// Sub-sample peak, then the signal sample n + lag matches the reference sample n:
+	float lag = (float)best;
+	if (best > minK && best < maxK)
+	{
+		const float y0 = at(best - 1), y1 = at(best), y2 = at(best + 1);
+		const float denom = y0 - 2.0f * y1 + y2;
+		lag += denom < 0.0f ? 0.5f * (y0 - y2) / denom : 0.0f;
+	}
+	return -lag * deltaTime;
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct SimulationResult;
+struct FlightLogRecord;
+
+// A simulation run or a board log as time series, one array per channel. Angles in degrees.
+struct ComparisonTrace
+{
+	struct Channel
+	{
+		enum T
+		{
+			Pitch,
+			Roll,
+			Yaw,
+			Height,
+			Thrust,
+			PitchSetPoint,
+			RollSetPoint,
+			COUNT
+		};
+		static const char* ToStr(T t)
+		{
+			switch (t)
+			{
+			case Pitch:			return "Pitch";
+			case Roll:			return "Roll";
+			case Yaw:			return "Yaw";
+			case Height:		return "Height";
+			case Thrust:		return "Thrust";
+			case PitchSetPoint:	return "Pitch SP";
+			case RollSetPoint:	return "Roll SP";
+			default:			return "Invalid";
+			}
+		}
+	};
+
+	static ComparisonTrace FromResult(const std::string& name, const SimulationResult& result);
+	// Records out of order (or repeated times) are dropped.
+	static ComparisonTrace FromLog(const std::string& name, const FlightLogRecord* records, int numRecords);
+
+	float GetStartTime()const;
+	float GetEndTime()const;
+
+	std::string Name;
+	std::vector<float> Time;	// s, increasing
+	std::vector<float> Values[Channel::COUNT];
+	float DeltaTime;			// Of uniform traces (simulation runs), 0 if not uniform
+	float Offset;				// s added to Time, set by the alignment
+};
+
+// Per channel error of a trace against the reference, over the common timebase.
+struct ComparisonError
+{
+	float Bias;			// Mean of trace - reference
+	float Rmse;
+	float MaxAbs;
+	float Correlation;	// Pearson, 0 if either is constant
+};
+
+// Compares several runs and logs against a reference one. Run():
+// 1. Aligns every trace to the reference: both are resampled on their own span, the
+//    cross-correlation of the pitch and roll (mean removed) is computed with an FFT and its peak
+//    inside +-MaxLag (refined with a parabola) gives the offset.
+// 2. Resamples all the traces to a common timebase every DeltaTime over the span they overlap.
+// 3. Computes the error of each channel against the reference.
+//
+// Resampling is linear. The segment and weight of every output sample are found once per trace
+// (closed form for uniform traces, a merge pass otherwise) and shared by all the channels,
+// whose lerps then run 4 at a time with SSE. Long logs resample in a few ms.
+class Comparison
+{
+public:
+	Comparison();
+
+	int Add(const ComparisonTrace& trace);
+	void Remove(int idx);
+	void Clear();
+	int GetNumTraces()const;
+	const ComparisonTrace& GetTrace(int idx)const;
+
+	// False (see GetError) if there is no reference or the traces do not overlap.
+	bool Run();
+	const std::string& GetError()const;
+
+	// Results of the last Run():
+	int GetNumSamples()const;
+	float GetStartTime()const;
+	const float* GetResampled(int trace, ComparisonTrace::Channel::T channel)const;
+	const ComparisonError& GetError(int trace, ComparisonTrace::Channel::T channel)const;
+	float GetAlignmentScore(int trace)const;	// Normalized correlation at the chosen lag
+
+	// Samples of (time, values) at start + k * deltaTime, k < numOut. Outside of the trace the
+	// first or last value is held.
+	static void Resample(const ComparisonTrace& trace, float start, float deltaTime, int numOut, std::vector<float>* out);
+	// Time (s) to add to signal so it matches reference, both sampled every deltaTime with
+	// their first samples at the same time. score gets the normalized correlation at that lag.
+	static float EstimateLag(const std::vector<float>* reference, const std::vector<float>* signal, int numSignals, float deltaTime, float maxLag, float& score);
+
+	int Reference;
+	float DeltaTime;	// Common timebase
+	float MaxLag;		// s, searched both ways
+	bool Align;
+
+private:
+	std::vector<ComparisonTrace> mTraces;
+	std::string mError;
+	int mNumSamples;
+	float mStartTime;
+	std::vector<std::vector<float>> mResampled;		// [trace * Channel::COUNT + channel]
+	std::vector<ComparisonError> mErrors;			// Same layout
+	std::vector<float> mScores;
+};
\ No newline at end of file
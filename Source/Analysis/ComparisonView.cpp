@@ -0,0 +1,187 @@
+#include "ComparisonView.h"
+#include "Simulation.h"
+#include "ResultFile.h"
+#include "Replay/FlightLog.h"
+#include "Graphics/UI/IMGUI/imgui.h"
+
+#include <chrono>
+#include <cstdio>
+
+ComparisonView::ComparisonView()
+	:mNumSimulations(0)
+	,mHasResults(false)
+{
+	mPath[0] = 0;
+}
+
+void ComparisonView::RenderUI(const Simulation& simulation)
+{
+	ImGui::Begin("Compare");
+	{
+		// Sources:
+		if (simulation.HasResults() && ImGui::Button("Add Simulation"))
+		{
+			char name[32];
+			snprintf(name, sizeof(name), "Simulation %i", ++mNumSimulations);
+			mComparison.Add(ComparisonTrace::FromResult(name, simulation.GetSimulationResults()));
+			mHasResults = false;
+		}
+		ImGui::InputText("Result or Log", mPath, sizeof(mPath));
+		ImGui::SameLine();
+		if (ImGui::Button("Add File"))
+		{
+			AddFile();
+		}
+
+		const int numTraces = mComparison.GetNumTraces();
+		if (numTraces > 0)
+		{
+			const ComparisonTrace& reference = mComparison.GetTrace(mComparison.Reference);
+			if (ImGui::BeginCombo("Reference", reference.Name.c_str()))
+			{
+				for (int t = 0; t < numTraces; ++t)
+				{
+					if (ImGui::Selectable(mComparison.GetTrace(t).Name.c_str(), t == mComparison.Reference))
+					{
+						mComparison.Reference = t;
+						mHasResults = false;
+					}
+				}
+				ImGui::EndCombo();
+			}
+		}
+		int removed = -1;
+		for (int t = 0; t < numTraces; ++t)
+		{
+			const ComparisonTrace& trace = mComparison.GetTrace(t);
+			ImGui::PushID(t);
+			if (ImGui::Button("Remove"))
+			{
+				removed = t;
+			}
+			ImGui::SameLine();
+			ImGui::TextColored(ImGui::ColorConvertU32ToFloat4(PlotView::GetColor(t)), "%s: %.2f-%.2f s, %i samples, offset %.3f s", trace.Name.c_str(), trace.GetStartTime(), trace.GetEndTime(), (int)trace.Time.size(), trace.Offset);
+			ImGui::PopID();
+		}
+		if (removed >= 0)
+		{
+			mComparison.Remove(removed);
+			mHasResults = false;
+		}
+
+		ImGui::Separator();
+		ImGui::InputFloat("Time Step (s)", &mComparison.DeltaTime);
+		ImGui::Checkbox("Align", &mComparison.Align);
+		ImGui::SameLine();
+		ImGui::InputFloat("Max Lag (s)", &mComparison.MaxLag);
+		if (numTraces > 0 && ImGui::Button("Compare"))
+		{
+			Run();
+		}
+		ImGui::Text("%s", mStatus.c_str());
+
+		if (mHasResults)
+		{
+			// Errors against the reference:
+			if (ImGui::CollapsingHeader("Errors"))
+			{
+				for (int t = 0; t < numTraces; ++t)
+				{
+					if (t == mComparison.Reference)
+					{
+						continue;
+					}
+					ImGui::Text("%s (alignment %.3f)", mComparison.GetTrace(t).Name.c_str(), mComparison.GetAlignmentScore(t));
+					ImGui::Text("  Channel       bias     rmse      max      r");
+					for (int c = 0; c < ComparisonTrace::Channel::COUNT; ++c)
+					{
+						const ComparisonTrace::Channel::T channel = (ComparisonTrace::Channel::T)c;
+						const ComparisonError& error = mComparison.GetError(t, channel);
+						ImGui::Text("  %-9s %8.3f %8.3f %8.3f %6.3f", ComparisonTrace::Channel::ToStr(channel), error.Bias, error.Rmse, error.MaxAbs, error.Correlation);
+					}
+				}
+			}
+
+			// Overlays, the traces in their colors:
+			if (ImGui::CollapsingHeader("Plots"))
+			{
+				mPlotView.SetExtent(mComparison.GetNumSamples(), mComparison.DeltaTime);
+				const ImVec2 plotSize(512, 128);
+				std::vector<const PlotChannel*> channels(numTraces);
+				for (int c = 0; c < ComparisonTrace::Channel::COUNT; ++c)
+				{
+					for (int t = 0; t < numTraces; ++t)
+					{
+						channels[t] = &mPlotChannels[t * ComparisonTrace::Channel::COUNT + c];
+					}
+					mPlotView.Plot(ComparisonTrace::Channel::ToStr((ComparisonTrace::Channel::T)c), channels.data(), numTraces, 0.0f, 0.0f, plotSize);
+				}
+			}
+		}
+	}
+	ImGui::End();
+}
+
+void ComparisonView::AddFile()
+{
+	const std::string path = mPath;
+	const size_t slash = path.find_last_of("/\\");
+	const std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+	if (path.size() > 5 && path.compare(path.size() - 5, 5, ".qcol") == 0)
+	{
+		SimulationResult result;
+		std::string error;
+		if (!ResultFile::ReadColumns(path, result, &error))
+		{
+			mStatus = "Could not read " + path + ": " + error;
+			return;
+		}
+		mComparison.Add(ComparisonTrace::FromResult(name, result));
+	}
+	else
+	{
+		FlightLog log;
+		if (!log.Open(path))
+		{
+			mStatus = "Could not open the log " + path;
+			return;
+		}
+		mComparison.Add(ComparisonTrace::FromLog(name, log.GetRecords(), log.GetNumRecords()));
+	}
+	mHasResults = false;
+	mStatus = "Added " + name;
+}
+
+void ComparisonView::Run()
+{
+	const auto start = std::chrono::steady_clock::now();
+	mHasResults = mComparison.Run();
+	const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	if (!mHasResults)
+	{
+		mStatus = mComparison.GetError();
+		return;
+	}
+
+	const int numTraces = mComparison.GetNumTraces();
+	const int numSamples = mComparison.GetNumSamples();
+	mPlotChannels.resize(numTraces * ComparisonTrace::Channel::COUNT);
+	for (int t = 0; t < numTraces; ++t)
+	{
+		for (int c = 0; c < ComparisonTrace::Channel::COUNT; ++c)
+		{
+			PlotChannel& channel = mPlotChannels[t * ComparisonTrace::Channel::COUNT + c];
+			const float* values = mComparison.GetResampled(t, (ComparisonTrace::Channel::T)c);
+			channel.Clear();
+			for (int s = 0; s < numSamples; ++s)
+			{
+				channel.Append(values[s]);
+			}
+		}
+	}
+	mPlotView.ResetView();
+
+	char status[128];
+	snprintf(status, sizeof(status), "%i samples from %.2f s, %.1f ms", numSamples, mComparison.GetStartTime(), ms);
+	mStatus = status;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Comparison.h"
+#include "Plotting/PlotView.h"
+
+#include <string>
+#include <vector>
+
+class Simulation;
+
+// Compare window: overlays simulation runs, result files (.qcol) and board logs aligned in
+// time, and shows the error of every channel against the reference one (see Comparison).
+class ComparisonView
+{
+public:
+	ComparisonView();
+	void RenderUI(const Simulation& simulation);
+
+private:
+	void AddFile();
+	void Run();
+
+	Comparison mComparison;
+	char mPath[256];
+	int mNumSimulations;	// Added so far, for the names
+	std::string mStatus;
+	bool mHasResults;		// Of the current traces and reference, cleared when they change
+	std::vector<PlotChannel> mPlotChannels;	// [trace * Channel::COUNT + channel] of the last run
+	PlotView mPlotView;
+};
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "FFT.h"
+
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#include <xmmintrin.h>
+	#define FFT_USE_SSE 1
+#else
+	#define FFT_USE_SSE 0
+#endif
+
+static const double k_Pi = 3.14159265358979323846;
+
+FFT::FFT(int size)
+	:mSize(size)
+{
+	BuildTables(mSize, mBitReverse, mTwiddleRe, mTwiddleIm);
+
+	int half = mSize / 2;
+	BuildTables(half, mHalfBitReverse, mHalfTwiddleRe, mHalfTwiddleIm);
+	mSplitRe.resize(half + 1);
+	mSplitIm.resize(half + 1);
+	for (int k = 0; k <= half; ++k)
+	{
+		double angle = -2.0 * k_Pi * (double)k / (double)mSize;
+		mSplitRe[k] = (float)cos(angle);
+		mSplitIm[k] = (float)sin(angle);
+	}
+	mScratchRe.resize(half);
+	mScratchIm.resize(half);
+}
+
+int FFT::GetSize() const
+{
+	return mSize;
+}
+
+bool FFT::IsPowerOfTwo(int size)
+{
+	return size > 0 && (size & (size - 1)) == 0;
+}
+
+void FFT::BuildTables(int size, std::vector<int>& bitReverse, std::vector<float>& twRe, std::vector<float>& twIm)
+{
+	bitReverse.resize(size);
+	int numBits = 0;
+	while ((1 << numBits) < size)
+	{
+		++numBits;
+	}
+	for (int i = 0; i < size; ++i)
+	{
+		int r = 0;
+		for (int b = 0; b < numBits; ++b)
+		{
+			r |= ((i >> b) & 1) << (numBits - 1 - b);
+		}
+		bitReverse[i] = r;
+	}
+
+	// Stage with half size h uses twiddles [h - 1, 2h - 1), contiguous for the SIMD loop.
+	twRe.resize(size > 1 ? size - 1 : 0);
+	twIm.resize(size > 1 ? size - 1 : 0);
+	for (int half = 1; half < size; half *= 2)
+	{
+		for (int j = 0; j < half; ++j)
+		{
+			double angle = -k_Pi * (double)j / (double)half;
+			twRe[half - 1 + j] = (float)cos(angle);
+			twIm[half - 1 + j] = (float)sin(angle);
+		}
+	}
+}
+
+void FFT::Transform(float* re, float* im, int size, const std::vector<int>& bitReverse, const std::vector<float>& twRe, const std::vector<float>& twIm)
+{
+	for (int i = 0; i < size; ++i)
+	{
+		int j = bitReverse[i];
+		if (j > i)
+		{
+			float tr = re[i]; re[i] = re[j]; re[j] = tr;
+			float ti = im[i]; im[i] = im[j]; im[j] = ti;
+		}
+	}
+
+	for (int half = 1; half < size; half *= 2)
+	{
+		const float* wRe = &twRe[half - 1];
+		const float* wIm = &twIm[half - 1];
+		for (int base = 0; base < size; base += 2 * half)
+		{
+			float* aRe = re + base;
+			float* aIm = im + base;
+			float* bRe = aRe + half;
+			float* bIm = aIm + half;
+			int j = 0;
+#if FFT_USE_SSE
+			for (; j + 4 <= half; j += 4)
+			{
+				__m128 wr = _mm_loadu_ps(wRe + j);
+				__m128 wi = _mm_loadu_ps(wIm + j);
+				__m128 br = _mm_loadu_ps(bRe + j);
+				__m128 bi = _mm_loadu_ps(bIm + j);
+				__m128 vr = _mm_sub_ps(_mm_mul_ps(br, wr), _mm_mul_ps(bi, wi));
+				__m128 vi = _mm_add_ps(_mm_mul_ps(br, wi), _mm_mul_ps(bi, wr));
+				__m128 ur = _mm_loadu_ps(aRe + j);
+				__m128 ui = _mm_loadu_ps(aIm + j);
+				_mm_storeu_ps(aRe + j, _mm_add_ps(ur, vr));
+				_mm_storeu_ps(aIm + j, _mm_add_ps(ui, vi));
+				_mm_storeu_ps(bRe + j, _mm_sub_ps(ur, vr));
+				_mm_storeu_ps(bIm + j, _mm_sub_ps(ui, vi));
+			}
+#endif
+			for (; j < half; ++j)
+			{
+				float vr = bRe[j] * wRe[j] - bIm[j] * wIm[j];
+				float vi = bRe[j] * wIm[j] + bIm[j] * wRe[j];
+				float ur = aRe[j];
+				float ui = aIm[j];
+				aRe[j] = ur + vr;
+				aIm[j] = ui + vi;
+				bRe[j] = ur - vr;
+				bIm[j] = ui - vi;
+			}
+		}
+	}
+}
+
+void FFT::Forward(float* re, float* im)
+{
+	Transform(re, im, mSize, mBitReverse, mTwiddleRe, mTwiddleIm);
+}
+
+void FFT::ForwardReal(const float* input, std::complex<float>* output)
+{
+	// Pack even/odd samples as a complex signal of half the size:
+	int half = mSize / 2;
+	for (int k = 0; k < half; ++k)
+	{
+		mScratchRe[k] = input[2 * k];
+		mScratchIm[k] = input[2 * k + 1];
+	}
+	Transform(mScratchRe.data(), mScratchIm.data(), half, mHalfBitReverse, mHalfTwiddleRe, mHalfTwiddleIm);
+
+	// Split: X[k] = E[k] + W^k O[k], E = (Z[k] + conj(Z[h-k])) / 2, O = (Z[k] - conj(Z[h-k])) / 2i
+	for (int k = 0; k <= half; ++k)
+	{
+		int a = k % half;
+		int b = (half - k) % half;
+		float zr = mScratchRe[a], zi = mScratchIm[a];
+		float cr = mScratchRe[b], ci = -mScratchIm[b];
+		float er = 0.5f * (zr + cr);
+		float ei = 0.5f * (zi + ci);
+		float or_ = 0.5f * (zi - ci);
+		float oi = -0.5f * (zr - cr);
+		float wr = mSplitRe[k], wi = mSplitIm[k];
+		output[k] = std::complex<float>(er + or_ * wr - oi * wi, ei + or_ * wi + oi * wr);
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+
+// Radix-2 FFT for power of two sizes. Data is kept split (real and imaginary arrays) so the
+// butterflies of the wider stages run 4 at a time with SSE. Twiddles are precomputed per
+// stage and stored contiguously. Not thread safe, use one instance per thread.
+class FFT
+{
+public:
+	explicit FFT(int size);
+	int GetSize()const;
+
+	// In place complex forward transform of GetSize() points.
+	void Forward(float* re, float* im);
+
+	// Forward transform of GetSize() real samples, writes GetSize()/2 + 1 bins.
+	// Runs a half size complex transform plus a split pass.
+	void ForwardReal(const float* input, std::complex<float>* output);
+
+	static bool IsPowerOfTwo(int size);
+
+private:
+	void Transform(float* re, float* im, int size, const std::vector<int>& bitReverse, const std::vector<float>& twRe, const std::vector<float>& twIm);
+	static void BuildTables(int size, std::vector<int>& bitReverse, std::vector<float>& twRe, std::vector<float>& twIm);
+
+	int mSize;
+
+	// Full size tables:
+	std::vector<int> mBitReverse;
+	std::vector<float> mTwiddleRe;
+	std::vector<float> mTwiddleIm;
+
+	// Half size tables and scratch for the real transform:
+	std::vector<int> mHalfBitReverse;
+	std::vector<float> mHalfTwiddleRe;
+	std::vector<float> mHalfTwiddleIm;
+	std::vector<float> mSplitRe;
+	std::vector<float> mSplitIm;
+	std::vector<float> mScratchRe;
+	std::vector<float> mScratchIm;
+};
\ No newline at end of file
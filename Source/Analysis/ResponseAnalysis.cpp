@@ -0,0 +1,209 @@
+#include "ResponseAnalysis.h"
+#include "FFT.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+static const float k_Pi = 3.14159265358979f;
+
+// Feedback taps of maximum length LFSRs, indexed by order.
+static const uint32_t k_LFSRTaps[17] =
+{
+	0x0, 0x0, 0x3, 0x6, 0xC, 0x14, 0x30, 0x60, 0xB8, 0x110, 0x240, 0x500, 0x829, 0x100D, 0x2015, 0x6000, 0xD008
+};
+
+// Linear interpolation of the frequency where values crosses 'level' between i-1 and i.
+static float CrossingFrequency(const FrequencyResponse& r, const std::vector<float>& values, int i, float level)
+{
+	float t = (level - values[i - 1]) / (values[i] - values[i - 1]);
+	return r.Frequency[i - 1] + t * (r.Frequency[i] - r.Frequency[i - 1]);
+}
+
+static void ComputeMargins(FrequencyResponse& r, const std::vector<std::complex<float>>& closedLoop)
+{
+	r.GainMarginDb = 0.0f;
+	r.PhaseCrossoverHz = 0.0f;
+	r.PhaseMarginDeg = 0.0f;
+	r.GainCrossoverHz = 0.0f;
+
+	std::vector<float> openMagDb(closedLoop.size());
+	std::vector<float> openPhase(closedLoop.size());
+	float offset = 0.0f;
+	for (size_t i = 0; i < closedLoop.size(); ++i)
+	{
+		std::complex<float> open = closedLoop[i] / (std::complex<float>(1.0f, 0.0f) - closedLoop[i]);
+		openMagDb[i] = 20.0f * std::log10(std::max(std::abs(open), 1e-12f));
+		float phase = std::arg(open) * 180.0f / k_Pi + offset;
+		if (i > 0)
+		{
+			// Unwrap:
+			while (phase - openPhase[i - 1] > 180.0f) { phase -= 360.0f; offset -= 360.0f; }
+			while (phase - openPhase[i - 1] < -180.0f) { phase += 360.0f; offset += 360.0f; }
+		}
+		openPhase[i] = phase;
+	}
+
+	// Skip DC, the first crossings define the margins:
+	for (size_t i = 2; i < closedLoop.size(); ++i)
+	{
+		if (r.GainCrossoverHz == 0.0f && openMagDb[i - 1] >= 0.0f && openMagDb[i] < 0.0f)
+		{
+			r.GainCrossoverHz = CrossingFrequency(r, openMagDb, (int)i, 0.0f);
+			r.PhaseMarginDeg = 180.0f + openPhase[i];
+		}
+		if (r.PhaseCrossoverHz == 0.0f && openPhase[i - 1] > -180.0f && openPhase[i] <= -180.0f)
+		{
+			r.PhaseCrossoverHz = CrossingFrequency(r, openPhase, (int)i, -180.0f);
+			r.GainMarginDb = -openMagDb[i];
+		}
+	}
+}
+
+bool ResponseAnalysis::EstimateFrequencyResponse(const float* input, const float* output, int numSamples, float sampleRate, int segmentSize, FrequencyResponse& result)
+{
+	if (!FFT::IsPowerOfTwo(segmentSize) || segmentSize < 4 || numSamples < segmentSize)
+	{
+		return false;
+	}
+
+	int numBins = segmentSize / 2 + 1;
+	std::vector<float> window(segmentSize);
+	for (int i = 0; i < segmentSize; ++i)
+	{
+		window[i] = 0.5f - 0.5f * std::cos(2.0f * k_Pi * (float)i / (float)(segmentSize - 1));
+	}
+
+	FFT fft(segmentSize);
+	std::vector<float> segIn(segmentSize), segOut(segmentSize);
+	std::vector<std::complex<float>> specIn(numBins), specOut(numBins);
+	std::vector<std::complex<float>> sxy(numBins);
+	std::vector<float> sxx(numBins, 0.0f), syy(numBins, 0.0f);
+
+	// Welch averaging, the mean of each segment is removed:
+	int hop = segmentSize / 2;
+	for (int start = 0; start + segmentSize <= numSamples; start += hop)
+	{
+		float meanIn = 0.0f, meanOut = 0.0f;
+		for (int i = 0; i < segmentSize; ++i)
+		{
+			meanIn += input[start + i];
+			meanOut += output[start + i];
+		}
+		meanIn /= (float)segmentSize;
+		meanOut /= (float)segmentSize;
+		for (int i = 0; i < segmentSize; ++i)
+		{
+			segIn[i] = (input[start + i] - meanIn) * window[i];
+			segOut[i] = (output[start + i] - meanOut) * window[i];
+		}
+		fft.ForwardReal(segIn.data(), specIn.data());
+		fft.ForwardReal(segOut.data(), specOut.data());
+		for (int k = 0; k < numBins; ++k)
+		{
+			sxy[k] += std::conj(specIn[k]) * specOut[k];
+			sxx[k] += std::norm(specIn[k]);
+			syy[k] += std::norm(specOut[k]);
+		}
+	}
+
+	result.Frequency.resize(numBins);
+	result.MagnitudeDb.resize(numBins);
+	result.PhaseDeg.resize(numBins);
+	result.Coherence.resize(numBins);
+	std::vector<std::complex<float>> closedLoop(numBins);
+	float offset = 0.0f;
+	for (int k = 0; k < numBins; ++k)
+	{
+		closedLoop[k] = sxx[k] > 0.0f ? sxy[k] / sxx[k] : std::complex<float>(0.0f, 0.0f);
+		result.Frequency[k] = (float)k * sampleRate / (float)segmentSize;
+		result.MagnitudeDb[k] = 20.0f * std::log10(std::max(std::abs(closedLoop[k]), 1e-12f));
+		float phase = std::arg(closedLoop[k]) * 180.0f / k_Pi + offset;
+		if (k > 0)
+		{
+			while (phase - result.PhaseDeg[k - 1] > 180.0f) { phase -= 360.0f; offset -= 360.0f; }
+			while (phase - result.PhaseDeg[k - 1] < -180.0f) { phase += 360.0f; offset += 360.0f; }
+		}
+		result.PhaseDeg[k] = phase;
+		float denom = sxx[k] * syy[k];
+		result.Coherence[k] = denom > 0.0f ? std::norm(sxy[k]) / denom : 0.0f;
+	}
+
+	ComputeMargins(result, closedLoop);
+	return true;
+}
+
+StepMetrics ResponseAnalysis::ComputeStepMetrics(const float* response, int numSamples, float deltaTime, float initial, float target, float settleBand)
+{
+	StepMetrics metrics = {};
+	metrics.SettlingTime = -1.0f;
+	float step = target - initial;
+	if (numSamples <= 0 || step == 0.0f)
+	{
+		return metrics;
+	}
+
+	// Work with the normalized response (0 = initial, 1 = target):
+	int rise10 = -1, rise90 = -1, peakIdx = 0;
+	float peak = -1e30f;
+	int lastOutside = -1;
+	for (int i = 0; i < numSamples; ++i)
+	{
+		float n = (response[i] - initial) / step;
+		if (rise10 < 0 && n >= 0.1f) rise10 = i;
+		if (rise90 < 0 && n >= 0.9f) rise90 = i;
+		if (n > peak)
+		{
+			peak = n;
+			peakIdx = i;
+		}
+		if (std::fabs(n - 1.0f) > settleBand)
+		{
+			lastOutside = i;
+		}
+	}
+
+	metrics.RiseTime = rise10 >= 0 && rise90 >= 0 ? (float)(rise90 - rise10) * deltaTime : -1.0f;
+	metrics.Overshoot = std::max(peak - 1.0f, 0.0f) * 100.0f;
+	metrics.PeakTime = (float)peakIdx * deltaTime;
+	if (lastOutside < numSamples - 1)
+	{
+		metrics.SettlingTime = (float)(lastOutside + 1) * deltaTime;
+	}
+
+	int tailStart = numSamples - std::max(numSamples / 10, 1);
+	float tailError = 0.0f;
+	for (int i = tailStart; i < numSamples; ++i)
+	{
+		tailError += target - response[i];
+	}
+	metrics.SteadyStateError = tailError / (float)(numSamples - tailStart);
+	return metrics;
+}
+
+std::vector<float> ResponseAnalysis::GeneratePRBS(int numSamples, int order, int samplesPerBit, float amplitude, uint32_t seed)
+{
+	order = std::min(std::max(order, 2), 16);
+	samplesPerBit = std::max(samplesPerBit, 1);
+	uint32_t mask = (1u << order) - 1u;
+	uint32_t state = (seed & mask) ? (seed & mask) : 1u;
+
+	std::vector<float> sequence(numSamples > 0 ? numSamples : 0);
+	float value = amplitude;
+	for (int i = 0; i < numSamples; ++i)
+	{
+		if (i % samplesPerBit == 0)
+		{
+			// Galois LFSR:
+			uint32_t lsb = state & 1u;
+			state >>= 1;
+			if (lsb)
+			{
+				state ^= k_LFSRTaps[order];
+			}
+			value = lsb ? amplitude : -amplitude;
+		}
+		sequence[i] = value;
+	}
+	return sequence;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+// Frequency response estimated from an excitation (chirp/PRBS set point) and the measured output.
+struct FrequencyResponse
+{
+	std::vector<float> Frequency;	// Hz
+	std::vector<float> MagnitudeDb;
+	std::vector<float> PhaseDeg;	// Unwrapped
+	std::vector<float> Coherence;	// 0-1, how much of the output is explained by the input
+
+	// Margins of the open loop L = T / (1 - T), derived from the closed loop response T.
+	// Zero when there is no crossover inside the measured band.
+	float GainMarginDb;
+	float PhaseCrossoverHz;
+	float PhaseMarginDeg;
+	float GainCrossoverHz;
+};
+
+struct StepMetrics
+{
+	float RiseTime;			// 10% to 90% (s)
+	float Overshoot;		// % of the step
+	float PeakTime;			// s
+	float SettlingTime;		// Time to stay inside the band (s), -1 if it never settles
+	float SteadyStateError;	// Mean error over the last 10% of the window
+};
+
+namespace ResponseAnalysis
+{
+	// Welch estimate of H = Sxy / Sxx using Hann windowed segments of segmentSize (power of
+	// two) with 50% overlap. Returns false if there are not enough samples.
+	bool EstimateFrequencyResponse(const float* input, const float* output, int numSamples, float sampleRate, int segmentSize, FrequencyResponse& result);
+
+	// Step metrics of a response that starts at 'initial' and should reach 'target'.
+	StepMetrics ComputeStepMetrics(const float* response, int numSamples, float deltaTime, float initial, float target, float settleBand = 0.02f);
+
+	// Maximum length sequence (order 2-16) of +-amplitude, each bit held for samplesPerBit.
+	std::vector<float> GeneratePRBS(int numSamples, int order, int samplesPerBit, float amplitude, uint32_t seed);
+}
\ No newline at end of file
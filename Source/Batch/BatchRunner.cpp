@@ -0,0 +1,170 @@
+#include "BatchRunner.h"
+#include "Quad.h"
+#include "QuadFlyController.h"
+#include "UnityFlightController.h"
+#include "GainSetIO.h"
+#include "Jobs/JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+
+static const float k_Pi = 3.14159265358979f;
+static const float k_RadToDeg = 180.0f / k_Pi;
+
+static float WrapAngle(float angle)
+{
+	angle = std::fmod(angle + k_Pi, 2.0f * k_Pi);
+	return (angle < 0.0f ? angle + 2.0f * k_Pi : angle) - k_Pi;
+}
+
+static std::string FileStem(const std::string& path)
+{
+	size_t start = path.find_last_of("/\\");
+	start = start == std::string::npos ? 0 : start + 1;
+	size_t end = path.find_last_of('.');
+	return path.substr(start, end == std::string::npos || end < start ? std::string::npos : end - start);
+}
+
+bool BatchRunner::PrepareJob(const Scenario& scenario, const std::string& airframePath, BatchJob& job, std::string* error)
+{
+	job.Scn = scenario;
+	job.RecordImu = false;
+
+	const std::string& airframe = airframePath.empty() ? scenario.AirframePath : airframePath;
+	job.Airframe = QuadProfile();
+	if (!airframe.empty() && !QuadProfileIO::Load(airframe, job.Airframe, error))
+	{
+		return false;
+	}
+	job.AirframeName = job.Airframe.Name[0] ? job.Airframe.Name : airframe.empty() ? "Default" : FileStem(airframe);
+
+	job.Profile = SetPointProfile();
+	if (!scenario.ProfilePath.empty() && !job.Profile.LoadFromFile(scenario.ProfilePath, error))
+	{
+		return false;
+	}
+
+	job.HasGains = !scenario.GainsPath.empty();
+	if (job.HasGains && !GainSetIO::Load(scenario.GainsPath, job.Gains, error))
+	{
+		return false;
+	}
+	return true;
+}
+
+void BatchRunner::RunJob(const BatchJob& job, BatchResult& result, ResultCache* cache)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	const Scenario& scenario = job.Scn;
+	Quad quad;
+	quad.ApplyProfile(job.Airframe);
+
+	std::unique_ptr<BaseFlyController> controller;
+	if (scenario.Control == Scenario::Controller::Unity)
+	{
+		controller.reset(new UnityFlyController);
+	}
+	else
+	{
+		controller.reset(new QuadFlyController);
+	}
+	if (job.HasGains)
+	{
+		controller->SetGainSet(job.Gains);
+	}
+
+	Simulation simulation;
+	simulation.SetQuadTarget(&quad);
+	simulation.SetFlightController(controller.get());
+	simulation.Backend = Dynamics::Backend::RigidBody;
+	simulation.TotalSimTime = scenario.TotalSimTime;
+	simulation.DeltaTime = scenario.DeltaTime;
+	simulation.Seed = scenario.Seed;
+	simulation.Deterministic = true;
+	simulation.Cache = cache;
+	simulation.Env = scenario.Env;
+	simulation.EmulateSensors = scenario.EmulateSensors;
+	simulation.Sensors = scenario.Sensors;
+	simulation.RecordImu = job.RecordImu ? &result.Imu : nullptr;
+	simulation.Profile = job.Profile;
+	simulation.RunSimulation();
+
+	result.ScenarioName = scenario.Name;
+	result.AirframeName = job.AirframeName;
+	result.Result = simulation.GetSimulationResults();
+	ComputeMetrics(scenario, result.Result, result.Metrics);
+
+	result.Passed = true;
+	result.Expectations = scenario.Expectations;
+	result.ExpectationPassed.resize(scenario.Expectations.size());
+	for (size_t e = 0; e < scenario.Expectations.size(); ++e)
+	{
+		const Scenario::Expectation& expectation = scenario.Expectations[e];
+		result.ExpectationPassed[e] = expectation.Check(result.Metrics[expectation.Quantity]);
+		result.Passed = result.Passed && result.ExpectationPassed[e];
+	}
+
+	result.WallTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void BatchRunner::Run(const std::vector<BatchJob>& jobs, int numThreads, std::vector<BatchResult>& results, ResultCache* cache)
+{
+	results.clear();
+	results.resize(jobs.size());
+	if (jobs.empty())
+	{
+		return;
+	}
+
+	// One job per chunk, the runs are long and their lengths vary:
+	JobSystem::Get().ParallelFor((int)jobs.size(), numThreads, [&](int j)
+	{
+		RunJob(jobs[j], results[j], cache);
+	}, 1);
+}
+
+void BatchRunner::ComputeMetrics(const Scenario& scenario, const SimulationResult& result, float* metrics)
+{
+	const CowArray<SimulationFrame>& frames = result.Frames;
+	int first = (int)std::ceil(scenario.WindowStart / result.DeltaTime - 1e-4f);
+	int last = scenario.WindowEnd < 0.0f ? (int)frames.size() : (int)std::ceil(scenario.WindowEnd / result.DeltaTime - 1e-4f);
+	first = std::max(first, 0);
+	last = std::min(last, (int)frames.size());
+
+	double heightSq = 0.0;
+	double pitchSq = 0.0;
+	double rollSq = 0.0;
+	double yawSq = 0.0;
+	float heightMax = 0.0f;
+	float tiltMax = 0.0f;
+	float heightMin = last > first ? frames[first].QuadPosition.y : 0.0f;
+	for (int i = first; i < last; ++i)
+	{
+		const SimulationFrame& frame = frames[i];
+		float heightError = frame.QuadPosition.y - frame.SetPoints.Height;
+		float pitchError = WrapAngle(frame.QuadOrientation.x - frame.SetPoints.Pitch) * k_RadToDeg;
+		float yawError = WrapAngle(-frame.QuadOrientation.y - frame.SetPoints.Yaw) * k_RadToDeg;
+		float rollError = WrapAngle(frame.QuadOrientation.z - frame.SetPoints.Roll) * k_RadToDeg;
+		heightSq += (double)heightError * heightError;
+		pitchSq += (double)pitchError * pitchError;
+		yawSq += (double)yawError * yawError;
+		rollSq += (double)rollError * rollError;
+		heightMax = std::max(heightMax, std::fabs(heightError));
+		float tilt = std::max(std::fabs(WrapAngle(frame.QuadOrientation.x)), std::fabs(WrapAngle(frame.QuadOrientation.z))) * k_RadToDeg;
+		tiltMax = std::max(tiltMax, tilt);
+		heightMin = std::min(heightMin, frame.QuadPosition.y);
+	}
+
+	const double count = (double)std::max(last - first, 1);
+	metrics[Scenario::Metric::HeightRms] = (float)std::sqrt(heightSq / count);
+	metrics[Scenario::Metric::HeightMaxError] = heightMax;
+	metrics[Scenario::Metric::HeightFinalError] = last > first ? std::fabs(frames[last - 1].QuadPosition.y - frames[last - 1].SetPoints.Height) : 0.0f;
+	metrics[Scenario::Metric::PitchRms] = (float)std::sqrt(pitchSq / count);
+	metrics[Scenario::Metric::RollRms] = (float)std::sqrt(rollSq / count);
+	metrics[Scenario::Metric::YawRms] = (float)std::sqrt(yawSq / count);
+	metrics[Scenario::Metric::MaxTilt] = tiltMax;
+	metrics[Scenario::Metric::MinHeight] = heightMin;
+}
\ No newline at end of file
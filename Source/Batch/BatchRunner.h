@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Scenario.h"
+#include "QuadProfile.h"
+#include "GainSet.h"
+#include "SetPointProfile.h"
+#include "Simulation.h"
+
+#include <string>
+#include <vector>
+
+class ResultCache;
+
+// One simulation of a batch: a scenario flown by one airframe. All the inputs are loaded by
+// PrepareJob, so running the jobs does no file IO and any number of them can run in parallel.
+// Runs are deterministic, a job gives the same bits on any worker and with any thread count.
+struct BatchJob
+{
+	Scenario Scn;
+	std::string AirframeName;
+	QuadProfile Airframe;
+	SetPointProfile Profile;
+	GainSet Gains;
+	bool HasGains;	// Otherwise the controller defaults
+	bool RecordImu;	// Keep the estimator inputs in the result (sensors on only), bypasses the cache lookups
+};
+
+struct BatchResult
+{
+	std::string ScenarioName;
+	std::string AirframeName;
+	SimulationResult Result;
+	ImuTrace Imu;	// Empty unless the job records it
+	float Metrics[Scenario::Metric::COUNT];
+	std::vector<Scenario::Expectation> Expectations;
+	std::vector<bool> ExpectationPassed;
+	bool Passed;
+	double WallTimeMs;
+};
+
+namespace BatchRunner
+{
+	// Loads the profile, gains and airframe of a scenario. An empty airframePath uses the
+	// scenario one (or the default airframe if there is none).
+	bool PrepareJob(const Scenario& scenario, const std::string& airframePath, BatchJob& job, std::string* error = nullptr);
+
+	// Runs on the shared JobSystem, numThreads at once (<= 0 uses all of it). results[i] is the
+	// result of jobs[i].
+	// With a cache, jobs already run with the same inputs are loaded instead.
+	void Run(const std::vector<BatchJob>& jobs, int numThreads, std::vector<BatchResult>& results, ResultCache* cache = nullptr);
+
+	// Single job, used by the workers.
+	void RunJob(const BatchJob& job, BatchResult& result, ResultCache* cache = nullptr);
+
+	void ComputeMetrics(const Scenario& scenario, const SimulationResult& result, float* metrics);
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include "ResultWriter.h"
+#include "BatchRunner.h"
+
+#include <cmath>
+#include <cstdio>
+
+static void WriteString(FILE* file, const std::string& str)
+{
+	fputc('"', file);
+	for (char c : str)
+	{
+		switch (c)
+		{
+		case '"':	fputs("\\\"", file); break;
+		case '\\':	fputs("\\\\", file); break;
+		case '\n':	fputs("\\n", file); break;
+		case '\t':	fputs("\\t", file); break;
+		default:
+			if ((unsigned char)c < 0x20)
+			{
+				fprintf(file, "\\u%04x", (unsigned)c);
+			}
+			else
+			{
+				fputc(c, file);
+			}
+		}
+	}
+	fputc('"', file);
+}
+
+// JSON has no NaN/Inf, a diverged run reports null.
+static void WriteNumber(FILE* file, double value)
+{
+	if (std::isfinite(value))
+	{
+		fprintf(file, "%.9g", value);
+	}
+	else
+	{
+		fputs("null", file);
+	}
+}
+
+bool ResultWriter::WriteSummary(const std::string& path, const std::vector<BatchResult>& results, const std::vector<std::vector<std::string>>& outputs)
+{
+	FILE* file = fopen(path.c_str(), "w");
+	if (!file)
+	{
+		return false;
+	}
+
+	int numPassed = 0;
+	fprintf(file, "{\n\t\"runs\": [");
+	for (size_t r = 0; r < results.size(); ++r)
+	{
+		const BatchResult& result = results[r];
+		numPassed += result.Passed ? 1 : 0;
+
+		fprintf(file, r == 0 ? "\n\t\t{\n" : ",\n\t\t{\n");
+		fprintf(file, "\t\t\t\"scenario\": ");
+		WriteString(file, result.ScenarioName);
+		fprintf(file, ",\n\t\t\t\"airframe\": ");
+		WriteString(file, result.AirframeName);
+		fprintf(file, ",\n\t\t\t\"passed\": %s", result.Passed ? "true" : "false");
+		fprintf(file, ",\n\t\t\t\"frames\": %d", (int)result.Result.Frames.size());
+		fprintf(file, ",\n\t\t\t\"checksum\": \"%016llx\"", (unsigned long long)result.Result.GetChecksum());
+		fprintf(file, ",\n\t\t\t\"delta_time\": ");
+		WriteNumber(file, result.Result.DeltaTime);
+		fprintf(file, ",\n\t\t\t\"wall_time_ms\": ");
+		WriteNumber(file, result.WallTimeMs);
+
+		fprintf(file, ",\n\t\t\t\"metrics\": {");
+		for (int m = 0; m < Scenario::Metric::COUNT; ++m)
+		{
+			fprintf(file, m == 0 ? "\n\t\t\t\t\"%s\": " : ",\n\t\t\t\t\"%s\": ", Scenario::Metric::ToStr((Scenario::Metric::T)m));
+			WriteNumber(file, result.Metrics[m]);
+		}
+		fprintf(file, "\n\t\t\t}");
+
+		fprintf(file, ",\n\t\t\t\"expectations\": [");
+		for (size_t e = 0; e < result.Expectations.size(); ++e)
+		{
+			const Scenario::Expectation& expectation = result.Expectations[e];
+			fprintf(file, e == 0 ? "\n" : ",\n");
+			fprintf(file, "\t\t\t\t{ \"metric\": \"%s\", \"op\": \"%s\", \"value\": ", Scenario::Metric::ToStr(expectation.Quantity), Scenario::Op::ToStr(expectation.Compare));
+			WriteNumber(file, expectation.Value);
+			fprintf(file, ", \"actual\": ");
+			WriteNumber(file, result.Metrics[expectation.Quantity]);
+			fprintf(file, ", \"passed\": %s }", result.ExpectationPassed[e] ? "true" : "false");
+		}
+		fprintf(file, result.Expectations.empty() ? "]" : "\n\t\t\t]");
+
+		fprintf(file, ",\n\t\t\t\"outputs\": [");
+		const std::vector<std::string>& files = r < outputs.size() ? outputs[r] : std::vector<std::string>();
+		for (size_t f = 0; f < files.size(); ++f)
+		{
+			fprintf(file, f == 0 ? "" : ", ");
+			WriteString(file, files[f]);
+		}
+		fprintf(file, "]\n\t\t}");
+	}
+	fprintf(file, results.empty() ? "],\n" : "\n\t],\n");
+	fprintf(file, "\t\"passed\": %d,\n\t\"failed\": %d\n}\n", numPassed, (int)results.size() - numPassed);
+	return fclose(file) == 0;
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct BatchResult;
+
+namespace ResultWriter
+{
+	// Metrics, expectations and output files of every run plus the pass/fail totals.
+	// outputs[i] lists the files written for results[i].
+	bool WriteSummary(const std::string& path, const std::vector<BatchResult>& results, const std::vector<std::vector<std::string>>& outputs);
+}
\ No newline at end of file
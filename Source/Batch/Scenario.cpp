@@ -0,0 +1,255 @@
+#include "Scenario.h"
+#include "IO/Directory.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+const char* Scenario::Controller::ToStr(T t)
+{
+	switch (t)
+	{
+	case Quad:	return "quad";
+	case Unity:	return "unity";
+	default:	return "invalid";
+	}
+}
+
+const char* Scenario::Metric::ToStr(T t)
+{
+	switch (t)
+	{
+	case HeightRms:			return "height_rms";
+	case HeightMaxError:	return "height_max_error";
+	case HeightFinalError:	return "height_final_error";
+	case PitchRms:			return "pitch_rms";
+	case RollRms:			return "roll_rms";
+	case YawRms:			return "yaw_rms";
+	case MaxTilt:			return "max_tilt";
+	case MinHeight:			return "min_height";
+	default:				return "invalid";
+	}
+}
+
+bool Scenario::Metric::FromStr(const std::string& str, T& t)
+{
+	for (int m = 0; m < COUNT; ++m)
+	{
+		if (str == ToStr((T)m))
+		{
+			t = (T)m;
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* Scenario::Op::ToStr(T t)
+{
+	switch (t)
+	{
+	case Less:			return "<";
+	case LessEqual:		return "<=";
+	case Greater:		return ">";
+	case GreaterEqual:	return ">=";
+	default:			return "?";
+	}
+}
+
+bool Scenario::Op::FromStr(const std::string& str, T& t)
+{
+	for (int o = Less; o <= GreaterEqual; ++o)
+	{
+		if (str == ToStr((T)o))
+		{
+			t = (T)o;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool Scenario::Expectation::Check(float actual) const
+{
+	switch (Compare)
+	{
+	case Op::Less:			return actual < Value;
+	case Op::LessEqual:		return actual <= Value;
+	case Op::Greater:		return actual > Value;
+	case Op::GreaterEqual:	return actual >= Value;
+	default:				return false;
+	}
+}
+
+// "Ground Effect" -> "ground_effect"
+static std::string ModelKey(const char* name)
+{
+	std::string key = name;
+	for (char& c : key)
+	{
+		c = c == ' ' ? '_' : (char)tolower((unsigned char)c);
+	}
+	return key;
+}
+
+static std::string ResolvePath(const std::string& baseDir, const std::string& path)
+{
+	bool absolute = !path.empty() && (path[0] == '/' || path[0] == '\\' || (path.size() > 1 && path[1] == ':'));
+	return absolute || baseDir.empty() ? path : Directory::Join(baseDir, path);
+}
+
+Scenario::Scenario()
+	:Name("Unnamed")
+	,Control(Controller::Quad)
+	,TotalSimTime(15.0f)
+	,DeltaTime(0.05f)
+	,Seed(1)
+	,EmulateSensors(false)
+	,WindowStart(0.0f)
+	,WindowEnd(-1.0f)
+{
+}
+
+bool Scenario::LoadFromFile(const std::string& path, std::string* error)
+{
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		if (error)
+		{
+			*error = "Could not open " + path;
+		}
+		return false;
+	}
+	std::stringstream text;
+	text << file.rdbuf();
+
+	size_t separator = path.find_last_of("/\\");
+	std::string baseDir = separator == std::string::npos ? std::string() : path.substr(0, separator);
+	if (!LoadFromString(text.str(), baseDir, error))
+	{
+		if (error)
+		{
+			*error = path + ": " + *error;
+		}
+		return false;
+	}
+	return true;
+}
+
+bool Scenario::LoadFromString(const std::string& text, const std::string& baseDir, std::string* error)
+{
+	// Parse into a copy so a bad scenario leaves this one untouched:
+	Scenario scenario;
+	std::istringstream lines(text);
+	std::string line;
+	int lineIdx = 0;
+	while (std::getline(lines, line))
+	{
+		++lineIdx;
+		std::istringstream tokens(line);
+		std::string key;
+		if (!(tokens >> key) || key[0] == '#')
+		{
+			continue;
+		}
+
+		bool ok = true;
+		std::string value;
+		if (key == "name")
+		{
+			std::getline(tokens >> std::ws, scenario.Name);
+			ok = !scenario.Name.empty();
+		}
+		else if (key == "profile" || key == "airframe" || key == "gains")
+		{
+			ok = (bool)(tokens >> value);
+			std::string& path = key == "profile" ? scenario.ProfilePath : key == "airframe" ? scenario.AirframePath : scenario.GainsPath;
+			path = ResolvePath(baseDir, value);
+		}
+		else if (key == "controller")
+		{
+			ok = false;
+			tokens >> value;
+			for (int c = 0; c < Controller::COUNT && !ok; ++c)
+			{
+				ok = value == Controller::ToStr((Controller::T)c);
+				scenario.Control = ok ? (Controller::T)c : scenario.Control;
+			}
+		}
+		else if (key == "time")		ok = (bool)(tokens >> scenario.TotalSimTime) && scenario.TotalSimTime > 0.0f;
+		else if (key == "dt")		ok = (bool)(tokens >> scenario.DeltaTime) && scenario.DeltaTime > 0.0f;
+		else if (key == "seed")		ok = (bool)(tokens >> scenario.Seed);
+		else if (key == "ground")	ok = (bool)(tokens >> scenario.Env.GroundHeight);
+		else if (key == "wind")		ok = (bool)(tokens >> scenario.Env.WindVelocity.x >> scenario.Env.WindVelocity.y >> scenario.Env.WindVelocity.z);
+		else if (key == "gusts")	ok = (bool)(tokens >> scenario.Env.GustIntensity >> scenario.Env.GustLengthScale);
+		else if (key == "env")
+		{
+			std::string state;
+			ok = (bool)(tokens >> value >> state) && (state == "on" || state == "off");
+			bool found = false;
+			for (int m = 0; m < Environment::Model::COUNT && ok; ++m)
+			{
+				if (value == ModelKey(Environment::Model::ToStr((Environment::Model::T)m)))
+				{
+					scenario.Env.Enabled[m] = state == "on";
+					found = true;
+				}
+			}
+			ok = ok && found;
+		}
+		else if (key == "sensors")
+		{
+			ok = (bool)(tokens >> value) && (value == "on" || value == "off");
+			scenario.EmulateSensors = value == "on";
+		}
+		else if (key == "sensor")
+		{
+			std::string state;
+			ok = (bool)(tokens >> value >> state) && (state == "on" || state == "off");
+			bool found = false;
+			for (int s = 0; s < SensorModel::Stage::COUNT && ok; ++s)
+			{
+				if (value == ModelKey(SensorModel::Stage::ToStr((SensorModel::Stage::T)s)))
+				{
+					scenario.Sensors.Enabled[s] = state == "on";
+					found = true;
+				}
+			}
+			ok = ok && found;
+		}
+		else if (key == "window")
+		{
+			std::string end;
+			ok = (bool)(tokens >> scenario.WindowStart >> end);
+			scenario.WindowEnd = end == "*" ? -1.0f : (float)atof(end.c_str());
+		}
+		else if (key == "expect")
+		{
+			std::string metric, op;
+			Expectation expectation;
+			ok = (bool)(tokens >> metric >> op >> expectation.Value) && Metric::FromStr(metric, expectation.Quantity) && Op::FromStr(op, expectation.Compare);
+			scenario.Expectations.push_back(expectation);
+		}
+		else
+		{
+			if (error)
+			{
+				*error = "Line " + std::to_string(lineIdx) + ": unknown key " + key;
+			}
+			return false;
+		}
+
+		if (!ok)
+		{
+			if (error)
+			{
+				*error = "Line " + std::to_string(lineIdx) + ": invalid value for " + key;
+			}
+			return false;
+		}
+	}
+	*this = scenario;
+	return true;
+}
\ No newline at end of file
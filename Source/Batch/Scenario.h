@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Environment.h"
+#include "Sensors/SensorModel.h"
+
+#include <string>
+#include <vector>
+
+// Headless run description used by the batch tools (quadsim). Text format, one key per line:
+//
+//   name       <scenario name>
+//   profile    <set point profile path>
+//   airframe   <quad profile path>
+//   gains      <gain set path>
+//   controller quad|unity
+//   time       <total simulation time s>
+//   dt         <delta time s>
+//   seed       <run seed>
+//   ground     <ground height m>
+//   env        <model> on|off
+//   wind       <x> <y> <z>
+//   gusts      <intensity m/s> <length scale m>
+//   sensors    on|off
+//   sensor     <stage> on|off
+//   window     <start> <end>
+//   expect     <metric> <op> <value>
+//
+// Paths are relative to the scenario file, missing ones use the built in defaults. Models
+// are the Environment ones in lower case with '_' (linear_drag, ground_effect...). With
+// sensors on the controller flies on the board estimator fed by the IMU emulation, stages
+// are the SensorModel ones in lower case (misalignment, bias...). Metrics
+// are computed over the window ('*' as the end means the end of the run), ops are < <= > >=.
+// Lines starting with '#' are comments.
+struct Scenario
+{
+	struct Controller
+	{
+		enum T
+		{
+			Quad,
+			Unity,
+			COUNT
+		};
+		static const char* ToStr(T t);
+	};
+
+	// Scalar results of a run, angles in degrees like the profiles.
+	struct Metric
+	{
+		enum T
+		{
+			HeightRms,			// Height error against the height set point (m)
+			HeightMaxError,
+			HeightFinalError,
+			PitchRms,			// Attitude error against the set points
+			RollRms,
+			YawRms,
+			MaxTilt,			// Largest pitch or roll
+			MinHeight,
+			COUNT
+		};
+		static const char* ToStr(T t);
+		static bool FromStr(const std::string& str, T& t);
+	};
+
+	struct Op
+	{
+		enum T
+		{
+			Less,
+			LessEqual,
+			Greater,
+			GreaterEqual
+		};
+		static const char* ToStr(T t);
+		static bool FromStr(const std::string& str, T& t);
+	};
+
+	struct Expectation
+	{
+		Metric::T Quantity;
+		Op::T Compare;
+		float Value;
+		bool Check(float actual)const;
+	};
+
+	Scenario();
+	bool LoadFromFile(const std::string& path, std::string* error = nullptr);
+	// baseDir resolves the relative paths.
+	bool LoadFromString(const std::string& text, const std::string& baseDir, std::string* error = nullptr);
+
+	std::string Name;
+	std::string ProfilePath;
+	std::string AirframePath;
+	std::string GainsPath;
+	Controller::T Control;
+	float TotalSimTime;
+	float DeltaTime;
+	uint32_t Seed;
+	Environment Env;
+	bool EmulateSensors;
+	SensorModel Sensors;
+	float WindowStart;
+	float WindowEnd;	// < 0 is the end of the run
+	std::vector<Expectation> Expectations;
+};
\ No newline at end of file
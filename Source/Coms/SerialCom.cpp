@@ -81,12 +81,19 @@ void SerialCom::RenderUI()
 
 bool SerialCom::IsConnected() const
 {
+	std::lock_guard<std::mutex> lock(mMutex);
 	return mPortHandle != INVALID_HANDLE_VALUE;
 }
 
 void SerialCom::CloseConnection()
 {
-	if (IsConnected())
+	std::lock_guard<std::mutex> lock(mMutex);
+	ClosePort();
+}
+
+void SerialCom::ClosePort()
+{
+	if (mPortHandle != INVALID_HANDLE_VALUE)
 	{
 		CloseHandle(mPortHandle);
 		mPortHandle = INVALID_HANDLE_VALUE;
@@ -95,9 +102,10 @@ void SerialCom::CloseConnection()
 
 void SerialCom::UpdateBaudRate(BaudRate::T newRate)
 {
+	std::lock_guard<std::mutex> lock(mMutex);
 	mBaudRate = newRate; // Always cache it for the UI
 
-	if (!IsConnected()) 
+	if (mPortHandle == INVALID_HANDLE_VALUE)
 	{
 		return;
 	}
@@ -121,7 +129,8 @@ void SerialCom::UpdateBaudRate(BaudRate::T newRate)
 
 void SerialCom::Connect(std::string port)
 {
-	CloseConnection();
+	std::lock_guard<std::mutex> lock(mMutex);
+	ClosePort();
 	mPortHandle = CreateFileA(port.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
 	if (mPortHandle == INVALID_HANDLE_VALUE)
 	{
@@ -160,7 +169,8 @@ void SerialCom::Connect(std::string port)
 
 int SerialCom::ReadBytes(char * buffer, int size)
 {
-	if (!IsConnected())
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (mPortHandle == INVALID_HANDLE_VALUE)
 	{
 		return 0;
 	}
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <mutex>
 #include <vector>
 #include <string>
 
 typedef void* PortHandle;
 
+// Serial port of the board. ReadBytes can be called from another thread (TelemetryStream)
+// while the UI connects or closes the port.
 class SerialCom
 {
 public:
@@ -41,6 +44,9 @@ public:
 	static std::vector<std::string> GetSerialPorts();
 
 private:
+	void ClosePort();	// mMutex locked
+
+	mutable std::mutex mMutex;
 	std::vector<std::string> mCurPorts;
 	std::string mActivePort;
 	PortHandle mPortHandle;
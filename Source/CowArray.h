@@ -0,0 +1,161 @@
+#pragma once
+
+#include <stddef.h>
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+// Array stored in fixed size chunks that are shared between copies. Copying only copies the
+// chunk pointers, a chunk is duplicated the first time a copy writes to it (Edit), so forks
+// of a simulation share every frame before the fork point. Reads never duplicate anything,
+// writes go through Edit() to make that explicit.
+// Copies can be used from different threads, a chunk is only written when no other copy
+// references it. The chunks count their references themselves: dropping one is a release and
+// Edit() reads the count with acquire, so the reads of a copy on another thread are done
+// before its chunk is written in place (shared_ptr::use_count() is a relaxed load).
+template<typename T, size_t ChunkSize = 512>
+class CowArray
+{
+public:
+	CowArray()
+		:mSize(0)
+	{
+	}
+
+	size_t size()const { return mSize; }
+	bool empty()const { return mSize == 0; }
+	const T& operator[](size_t index)const { return mChunks[index / ChunkSize].Get()->Items[index % ChunkSize]; }
+
+	T& Edit(size_t index)
+	{
+		ChunkRef& chunk = mChunks[index / ChunkSize];
+		if (chunk.IsShared())
+		{
+			chunk = ChunkRef(new Chunk(*chunk.Get()));
+		}
+		return chunk.Get()->Items[index % ChunkSize];
+	}
+
+	void clear()
+	{
+		mChunks.clear();
+		mSize = 0;
+	}
+
+	// New elements are value initialized, same as std::vector.
+	void resize(size_t size)
+	{
+		const size_t oldSize = mSize;
+		mChunks.resize((size + ChunkSize - 1) / ChunkSize);
+		for (ChunkRef& chunk : mChunks)
+		{
+			if (!chunk.Get())
+			{
+				chunk = ChunkRef(new Chunk());
+			}
+		}
+		mSize = size;
+
+		// The tail of the last old chunk may hold stale elements:
+		const size_t end = std::min(size, (oldSize + ChunkSize - 1) / ChunkSize * ChunkSize);
+		for (size_t i = oldSize; i < end; ++i)
+		{
+			Edit(i) = T();
+		}
+	}
+
+	// Elements in chunks shared with another copy.
+	size_t GetNumShared()const
+	{
+		size_t numShared = 0;
+		for (size_t c = 0; c < mChunks.size(); ++c)
+		{
+			if (mChunks[c].IsShared())
+			{
+				numShared += std::min(ChunkSize, mSize - c * ChunkSize);
+			}
+		}
+		return numShared;
+	}
+
+private:
+	struct Chunk
+	{
+		Chunk()
+			:Refs(1)
+			,Items()
+		{
+		}
+
+		Chunk(const Chunk& other)
+			:Refs(1)
+		{
+			std::copy(other.Items, other.Items + ChunkSize, Items);
+		}
+
+		std::atomic<int> Refs;
+		T Items[ChunkSize];
+	};
+
+	// Counted reference to a chunk, owns the first reference of a new one.
+	class ChunkRef
+	{
+	public:
+		ChunkRef()
+			:mChunk(nullptr)
+		{
+		}
+
+		explicit ChunkRef(Chunk* chunk)
+			:mChunk(chunk)
+		{
+		}
+
+		ChunkRef(const ChunkRef& other)
+			:mChunk(other.mChunk)
+		{
+			if (mChunk)
+			{
+				mChunk->Refs.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		ChunkRef(ChunkRef&& other) noexcept
+			:mChunk(other.mChunk)
+		{
+			other.mChunk = nullptr;
+		}
+
+		~ChunkRef()
+		{
+			Release();
+		}
+
+		ChunkRef& operator=(ChunkRef other)
+		{
+			std::swap(mChunk, other.mChunk);
+			return *this;
+		}
+
+		Chunk* Get()const { return mChunk; }
+
+		// Another copy references the chunk. Acquire, pairs with the release of Release().
+		bool IsShared()const { return mChunk->Refs.load(std::memory_order_acquire) > 1; }
+
+	private:
+		void Release()
+		{
+			if (mChunk && mChunk->Refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				delete mChunk;
+			}
+			mChunk = nullptr;
+		}
+
+		Chunk* mChunk;
+	};
+
+	std::vector<ChunkRef> mChunks;
+	size_t mSize;
+};
\ No newline at end of file
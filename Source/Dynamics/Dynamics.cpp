@@ -0,0 +1,18 @@
+#include "Dynamics.h"
+#include "RigidBodyDynamics.h"
+
+#ifndef HEADLESS
+	#include "PhysXDynamics.h"
+#endif
+
+Dynamics* Dynamics::Create(Backend::T backend)
+{
+	switch (backend)
+	{
+#ifndef HEADLESS
+	case Backend::PhysX:		return new PhysXDynamics;
+#endif
+	case Backend::RigidBody:	return new RigidBodyDynamics;
+	default:					return nullptr;
+	}
+}
\ No newline at end of file
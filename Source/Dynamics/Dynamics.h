@@ -0,0 +1,63 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include "glm/gtx/quaternion.hpp"
+
+class Quad;
+
+// Rigid body of the quad stepped by the simulation. Forces and torques are accumulated
+// between steps and cleared by Step(), gravity and the ground plane are part of the backend.
+class Dynamics
+{
+public:
+	struct Backend
+	{
+		enum T
+		{
+			PhysX,		// Not available in HEADLESS builds
+			RigidBody,
+			COUNT
+		};
+		static const char* ToStr(T t)
+		{
+			switch (t)
+			{
+			case PhysX:		return "PhysX";
+			case RigidBody:	return "Rigid Body";
+			default:		return "Invalid";
+			}
+		}
+	};
+
+	// Kinematic state of the body between steps, used by the simulation snapshots.
+	struct State
+	{
+		glm::vec3 Position;
+		glm::quat Orientation;
+		glm::vec3 LinearVelocity;	// World frame
+		glm::vec3 AngularVelocity;	// Body frame
+	};
+
+	// Returns nullptr if the backend is not part of this build.
+	static Dynamics* Create(Backend::T backend);
+
+	virtual ~Dynamics() {}
+
+	// deterministic asks for bit reproducible steps, even if that is slower.
+	virtual void Init(const Quad& quad, const glm::vec3& position, const glm::quat& orientation, float groundHeight, bool deterministic) = 0;
+
+	virtual glm::vec3 GetPosition()const = 0;
+	virtual glm::quat GetOrientation()const = 0;
+	virtual glm::vec3 GetLinearVelocity()const = 0;
+
+	// Restoring a state is exact with the rigid body backend, PhysX keeps internal caches
+	// (contacts, solver warm starting) so a restored body only continues approximately.
+	virtual State GetState()const = 0;
+	virtual void SetState(const State& state) = 0;
+
+	virtual void AddForce(const glm::vec3& force) = 0;										// World frame, at the center of mass
+	virtual void AddLocalForceAtLocalPos(const glm::vec3& force, const glm::vec3& pos) = 0;	// Body frame
+	virtual void AddTorque(const glm::vec3& torque) = 0;									// World frame
+
+	virtual void Step(float deltaTime) = 0;
+};
\ No newline at end of file
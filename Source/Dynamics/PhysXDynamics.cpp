@@ -0,0 +1,159 @@
+#define NOMINMAX
+
+#include "PhysXDynamics.h"
+#include "Quad.h"
+#include "Graphics/World/PhysicsWorld.h"
+
+#include "PxPhysicsAPI.h"
+#include "PxFiltering.h"
+#include "PxSceneDesc.h"
+#include "extensions/PxRigidBodyExt.h"
+
+using namespace physx;
+
+static PxVec3 ToPx(const glm::vec3& v)
+{
+	return PxVec3(v.x, v.y, v.z);
+}
+
+PhysXDynamics::PhysXDynamics()
+	:mScene(nullptr)
+	,mBody(nullptr)
+	,mGround(nullptr)
+	,mMaterial(nullptr)
+	,mDispatcher(nullptr)
+{
+}
+
+PhysXDynamics::~PhysXDynamics()
+{
+	Release();
+}
+
+void PhysXDynamics::Init(const Quad& quad, const glm::vec3& position, const glm::quat& orientation, float groundHeight, bool deterministic)
+{
+	Release();
+
+	auto physx = World::PhysicsWorld::GetInstance()->GetPhyx();
+	PxSceneDesc sceneDesc = PxSceneDesc(physx->getTolerancesScale());
+	sceneDesc.gravity = PxVec3(0.0f, -9.81f, 0.0f);
+	sceneDesc.cpuDispatcher = World::PhysicsWorld::GetInstance()->GetPhyxCPUDispatcher();
+	if (deterministic)
+	{
+		// No workers, the tasks run on the thread that steps the scene in a fixed order:
+		mDispatcher = PxDefaultCpuDispatcherCreate(0);
+		sceneDesc.cpuDispatcher = mDispatcher;
+		sceneDesc.flags.set(PxSceneFlag::eENABLE_ENHANCED_DETERMINISM);
+	}
+	sceneDesc.filterShader = PxDefaultSimulationFilterShader;
+	sceneDesc.solverType = PxSolverType::eTGS;
+	sceneDesc.flags.set(PxSceneFlag::eENABLE_CCD);
+	sceneDesc.bounceThresholdVelocity = 10.0f * 9.81f;
+	sceneDesc.ccdMaxPasses = 4;
+	mScene = physx->createScene(sceneDesc);
+
+	// Quad rigid body:
+	PxTransform initialTransform;
+	initialTransform.p = ToPx(position);
+	initialTransform.q = PxQuat(orientation.x, orientation.y, orientation.z, orientation.w);
+	mBody = physx->createRigidDynamic(initialTransform);
+	mBody->setMass(quad.Mass);
+
+	mMaterial = physx->createMaterial(0.5f, 0.5f, 0.0f);
+	PxShape* quadBox = physx->createShape(PxBoxGeometry(quad.Width * 0.5f, quad.Height * 0.5f, quad.Depth * 0.5f), *mMaterial);
+	mBody->attachShape(*quadBox);
+	quadBox->release();
+
+	float density = quad.Mass / (quad.Width * quad.Height * quad.Depth);
+	PxRigidBodyExt::updateMassAndInertia(*mBody, density);
+	if (quad.Inertia != glm::vec3(0.0f))
+	{
+		// Identified (or measured) inertia overrides the uniform box:
+		mBody->setMassSpaceInertiaTensor(ToPx(quad.Inertia));
+	}
+	mScene->addActor(*mBody);
+
+	// Ground plane
+	mGround = PxCreatePlane(*physx, PxPlane(0.0f, 1.0f, 0.0f, -groundHeight), *mMaterial);
+	mScene->addActor(*mGround);
+}
+
+glm::vec3 PhysXDynamics::GetPosition() const
+{
+	PxVec3 p = mBody->getGlobalPose().p;
+	return glm::vec3(p.x, p.y, p.z);
+}
+
+glm::quat PhysXDynamics::GetOrientation() const
+{
+	PxQuat q = mBody->getGlobalPose().q;
+	return glm::quat(q.w, q.x, q.y, q.z);
+}
+
+glm::vec3 PhysXDynamics::GetLinearVelocity() const
+{
+	PxVec3 v = mBody->getLinearVelocity();
+	return glm::vec3(v.x, v.y, v.z);
+}
+
+Dynamics::State PhysXDynamics::GetState() const
+{
+	State state;
+	state.Position = GetPosition();
+	state.Orientation = GetOrientation();
+	state.LinearVelocity = GetLinearVelocity();
+	PxVec3 w = mBody->getAngularVelocity();
+	state.AngularVelocity = glm::inverse(state.Orientation) * glm::vec3(w.x, w.y, w.z);
+	return state;
+}
+
+void PhysXDynamics::SetState(const State& state)
+{
+	const glm::quat& q = state.Orientation;
+	mBody->setGlobalPose(PxTransform(ToPx(state.Position), PxQuat(q.x, q.y, q.z, q.w)));
+	mBody->setLinearVelocity(ToPx(state.LinearVelocity));
+	mBody->setAngularVelocity(ToPx(q * state.AngularVelocity));
+	mBody->clearForce();
+	mBody->clearTorque();
+}
+
+void PhysXDynamics::AddForce(const glm::vec3& force)
+{
+	mBody->addForce(ToPx(force));
+}
+
+void PhysXDynamics::AddLocalForceAtLocalPos(const glm::vec3& force, const glm::vec3& pos)
+{
+	PxRigidBodyExt::addLocalForceAtLocalPos(*mBody, ToPx(force), ToPx(pos));
+}
+
+void PhysXDynamics::AddTorque(const glm::vec3& torque)
+{
+	mBody->addTorque(ToPx(torque));
+}
+
+void PhysXDynamics::Step(float deltaTime)
+{
+	mScene->simulate(deltaTime);
+	mScene->fetchResults(true);
+}
+
+void PhysXDynamics::Release()
+{
+	if (mScene)
+	{
+		mGround->release();
+		mBody->release();
+		mMaterial->release();
+		mScene->release();
+	}
+	if (mDispatcher)
+	{
+		mDispatcher->release();
+	}
+	mScene = nullptr;
+	mBody = nullptr;
+	mGround = nullptr;
+	mMaterial = nullptr;
+	mDispatcher = nullptr;
+}
\ No newline at end of file
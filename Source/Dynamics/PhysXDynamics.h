@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Dynamics.h"
+
+namespace physx
+{
+	class PxScene;
+	class PxRigidDynamic;
+	class PxRigidStatic;
+	class PxMaterial;
+	class PxDefaultCpuDispatcher;
+}
+
+// PhysX backend, owns a scene with the quad box and the ground plane. Needs the engine
+// physics world, so it is only part of the application build.
+class PhysXDynamics : public Dynamics
+{
+public:
+	PhysXDynamics();
+	~PhysXDynamics();
+
+	void Init(const Quad& quad, const glm::vec3& position, const glm::quat& orientation, float groundHeight, bool deterministic) override;
+
+	glm::vec3 GetPosition()const override;
+	glm::quat GetOrientation()const override;
+	glm::vec3 GetLinearVelocity()const override;
+	State GetState()const override;
+	void SetState(const State& state) override;
+
+	void AddForce(const glm::vec3& force) override;
+	void AddLocalForceAtLocalPos(const glm::vec3& force, const glm::vec3& pos) override;
+	void AddTorque(const glm::vec3& torque) override;
+
+	void Step(float deltaTime) override;
+
+private:
+	void Release();
+
+	physx::PxScene* mScene;
+	physx::PxRigidDynamic* mBody;
+	physx::PxRigidStatic* mGround;
+	physx::PxMaterial* mMaterial;
+	physx::PxDefaultCpuDispatcher* mDispatcher;	// Deterministic runs only
+};
\ No newline at end of file
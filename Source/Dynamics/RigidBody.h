@@ -0,0 +1,164 @@
+#pragma once
+
+#include <math.h>
+
+// State and step of the rigid body backend (RigidBodyDynamics), templated on the scalar so the
+// gain optimizer (Source/Optimize) can step it with dual numbers. It has its own small vector
+// types, glm only takes the built in floating point types. The operations follow the glm ones
+// (quaternion rotation, normalize, eulerAngles) so the float body matches the glm math.
+// Orientation is body to world, the angular velocity and the torque are in the body frame.
+template<typename Scalar>
+struct RigidBody
+{
+	struct Vec3
+	{
+		Scalar X, Y, Z;
+	};
+
+	struct Quat
+	{
+		Scalar W, X, Y, Z;
+	};
+
+	static Vec3 MakeVec3(Scalar x, Scalar y, Scalar z)
+	{
+		Vec3 v = { x, y, z };
+		return v;
+	}
+
+	static Vec3 Cross(const Vec3& a, const Vec3& b)
+	{
+		return MakeVec3(a.Y * b.Z - b.Y * a.Z, a.Z * b.X - b.Z * a.X, a.X * b.Y - b.X * a.Y);
+	}
+
+	static Vec3 Rotate(const Quat& q, const Vec3& v)
+	{
+		const Vec3 u = MakeVec3(q.X, q.Y, q.Z);
+		const Vec3 uv = Cross(u, v);
+		const Vec3 uuv = Cross(u, uv);
+		return MakeVec3(v.X + (uv.X * q.W + uuv.X) * 2.0f, v.Y + (uv.Y * q.W + uuv.Y) * 2.0f, v.Z + (uv.Z * q.W + uuv.Z) * 2.0f);
+	}
+
+	// By the inverse of q (world to body).
+	static Vec3 InverseRotate(const Quat& q, const Vec3& v)
+	{
+		const Scalar n = q.W * q.W + q.X * q.X + q.Y * q.Y + q.Z * q.Z;
+		const Quat inverse = { q.W / n, -q.X / n, -q.Y / n, -q.Z / n };
+		return Rotate(inverse, v);
+	}
+
+	// (pitch, yaw, roll) in radians, as glm::eulerAngles.
+	static Vec3 ToEuler(const Quat& q)
+	{
+		const Scalar pitch = atan2f(2.0f * (q.Y * q.Z + q.W * q.X), q.W * q.W - q.X * q.X - q.Y * q.Y + q.Z * q.Z);
+		const Scalar yaw = asinf(fminf(fmaxf(-2.0f * (q.X * q.Z - q.W * q.Y), -1.0f), 1.0f));
+		const Scalar roll = atan2f(2.0f * (q.X * q.Y + q.W * q.Z), q.W * q.W + q.X * q.X - q.Y * q.Y - q.Z * q.Z);
+		return MakeVec3(pitch, yaw, roll);
+	}
+
+	// Starts at rest, position and orientation as given.
+	void Init(const Vec3& position, const Quat& orientation)
+	{
+		Position = position;
+		Orientation = orientation;
+		Velocity = MakeVec3(0.0f, 0.0f, 0.0f);
+		AngularVelocity = MakeVec3(0.0f, 0.0f, 0.0f);
+		Force = MakeVec3(0.0f, 0.0f, 0.0f);
+		Torque = MakeVec3(0.0f, 0.0f, 0.0f);
+	}
+
+	void AddForce(const Vec3& force)
+	{
+		Force = MakeVec3(Force.X + force.X, Force.Y + force.Y, Force.Z + force.Z);
+	}
+
+	void AddLocalForceAtLocalPos(const Vec3& force, const Vec3& pos)
+	{
+		AddForce(Rotate(Orientation, force));
+		const Vec3 torque = Cross(pos, force);
+		Torque = MakeVec3(Torque.X + torque.X, Torque.Y + torque.Y, Torque.Z + torque.Z);
+	}
+
+	// World frame.
+	void AddTorque(const Vec3& torque)
+	{
+		const Vec3 local = InverseRotate(Orientation, torque);
+		Torque = MakeVec3(Torque.X + local.X, Torque.Y + local.Y, Torque.Z + local.Z);
+	}
+
+	void Step(float deltaTime)
+	{
+		Force.Y -= Mass * Gravity;
+
+		// Semi-implicit Euler, velocities first:
+		const float impulseScale = deltaTime / Mass;
+		Velocity = MakeVec3(Velocity.X + Force.X * impulseScale, Velocity.Y + Force.Y * impulseScale, Velocity.Z + Force.Z * impulseScale);
+		const Vec3& w = AngularVelocity;
+		const Vec3 gyroscopic = Cross(w, MakeVec3(Inertia[0] * w.X, Inertia[1] * w.Y, Inertia[2] * w.Z));
+		AngularVelocity = MakeVec3(
+			w.X + (Torque.X - gyroscopic.X) / Inertia[0] * deltaTime,
+			w.Y + (Torque.Y - gyroscopic.Y) / Inertia[1] * deltaTime,
+			w.Z + (Torque.Z - gyroscopic.Z) / Inertia[2] * deltaTime);
+		const float damping = 1.0f / (1.0f + AngularDamping * deltaTime);
+		AngularVelocity = MakeVec3(AngularVelocity.X * damping, AngularVelocity.Y * damping, AngularVelocity.Z * damping);
+
+		Position = MakeVec3(Position.X + Velocity.X * deltaTime, Position.Y + Velocity.Y * deltaTime, Position.Z + Velocity.Z * deltaTime);
+
+		// q + q * (0, w) * dt/2, normalized:
+		const Quat& q = Orientation;
+		const Vec3& v = AngularVelocity;
+		const float h = 0.5f * deltaTime;
+		Quat next =
+		{
+			q.W + (-q.X * v.X - q.Y * v.Y - q.Z * v.Z) * h,
+			q.X + (q.W * v.X + q.Y * v.Z - q.Z * v.Y) * h,
+			q.Y + (q.W * v.Y + q.Z * v.X - q.X * v.Z) * h,
+			q.Z + (q.W * v.Z + q.X * v.Y - q.Y * v.X) * h
+		};
+		const Scalar length = sqrtf(next.W * next.W + next.X * next.X + next.Y * next.Y + next.Z * next.Z);
+		Orientation.W = next.W / length;
+		Orientation.X = next.X / length;
+		Orientation.Y = next.Y / length;
+		Orientation.Z = next.Z / length;
+
+		// Ground contact, lowest corner of the box against the plane:
+		const Vec3 axisX = Rotate(Orientation, MakeVec3(1.0f, 0.0f, 0.0f));
+		const Vec3 axisY = Rotate(Orientation, MakeVec3(0.0f, 1.0f, 0.0f));
+		const Vec3 axisZ = Rotate(Orientation, MakeVec3(0.0f, 0.0f, 1.0f));
+		const Scalar extent = fabsf(axisX.Y) * HalfExtents[0] + fabsf(axisY.Y) * HalfExtents[1] + fabsf(axisZ.Y) * HalfExtents[2];
+		const Scalar penetration = GroundHeight - (Position.Y - extent);
+		if (penetration > 0.0f)
+		{
+			Position.Y += penetration;
+			if (Velocity.Y < 0.0f)
+			{
+				// Friction impulse bounded by the normal impulse that stopped the body:
+				const Scalar normalImpulse = -Velocity.Y;
+				Velocity.Y = 0.0f;
+				const Scalar speed = sqrtf(Velocity.X * Velocity.X + Velocity.Z * Velocity.Z);
+				const Scalar scale = speed > 0.0f ? fmaxf(1.0f - Friction * normalImpulse / speed, 0.0f) : Scalar(0.0f);
+				Velocity.X *= scale;
+				Velocity.Z *= scale;
+				AngularVelocity = MakeVec3(AngularVelocity.X * scale, AngularVelocity.Y * scale, AngularVelocity.Z * scale);
+			}
+		}
+
+		Force = MakeVec3(0.0f, 0.0f, 0.0f);
+		Torque = MakeVec3(0.0f, 0.0f, 0.0f);
+	}
+
+	Vec3 Position;
+	Quat Orientation;
+	Vec3 Velocity;
+	Vec3 AngularVelocity;
+	Vec3 Force;
+	Vec3 Torque;
+
+	float Mass;
+	float Inertia[3];		// Body frame diagonal
+	float HalfExtents[3];
+	float GroundHeight;
+	float Friction;			// Coulomb coefficient against the ground
+	float AngularDamping;
+	float Gravity;
+};
\ No newline at end of file
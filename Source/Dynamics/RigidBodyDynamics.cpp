@@ -0,0 +1,122 @@
+#include "RigidBodyDynamics.h"
+#include "Quad.h"
+
+static const float k_Gravity = 9.81f;
+
+RigidBodyDynamics::RigidBodyDynamics()
+	:Friction(0.5f)
+	,AngularDamping(0.05f)
+{
+	mBody.Init(ToBody(glm::vec3(0.0f)), ToBody(glm::quat(1.0f, 0.0f, 0.0f, 0.0f)));
+	mBody.Mass = 1.0f;
+	mBody.Inertia[0] = mBody.Inertia[1] = mBody.Inertia[2] = 1.0f;
+	mBody.HalfExtents[0] = mBody.HalfExtents[1] = mBody.HalfExtents[2] = 0.0f;
+	mBody.GroundHeight = 0.0f;
+	mBody.Friction = Friction;
+	mBody.AngularDamping = AngularDamping;
+	mBody.Gravity = k_Gravity;
+}
+
+// Single threaded with a fixed operation order, the steps are always bit reproducible and
+// there is nothing to switch for a deterministic run.
+void RigidBodyDynamics::Init(const Quad& quad, const glm::vec3& position, const glm::quat& orientation, float groundHeight, bool /*deterministic*/)
+{
+	mBody.Init(ToBody(position), ToBody(orientation));
+	mBody.Mass = quad.Mass;
+	const glm::vec3 halfExtents = glm::vec3(quad.Width, quad.Height, quad.Depth) * 0.5f;
+	mBody.HalfExtents[0] = halfExtents.x;
+	mBody.HalfExtents[1] = halfExtents.y;
+	mBody.HalfExtents[2] = halfExtents.z;
+	mBody.GroundHeight = groundHeight;
+
+	glm::vec3 inertia = quad.Inertia;
+	if (inertia == glm::vec3(0.0f))
+	{
+		const glm::vec3 size = halfExtents * 2.0f;
+		const float k = quad.Mass / 12.0f;
+		inertia = glm::vec3(k * (size.y * size.y + size.z * size.z), k * (size.x * size.x + size.z * size.z), k * (size.x * size.x + size.y * size.y));
+	}
+	mBody.Inertia[0] = inertia.x;
+	mBody.Inertia[1] = inertia.y;
+	mBody.Inertia[2] = inertia.z;
+}
+
+glm::vec3 RigidBodyDynamics::GetPosition() const
+{
+	return FromBody(mBody.Position);
+}
+
+glm::quat RigidBodyDynamics::GetOrientation() const
+{
+	return FromBody(mBody.Orientation);
+}
+
+glm::vec3 RigidBodyDynamics::GetLinearVelocity() const
+{
+	return FromBody(mBody.Velocity);
+}
+
+Dynamics::State RigidBodyDynamics::GetState() const
+{
+	State state;
+	state.Position = FromBody(mBody.Position);
+	state.Orientation = FromBody(mBody.Orientation);
+	state.LinearVelocity = FromBody(mBody.Velocity);
+	state.AngularVelocity = FromBody(mBody.AngularVelocity);
+	return state;
+}
+
+void RigidBodyDynamics::SetState(const State& state)
+{
+	mBody.Init(ToBody(state.Position), ToBody(state.Orientation));
+	mBody.Velocity = ToBody(state.LinearVelocity);
+	mBody.AngularVelocity = ToBody(state.AngularVelocity);
+}
+
+void RigidBodyDynamics::AddForce(const glm::vec3& force)
+{
+	mBody.AddForce(ToBody(force));
+}
+
+void RigidBodyDynamics::AddLocalForceAtLocalPos(const glm::vec3& force, const glm::vec3& pos)
+{
+	mBody.AddLocalForceAtLocalPos(ToBody(force), ToBody(pos));
+}
+
+void RigidBodyDynamics::AddTorque(const glm::vec3& torque)
+{
+	mBody.AddTorque(ToBody(torque));
+}
+
+void RigidBodyDynamics::Step(float deltaTime)
+{
+	mBody.Friction = Friction;
+	mBody.AngularDamping = AngularDamping;
+	mBody.Step(deltaTime);
+}
+
+const RigidBody<float>& RigidBodyDynamics::GetBody() const
+{
+	return mBody;
+}
+
+RigidBody<float>::Vec3 RigidBodyDynamics::ToBody(const glm::vec3& v)
+{
+	return RigidBody<float>::MakeVec3(v.x, v.y, v.z);
+}
+
+glm::vec3 RigidBodyDynamics::FromBody(const RigidBody<float>::Vec3& v)
+{
+	return glm::vec3(v.X, v.Y, v.Z);
+}
+
+RigidBody<float>::Quat RigidBodyDynamics::ToBody(const glm::quat& q)
+{
+	RigidBody<float>::Quat quat = { q.w, q.x, q.y, q.z };
+	return quat;
+}
+
+glm::quat RigidBodyDynamics::FromBody(const RigidBody<float>::Quat& q)
+{
+	return glm::quat(q.W, q.X, q.Y, q.Z);
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Dynamics.h"
+#include "RigidBody.h"
+
+// Self contained 6DOF integrator used by the headless tools, no PhysX scene required. Single
+// threaded and with a fixed operation order, so it is always deterministic.
+// Semi-implicit Euler with gyroscopic torque and a diagonal inertia (the identified one or
+// the uniform box, same as the PhysX backend). Ground contact only stops the lowest corner of
+// the box going through the plane and applies friction, it does not tip the body over.
+// The integrator itself is RigidBody<float>, this class maps it to the glm interface.
+class RigidBodyDynamics : public Dynamics
+{
+public:
+	RigidBodyDynamics();
+
+	void Init(const Quad& quad, const glm::vec3& position, const glm::quat& orientation, float groundHeight, bool deterministic) override;
+
+	glm::vec3 GetPosition()const override;
+	glm::quat GetOrientation()const override;
+	glm::vec3 GetLinearVelocity()const override;
+	State GetState()const override;
+	void SetState(const State& state) override;
+
+	void AddForce(const glm::vec3& force) override;
+	void AddLocalForceAtLocalPos(const glm::vec3& force, const glm::vec3& pos) override;
+	void AddTorque(const glm::vec3& torque) override;
+
+	void Step(float deltaTime) override;
+
+	// State and parameters, also used to start the templated bodies the same way.
+	const RigidBody<float>& GetBody()const;
+
+	float Friction;			// Coulomb coefficient against the ground
+	float AngularDamping;	// Same default as a PhysX rigid body
+
+private:
+	static RigidBody<float>::Vec3 ToBody(const glm::vec3& v);
+	static glm::vec3 FromBody(const RigidBody<float>::Vec3& v);
+	static RigidBody<float>::Quat ToBody(const glm::quat& q);
+	static glm::quat FromBody(const RigidBody<float>::Quat& q);
+
+	RigidBody<float> mBody;
+};
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "Environment.h"
+#include "Quad.h"
+
+#ifndef HEADLESS
+	#include "Graphics/UI/IMGUI/imgui.h"
+#endif
+
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+// Times a block when MeasureCost is set. Adds the elapsed ns to mCostNs[model].
+struct ScopedCost
+{
+	ScopedCost(bool enabled, double& target)
+		:Enabled(enabled)
+		,Target(target)
+	{
+		if (Enabled)
+		{
+			Start = std::chrono::high_resolution_clock::now();
+		}
+	}
+	~ScopedCost()
+	{
+		if (Enabled)
+		{
+			auto end = std::chrono::high_resolution_clock::now();
+			Target += (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - Start).count();
+		}
+	}
+	bool Enabled;
+	double& Target;
+	std::chrono::high_resolution_clock::time_point Start;
+};
+
+Environment::Environment()
+	:MeasureCost(false)
+	,GroundHeight(-0.2f)
+	,RotorRadius(0.03f)
+	,WindVelocity(2.0f, 0.0f, 0.0f)
+	,GustIntensity(0.5f)
+	,GustLengthScale(10.0f)
+{
+	Enabled[Model::LinearDrag] = true;
+	Enabled[Model::QuadraticDrag] = true;
+	Enabled[Model::GroundEffect] = true;
+	Enabled[Model::Wind] = false;
+	Enabled[Model::Gusts] = false;
+	Reset(0);
+}
+
+void Environment::RenderUI()
+{
+#ifndef HEADLESS
+	for (int m = 0; m < Model::COUNT; ++m)
+	{
+		ImGui::Checkbox(Model::ToStr((Model::T)m), &Enabled[m]);
+	}
+	ImGui::InputFloat("Rotor Radius", &RotorRadius);
+	ImGui::InputFloat3("Wind Velocity", &WindVelocity.x);
+	ImGui::InputFloat("Gust Intensity", &GustIntensity);
+	ImGui::InputFloat("Gust Length Scale", &GustLengthScale);
+
+	ImGui::Checkbox("Measure Cost", &MeasureCost);
+	if (MeasureCost && mNumSteps > 0)
+	{
+		for (int m = 0; m < Model::COUNT; ++m)
+		{
+			ImGui::Text("%s: %.1f ns/step", Model::ToStr((Model::T)m), GetStepCost((Model::T)m));
+		}
+	}
+#endif
+}
+
+Environment::State Environment::GetState() const
+{
+	State state;
+	state.Rng = mRng;
+	state.Gust = mGust;
+	return state;
+}
+
+void Environment::SetState(const State& state)
+{
+	mRng = state.Rng;
+	mGust = state.Gust;
+}
+
+void Environment::Reset(uint32_t seed)
+{
+	mRng.Seed(seed, RandomStream::Stream::Gusts);
+	mGust = glm::vec3(0.0f);
+	for (int m = 0; m < Model::COUNT; ++m)
+	{
+		mCostNs[m] = 0.0;
+	}
+	mNumSteps = 0;
+}
+
+void Environment::Step(const Quad& quad, const glm::vec3& velocity, float deltaTime, glm::vec3& force, float& thrustScale)
+{
+	force = glm::vec3(0.0f);
+	thrustScale = 1.0f;
+	++mNumSteps;
+
+	glm::vec3 airVelocity = glm::vec3(0.0f);
+	if (Enabled[Model::Wind])
+	{
+		ScopedCost cost(MeasureCost, mCostNs[Model::Wind]);
+		airVelocity += WindVelocity;
+	}
+
+	// First order Dryden form: Gauss-Markov process per axis, correlation time L/V.
+	if (Enabled[Model::Gusts])
+	{
+		ScopedCost cost(MeasureCost, mCostNs[Model::Gusts]);
+		float airSpeed = std::max(glm::length(velocity - airVelocity), 1.0f);
+		float a = std::exp(-airSpeed * deltaTime / GustLengthScale);
+		float b = GustIntensity * std::sqrt(1.0f - a * a);
+		mGust.x = a * mGust.x + b * mRng.Normal();
+		mGust.y = a * mGust.y + b * mRng.Normal();
+		mGust.z = a * mGust.z + b * mRng.Normal();
+		airVelocity += mGust;
+	}
+
+	glm::vec3 relVelocity = velocity - airVelocity;
+	if (Enabled[Model::LinearDrag])
+	{
+		ScopedCost cost(MeasureCost, mCostNs[Model::LinearDrag]);
+		force -= quad.LinearDrag * relVelocity;
+	}
+	if (Enabled[Model::QuadraticDrag])
+	{
+		ScopedCost cost(MeasureCost, mCostNs[Model::QuadraticDrag]);
+		force -= quad.QuadraticDrag * glm::length(relVelocity) * relVelocity;
+	}
+
+	// Cheeseman-Bennett: T_ige / T_oge = 1 / (1 - (R / 4z)^2), capped close to the ground.
+	if (Enabled[Model::GroundEffect])
+	{
+		ScopedCost cost(MeasureCost, mCostNs[Model::GroundEffect]);
+		float z = std::max(quad.Position.y - GroundHeight, 1e-3f);
+		float ratio = std::min(RotorRadius / (4.0f * z), 0.6f);
+		thrustScale = 1.0f / (1.0f - ratio * ratio);
+	}
+}
+
+float Environment::GetStepCost(Model::T model) const
+{
+	return mNumSteps > 0 ? (float)(mCostNs[model] / (double)mNumSteps) : 0.0f;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include "RandomStream.h"
+
+#include <stdint.h>
+
+class Quad;
+
+// Environment models applied on top of gravity and the ground plane. Each model can be
+// toggled per run, the cost of each one is measured per step when MeasureCost is set.
+class Environment
+{
+public:
+	struct Model
+	{
+		enum T
+		{
+			LinearDrag,
+			QuadraticDrag,
+			GroundEffect,
+			Wind,
+			Gusts,
+			COUNT
+		};
+		static const char* ToStr(T t)
+		{
+			switch (t)
+			{
+			case LinearDrag:	return "Linear Drag";
+			case QuadraticDrag:	return "Quadratic Drag";
+			case GroundEffect:	return "Ground Effect";
+			case Wind:			return "Wind";
+			case Gusts:			return "Gusts";
+			default:			return "Invalid";
+			}
+		}
+	};
+
+	// Gust stream position and filter state, used by the simulation snapshots.
+	struct State
+	{
+		RandomStream Rng;
+		glm::vec3 Gust;
+	};
+
+	Environment();
+	void RenderUI();
+
+	// Restarts the gust stream from the run seed and clears the cost counters.
+	void Reset(uint32_t seed);
+
+	// Computes the environment force (world frame, N) and the motor thrust scale (ground effect).
+	// The drag coefficients are part of the airframe (Quad).
+	void Step(const Quad& quad, const glm::vec3& velocity, float deltaTime, glm::vec3& force, float& thrustScale);
+
+	// Average cost of a model per step (ns), only valid if MeasureCost was set during the run.
+	float GetStepCost(Model::T model)const;
+
+	State GetState()const;
+	void SetState(const State& state);
+
+	bool Enabled[Model::COUNT];
+	bool MeasureCost;
+
+	float GroundHeight;			// Height of the ground plane (m)
+	float RotorRadius;			// Used by the ground effect (m)
+	glm::vec3 WindVelocity;		// m/s
+	float GustIntensity;		// Turbulence standard deviation (m/s)
+	float GustLengthScale;		// Turbulence length scale (m)
+
+private:
+	RandomStream mRng;
+	glm::vec3 mGust;
+	double mCostNs[Model::COUNT];
+	int mNumSteps;
+};
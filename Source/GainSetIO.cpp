@@ -0,0 +1,98 @@
+#include "GainSetIO.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Shortest float literal that reads back to the same bits ("0.5f", "1.0f", "3.40282347e+38f").
+static std::string FloatLiteral(float value)
+{
+	char text[32];
+	for (int digits = 6; digits <= 9; ++digits)
+	{
+		snprintf(text, sizeof(text), "%.*g", digits, value);
+		if (strtof(text, nullptr) == value)
+		{
+			break;
+		}
+	}
+	std::string literal = text;
+	if (literal.find_first_of(".e") == std::string::npos)
+	{
+		literal += ".0";
+	}
+	return literal + "f";
+}
+
+bool GainSetIO::Load(const std::string& path, GainSet& gainSet, std::string* error)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file)
+	{
+		if (error)
+		{
+			*error = "Could not open " + path;
+		}
+		return false;
+	}
+	GainSet loaded;
+	size_t read = fread(&loaded, 1, sizeof(loaded), file);
+	fclose(file);
+	if (read != sizeof(loaded) || !IsValidGainSet(loaded))
+	{
+		if (error)
+		{
+			*error = path + " is not a valid gain set (version " + std::to_string(GainSet::k_Version) + ")";
+		}
+		return false;
+	}
+	gainSet = loaded;
+	return true;
+}
+
+bool GainSetIO::Save(const std::string& path, const GainSet& gainSet)
+{
+	GainSet sealed = gainSet;
+	SealGainSet(sealed);
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+	bool ok = fwrite(&sealed, sizeof(sealed), 1, file) == 1;
+	ok = fclose(file) == 0 && ok;
+	return ok;
+}
+
+bool GainSetIO::WriteHeader(const std::string& path, const GainSet& gainSet, const std::string& name, const std::string& source)
+{
+	static_assert(sizeof(PIDGains) == 12 * sizeof(float), "Update the field list below");
+	GainSet sealed = gainSet;
+	SealGainSet(sealed);
+	FILE* file = fopen(path.c_str(), "w");
+	if (!file)
+	{
+		return false;
+	}
+
+	fprintf(file, "#pragma once\n\n");
+	fprintf(file, "// Generated by GainGen from %s, do not edit.\n", source.c_str());
+	fprintf(file, "// Fields: KP, KI, KD, KF, SetPointWeightP, SetPointWeightD, IntegralLimit, BackCalcGain,\n");
+	fprintf(file, "//         DCutoffHz, SlewRate, OutputMin, OutputMax\n\n");
+	fprintf(file, "#include \"GainSet.h\"\n\n");
+	fprintf(file, "constexpr GainSet %s =\n{\n", name.c_str());
+	fprintf(file, "\t0x%08X, %u, %u,\n\t{\n", sealed.Magic, (unsigned)sealed.Version, (unsigned)sealed.Size);
+	for (int s = 0; s < GainSlot::COUNT; ++s)
+	{
+		const PIDGains& g = sealed.Gains[s];
+		const float values[12] = { g.KP, g.KI, g.KD, g.KF, g.SetPointWeightP, g.SetPointWeightD, g.IntegralLimit, g.BackCalcGain, g.DCutoffHz, g.SlewRate, g.OutputMin, g.OutputMax };
+		fprintf(file, "\t\t{ ");
+		for (int v = 0; v < 12; ++v)
+		{
+			fprintf(file, "%s%s", FloatLiteral(values[v]).c_str(), v < 11 ? ", " : " ");
+		}
+		fprintf(file, "}%s // %s\n", s < GainSlot::COUNT - 1 ? "," : "", GainSlot::ToStr((GainSlot::T)s));
+	}
+	fprintf(file, "\t},\n\t0x%08X\n};", sealed.Crc);
+	return fclose(file) == 0;
+}
\ No newline at end of file
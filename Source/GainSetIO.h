@@ -0,0 +1,19 @@
+#pragma once
+
+#include "GainSet.h"
+
+#include <string>
+
+// Host side of the gain sets: .gainset files (raw GainSet bytes) and the firmware header.
+namespace GainSetIO
+{
+	// Fails on a wrong magic, version, size or CRC.
+	bool Load(const std::string& path, GainSet& gainSet, std::string* error = nullptr);
+
+	// Seals a copy of the gain set before writing it.
+	bool Save(const std::string& path, const GainSet& gainSet);
+
+	// Header with "constexpr GainSet <name> = {...}" so the firmware gets the gains as compile
+	// time constants. source is only used in the generated comment.
+	bool WriteHeader(const std::string& path, const GainSet& gainSet, const std::string& name, const std::string& source);
+}
\ No newline at end of file
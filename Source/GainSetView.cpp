@@ -0,0 +1,59 @@
+#include "GainSetView.h"
+#include "GainSetIO.h"
+#include "DefaultGainSet.h"
+#include "Graphics/UI/IMGUI/imgui.h"
+#include "Core/Logging.h"
+
+#include <cstring>
+
+GainSetView::GainSetView()
+	:mGainSet(k_DefaultGainSet)
+{
+	strcpy(mPath, "../../Assets/Gains/Default.gainset");
+	strcpy(mHeaderPath, "../../Board/lib/QuadFlyController/src/DefaultGainSet.h");
+}
+
+void GainSetView::RenderUI(BaseFlyController& controller)
+{
+	ImGui::InputText("Gain Set", mPath, sizeof(mPath));
+	if (ImGui::Button("Load Gains"))
+	{
+		std::string error;
+		if (GainSetIO::Load(mPath, mGainSet, &error))
+		{
+			controller.SetGainSet(mGainSet);
+		}
+		else
+		{
+			ERR("Failed to load the gain set: %s", error.c_str());
+		}
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Save Gains"))
+	{
+		controller.GetGainSet(mGainSet);
+		if (!GainSetIO::Save(mPath, mGainSet))
+		{
+			ERR("Failed to save the gain set: %s", mPath);
+		}
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Firmware Defaults"))
+	{
+		mGainSet = k_DefaultGainSet;
+		controller.SetGainSet(mGainSet);
+	}
+
+	ImGui::InputText("Firmware Header", mHeaderPath, sizeof(mHeaderPath));
+	if (ImGui::Button("Export Header"))
+	{
+		controller.GetGainSet(mGainSet);
+		std::string source = mPath;
+		size_t start = source.find_last_of("/\\");
+		source = start == std::string::npos ? source : source.substr(start + 1);
+		if (!GainSetIO::WriteHeader(mHeaderPath, mGainSet, "k_DefaultGainSet", source))
+		{
+			ERR("Failed to write the firmware header: %s", mHeaderPath);
+		}
+	}
+}
\ No newline at end of file
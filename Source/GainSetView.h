@@ -0,0 +1,19 @@
+#pragma once
+
+#include "GainSet.h"
+
+class BaseFlyController;
+
+// Loads/saves the gains of the active controller as a gain set and exports the constexpr
+// table the firmware builds with (same output as Tools/GainGen).
+class GainSetView
+{
+public:
+	GainSetView();
+	void RenderUI(BaseFlyController& controller);
+
+private:
+	char mPath[256];
+	char mHeaderPath[256];
+	GainSet mGainSet;	// Keeps the slots the controller does not use
+};
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "Directory.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+	#include <Windows.h>
+	#include <direct.h>
+#else
+	#include <dirent.h>
+	#include <sys/stat.h>
+#endif
+
+static bool HasExtension(const std::string& name, const std::string& extension)
+{
+	return name.size() >= extension.size() && name.compare(name.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+bool Directory::ListFiles(const std::string& directory, const std::string& extension, std::vector<std::string>& names)
+{
+	names.clear();
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE find = FindFirstFileA(Join(directory, "*").c_str(), &data);
+	if (find == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	do
+	{
+		if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && HasExtension(data.cFileName, extension))
+		{
+			names.push_back(data.cFileName);
+		}
+	} while (FindNextFileA(find, &data));
+	FindClose(find);
+#else
+	DIR* dir = opendir(directory.c_str());
+	if (!dir)
+	{
+		return false;
+	}
+	while (dirent* entry = readdir(dir))
+	{
+		struct stat info;
+		std::string name = entry->d_name;
+		if (stat(Join(directory, name).c_str(), &info) == 0 && S_ISREG(info.st_mode) && HasExtension(name, extension))
+		{
+			names.push_back(name);
+		}
+	}
+	closedir(dir);
+#endif
+	std::sort(names.begin(), names.end());
+	return true;
+}
+
+bool Directory::Create(const std::string& directory)
+{
+	// Each parent first, existing ones fail to create and are skipped:
+	for (size_t end = 0; end != std::string::npos;)
+	{
+		end = directory.find_first_of("/\\", end + 1);
+		std::string path = directory.substr(0, end);
+		if (path.empty() || path.back() == ':')
+		{
+			continue;
+		}
+#ifdef _WIN32
+		_mkdir(path.c_str());
+#else
+		mkdir(path.c_str(), 0755);
+#endif
+	}
+
+#ifdef _WIN32
+	DWORD attributes = GetFileAttributesA(directory.c_str());
+	return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+	struct stat info;
+	return stat(directory.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+#endif
+}
+
+std::string Directory::Join(const std::string& directory, const std::string& name)
+{
+	if (directory.empty() || directory.back() == '/' || directory.back() == '\\')
+	{
+		return directory + name;
+	}
+	return directory + "/" + name;
+}
\ No newline at end of file
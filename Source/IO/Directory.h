@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace Directory
+{
+	// Names (not paths) of the regular files in a directory with the extension (".quad"),
+	// sorted. An empty extension lists all the files.
+	bool ListFiles(const std::string& directory, const std::string& extension, std::vector<std::string>& names);
+
+	// Creates the directory and any missing parent, true if it exists afterwards.
+	bool Create(const std::string& directory);
+
+	// Joins a directory and a file name, the directory may end with a separator.
+	std::string Join(const std::string& directory, const std::string& name);
+}
\ No newline at end of file
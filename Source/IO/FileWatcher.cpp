@@ -0,0 +1,204 @@
+#include "FileWatcher.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+	#include <Windows.h>
+#elif defined(__linux__)
+	#include <sys/inotify.h>
+	#include <unistd.h>
+#endif
+
+static void AddUnique(std::vector<std::string>& names, const std::string& name)
+{
+	if (std::find(names.begin(), names.end(), name) == names.end())
+	{
+		names.push_back(name);
+	}
+}
+
+#ifdef _WIN32
+
+FileWatcher::FileWatcher()
+	:mDirHandle(INVALID_HANDLE_VALUE)
+	,mOverlapped(nullptr)
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+	Stop();
+}
+
+bool FileWatcher::Watch(const std::string& directory)
+{
+	Stop();
+	mDirHandle = CreateFileA(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+	if (mDirHandle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	OVERLAPPED* overlapped = new OVERLAPPED();
+	overlapped->hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+	mOverlapped = overlapped;
+	mBuffer.resize(16 * 1024);
+	if (!Issue())
+	{
+		Stop();
+		return false;
+	}
+	return true;
+}
+
+void FileWatcher::Stop()
+{
+	OVERLAPPED* overlapped = (OVERLAPPED*)mOverlapped;
+	if (mDirHandle != INVALID_HANDLE_VALUE)
+	{
+		CancelIo(mDirHandle);
+		if (overlapped)
+		{
+			DWORD bytes = 0;
+			GetOverlappedResult(mDirHandle, overlapped, &bytes, TRUE);
+		}
+		CloseHandle(mDirHandle);
+		mDirHandle = INVALID_HANDLE_VALUE;
+	}
+	if (overlapped)
+	{
+		CloseHandle(overlapped->hEvent);
+		delete overlapped;
+		mOverlapped = nullptr;
+	}
+}
+
+bool FileWatcher::IsWatching() const
+{
+	return mDirHandle != INVALID_HANDLE_VALUE;
+}
+
+bool FileWatcher::Issue()
+{
+	OVERLAPPED* overlapped = (OVERLAPPED*)mOverlapped;
+	ResetEvent(overlapped->hEvent);
+	DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE;
+	return ReadDirectoryChangesW(mDirHandle, mBuffer.data(), (DWORD)(mBuffer.size() * sizeof(uint32_t)), FALSE, filter, NULL, overlapped, NULL) != 0;
+}
+
+void FileWatcher::Poll(std::vector<std::string>& changed)
+{
+	changed.clear();
+	OVERLAPPED* overlapped = (OVERLAPPED*)mOverlapped;
+	if (!IsWatching() || !HasOverlappedIoCompleted(overlapped))
+	{
+		return;
+	}
+
+	DWORD bytes = 0;
+	if (GetOverlappedResult(mDirHandle, overlapped, &bytes, FALSE) && bytes > 0)
+	{
+		const uint8_t* cur = (const uint8_t*)mBuffer.data();
+		for (;;)
+		{
+			const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)cur;
+			int numChars = (int)(info->FileNameLength / sizeof(WCHAR));
+			int size = WideCharToMultiByte(CP_UTF8, 0, info->FileName, numChars, NULL, 0, NULL, NULL);
+			std::string name(size, 0);
+			WideCharToMultiByte(CP_UTF8, 0, info->FileName, numChars, &name[0], size, NULL, NULL);
+			AddUnique(changed, name);
+			if (info->NextEntryOffset == 0)
+			{
+				break;
+			}
+			cur += info->NextEntryOffset;
+		}
+	}
+	// bytes == 0 means the buffer overflowed, the changes are lost but the watch goes on.
+	if (!Issue())
+	{
+		Stop();
+	}
+}
+
+#else
+
+FileWatcher::FileWatcher()
+	:mFileDesc(-1)
+	,mWatchDesc(-1)
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+	Stop();
+}
+
+bool FileWatcher::Watch(const std::string& directory)
+{
+	Stop();
+#ifdef __linux__
+	mFileDesc = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (mFileDesc < 0)
+	{
+		return false;
+	}
+	mWatchDesc = inotify_add_watch(mFileDesc, directory.c_str(), IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO);
+	if (mWatchDesc < 0)
+	{
+		Stop();
+		return false;
+	}
+	return true;
+#else
+	(void)directory;
+	return false;
+#endif
+}
+
+void FileWatcher::Stop()
+{
+#ifdef __linux__
+	if (mFileDesc >= 0)
+	{
+		close(mFileDesc); // Also removes the watch
+	}
+#endif
+	mFileDesc = -1;
+	mWatchDesc = -1;
+}
+
+bool FileWatcher::IsWatching() const
+{
+	return mWatchDesc >= 0;
+}
+
+void FileWatcher::Poll(std::vector<std::string>& changed)
+{
+	changed.clear();
+#ifdef __linux__
+	if (!IsWatching())
+	{
+		return;
+	}
+	alignas(inotify_event) char buffer[4096];
+	for (;;)
+	{
+		ssize_t bytes = read(mFileDesc, buffer, sizeof(buffer));
+		if (bytes <= 0)
+		{
+			break; // EAGAIN, nothing else queued
+		}
+		for (ssize_t offset = 0; offset < bytes;)
+		{
+			const inotify_event* event = (const inotify_event*)(buffer + offset);
+			if (event->len > 0)
+			{
+				AddUnique(changed, event->name);
+			}
+			offset += sizeof(inotify_event) + event->len;
+		}
+	}
+#endif
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Non blocking watch of the files in a directory (not recursive): inotify on Linux and
+// ReadDirectoryChangesW on Windows. Poll it from the main loop.
+class FileWatcher
+{
+public:
+	FileWatcher();
+	~FileWatcher();
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	bool Watch(const std::string& directory);
+	void Stop();
+	bool IsWatching()const;
+
+	// Names of the files written, created, renamed or deleted since the last call (no duplicates).
+	void Poll(std::vector<std::string>& changed);
+
+private:
+#ifdef _WIN32
+	bool Issue();
+
+	void* mDirHandle;
+	void* mOverlapped;
+	std::vector<uint32_t> mBuffer; // DWORD aligned FILE_NOTIFY_INFORMATION
+#else
+	int mFileDesc;
+	int mWatchDesc;
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+	#include <Windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+	:mData(nullptr)
+	,mSize(0)
+#ifdef _WIN32
+	,mFileHandle(INVALID_HANDLE_VALUE)
+	,mMappingHandle(nullptr)
+#else
+	,mFileDesc(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+#ifdef _WIN32
+	mFileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (mFileHandle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER size = {};
+	if (!GetFileSizeEx(mFileHandle, &size) || size.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+	mMappingHandle = CreateFileMappingA(mFileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mMappingHandle)
+	{
+		Close();
+		return false;
+	}
+	mData = MapViewOfFile(mMappingHandle, FILE_MAP_READ, 0, 0, 0);
+	mSize = (size_t)size.QuadPart;
+#else
+	mFileDesc = open(path.c_str(), O_RDONLY);
+	if (mFileDesc < 0)
+	{
+		return false;
+	}
+	struct stat info = {};
+	if (fstat(mFileDesc, &info) != 0 || info.st_size == 0)
+	{
+		Close();
+		return false;
+	}
+	void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, mFileDesc, 0);
+	mData = data == MAP_FAILED ? nullptr : data;
+	mSize = (size_t)info.st_size;
+#endif
+	if (!mData)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (mData)
+	{
+		UnmapViewOfFile(mData);
+	}
+	if (mMappingHandle)
+	{
+		CloseHandle(mMappingHandle);
+		mMappingHandle = nullptr;
+	}
+	if (mFileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(mFileHandle);
+		mFileHandle = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (mData)
+	{
+		munmap(const_cast<void*>(mData), mSize);
+	}
+	if (mFileDesc >= 0)
+	{
+		close(mFileDesc);
+		mFileDesc = -1;
+	}
+#endif
+	mData = nullptr;
+	mSize = 0;
+}
+
+bool MappedFile::IsOpen() const
+{
+	return mData != nullptr;
+}
+
+const void* MappedFile::GetData() const
+{
+	return mData;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return mSize;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stddef.h>
+#include <string>
+
+// Read only memory mapped file. The mapping can be shared between threads.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::string& path);
+	void Close();
+	bool IsOpen()const;
+	const void* GetData()const;
+	size_t GetSize()const;
+
+private:
+	const void* mData;
+	size_t mSize;
+#ifdef _WIN32
+	void* mFileHandle;
+	void* mMappingHandle;
+#else
+	int mFileDesc;
+#endif
+};
\ No newline at end of file
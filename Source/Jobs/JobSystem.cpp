@@ -0,0 +1,385 @@
+#include "JobSystem.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Slot of the current thread in its pool (workers only), callers use the injection queue slot.
+static thread_local const JobSystem* t_Pool = nullptr;
+static thread_local int t_Slot = -1;
+// Tasks running on the current thread, a task waiting on a group runs others inside of it.
+static thread_local int t_Depth = 0;
+
+static std::mutex s_ConfigLock;
+static JobSystem::Settings s_Settings;
+static bool s_Created = false;
+
+#ifdef __linux__
+// "0-3,8-11" as the list of CPUs.
+static std::vector<int> ParseCpuList(const char* text)
+{
+	std::vector<int> cpus;
+	while (*text)
+	{
+		char* end;
+		const long first = strtol(text, &end, 10);
+		if (end == text)
+		{
+			break;
+		}
+		long last = first;
+		text = end;
+		if (*text == '-')
+		{
+			last = strtol(text + 1, &end, 10);
+			text = end;
+		}
+		for (long cpu = first; cpu <= last; ++cpu)
+		{
+			cpus.push_back((int)cpu);
+		}
+		text += *text == ',' ? 1 : 0;
+	}
+	return cpus;
+}
+
+// CPUs the process may run on, ordered by NUMA node, and their nodes. Everything is node 0
+// without the sysfs node directories.
+static void GetCpuTopology(std::vector<int>& cpus, std::vector<int>& nodes)
+{
+	static const int k_MaxNodes = 64;
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+	{
+		return;
+	}
+	for (int node = 0; node < k_MaxNodes; ++node)
+	{
+		const std::string path = "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist";
+		FILE* file = fopen(path.c_str(), "r");
+		if (!file)
+		{
+			continue;
+		}
+		char text[1024] = {};
+		const bool read = fgets(text, sizeof(text), file) != nullptr;
+		fclose(file);
+		for (int cpu : read ? ParseCpuList(text) : std::vector<int>())
+		{
+			if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))
+			{
+				cpus.push_back(cpu);
+				nodes.push_back(node);
+				CPU_CLR(cpu, &allowed);
+			}
+		}
+	}
+	for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+	{
+		if (CPU_ISSET(cpu, &allowed))
+		{
+			cpus.push_back(cpu);
+			nodes.push_back(0);
+		}
+	}
+}
+#endif
+
+JobSystem::Settings::Settings()
+	:NumThreads(0)
+	,Pin(false)
+{
+}
+
+JobSystem::TaskGroup::TaskGroup(JobSystem& jobs)
+	:mJobs(jobs)
+	,mPending(0)
+{
+}
+
+JobSystem::TaskGroup::~TaskGroup()
+{
+	Wait();
+}
+
+void JobSystem::TaskGroup::Run(Task task)
+{
+	++mPending;
+	mJobs.Push({ std::move(task), this });
+}
+
+void JobSystem::TaskGroup::Wait()
+{
+	const int slot = t_Pool == &mJobs ? t_Slot : (int)mJobs.mWorkers.size() - 1;
+	while (mPending > 0)
+	{
+		if (!mJobs.RunOne(slot))
+		{
+			// The last tasks run elsewhere, sleep until they are done or there is more work:
+			std::unique_lock<std::mutex> lock(mJobs.mSleepLock);
+			mJobs.mWake.wait(lock, [&]() { return mPending == 0 || mJobs.mQueued > 0; });
+		}
+	}
+}
+
+JobSystem::JobSystem(const Settings& settings)
+	:mQueued(0)
+	,mStop(false)
+	,mStatsStart(std::chrono::steady_clock::now())
+{
+	const int numThreads = settings.NumThreads > 0 ? settings.NumThreads : std::max((int)std::thread::hardware_concurrency(), 1);
+	const int numWorkers = numThreads - 1;
+
+	std::vector<int> cpus, nodes;
+#ifdef __linux__
+	if (settings.Pin)
+	{
+		GetCpuTopology(cpus, nodes);
+	}
+#endif
+	for (int w = 0; w <= numWorkers; ++w)
+	{
+		mWorkers.emplace_back(new Worker);
+		Worker& worker = *mWorkers.back();
+		worker.TasksRun = 0;
+		worker.TasksStolen = 0;
+		worker.BusyNs = 0;
+		// Worker w on the CPU after the one of the caller, callers are not pinned:
+		const bool pinned = w < numWorkers && !cpus.empty();
+		worker.Cpu = pinned ? cpus[(w + 1) % cpus.size()] : -1;
+		worker.Node = pinned ? nodes[(w + 1) % cpus.size()] : 0;
+	}
+
+	// Victims, the workers of the same node first, then the others by distance in the list:
+	for (int w = 0; w <= numWorkers; ++w)
+	{
+		Worker& worker = *mWorkers[w];
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			for (int offset = 1; offset <= numWorkers; ++offset)
+			{
+				const int victim = (w + offset) % (numWorkers + 1);
+				const bool sameNode = mWorkers[victim]->Node == worker.Node;
+				if (victim < numWorkers && sameNode == (pass == 0))
+				{
+					worker.Victims.push_back(victim);
+				}
+			}
+		}
+	}
+
+	for (int w = 0; w < numWorkers; ++w)
+	{
+		mWorkers[w]->Thread = std::thread(&JobSystem::WorkerLoop, this, w);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mSleepLock);
+		mStop = true;
+	}
+	mWake.notify_all();
+	for (std::unique_ptr<Worker>& worker : mWorkers)
+	{
+		if (worker->Thread.joinable())
+		{
+			worker->Thread.join();
+		}
+	}
+}
+
+JobSystem& JobSystem::Get()
+{
+	static JobSystem jobs([]()
+	{
+		std::lock_guard<std::mutex> lock(s_ConfigLock);
+		s_Created = true;
+		return s_Settings;
+	}());
+	return jobs;
+}
+
+bool JobSystem::Configure(const Settings& settings)
+{
+	std::lock_guard<std::mutex> lock(s_ConfigLock);
+	if (s_Created)
+	{
+		return false;
+	}
+	s_Settings = settings;
+	return true;
+}
+
+int JobSystem::GetNumWorkers() const
+{
+	return (int)mWorkers.size() - 1;
+}
+
+int JobSystem::GetConcurrency() const
+{
+	return (int)mWorkers.size();
+}
+
+void JobSystem::Push(Item item)
+{
+	// Workers push to their own deque, the other threads to the injection queue:
+	Worker& worker = t_Pool == this ? *mWorkers[t_Slot] : *mWorkers.back();
+	{
+		std::lock_guard<std::mutex> lock(worker.Lock);
+		worker.Items.push_back(std::move(item));
+	}
+	++mQueued;
+	{
+		std::lock_guard<std::mutex> lock(mSleepLock);
+	}
+	mWake.notify_one();
+}
+
+bool JobSystem::Pop(int slot, Item& item)
+{
+	if (mQueued <= 0)
+	{
+		return false;
+	}
+	const int injection = (int)mWorkers.size() - 1;
+
+	// Own tasks, newest first (still in cache):
+	if (slot != injection)
+	{
+		Worker& own = *mWorkers[slot];
+		std::lock_guard<std::mutex> lock(own.Lock);
+		if (!own.Items.empty())
+		{
+			item = std::move(own.Items.back());
+			own.Items.pop_back();
+			--mQueued;
+			return true;
+		}
+	}
+
+	// Submitted from outside, oldest first:
+	{
+		Worker& queue = *mWorkers[injection];
+		std::lock_guard<std::mutex> lock(queue.Lock);
+		if (!queue.Items.empty())
+		{
+			item = std::move(queue.Items.front());
+			queue.Items.pop_front();
+			--mQueued;
+			return true;
+		}
+	}
+
+	// Steal the oldest task of another worker:
+	for (int victim : mWorkers[slot]->Victims)
+	{
+		Worker& other = *mWorkers[victim];
+		std::lock_guard<std::mutex> lock(other.Lock);
+		if (!other.Items.empty())
+		{
+			item = std::move(other.Items.front());
+			other.Items.pop_front();
+			--mQueued;
+			++mWorkers[slot]->TasksStolen;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool JobSystem::RunOne(int slot)
+{
+	Item item;
+	if (!Pop(slot, item))
+	{
+		return false;
+	}
+	// Busy time of the outermost task only, the nested ones are part of it:
+	const auto start = std::chrono::steady_clock::now();
+	++t_Depth;
+	item.Func();
+	Worker& worker = *mWorkers[slot];
+	++worker.TasksRun;
+	if (--t_Depth == 0)
+	{
+		worker.BusyNs += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	}
+	Finish(item.Group);
+	return true;
+}
+
+void JobSystem::Finish(TaskGroup* group)
+{
+	if (--group->mPending == 0)
+	{
+		// Wakes the thread waiting on the group (and the idle ones, they go back to sleep):
+		std::lock_guard<std::mutex> lock(mSleepLock);
+		mWake.notify_all();
+	}
+}
+
+void JobSystem::WorkerLoop(int slot)
+{
+	t_Pool = this;
+	t_Slot = slot;
+#ifdef __linux__
+	const int cpu = mWorkers[slot]->Cpu;
+	if (cpu >= 0)
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	}
+#endif
+
+	for (;;)
+	{
+		if (RunOne(slot))
+		{
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(mSleepLock);
+		mWake.wait(lock, [&]() { return mQueued > 0 || mStop; });
+		if (mStop && mQueued == 0)
+		{
+			break;
+		}
+	}
+}
+
+void JobSystem::GetStats(std::vector<WorkerStats>& stats) const
+{
+	const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStatsStart).count();
+	stats.resize(mWorkers.size());
+	for (size_t w = 0; w < mWorkers.size(); ++w)
+	{
+		const Worker& worker = *mWorkers[w];
+		WorkerStats& entry = stats[w];
+		entry.Cpu = worker.Cpu;
+		entry.Node = worker.Node;
+		entry.TasksRun = worker.TasksRun;
+		entry.TasksStolen = worker.TasksStolen;
+		entry.BusyMs = (double)worker.BusyNs * 1e-6;
+		entry.Utilization = elapsedMs > 0.0 ? entry.BusyMs / elapsedMs : 0.0;
+	}
+}
+
+void JobSystem::ResetStats()
+{
+	for (std::unique_ptr<Worker>& worker : mWorkers)
+	{
+		worker->TasksRun = 0;
+		worker->TasksStolen = 0;
+		worker->BusyNs = 0;
+	}
+	mStatsStart = std::chrono::steady_clock::now();
+}
\ No newline at end of file
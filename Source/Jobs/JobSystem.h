@@ -0,0 +1,168 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work stealing thread pool shared by the batch workloads (BatchRunner, ReplayEngine, the
+// system identification, the optimizers on top of them). Every worker owns a deque: it pushes
+// and pops its own tasks at the back, idle workers steal from the front of the others, the
+// ones on the same NUMA node first. Threads outside of the pool submit to an injection queue
+// and run tasks themselves while they wait on a group, so nested parallel loops do not
+// deadlock and a pool with no workers still works (everything runs on the caller).
+//
+// On Linux the workers can be pinned, one per CPU the process may use, ordered by NUMA node
+// (sysfs) so consecutive workers share a node. The first CPU is left to the calling thread.
+//
+// Every worker counts the tasks it ran and stole and its busy time, GetStats() gives the
+// utilization since the last ResetStats(). The last slot is the calling threads.
+class JobSystem
+{
+public:
+	typedef std::function<void()> Task;
+
+	struct Settings
+	{
+		Settings();
+		int NumThreads;	// Callers included, <= 0 uses all the hardware threads
+		bool Pin;		// Linux only
+	};
+
+	struct WorkerStats
+	{
+		int Cpu;				// Pinned CPU, -1 if not pinned
+		int Node;				// NUMA node of the CPU
+		uint64_t TasksRun;
+		uint64_t TasksStolen;	// Taken from the deque of another worker
+		double BusyMs;			// Running tasks
+		double Utilization;		// Busy time over the time since ResetStats()
+	};
+
+	// Tasks that are waited on together. The group must outlive its tasks: Wait() (or the
+	// destructor) before it goes out of scope.
+	class TaskGroup
+	{
+	public:
+		explicit TaskGroup(JobSystem& jobs);
+		~TaskGroup();
+		void Run(Task task);
+		// Runs queued tasks on the calling thread until the ones of the group are done.
+		void Wait();
+
+	private:
+		friend class JobSystem;
+		TaskGroup(const TaskGroup&) = delete;
+		TaskGroup& operator=(const TaskGroup&) = delete;
+
+		JobSystem& mJobs;
+		std::atomic<int> mPending;
+	};
+
+	explicit JobSystem(const Settings& settings = Settings());
+	~JobSystem();	// Waits for the queued tasks
+
+	// Pool shared by the batch code, created on first use with the settings of Configure().
+	static JobSystem& Get();
+	// Settings of the shared pool, false once it was created (the tools call it first).
+	static bool Configure(const Settings& settings);
+
+	int GetNumWorkers()const;
+	// Threads that run tasks at once: the workers plus a caller.
+	int GetConcurrency()const;
+
+	// func(i) for every i in [0, count), on at most maxConcurrency threads at once (<= 0 is
+	// the whole pool). Threads take chunkSize indices at a time, 0 picks a size that leaves
+	// every thread a few chunks to balance. With one thread it all runs on the caller.
+	template<typename Func>
+	void ParallelFor(int count, int maxConcurrency, const Func& func, int chunkSize = 0);
+
+	void GetStats(std::vector<WorkerStats>& stats)const;
+	void ResetStats();
+
+private:
+	struct Item
+	{
+		Task Func;
+		TaskGroup* Group;
+	};
+
+	struct Worker
+	{
+		std::mutex Lock;
+		std::deque<Item> Items;
+		std::thread Thread;
+		int Cpu;
+		int Node;
+		std::vector<int> Victims;	// Deques to steal from, nearest first
+		std::atomic<uint64_t> TasksRun;
+		std::atomic<uint64_t> TasksStolen;
+		std::atomic<uint64_t> BusyNs;
+		char Padding[64];			// Keeps the counters of two workers off the same cache line
+	};
+
+	void Push(Item item);
+	// Runs one queued task, false if there was none. slot is the worker (callers use the last).
+	bool RunOne(int slot);
+	bool Pop(int slot, Item& item);
+	void WorkerLoop(int slot);
+	void Finish(TaskGroup* group);
+
+	std::vector<std::unique_ptr<Worker>> mWorkers;	// Workers, then the injection queue
+	std::atomic<int> mQueued;
+	std::atomic<bool> mStop;
+	std::mutex mSleepLock;
+	std::condition_variable mWake;
+	std::chrono::steady_clock::time_point mStatsStart;
+};
+
+template<typename Func>
+void JobSystem::ParallelFor(int count, int maxConcurrency, const Func& func, int chunkSize)
+{
+	static const int k_ChunksPerThread = 8;
+	if (count <= 0)
+	{
+		return;
+	}
+	int numThreads = maxConcurrency > 0 ? std::min(maxConcurrency, GetConcurrency()) : GetConcurrency();
+	if (chunkSize <= 0)
+	{
+		chunkSize = std::max(count / (numThreads * k_ChunksPerThread), 1);
+	}
+	numThreads = std::min(numThreads, (count + chunkSize - 1) / chunkSize);
+	if (numThreads <= 1)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			func(i);
+		}
+		return;
+	}
+
+	// One task per thread, each takes the next chunk until there are none left:
+	std::atomic<int> next(0);
+	auto runner = [&]()
+	{
+		for (int first = next.fetch_add(chunkSize); first < count; first = next.fetch_add(chunkSize))
+		{
+			const int last = std::min(first + chunkSize, count);
+			for (int i = first; i < last; ++i)
+			{
+				func(i);
+			}
+		}
+	};
+	TaskGroup group(*this);
+	for (int t = 0; t < numThreads; ++t)
+	{
+		group.Run(runner);
+	}
+	group.Wait();
+}
\ No newline at end of file
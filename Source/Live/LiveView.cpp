@@ -0,0 +1,155 @@
+#include "LiveView.h"
+#include "Replay/FlightLog.h"
+#include "Core/Logging.h"
+#include "Graphics/UI/IMGUI/imgui.h"
+
+#include <algorithm>
+
+static const double k_StatInterval = 1.0;
+
+void LiveView::LatencyStat::Add(double value)
+{
+	Sum += value;
+	Max = std::max(Max, value);
+	Count++;
+}
+
+void LiveView::LatencyStat::Publish()
+{
+	Mean = Count > 0 ? Sum / (double)Count : 0.0;
+	LastMax = Max;
+	Sum = 0.0;
+	Max = 0.0;
+	Count = 0;
+}
+
+LiveView::LiveView()
+	:LiveMode(true)
+	,mNextSequence(0)
+	,mFrame()
+	,mHasFrame(false)
+	,mLatestShown(true)
+	,mLastBoardTime(0.0)
+	,mSampleInterval(0.02f)
+	,mStatStart(0.0)
+	,mTotal()
+	,mTransport()
+	,mHost()
+{
+}
+
+void LiveView::Init(SerialCom* com)
+{
+	mStream.Start(com, "../../Temp/Live/");
+	mStatStart = TelemetryStream::Now();
+}
+
+void LiveView::Release()
+{
+	mStream.Stop();
+}
+
+void LiveView::Update()
+{
+	mText.clear();
+	mStream.FetchText(mText);
+	for (const std::string& line : mText)
+	{
+		INFO("%s", line.c_str());
+	}
+
+	mNew.clear();
+	mNextSequence = mStream.Fetch(mNextSequence, mNew);
+	if (mNew.empty())
+	{
+		return;
+	}
+
+	// Bounded plots, rebuilt from the window:
+	if (mPlotData.GetNumSamples() + (int)mNew.size() > 2 * mStream.WindowSize)
+	{
+		mPlotData.Clear();
+		mNew.clear();
+		mNextSequence = mStream.Fetch(0, mNew);
+	}
+	for (const LiveSample& sample : mNew)
+	{
+		if (mHasFrame && sample.BoardTime > mLastBoardTime)
+		{
+			mSampleInterval += 0.05f * ((float)(sample.BoardTime - mLastBoardTime) - mSampleInterval);
+		}
+		mLastBoardTime = sample.BoardTime;
+		mFrame = FlightLog::ToSimulationFrame(sample.Sample);
+		mPlotData.Append(mFrame);
+		mHasFrame = true;
+	}
+	mLatest = mNew.back();
+	mLatestShown = false;
+}
+
+void LiveView::MarkDisplayed()
+{
+	const double now = TelemetryStream::Now();
+	if (IsLive() && !mLatestShown)
+	{
+		const double host = now - mLatest.ReceiveTime;
+		mHost.Add(host);
+		mTransport.Add(mLatest.TransportDelay);
+		mTotal.Add(host + mLatest.TransportDelay);
+		mLatestShown = true;
+	}
+	if (now - mStatStart > k_StatInterval)
+	{
+		mTotal.Publish();
+		mTransport.Publish();
+		mHost.Publish();
+		mStatStart = now;
+	}
+}
+
+void LiveView::RenderUI()
+{
+	ImGui::Begin("Live");
+	{
+		ImGui::Checkbox("Live Mode", &LiveMode);
+		const TelemetryStream::Stats stats = mStream.GetStats();
+		ImGui::Text("%s, %.1f Hz", stats.Receiving ? "Receiving" : "No telemetry", mSampleInterval > 0.0f ? 1.0f / mSampleInterval : 0.0f);
+		ImGui::Text("%llu samples, %llu corrupt, %llu lines, %.1f KB", (unsigned long long)stats.NumSamples, (unsigned long long)stats.NumCorrupt, (unsigned long long)stats.NumLines, (double)stats.NumBytes / 1024.0);
+		ImGui::Text("Window: %i samples (%.1f s), %.0f KB", mStream.WindowSize, mStream.WindowSize * mSampleInterval, mStream.WindowSize * sizeof(LiveSample) / 1024.0);
+		const std::string capture = mStream.GetCapturePath();
+		ImGui::TextWrapped("Capture: %s", capture.empty() ? "none" : capture.c_str());
+		ImGui::Separator();
+		ImGui::Text("Latency (ms)  mean   max");
+		ImGui::Text("Total       %6.1f %6.1f", mTotal.Mean * 1e3, mTotal.LastMax * 1e3);
+		ImGui::Text("Transport   %6.1f %6.1f", mTransport.Mean * 1e3, mTransport.LastMax * 1e3);
+		ImGui::Text("Host        %6.1f %6.1f", mHost.Mean * 1e3, mHost.LastMax * 1e3);
+		if (mHasFrame)
+		{
+			const FlightSample& sample = mLatest.Sample;
+			ImGui::Separator();
+			ImGui::Text("Pitch %.1f Roll %.1f Yaw %.1f (deg)", glm::degrees(sample.Pitch), glm::degrees(sample.Roll), glm::degrees(sample.Yaw));
+			ImGui::Text("Thrust %.2f Motors %i %i %i %i", sample.Thrust, sample.Motors[0], sample.Motors[1], sample.Motors[2], sample.Motors[3]);
+		}
+	}
+	ImGui::End();
+}
+
+bool LiveView::IsLive() const
+{
+	return LiveMode && mHasFrame;
+}
+
+const SimulationFrame& LiveView::GetFrame() const
+{
+	return mFrame;
+}
+
+const SimulationPlotData& LiveView::GetPlotData() const
+{
+	return mPlotData;
+}
+
+float LiveView::GetSampleInterval() const
+{
+	return mSampleInterval;
+}
\ No newline at end of file
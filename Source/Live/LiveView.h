@@ -0,0 +1,74 @@
+#pragma once
+
+#include "TelemetryStream.h"
+#include "Simulation.h"
+#include "Plotting/PlotView.h"
+
+#include <string>
+#include <vector>
+
+class SerialCom;
+
+// Live window: the board telemetry as it streams in. The samples are decoded off the render
+// thread (TelemetryStream), Update() only picks up the new ones once per frame. In live mode
+// the app shows the latest sample on the quad and plots the window instead of the simulation.
+// The plot channels are rebuilt from the window when they reach twice its size, so the memory
+// stays bounded however long the session.
+//
+// Latency is from the board sample time to the frame that shows it being submitted: the
+// transport delay of the stream (see TelemetryStream) plus the time the sample waited on the
+// host. The present of that frame (vsync) comes on top.
+class LiveView
+{
+public:
+	LiveView();
+
+	// Starts reading the port, the text lines go to the log.
+	void Init(SerialCom* com);
+	void Release();
+
+	// Takes the samples that arrived since the last frame, call once per frame.
+	void Update();
+	// After rendering the frame, for the latency.
+	void MarkDisplayed();
+	void RenderUI();
+
+	// Live mode is on and a sample has arrived.
+	bool IsLive()const;
+	// Latest sample as a frame, attitude and PID terms only (no position).
+	const SimulationFrame& GetFrame()const;
+
+	const SimulationPlotData& GetPlotData()const;
+	float GetSampleInterval()const;	// Seconds between the samples, measured
+
+	bool LiveMode;
+
+private:
+	// Running mean and max over ~1 s, then published.
+	struct LatencyStat
+	{
+		void Add(double value);
+		void Publish();
+		double Sum;
+		double Max;
+		int Count;
+		double Mean;
+		double LastMax;
+	};
+
+	TelemetryStream mStream;
+	uint64_t mNextSequence;
+	std::vector<LiveSample> mNew;
+	std::vector<std::string> mText;
+	SimulationPlotData mPlotData;
+	SimulationFrame mFrame;
+	bool mHasFrame;
+	LiveSample mLatest;
+	bool mLatestShown;			// Its latency was measured
+	double mLastBoardTime;
+	float mSampleInterval;
+	double mStatStart;
+	LatencyStat mTotal;
+	LatencyStat mTransport;
+	LatencyStat mHost;
+};
\ No newline at end of file
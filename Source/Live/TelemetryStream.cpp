@@ -0,0 +1,233 @@
+#include "TelemetryStream.h"
+#include "Coms/SerialCom.h"
+#include "IO/Directory.h"
+#include "Replay/FlightLog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+
+static const size_t k_MaxLineLength = 4096;		// Longer lines are garbage, dropped
+static const size_t k_MaxTextLines = 1024;		// Text waiting for the log, the oldest are dropped
+static const double k_OffsetEpoch = 5.0;		// Seconds, the offset is the minimum of two epochs
+static const double k_FlushInterval = 1.0;
+
+TelemetryStream::TelemetryStream()
+	:WindowSize(3000)
+	,mCom(nullptr)
+	,mRunning(false)
+	,mCapture(nullptr)
+	,mLastFlushTime(0.0)
+	,mLastTimeUs(0)
+	,mTimeHighUs(0)
+	,mHasTime(false)
+	,mEpochStart(0.0)
+	,mNextSequence(0)
+	,mStats()
+	,mLastSampleTime(-1.0)
+{
+	mOffsetMin[0] = mOffsetMin[1] = 0.0;
+}
+
+TelemetryStream::~TelemetryStream()
+{
+	Stop();
+}
+
+void TelemetryStream::Start(SerialCom* com, const std::string& captureDirectory)
+{
+	Stop();
+	mCom = com;
+	mCaptureDirectory = captureDirectory;
+	mLine.clear();
+	mHasTime = false;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mWindow.assign(std::max(WindowSize, 1), LiveSample());
+		mNextSequence = 0;
+		mText.clear();
+		mStats = Stats();
+		mLastSampleTime = -1.0;
+		mCapturePath.clear();
+	}
+	mRunning = true;
+	mThread = std::thread(&TelemetryStream::Run, this);
+}
+
+void TelemetryStream::Stop()
+{
+	mRunning = false;
+	if (mThread.joinable())
+	{
+		mThread.join();
+	}
+	if (mCapture)
+	{
+		fclose(mCapture);
+		mCapture = nullptr;
+	}
+}
+
+uint64_t TelemetryStream::Fetch(uint64_t firstSequence, std::vector<LiveSample>& samples) const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	const uint64_t size = (uint64_t)mWindow.size();
+	const uint64_t oldest = mNextSequence > size ? mNextSequence - size : 0;
+	for (uint64_t s = std::max(firstSequence, oldest); s < mNextSequence; ++s)
+	{
+		samples.push_back(mWindow[(size_t)(s % size)]);
+	}
+	return mNextSequence;
+}
+
+void TelemetryStream::FetchText(std::vector<std::string>& lines)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	lines.insert(lines.end(), mText.begin(), mText.end());
+	mText.clear();
+}
+
+TelemetryStream::Stats TelemetryStream::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	Stats stats = mStats;
+	stats.Receiving = mLastSampleTime >= 0.0 && Now() - mLastSampleTime < 1.0;
+	return stats;
+}
+
+std::string TelemetryStream::GetCapturePath() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mCapturePath;
+}
+
+double TelemetryStream::Now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void TelemetryStream::Run()
+{
+	// ReadBytes returns after ~2 ms without data (SerialCom timeouts):
+	char buffer[1024];
+	while (mRunning)
+	{
+		const int numBytes = mCom ? mCom->ReadBytes(buffer, sizeof(buffer)) : 0;
+		if (numBytes <= 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+		Ingest(buffer, numBytes, Now());
+	}
+}
+
+void TelemetryStream::Ingest(const char* data, int size, double time)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStats.NumBytes += (uint64_t)size;
+	}
+	for (int i = 0; i < size; ++i)
+	{
+		const char c = data[i];
+		if (c == '\n')
+		{
+			ProcessLine(time);
+			mLine.clear();
+		}
+		else if (c != '\r' && mLine.size() < k_MaxLineLength)
+		{
+			mLine += c;
+		}
+	}
+	if (mCapture && time - mLastFlushTime > k_FlushInterval)
+	{
+		fflush(mCapture);
+		mLastFlushTime = time;
+	}
+}
+
+void TelemetryStream::ProcessLine(double time)
+{
+	WriteCapture(mLine, time);
+
+	const size_t marker = mLine.find("QTEL ");
+	if (marker == std::string::npos)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStats.NumLines++;
+		if (mText.size() >= k_MaxTextLines)
+		{
+			mText.pop_front();
+		}
+		mText.push_back(mLine);
+		return;
+	}
+
+	LiveSample live;
+	if (!FlightLog::ParseStreamLine(mLine.c_str() + marker + 5, live.Sample))
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStats.NumLines++;
+		mStats.NumCorrupt++;
+		return;
+	}
+
+	// micros() wraps every ~71 min:
+	const uint32_t timeUs = live.Sample.TimeUs;
+	if (mHasTime && timeUs < mLastTimeUs && mLastTimeUs - timeUs > 0x80000000u)
+	{
+		mTimeHighUs += 1ull << 32;
+	}
+	mLastTimeUs = timeUs;
+	live.BoardTime = (double)(mTimeHighUs + timeUs) * 1e-6;
+	live.ReceiveTime = time;
+
+	// Clock offset, the minimum over the previous and the current epoch:
+	const double offset = time - live.BoardTime;
+	if (!mHasTime)
+	{
+		mOffsetMin[0] = mOffsetMin[1] = offset;
+		mEpochStart = time;
+		mHasTime = true;
+	}
+	else if (time - mEpochStart > k_OffsetEpoch)
+	{
+		mOffsetMin[0] = mOffsetMin[1];
+		mOffsetMin[1] = offset;
+		mEpochStart = time;
+	}
+	mOffsetMin[1] = std::min(mOffsetMin[1], offset);
+	live.TransportDelay = offset - std::min(mOffsetMin[0], mOffsetMin[1]);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mWindow[(size_t)(mNextSequence % mWindow.size())] = live;
+	mNextSequence++;
+	mStats.NumLines++;
+	mStats.NumSamples++;
+	mLastSampleTime = time;
+}
+
+void TelemetryStream::WriteCapture(const std::string& line, double time)
+{
+	if (!mCapture && !mCaptureDirectory.empty())
+	{
+		char name[64];
+		const time_t now = ::time(nullptr);
+		strftime(name, sizeof(name), "Live_%Y%m%d_%H%M%S.txt", localtime(&now));
+		const std::string path = Directory::Join(mCaptureDirectory, name);
+		mCapture = Directory::Create(mCaptureDirectory) ? fopen(path.c_str(), "w") : nullptr;
+		mLastFlushTime = time;
+		mCaptureDirectory = mCapture ? mCaptureDirectory : std::string();	// Only tried once
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		mCapturePath = mCapture ? path : std::string();
+	}
+	if (mCapture)
+	{
+		fputs(line.c_str(), mCapture);
+		fputc('\n', mCapture);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "FlightRecorder.h"
+
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class SerialCom;
+
+// A streamed sample as it reached the host.
+struct LiveSample
+{
+	FlightSample Sample;
+	double BoardTime;		// Sample time (s), the board micros() unwrapped
+	double ReceiveTime;		// Host clock (TelemetryStream::Now) when its line was read
+	double TransportDelay;	// Board to host delay (s), see TelemetryStream
+};
+
+// Ingests the board serial port on its own thread, so a slow frame never stalls it and the
+// decoding never stalls a frame. The lines are split there: the telemetry stream (QTEL lines,
+// see StreamTelemetry in Board/src/main.cpp) is decoded into a rolling window of the last
+// WindowSize samples, everything else is queued as text for the log. Every line is also
+// appended to a capture file as it arrives, the samples that leave the window are still on
+// disk and the capture opens in the Replay window and flightrec.
+//
+// The board and host clocks are not synchronized. The delay of a sample is measured against
+// the fastest one of the last ~10 s (the clock offset is the minimum of receive time minus
+// board time), so it is the queuing and transport delay over the USB floor, not including
+// the floor itself (a ~1 ms USB frame). The estimate follows the drift of the board clock.
+class TelemetryStream
+{
+public:
+	struct Stats
+	{
+		uint64_t NumLines;
+		uint64_t NumSamples;
+		uint64_t NumCorrupt;	// QTEL lines that failed the CRC or the unpacking
+		uint64_t NumBytes;
+		bool Receiving;			// Got a sample in the last second
+	};
+
+	TelemetryStream();
+	~TelemetryStream();
+
+	// Reads com until Stop(). The capture file is created in captureDirectory with the first
+	// line, an empty one disables the capture.
+	void Start(SerialCom* com, const std::string& captureDirectory);
+	void Stop();
+
+	// Appends the samples of the window from sequence firstSequence on (the sequence counts
+	// every sample since Start). Returns the sequence after the last one, pass it to the next
+	// call. Older samples that already left the window are skipped.
+	uint64_t Fetch(uint64_t firstSequence, std::vector<LiveSample>& samples)const;
+
+	// Moves the queued text lines to lines.
+	void FetchText(std::vector<std::string>& lines);
+
+	Stats GetStats()const;
+	std::string GetCapturePath()const;
+
+	// Seconds of a monotonic host clock.
+	static double Now();
+
+	int WindowSize;		// Samples kept in memory, set before Start()
+
+private:
+	void Run();
+	void Ingest(const char* data, int size, double time);
+	void ProcessLine(double time);
+	void WriteCapture(const std::string& line, double time);
+
+	SerialCom* mCom;
+	std::thread mThread;
+	std::atomic<bool> mRunning;
+
+	// Ingestion thread only:
+	std::string mCaptureDirectory;
+	FILE* mCapture;
+	double mLastFlushTime;
+	std::string mLine;
+	uint32_t mLastTimeUs;		// Board time unwrapping
+	uint64_t mTimeHighUs;
+	bool mHasTime;
+	double mOffsetMin[2];		// Receive minus board time, minimum of the previous and current epoch
+	double mEpochStart;
+
+	// Shared, mMutex:
+	mutable std::mutex mMutex;
+	std::vector<LiveSample> mWindow;	// Ring, sequence s is at s % WindowSize
+	uint64_t mNextSequence;
+	std::deque<std::string> mText;
+	Stats mStats;
+	double mLastSampleTime;
+	std::string mCapturePath;
+};
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include "MotorModel.h"
+
+#ifndef HEADLESS
+	#include "Graphics/UI/IMGUI/imgui.h"
+#endif
+
+#include <cmath>
+#include <algorithm>
+
+// Props of the board: FL and RR speeding up turn the quad left seen from above, which is what
+// the firmware yaw loop expects (Quad X mixer yaw column, board estimator yaw). That is a
+// torque around the body down axis, the simulation yaw grows turning right.
+const float MotorModel::k_SpinDirection[MotorModel::k_NumMotors] = { -1.0f, 1.0f, 1.0f, -1.0f };
+
+MotorModel::MotorModel()
+{
+	Motor.MaxThrust = 0.3675f; // RaceStart 8250
+	Motor.ThrustCurve = 0.7f;
+	Motor.TorqueCoeff = 0.006f;
+	Motor.TimeConstant = 0.03f;
+	Motor.NominalVoltage = 4.2f;
+	Motor.InternalResistance = 0.05f;
+	Motor.MaxCurrent = 2.5f;
+	Motor.PWMBits = 8;
+
+	ThrustOffset[0] = 0.01f;
+	ThrustOffset[1] = 0.0233f;
+	ThrustOffset[2] = 0.0175f;
+	ThrustOffset[3] = 0.0137f;
+
+	Reset();
+}
+
+void MotorModel::RenderUI()
+{
+#ifndef HEADLESS
+	ImGui::InputFloat("Max Thrust (N)", &Motor.MaxThrust);
+	ImGui::SliderFloat("Thrust Curve", &Motor.ThrustCurve, 0.0f, 1.0f);
+	ImGui::InputFloat("Torque Coeff", &Motor.TorqueCoeff);
+	ImGui::InputFloat("Time Constant (s)", &Motor.TimeConstant);
+	ImGui::InputFloat("Nominal Voltage", &Motor.NominalVoltage);
+	ImGui::InputFloat("Internal Resistance", &Motor.InternalResistance);
+	ImGui::InputFloat("Max Current (A)", &Motor.MaxCurrent);
+	ImGui::SliderInt("PWM Bits", &Motor.PWMBits, 0, 16);
+	ImGui::InputFloat4("Thrust Offset", ThrustOffset);
+#endif
+}
+
+void MotorModel::Reset()
+{
+	for (int i = 0; i < k_NumMotors; ++i)
+	{
+		mSpeed[i] = 0.0f;
+	}
+	mVoltage = Motor.NominalVoltage;
+	mLagAlpha = 1.0f;
+	mLagDeltaTime = -1.0f;
+	mLagTimeConstant = -1.0f;
+}
+
+void MotorModel::Reset(const float* commands)
+{
+	Reset();
+	for (int i = 0; i < k_NumMotors; ++i)
+	{
+		mSpeed[i] = std::min(std::max(commands[i], 0.0f), 1.0f);
+	}
+}
+
+void MotorModel::Step(const float* commands, float deltaTime, float* thrust, float& yawTorque)
+{
+	// The lag factor only changes with the time step, avoid the exp() per motor and step:
+	if (deltaTime != mLagDeltaTime || Motor.TimeConstant != mLagTimeConstant)
+	{
+		mLagDeltaTime = deltaTime;
+		mLagTimeConstant = Motor.TimeConstant;
+		mLagAlpha = Motor.TimeConstant > 0.0f ? 1.0f - std::exp(-deltaTime / Motor.TimeConstant) : 1.0f;
+	}
+
+	StepMotors(Motor, ThrustOffset, mLagAlpha, commands, mSpeed, mVoltage, thrust, yawTorque);
+}
+
+float MotorModel::GetVoltage() const
+{
+	return mVoltage;
+}
+
+MotorModel::State MotorModel::GetState() const
+{
+	State state;
+	for (int i = 0; i < k_NumMotors; ++i)
+	{
+		state.Speed[i] = mSpeed[i];
+	}
+	state.Voltage = mVoltage;
+	return state;
+}
+
+void MotorModel::SetState(const State& state)
+{
+	for (int i = 0; i < k_NumMotors; ++i)
+	{
+		mSpeed[i] = state.Speed[i];
+	}
+	mVoltage = state.Voltage;
+}
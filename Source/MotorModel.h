@@ -0,0 +1,96 @@
+#pragma once
+
+#include <math.h>
+
+// Motor, propeller and battery model used by the simulation. Motor order matches FCCommands.
+//   - Commands are quantized like the board analogWrite (PWMBits).
+//   - Rotor speed follows the command with a first order lag (ESC + rotor inertia).
+//   - Thrust is a blend of a linear and a quadratic curve of the rotor speed.
+//   - Reaction torque is proportional to the thrust, the sign depends on the spin direction.
+//   - Battery voltage sags with the current drawn on the previous step, max speed scales with it.
+class MotorModel
+{
+public:
+	static const int k_NumMotors = 4;
+
+	struct Params
+	{
+		float MaxThrust;			// Thrust at full command and nominal voltage (N)
+		float ThrustCurve;			// 0 = linear, 1 = quadratic thrust vs rotor speed
+		float TorqueCoeff;			// Reaction torque per newton of thrust (N*m/N)
+		float TimeConstant;			// Spin up/down time constant (s)
+		float NominalVoltage;		// Battery open circuit voltage (V)
+		float InternalResistance;	// Battery and wiring resistance (ohm)
+		float MaxCurrent;			// Current drawn by one motor at full thrust (A)
+		int PWMBits;				// Command resolution, 0 disables the quantization
+	};
+
+	// Rotor speeds and battery voltage, used by the simulation snapshots.
+	struct State
+	{
+		float Speed[k_NumMotors];
+		float Voltage;
+	};
+
+	MotorModel();
+	void RenderUI();
+	void Reset();
+	// Starts the rotors at the steady state speed of the commands (used to start mid flight).
+	void Reset(const float* commands);
+
+	// Advances the motors by deltaTime. Commands in [0,1], outputs the thrust of each
+	// motor (N) and the total reaction torque around the quad up axis (N*m).
+	void Step(const float* commands, float deltaTime, float* thrust, float& yawTorque);
+
+	// The same step on an explicit state, lagAlpha = 1 - exp(-deltaTime / TimeConstant).
+	// Templated on the scalar for the gain optimizer, which clears PWMBits (the quantization
+	// has no useful derivative).
+	template<typename Scalar>
+	static void StepMotors(const Params& motor, const float* thrustOffset, float lagAlpha, const Scalar* commands, Scalar* speed, Scalar& voltage, Scalar* thrust, Scalar& yawTorque);
+
+	float GetVoltage()const;
+	State GetState()const;
+	void SetState(const State& state);
+
+	Params Motor;
+	float ThrustOffset[k_NumMotors];	// Per motor variation added to MaxThrust (N)
+
+	static const float k_SpinDirection[k_NumMotors];	// FL, FR, RL, RR
+
+private:
+	float mSpeed[k_NumMotors];	// Normalized rotor speed [0,1]
+	float mVoltage;
+	float mLagAlpha;			// Cached for mLagDeltaTime/mLagTimeConstant
+	float mLagDeltaTime;
+	float mLagTimeConstant;
+};
+
+template<typename Scalar>
+void MotorModel::StepMotors(const Params& motor, const float* thrustOffset, float lagAlpha, const Scalar* commands, Scalar* speed, Scalar& voltage, Scalar* thrust, Scalar& yawTorque)
+{
+	float pwmSteps = motor.PWMBits > 0 ? (float)((1 << motor.PWMBits) - 1) : 0.0f;
+	Scalar voltageScale = motor.NominalVoltage > 0.0f ? voltage / motor.NominalVoltage : Scalar(1.0f);
+
+	Scalar current = 0.0f;
+	yawTorque = 0.0f;
+	for (int i = 0; i < k_NumMotors; ++i)
+	{
+		Scalar cmd = fminf(fmaxf(commands[i], 0.0f), 1.0f);
+		if (pwmSteps > 0.0f)
+		{
+			cmd = floorf(cmd * pwmSteps) / pwmSteps; // analogWrite truncates (int cast)
+		}
+
+		speed[i] += lagAlpha * (cmd * voltageScale - speed[i]);
+
+		Scalar curve = motor.ThrustCurve * speed[i] * speed[i] + (1.0f - motor.ThrustCurve) * speed[i];
+		thrust[i] = curve * (motor.MaxThrust + thrustOffset[i]);
+		yawTorque += k_SpinDirection[i] * motor.TorqueCoeff * thrust[i];
+
+		// Momentum theory, power (and current) goes with thrust^1.5:
+		current += motor.MaxCurrent * curve * sqrtf(curve);
+	}
+
+	// Sag for the next step, using the current of this one:
+	voltage = fmaxf(motor.NominalVoltage - motor.InternalResistance * current, 0.0f);
+}
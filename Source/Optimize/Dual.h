@@ -0,0 +1,159 @@
+#pragma once
+
+#include <math.h>
+
+// Forward mode automatic differentiation: a value and its derivatives with respect to N
+// parameters. Code templated on the scalar (PIDT, Mixer::Mix, the controller laws, RigidBody,
+// MotorModel::StepMotors) run with it gives the exact gradient of its result in the same
+// pass. Constants convert implicitly (zero derivatives), comparisons only look at the value,
+// so branches and min/max pick a side and differentiate that one (like a subgradient).
+// The math functions use the float names (fminf, sqrtf...) so the templates call the same
+// ones for both scalars.
+template<int N>
+struct Dual
+{
+	Dual()
+		:Value(0.0f)
+	{
+		for (int i = 0; i < N; ++i)
+		{
+			Grad[i] = 0.0f;
+		}
+	}
+
+	Dual(float value)
+		:Value(value)
+	{
+		for (int i = 0; i < N; ++i)
+		{
+			Grad[i] = 0.0f;
+		}
+	}
+
+	// Parameter idx, its own derivative is 1.
+	static Dual Variable(float value, int idx)
+	{
+		Dual dual(value);
+		dual.Grad[idx] = 1.0f;
+		return dual;
+	}
+
+	Dual& operator+=(const Dual& b) { *this = *this + b; return *this; }
+	Dual& operator-=(const Dual& b) { *this = *this - b; return *this; }
+	Dual& operator*=(const Dual& b) { *this = *this * b; return *this; }
+	Dual& operator/=(const Dual& b) { *this = *this / b; return *this; }
+
+	float Value;
+	float Grad[N];
+};
+
+// Result value with the derivatives d = da * ka + db * kb, the chain rule of every operation.
+template<int N>
+inline Dual<N> MakeDual(float value, const Dual<N>& a, float ka)
+{
+	Dual<N> r;
+	r.Value = value;
+	for (int i = 0; i < N; ++i)
+	{
+		r.Grad[i] = a.Grad[i] * ka;
+	}
+	return r;
+}
+
+template<int N>
+inline Dual<N> MakeDual(float value, const Dual<N>& a, float ka, const Dual<N>& b, float kb)
+{
+	Dual<N> r;
+	r.Value = value;
+	for (int i = 0; i < N; ++i)
+	{
+		r.Grad[i] = a.Grad[i] * ka + b.Grad[i] * kb;
+	}
+	return r;
+}
+
+template<int N> inline Dual<N> operator-(const Dual<N>& a) { return MakeDual(-a.Value, a, -1.0f); }
+
+template<int N> inline Dual<N> operator+(const Dual<N>& a, const Dual<N>& b) { return MakeDual(a.Value + b.Value, a, 1.0f, b, 1.0f); }
+template<int N> inline Dual<N> operator+(const Dual<N>& a, float b) { return MakeDual(a.Value + b, a, 1.0f); }
+template<int N> inline Dual<N> operator+(float a, const Dual<N>& b) { return MakeDual(a + b.Value, b, 1.0f); }
+
+template<int N> inline Dual<N> operator-(const Dual<N>& a, const Dual<N>& b) { return MakeDual(a.Value - b.Value, a, 1.0f, b, -1.0f); }
+template<int N> inline Dual<N> operator-(const Dual<N>& a, float b) { return MakeDual(a.Value - b, a, 1.0f); }
+template<int N> inline Dual<N> operator-(float a, const Dual<N>& b) { return MakeDual(a - b.Value, b, -1.0f); }
+
+template<int N> inline Dual<N> operator*(const Dual<N>& a, const Dual<N>& b) { return MakeDual(a.Value * b.Value, a, b.Value, b, a.Value); }
+template<int N> inline Dual<N> operator*(const Dual<N>& a, float b) { return MakeDual(a.Value * b, a, b); }
+template<int N> inline Dual<N> operator*(float a, const Dual<N>& b) { return MakeDual(a * b.Value, b, a); }
+
+template<int N> inline Dual<N> operator/(const Dual<N>& a, const Dual<N>& b)
+{
+	const float inv = 1.0f / b.Value;
+	const float value = a.Value * inv;
+	return MakeDual(value, a, inv, b, -value * inv);
+}
+template<int N> inline Dual<N> operator/(const Dual<N>& a, float b) { return MakeDual(a.Value / b, a, 1.0f / b); }
+template<int N> inline Dual<N> operator/(float a, const Dual<N>& b)
+{
+	const float value = a / b.Value;
+	return MakeDual(value, b, -value / b.Value);
+}
+
+#define DUAL_COMPARISON(op) \
+	template<int N> inline bool operator op(const Dual<N>& a, const Dual<N>& b) { return a.Value op b.Value; } \
+	template<int N> inline bool operator op(const Dual<N>& a, float b) { return a.Value op b; } \
+	template<int N> inline bool operator op(float a, const Dual<N>& b) { return a op b.Value; }
+DUAL_COMPARISON(<)
+DUAL_COMPARISON(<=)
+DUAL_COMPARISON(>)
+DUAL_COMPARISON(>=)
+DUAL_COMPARISON(==)
+DUAL_COMPARISON(!=)
+#undef DUAL_COMPARISON
+
+template<int N> inline Dual<N> fminf(const Dual<N>& a, const Dual<N>& b) { return b.Value < a.Value ? b : a; }
+template<int N> inline Dual<N> fminf(const Dual<N>& a, float b) { return b < a.Value ? Dual<N>(b) : a; }
+template<int N> inline Dual<N> fminf(float a, const Dual<N>& b) { return b.Value < a ? b : Dual<N>(a); }
+template<int N> inline Dual<N> fmaxf(const Dual<N>& a, const Dual<N>& b) { return b.Value > a.Value ? b : a; }
+template<int N> inline Dual<N> fmaxf(const Dual<N>& a, float b) { return b > a.Value ? Dual<N>(b) : a; }
+template<int N> inline Dual<N> fmaxf(float a, const Dual<N>& b) { return b.Value > a ? b : Dual<N>(a); }
+
+template<int N> inline Dual<N> fabsf(const Dual<N>& a) { return a.Value < 0.0f ? -a : a; }
+template<int N> inline Dual<N> floorf(const Dual<N>& a) { return Dual<N>(::floorf(a.Value)); }
+
+// The derivative at 0 is infinite, taken as 0 (the values we take the root of are squares).
+template<int N> inline Dual<N> sqrtf(const Dual<N>& a)
+{
+	const float value = ::sqrtf(a.Value);
+	return MakeDual(value, a, value > 0.0f ? 0.5f / value : 0.0f);
+}
+
+template<int N> inline Dual<N> expf(const Dual<N>& a)
+{
+	const float value = ::expf(a.Value);
+	return MakeDual(value, a, value);
+}
+
+template<int N> inline Dual<N> asinf(const Dual<N>& a)
+{
+	const float cos = ::sqrtf(1.0f - a.Value * a.Value);
+	return MakeDual(::asinf(a.Value), a, cos > 0.0f ? 1.0f / cos : 0.0f);
+}
+
+template<int N> inline Dual<N> atan2f(const Dual<N>& y, const Dual<N>& x)
+{
+	const float lengthSq = x.Value * x.Value + y.Value * y.Value;
+	const float inv = lengthSq > 0.0f ? 1.0f / lengthSq : 0.0f;
+	return MakeDual(::atan2f(y.Value, x.Value), y, x.Value * inv, x, -y.Value * inv);
+}
+
+// Value of a scalar, the same for both.
+inline float ScalarValue(float value)
+{
+	return value;
+}
+
+template<int N> inline float ScalarValue(const Dual<N>& value)
+{
+	return value.Value;
+}
\ No newline at end of file
@@ -0,0 +1,691 @@
+#include "EvolutionOptimizer.h"
+#include "DefaultGainSet.h"
+#include "RandomStream.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <sstream>
+
+static const int k_MaxJacobiSweeps = 50;
+
+// Eigen decomposition of a symmetric n x n matrix (row major) by cyclic Jacobi rotations,
+// plenty for the dozen parameters we have. The eigenvectors are the columns of vectors.
+static void SymmetricEigen(std::vector<double> a, int n, std::vector<double>& vectors, std::vector<double>& values)
+{
+	vectors.assign(n * n, 0.0);
+	for (int i = 0; i < n; ++i)
+	{
+		vectors[i * n + i] = 1.0;
+	}
+	for (int sweep = 0; sweep < k_MaxJacobiSweeps; ++sweep)
+	{
+		double offDiagonal = 0.0;
+		for (int p = 0; p < n; ++p)
+		{
+			for (int q = p + 1; q < n; ++q)
+			{
+				offDiagonal += a[p * n + q] * a[p * n + q];
+			}
+		}
+		if (offDiagonal < 1e-30)
+		{
+			break;
+		}
+
+		for (int p = 0; p < n; ++p)
+		{
+			for (int q = p + 1; q < n; ++q)
+			{
+				const double apq = a[p * n + q];
+				if (std::fabs(apq) < 1e-300)
+				{
+					continue;
+				}
+				// Rotation that zeroes a[p][q], A = J' * A * J:
+				const double theta = (a[q * n + q] - a[p * n + p]) / (2.0 * apq);
+				const double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+				const double c = 1.0 / std::sqrt(t * t + 1.0);
+				const double s = t * c;
+				for (int k = 0; k < n; ++k)
+				{
+					const double akp = a[k * n + p];
+					const double akq = a[k * n + q];
+					a[k * n + p] = c * akp - s * akq;
+					a[k * n + q] = s * akp + c * akq;
+				}
+				for (int k = 0; k < n; ++k)
+				{
+					const double apk = a[p * n + k];
+					const double aqk = a[q * n + k];
+					a[p * n + k] = c * apk - s * aqk;
+					a[q * n + k] = s * apk + c * aqk;
+				}
+				for (int k = 0; k < n; ++k)
+				{
+					const double vkp = vectors[k * n + p];
+					const double vkq = vectors[k * n + q];
+					vectors[k * n + p] = c * vkp - s * vkq;
+					vectors[k * n + q] = s * vkp + c * vkq;
+				}
+			}
+		}
+	}
+	values.resize(n);
+	for (int i = 0; i < n; ++i)
+	{
+		values[i] = a[i * n + i];
+	}
+}
+
+static double Norm(const std::vector<double>& a)
+{
+	double sum = 0.0;
+	for (double value : a)
+	{
+		sum += value * value;
+	}
+	return std::sqrt(sum);
+}
+
+static void WriteRow(FILE* file, const char* key, const std::vector<double>& values, size_t first, size_t count)
+{
+	fprintf(file, "%s", key);
+	for (size_t i = first; i < first + count; ++i)
+	{
+		fprintf(file, " %.17g", values[i]);
+	}
+	fprintf(file, "\n");
+}
+
+static bool ReadRow(std::istringstream& tokens, std::vector<double>& values, size_t first, size_t count)
+{
+	for (size_t i = first; i < first + count; ++i)
+	{
+		if (!(tokens >> values[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+EvolutionOptimizer::EvolutionOptimizer()
+	:HeightWeight(100.0f)
+	,EffortWeight(50.0f)
+	,FailPenalty(100.0f)
+	,RobustWeight(0.5f)
+	,NumSeeds(4)
+	,GustIntensity(0.0f)
+	,MinGain(1e-3f)
+	,ArmLengthRange(1.5f)
+	,Sigma(0.3f)
+	,PopulationSize(0)
+	,NumThreads(0)
+	,Seed(1)
+	,Tolerance(1e-3f)
+	,mGains(k_DefaultGainSet)
+	,mBestCost(std::numeric_limits<float>::infinity())
+{
+}
+
+void EvolutionOptimizer::Init(const BatchJob& job)
+{
+	mJob = job;
+	mGains = job.HasGains ? job.Gains : k_DefaultGainSet;
+	SetParameters(GetDefaultParameters(job.Scn.Control, false));
+}
+
+std::vector<EvolutionOptimizer::Parameter> EvolutionOptimizer::GetDefaultParameters(Scenario::Controller::T controller, bool armLength)
+{
+	std::vector<Parameter> parameters;
+	for (const GainOptimizer::Parameter& gain : GainOptimizer::GetDefaultParameters(controller))
+	{
+		Parameter parameter;
+		parameter.Type = Target::Gain;
+		parameter.Slot = gain.Slot;
+		parameter.Gain = gain.Gain;
+		parameters.push_back(parameter);
+	}
+	if (armLength)
+	{
+		Parameter parameter;
+		parameter.Type = Target::ArmLength;
+		parameter.Slot = GainSlot::Height;
+		parameter.Gain = GainOptimizer::Term::KP;
+		parameters.push_back(parameter);
+	}
+	return parameters;
+}
+
+void EvolutionOptimizer::SetParameters(const std::vector<Parameter>& parameters)
+{
+	mParameters = parameters;
+	mStart = GetStartValues();
+	Reset();
+}
+
+const std::vector<EvolutionOptimizer::Parameter>& EvolutionOptimizer::GetParameters() const
+{
+	return mParameters;
+}
+
+std::string EvolutionOptimizer::ToStr(const Parameter& parameter)
+{
+	if (parameter.Type == Target::ArmLength)
+	{
+		return "ArmLength";
+	}
+	return std::string(GainSlot::ToStr(parameter.Slot)) + " " + GainOptimizer::Term::ToStr(parameter.Gain);
+}
+
+std::vector<float> EvolutionOptimizer::GetStartValues() const
+{
+	std::vector<float> values(mParameters.size());
+	for (size_t p = 0; p < mParameters.size(); ++p)
+	{
+		const Parameter& parameter = mParameters[p];
+		if (parameter.Type == Target::ArmLength)
+		{
+			values[p] = std::log(mJob.Airframe.ArmLength);
+			continue;
+		}
+		const PIDGains& gains = mGains.Gains[parameter.Slot];
+		const float gain = parameter.Gain == GainOptimizer::Term::KP ? gains.KP : parameter.Gain == GainOptimizer::Term::KI ? gains.KI : gains.KD;
+		values[p] = std::log(std::max(gain, MinGain));
+	}
+	return values;
+}
+
+float EvolutionOptimizer::ToValue(float value)
+{
+	return std::exp(value);
+}
+
+void EvolutionOptimizer::Reset()
+{
+	const int n = (int)mParameters.size();
+	mLambda = PopulationSize > 0 ? PopulationSize : 4 + (int)std::floor(3.0 * std::log((double)std::max(n, 1)));
+	mLambda = std::max(mLambda, 2);
+	mMu = mLambda / 2;
+
+	// Log decreasing weights of the best half:
+	mWeights.resize(mMu);
+	for (int i = 0; i < mMu; ++i)
+	{
+		mWeights[i] = std::log(mMu + 0.5) - std::log(i + 1.0);
+	}
+	const double sum = std::accumulate(mWeights.begin(), mWeights.end(), 0.0);
+	double sumSq = 0.0;
+	for (double& weight : mWeights)
+	{
+		weight /= sum;
+		sumSq += weight * weight;
+	}
+	mMuEff = 1.0 / sumSq;
+
+	// Learning rates, the defaults of Hansen's tutorial:
+	mCc = (4.0 + mMuEff / n) / (n + 4.0 + 2.0 * mMuEff / n);
+	mCs = (mMuEff + 2.0) / (n + mMuEff + 5.0);
+	mC1 = 2.0 / ((n + 1.3) * (n + 1.3) + mMuEff);
+	mCmu = std::min(1.0 - mC1, 2.0 * (mMuEff - 2.0 + 1.0 / mMuEff) / ((n + 2.0) * (n + 2.0) + mMuEff));
+	mDamps = 1.0 + 2.0 * std::max(0.0, std::sqrt((mMuEff - 1.0) / (n + 1.0)) - 1.0) + mCs;
+	mChiN = std::sqrt((double)n) * (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+
+	mGeneration = 0;
+	mNumEvaluations = 0;
+	mSigma = Sigma;
+	mMean.assign(mStart.begin(), mStart.end());
+	mPathC.assign(n, 0.0);
+	mPathS.assign(n, 0.0);
+	mCov.assign(n * n, 0.0);
+	for (int i = 0; i < n; ++i)
+	{
+		mCov[i * n + i] = 1.0;
+	}
+	Decompose();
+
+	mBestValues = mStart;
+	mBestCost = std::numeric_limits<float>::infinity();
+	mHistory.clear();
+}
+
+void EvolutionOptimizer::Decompose()
+{
+	const int n = (int)mParameters.size();
+	SymmetricEigen(mCov, n, mAxes, mScales);
+	for (double& scale : mScales)
+	{
+		scale = std::sqrt(std::max(scale, 1e-20));
+	}
+}
+
+void EvolutionOptimizer::Clamp(std::vector<double>& values) const
+{
+	for (size_t p = 0; p < mParameters.size(); ++p)
+	{
+		if (mParameters[p].Type == Target::ArmLength)
+		{
+			const double range = std::log((double)std::max(ArmLengthRange, 1.0f));
+			values[p] = std::min(std::max(values[p], mStart[p] - range), mStart[p] + range);
+		}
+	}
+}
+
+BatchJob EvolutionOptimizer::ToJob(const std::vector<float>& values) const
+{
+	BatchJob job = mJob;
+	job.Gains = mGains;
+	job.HasGains = true;
+	for (size_t p = 0; p < mParameters.size() && p < values.size(); ++p)
+	{
+		const Parameter& parameter = mParameters[p];
+		const float value = ToValue(values[p]);
+		if (parameter.Type == Target::ArmLength)
+		{
+			job.Airframe.ArmLength = value;
+			continue;
+		}
+		PIDGains& gains = job.Gains.Gains[parameter.Slot];
+		switch (parameter.Gain)
+		{
+		case GainOptimizer::Term::KP:	gains.KP = value; break;
+		case GainOptimizer::Term::KI:	gains.KI = value; break;
+		default:						gains.KD = value; break;
+		}
+	}
+	SealGainSet(job.Gains);
+	return job;
+}
+
+float EvolutionOptimizer::ComputeCost(const BatchResult& result) const
+{
+	const Scenario& scenario = mJob.Scn;
+	const bool unity = scenario.Control == Scenario::Controller::Unity;
+	const float* metrics = result.Metrics;
+	float cost = metrics[Scenario::Metric::PitchRms] * metrics[Scenario::Metric::PitchRms] + metrics[Scenario::Metric::RollRms] * metrics[Scenario::Metric::RollRms];
+	cost += metrics[Scenario::Metric::YawRms] * metrics[Scenario::Metric::YawRms];
+	if (unity)
+	{
+		cost += HeightWeight * metrics[Scenario::Metric::HeightRms] * metrics[Scenario::Metric::HeightRms];
+	}
+
+	// Effort, the PIDs the frames record for the controller (not the yaw):
+	const CowArray<SimulationFrame>& frames = result.Result.Frames;
+	int first = (int)std::ceil(scenario.WindowStart / result.Result.DeltaTime - 1e-4f);
+	int last = scenario.WindowEnd < 0.0f ? (int)frames.size() : (int)std::ceil(scenario.WindowEnd / result.Result.DeltaTime - 1e-4f);
+	first = std::max(first, 1);
+	last = std::min(last, (int)frames.size());
+	const SimulationFrame::PIDType types[] = { SimulationFrame::Pitch, SimulationFrame::Roll, SimulationFrame::Height };
+	const int numTypes = unity ? 3 : 2;
+	double effort = 0.0;
+	for (int i = first; i < last; ++i)
+	{
+		for (int t = 0; t < numTypes; ++t)
+		{
+			const SimulationFrame::PIDState& prev = frames[i - 1].GetPIDState(types[t]);
+			const SimulationFrame::PIDState& cur = frames[i].GetPIDState(types[t]);
+			const double change = (double)(cur.P + cur.I + cur.D) - (double)(prev.P + prev.I + prev.D);
+			effort += change * change;
+		}
+	}
+	cost += EffortWeight * (float)(effort / (double)std::max(last - first, 1));
+
+	if (!result.Passed)
+	{
+		cost += FailPenalty;
+	}
+	return std::isfinite(cost) ? cost : std::numeric_limits<float>::infinity();
+}
+
+void EvolutionOptimizer::Evaluate(const std::vector<std::vector<float>>& candidates, std::vector<float>& costs) const
+{
+	const int numSeeds = std::max(NumSeeds, 1);
+	std::vector<BatchJob> jobs;
+	jobs.reserve(candidates.size() * numSeeds);
+	for (const std::vector<float>& values : candidates)
+	{
+		const BatchJob job = ToJob(values);
+		for (int s = 0; s < numSeeds; ++s)
+		{
+			jobs.push_back(job);
+			Scenario& scenario = jobs.back().Scn;
+			scenario.Seed = mJob.Scn.Seed + (uint32_t)s;
+			if (GustIntensity > 0.0f)
+			{
+				scenario.Env.Enabled[Environment::Model::Gusts] = true;
+				scenario.Env.GustIntensity = GustIntensity;
+			}
+		}
+	}
+
+	std::vector<BatchResult> results;
+	BatchRunner::Run(jobs, NumThreads, results);
+
+	costs.resize(candidates.size());
+	for (size_t c = 0; c < candidates.size(); ++c)
+	{
+		float sum = 0.0f;
+		float worst = 0.0f;
+		for (int s = 0; s < numSeeds; ++s)
+		{
+			const float cost = ComputeCost(results[c * numSeeds + s]);
+			sum += cost;
+			worst = std::max(worst, cost);
+		}
+		const float mean = sum / (float)numSeeds;
+		costs[c] = mean + RobustWeight * (worst - mean);
+	}
+}
+
+void EvolutionOptimizer::Step()
+{
+	const int n = (int)mParameters.size();
+
+	// Sample x = mean + sigma * B * D * z, seeded by the generation:
+	RandomStream rng;
+	rng.Seed(Seed, RandomStream::Stream::Optimizer, (uint32_t)mGeneration);
+	std::vector<std::vector<double>> samples(mLambda, std::vector<double>(n));
+	std::vector<std::vector<float>> candidates(mLambda, std::vector<float>(n));
+	std::vector<double> z(n);
+	for (int k = 0; k < mLambda; ++k)
+	{
+		for (int i = 0; i < n; ++i)
+		{
+			z[i] = mScales[i] * rng.Normal();
+		}
+		std::vector<double>& x = samples[k];
+		for (int i = 0; i < n; ++i)
+		{
+			double y = 0.0;
+			for (int j = 0; j < n; ++j)
+			{
+				y += mAxes[i * n + j] * z[j];
+			}
+			x[i] = mMean[i] + mSigma * y;
+		}
+		Clamp(x);
+		candidates[k].assign(x.begin(), x.end());
+	}
+
+	std::vector<float> costs;
+	Evaluate(candidates, costs);
+	mNumEvaluations += mLambda;
+
+	std::vector<int> order(mLambda);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return costs[a] < costs[b]; });
+	if (costs[order[0]] < mBestCost)
+	{
+		mBestCost = costs[order[0]];
+		mBestValues = candidates[order[0]];
+	}
+
+	// Mean, weighted recombination of the best mu:
+	const std::vector<double> oldMean = mMean;
+	std::fill(mMean.begin(), mMean.end(), 0.0);
+	for (int i = 0; i < mMu; ++i)
+	{
+		for (int p = 0; p < n; ++p)
+		{
+			mMean[p] += mWeights[i] * samples[order[i]][p];
+		}
+	}
+	std::vector<double> step(n);
+	for (int p = 0; p < n; ++p)
+	{
+		step[p] = (mMean[p] - oldMean[p]) / mSigma;
+	}
+
+	// Step size path, in the isotropic coordinates (C^-1/2 * step = B * D^-1 * B' * step):
+	std::vector<double> rotated(n, 0.0);
+	for (int j = 0; j < n; ++j)
+	{
+		for (int i = 0; i < n; ++i)
+		{
+			rotated[j] += mAxes[i * n + j] * step[i];
+		}
+		rotated[j] /= mScales[j];
+	}
+	const double pathSScale = std::sqrt(mCs * (2.0 - mCs) * mMuEff);
+	for (int i = 0; i < n; ++i)
+	{
+		double whitened = 0.0;
+		for (int j = 0; j < n; ++j)
+		{
+			whitened += mAxes[i * n + j] * rotated[j];
+		}
+		mPathS[i] = (1.0 - mCs) * mPathS[i] + pathSScale * whitened;
+	}
+	const double pathSNorm = Norm(mPathS);
+
+	// Covariance path, stalled while the step size path is long (hsig):
+	const bool stall = pathSNorm / std::sqrt(1.0 - std::pow(1.0 - mCs, 2.0 * (mGeneration + 1))) / mChiN >= 1.4 + 2.0 / (n + 1.0);
+	const double pathCScale = stall ? 0.0 : std::sqrt(mCc * (2.0 - mCc) * mMuEff);
+	for (int i = 0; i < n; ++i)
+	{
+		mPathC[i] = (1.0 - mCc) * mPathC[i] + pathCScale * step[i];
+	}
+
+	// Covariance, rank one (path) and rank mu (best steps) updates:
+	const double c1Lost = stall ? mC1 * mCc * (2.0 - mCc) : 0.0;
+	const double decay = 1.0 - mC1 - mCmu + c1Lost;
+	for (int i = 0; i < n; ++i)
+	{
+		for (int j = 0; j <= i; ++j)
+		{
+			double rankMu = 0.0;
+			for (int k = 0; k < mMu; ++k)
+			{
+				const std::vector<double>& x = samples[order[k]];
+				rankMu += mWeights[k] * (x[i] - oldMean[i]) * (x[j] - oldMean[j]);
+			}
+			const double value = decay * mCov[i * n + j] + mC1 * mPathC[i] * mPathC[j] + mCmu * rankMu / (mSigma * mSigma);
+			mCov[i * n + j] = value;
+			mCov[j * n + i] = value;
+		}
+	}
+
+	mSigma *= std::exp(std::min(1.0, mCs / mDamps * (pathSNorm / mChiN - 1.0)));
+	Decompose();
+
+	std::vector<float> sorted(mLambda);
+	for (int k = 0; k < mLambda; ++k)
+	{
+		sorted[k] = costs[order[k]];
+	}
+	mHistory.push_back({ mNumEvaluations, sorted[0], sorted[mLambda / 2], (float)mSigma });
+	++mGeneration;
+}
+
+bool EvolutionOptimizer::Run(int maxGenerations, const std::string& checkpointPath)
+{
+	while (mGeneration < maxGenerations)
+	{
+		Step();
+		if (!checkpointPath.empty() && !SaveCheckpoint(checkpointPath))
+		{
+			fprintf(stderr, "Could not write the checkpoint %s\n", checkpointPath.c_str());
+		}
+		if (mSigma * *std::max_element(mScales.begin(), mScales.end()) < Tolerance)
+		{
+			break;
+		}
+	}
+	return std::isfinite(mBestCost);
+}
+
+bool EvolutionOptimizer::SaveCheckpoint(const std::string& path) const
+{
+	const size_t n = mParameters.size();
+	const std::string tempPath = path + ".tmp";
+	FILE* file = fopen(tempPath.c_str(), "w");
+	if (!file)
+	{
+		return false;
+	}
+	fprintf(file, "# CMA-ES search state, see Source/Optimize/EvolutionOptimizer.h\n");
+	for (const Parameter& parameter : mParameters)
+	{
+		fprintf(file, "parameter %s\n", ToStr(parameter).c_str());
+	}
+	fprintf(file, "population %i\n", mLambda);
+	fprintf(file, "generation %i\n", mGeneration);
+	fprintf(file, "evaluations %i\n", mNumEvaluations);
+	fprintf(file, "sigma %.17g\n", mSigma);
+	WriteRow(file, "mean", mMean, 0, n);
+	WriteRow(file, "pathc", mPathC, 0, n);
+	WriteRow(file, "paths", mPathS, 0, n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		WriteRow(file, "cov", mCov, i * n, n);
+	}
+	fprintf(file, "best %.9g", mBestCost);
+	for (float value : mBestValues)
+	{
+		fprintf(file, " %.9g", value);
+	}
+	fprintf(file, "\n");
+	for (const Generation& generation : mHistory)
+	{
+		fprintf(file, "history %i %.9g %.9g %.9g\n", generation.Evaluations, generation.BestCost, generation.MedianCost, generation.Sigma);
+	}
+	bool ok = !ferror(file);
+	ok = fclose(file) == 0 && ok;
+	// Written aside and renamed, an interrupted write leaves the previous checkpoint:
+	remove(path.c_str());
+	return ok && rename(tempPath.c_str(), path.c_str()) == 0;
+}
+
+bool EvolutionOptimizer::LoadCheckpoint(const std::string& path, std::string* error)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		if (error)
+		{
+			*error = "Could not open " + path;
+		}
+		return false;
+	}
+
+	// Parse into copies so a bad checkpoint leaves the search untouched:
+	const size_t n = mParameters.size();
+	std::vector<std::string> names;
+	int population = 0;
+	int generation = -1;
+	int numEvaluations = 0;
+	double sigma = 0.0;
+	std::vector<double> mean(n), pathC(n), pathS(n), cov(n * n);
+	size_t numRows = 0;
+	float bestCost = std::numeric_limits<float>::infinity();
+	std::vector<float> bestValues(n);
+	std::vector<Generation> history;
+	std::string line;
+	int lineIdx = 0;
+	while (std::getline(file, line))
+	{
+		++lineIdx;
+		std::istringstream tokens(line);
+		std::string key;
+		if (!(tokens >> key) || key[0] == '#')
+		{
+			continue;
+		}
+
+		bool ok = true;
+		if (key == "parameter")
+		{
+			std::string name;
+			std::getline(tokens >> std::ws, name);
+			names.push_back(name);
+		}
+		else if (key == "population")	ok = (bool)(tokens >> population);
+		else if (key == "generation")	ok = (bool)(tokens >> generation);
+		else if (key == "evaluations")	ok = (bool)(tokens >> numEvaluations);
+		else if (key == "sigma")		ok = (bool)(tokens >> sigma) && sigma > 0.0;
+		else if (key == "mean")			ok = ReadRow(tokens, mean, 0, n);
+		else if (key == "pathc")		ok = ReadRow(tokens, pathC, 0, n);
+		else if (key == "paths")		ok = ReadRow(tokens, pathS, 0, n);
+		else if (key == "cov")			ok = numRows < n && ReadRow(tokens, cov, n * numRows++, n);
+		else if (key == "best")
+		{
+			std::string cost;
+			ok = (bool)(tokens >> cost);
+			bestCost = ok ? strtof(cost.c_str(), nullptr) : bestCost;	// "inf" if nothing was finite
+			for (size_t p = 0; p < n && ok; ++p)
+			{
+				ok = (bool)(tokens >> bestValues[p]);
+			}
+		}
+		else if (key == "history")
+		{
+			Generation entry;
+			ok = (bool)(tokens >> entry.Evaluations >> entry.BestCost >> entry.MedianCost >> entry.Sigma);
+			history.push_back(entry);
+		}
+		else
+		{
+			ok = false;
+		}
+
+		if (!ok)
+		{
+			if (error)
+			{
+				*error = path + ": invalid line " + std::to_string(lineIdx) + ": " + line;
+			}
+			return false;
+		}
+	}
+
+	bool sameParameters = names.size() == n;
+	for (size_t p = 0; p < n && sameParameters; ++p)
+	{
+		sameParameters = names[p] == ToStr(mParameters[p]);
+	}
+	if (!sameParameters || population != mLambda || generation < 0 || sigma <= 0.0 || numRows != n)
+	{
+		if (error)
+		{
+			*error = path + ": not a checkpoint of this search (parameters, population size) or incomplete";
+		}
+		return false;
+	}
+
+	mGeneration = generation;
+	mNumEvaluations = numEvaluations;
+	mSigma = sigma;
+	mMean = mean;
+	mPathC = pathC;
+	mPathS = pathS;
+	mCov = cov;
+	Decompose();
+	mBestCost = bestCost;
+	mBestValues = std::isfinite(bestCost) ? bestValues : mStart;
+	mHistory = history;
+	return true;
+}
+
+int EvolutionOptimizer::GetGeneration() const
+{
+	return mGeneration;
+}
+
+const std::vector<float>& EvolutionOptimizer::GetBestValues() const
+{
+	return mBestValues;
+}
+
+float EvolutionOptimizer::GetBestCost() const
+{
+	return mBestCost;
+}
+
+const std::vector<EvolutionOptimizer::Generation>& EvolutionOptimizer::GetHistory() const
+{
+	return mHistory;
+}
\ No newline at end of file
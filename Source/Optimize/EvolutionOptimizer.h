@@ -0,0 +1,153 @@
+#pragma once
+
+#include "Batch/BatchRunner.h"
+#include "GainOptimizer.h"
+
+#include <string>
+#include <vector>
+
+// Tunes a batch job with CMA-ES (covariance matrix adaptation evolution strategy): each
+// generation samples a population of parameter vectors from a normal distribution, flies every
+// one of them with the full simulation (BatchRunner, in parallel) and moves the mean, step size
+// and covariance toward the best ones. It only ranks costs, so it copes with what has no useful
+// gradient (the fail safe, saturation, clipping, PWM quantization, noise) where GainOptimizer
+// does not, at the price of many more runs.
+//
+// The parameters are PID gains and optionally the arm length of the airframe, in log space like
+// GainOptimizer (positive, relative steps). The arm length stays within a factor ArmLengthRange
+// of the start. Every candidate is flown on a disturbance set: the scenario with NumSeeds run
+// seeds (sensor noise and gusts, gusts of GustIntensity if it is not 0).
+//
+// Cost of a run, on the axes the controller flies (Scenario::Metric):
+//   attitude rms^2 (deg^2) + HeightWeight * height rms^2 (m^2)
+//   + EffortWeight * mean squared change per frame of the recorded PID outputs
+//   + FailPenalty if an expectation of the scenario fails
+// Cost of a candidate: mean over the seeds + RobustWeight * (worst - mean).
+//
+// The state after every generation can be written to a checkpoint and the search resumed from
+// it. Sampling is seeded per generation, a resumed search gives the same result as an
+// uninterrupted one.
+class EvolutionOptimizer
+{
+public:
+	struct Target
+	{
+		enum T
+		{
+			Gain,
+			ArmLength,
+			COUNT
+		};
+	};
+
+	struct Parameter
+	{
+		Target::T Type;
+		GainSlot::T Slot;				// Gains only
+		GainOptimizer::Term::T Gain;
+	};
+
+	struct Generation
+	{
+		int Evaluations;	// Candidates flown so far (each on the whole disturbance set)
+		float BestCost;		// Of this generation
+		float MedianCost;
+		float Sigma;		// Step size after the update
+	};
+
+	EvolutionOptimizer();
+
+	// Airframe, profile, controller and starting gains (the controller defaults if the job has
+	// none). Selects the default parameters of the controller and starts a new search.
+	void Init(const BatchJob& job);
+
+	// KP, KI and KD of the slots the controller flies with, plus the arm length if asked.
+	static std::vector<Parameter> GetDefaultParameters(Scenario::Controller::T controller, bool armLength);
+	// Restarts the search.
+	void SetParameters(const std::vector<Parameter>& parameters);
+	const std::vector<Parameter>& GetParameters()const;
+	static std::string ToStr(const Parameter& parameter);	// "Pitch KP", "ArmLength"
+
+	// Parameter values (log) of the starting gain set and airframe.
+	std::vector<float> GetStartValues()const;
+	// Actual value of a parameter (gain or arm length).
+	static float ToValue(float value);
+
+	// New search from the start values, the settings below are read here.
+	void Reset();
+	// Flies the jobs of a few parameter vectors (on the disturbance set) in parallel.
+	void Evaluate(const std::vector<std::vector<float>>& candidates, std::vector<float>& costs)const;
+	// One generation: sample, evaluate, update.
+	void Step();
+	// Up to maxGenerations (counting the ones of a resumed search), stops early once the
+	// step size is below Tolerance. Writes the checkpoint after every generation if the path
+	// is not empty. False if no candidate had a finite cost.
+	bool Run(int maxGenerations, const std::string& checkpointPath);
+
+	// Text file of the search state (parameters, mean, step size, evolution paths, covariance,
+	// best so far). Loading checks that the parameters match.
+	bool SaveCheckpoint(const std::string& path)const;
+	bool LoadCheckpoint(const std::string& path, std::string* error = nullptr);
+
+	int GetGeneration()const;
+	const std::vector<float>& GetBestValues()const;
+	float GetBestCost()const;
+	const std::vector<Generation>& GetHistory()const;
+
+	// The starting job with the values applied (sealed gain set, airframe), seed of the scenario.
+	BatchJob ToJob(const std::vector<float>& values)const;
+
+	float HeightWeight;
+	float EffortWeight;
+	float FailPenalty;
+	float RobustWeight;		// 0 is the mean over the seeds, 1 the worst seed
+	int NumSeeds;
+	float GustIntensity;	// m/s, 0 keeps the scenario gusts
+	float MinGain;			// Start of the gains that are 0
+	float ArmLengthRange;	// Factor around the start arm length
+	float Sigma;			// Initial step size, log space
+	int PopulationSize;		// 0 picks 4 + 3 ln(n)
+	int NumThreads;			// Threads at once on the shared JobSystem, <= 0 uses all of it
+	uint32_t Seed;			// Of the sampling
+	float Tolerance;		// Stops when sigma times the largest axis is below
+
+private:
+	// Cost of a run of the disturbance set.
+	float ComputeCost(const BatchResult& result)const;
+	// Keeps the arm length within its range.
+	void Clamp(std::vector<double>& values)const;
+	// B and D from the covariance (C = B * D^2 * B').
+	void Decompose();
+
+	BatchJob mJob;
+	GainSet mGains;
+	std::vector<Parameter> mParameters;
+	std::vector<float> mStart;
+
+	// Strategy parameters, from the dimension and population size:
+	int mLambda;
+	int mMu;
+	std::vector<double> mWeights;
+	double mMuEff;
+	double mCc;
+	double mCs;
+	double mC1;
+	double mCmu;
+	double mDamps;
+	double mChiN;
+
+	// Search state:
+	int mGeneration;
+	int mNumEvaluations;
+	double mSigma;
+	std::vector<double> mMean;
+	std::vector<double> mPathC;
+	std::vector<double> mPathS;
+	std::vector<double> mCov;	// Row major n x n
+	std::vector<double> mAxes;	// B, eigenvectors in the columns
+	std::vector<double> mScales;	// D, square roots of the eigenvalues
+
+	std::vector<float> mBestValues;
+	float mBestCost;
+	std::vector<Generation> mHistory;
+};
\ No newline at end of file
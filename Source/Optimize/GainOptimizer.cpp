@@ -0,0 +1,551 @@
+#include "GainOptimizer.h"
+#include "Dynamics/RigidBodyDynamics.h"
+#include "QuadFlyController.h"
+#include "RandomStream.h"
+#include "UnityFlightController.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static const float k_RadToDeg = 57.295779513082320876798154814105f;
+static const float k_InitialStep = 0.25f;	// Largest change of the first L-BFGS step (log space)
+static const float k_MaxStep = 1.0f;		// Of any L-BFGS step, a factor of e on a gain
+static const int k_MaxLineSearch = 12;
+
+static float Dot(const std::vector<float>& a, const std::vector<float>& b)
+{
+	float sum = 0.0f;
+	for (size_t i = 0; i < a.size(); ++i)
+	{
+		sum += a[i] * b[i];
+	}
+	return sum;
+}
+
+static float MaxAbs(const std::vector<float>& a)
+{
+	float result = 0.0f;
+	for (float value : a)
+	{
+		result = std::max(result, std::fabs(value));
+	}
+	return result;
+}
+
+GainOptimizer::GainOptimizer()
+	:HeightWeight(100.0f)
+	,EffortWeight(1000.0f)
+	,MinGain(1e-3f)
+	,LearningRate(0.1f)
+	,History(6)
+	,Tolerance(1e-4f)
+	,mGains(k_DefaultGainSet)
+	,mBestCost(std::numeric_limits<float>::infinity())
+	,mNumEvaluations(0)
+{
+}
+
+void GainOptimizer::Init(const BatchJob& job)
+{
+	mJob = job;
+	mJob.Profile.Compile(job.Scn.DeltaTime, job.Scn.TotalSimTime);
+	mGains = job.HasGains ? job.Gains : k_DefaultGainSet;
+	mQuad.ApplyProfile(job.Airframe);
+	mQuad.Reset();
+
+	// Same start as Simulation::CreateDynamics:
+	RigidBodyDynamics dynamics;
+	dynamics.Init(mQuad, glm::vec3(0.0f), glm::quat(glm::vec3(glm::radians(20.0f), 0.0f, 0.0f)), job.Scn.Env.GroundHeight, true);
+	mBody = dynamics.GetBody();
+
+	mParameters = GetDefaultParameters(job.Scn.Control);
+	mBestValues.clear();
+	mBestCost = std::numeric_limits<float>::infinity();
+	mHistory.clear();
+}
+
+std::vector<GainOptimizer::Parameter> GainOptimizer::GetDefaultParameters(Scenario::Controller::T controller)
+{
+	const GainSlot::T quadSlots[] = { GainSlot::Pitch, GainSlot::Roll, GainSlot::Yaw };
+	const GainSlot::T unitySlots[] = { GainSlot::Height, GainSlot::Pitch, GainSlot::Roll, GainSlot::Yaw };
+	const bool unity = controller == Scenario::Controller::Unity;
+	const GainSlot::T* slots = unity ? unitySlots : quadSlots;
+	const int numSlots = unity ? 4 : 3;
+
+	std::vector<Parameter> parameters;
+	for (int s = 0; s < numSlots; ++s)
+	{
+		for (int t = 0; t < Term::COUNT; ++t)
+		{
+			Parameter parameter;
+			parameter.Slot = slots[s];
+			parameter.Gain = (Term::T)t;
+			parameters.push_back(parameter);
+		}
+	}
+	return parameters;
+}
+
+void GainOptimizer::SetParameters(const std::vector<Parameter>& parameters)
+{
+	mParameters.assign(parameters.begin(), parameters.begin() + std::min((int)parameters.size(), k_MaxParams));
+}
+
+const std::vector<GainOptimizer::Parameter>& GainOptimizer::GetParameters() const
+{
+	return mParameters;
+}
+
+std::vector<float> GainOptimizer::GetStartValues() const
+{
+	std::vector<float> values(mParameters.size());
+	for (size_t p = 0; p < mParameters.size(); ++p)
+	{
+		const PIDGains& gains = mGains.Gains[mParameters[p].Slot];
+		const float gain = mParameters[p].Gain == Term::KP ? gains.KP : mParameters[p].Gain == Term::KI ? gains.KI : gains.KD;
+		values[p] = std::log(std::max(gain, MinGain));
+	}
+	return values;
+}
+
+float GainOptimizer::Evaluate(const std::vector<float>& values, std::vector<float>* gradient) const
+{
+	const int numParams = (int)mParameters.size();
+	if (!gradient)
+	{
+		std::vector<float> gains(numParams);
+		for (int p = 0; p < numParams; ++p)
+		{
+			gains[p] = std::exp(values[p]);
+		}
+		return Rollout(gains.data());
+	}
+
+	// The gains are exp() of the values, seeding the values gives the gradient in log space:
+	std::vector<Scalar> gains(numParams);
+	for (int p = 0; p < numParams; ++p)
+	{
+		gains[p] = expf(Scalar::Variable(values[p], p));
+	}
+	const Scalar cost = Rollout(gains.data());
+	gradient->resize(numParams);
+	for (int p = 0; p < numParams; ++p)
+	{
+		(*gradient)[p] = cost.Grad[p];
+	}
+	return cost.Value;
+}
+
+void GainOptimizer::FiniteDifferences(const std::vector<float>& values, float step, std::vector<float>& gradient) const
+{
+	gradient.resize(values.size());
+	std::vector<float> shifted = values;
+	for (size_t p = 0; p < values.size(); ++p)
+	{
+		shifted[p] = values[p] + step;
+		const float up = Evaluate(shifted, nullptr);
+		shifted[p] = values[p] - step;
+		const float down = Evaluate(shifted, nullptr);
+		shifted[p] = values[p];
+		gradient[p] = (up - down) / (2.0f * step);
+	}
+}
+
+template<typename Real>
+Real GainOptimizer::Rollout(const Real* gains) const
+{
+	typedef RigidBody<Real> Body;
+	typedef typename Body::Vec3 Vec3;
+
+	const Scenario& scenario = mJob.Scn;
+	const float deltaTime = scenario.DeltaTime;
+	const int numFrames = (int)(scenario.TotalSimTime / deltaTime);
+	int first = (int)std::ceil(scenario.WindowStart / deltaTime - 1e-4f);
+	int last = scenario.WindowEnd < 0.0f ? numFrames : (int)std::ceil(scenario.WindowEnd / deltaTime - 1e-4f);
+	first = std::max(first, 0);
+	last = std::min(last, numFrames);
+
+	// Controller, the parameters on top of the gain set:
+	PIDT<Real> pids[GainSlot::COUNT] =
+	{
+		PIDT<Real>(mGains.Gains[GainSlot::Height]),
+		PIDT<Real>(mGains.Gains[GainSlot::Pitch]),
+		PIDT<Real>(mGains.Gains[GainSlot::Roll]),
+		PIDT<Real>(mGains.Gains[GainSlot::Yaw])
+	};
+	for (size_t p = 0; p < mParameters.size(); ++p)
+	{
+		PIDT<Real>& pid = pids[mParameters[p].Slot];
+		switch (mParameters[p].Gain)
+		{
+		case Term::KP:	pid.KP = gains[p]; break;
+		case Term::KI:	pid.KI = gains[p]; break;
+		default:		pid.KD = gains[p]; break;
+		}
+	}
+	PIDT<Real>* pidSlots[GainSlot::COUNT] = { &pids[0], &pids[1], &pids[2], &pids[3] };
+	const bool unity = scenario.Control == Scenario::Controller::Unity;
+
+	// Body, from the state and parameters of the float one:
+	Body body;
+	const typename Body::Quat orientation = { mBody.Orientation.W, mBody.Orientation.X, mBody.Orientation.Y, mBody.Orientation.Z };
+	body.Init(Body::MakeVec3(mBody.Position.X, mBody.Position.Y, mBody.Position.Z), orientation);
+	body.Mass = mBody.Mass;
+	for (int a = 0; a < 3; ++a)
+	{
+		body.Inertia[a] = mBody.Inertia[a];
+		body.HalfExtents[a] = mBody.HalfExtents[a];
+	}
+	body.GroundHeight = mBody.GroundHeight;
+	body.Friction = mBody.Friction;
+	body.AngularDamping = mBody.AngularDamping;
+	body.Gravity = mBody.Gravity;
+
+	// Motors from rest:
+	MotorModel::Params motor = mQuad.Motors.Motor;
+	motor.PWMBits = 0;
+	const float lagAlpha = motor.TimeConstant > 0.0f ? 1.0f - std::exp(-deltaTime / motor.TimeConstant) : 1.0f;
+	Real speed[MotorModel::k_NumMotors] = {};
+	Real voltage = motor.NominalVoltage;
+
+	const Environment& env = scenario.Env;
+	const glm::vec3 wind = env.Enabled[Environment::Model::Wind] ? env.WindVelocity : glm::vec3(0.0f);
+	const float dimX = mQuad.ArmLength * 0.70710678f;
+	const float dimZ = dimX;
+	const Vec3 motorPos[MotorModel::k_NumMotors] =
+	{
+		Body::MakeVec3(-dimX, 0.0f, dimZ), Body::MakeVec3(dimX, 0.0f, dimZ), Body::MakeVec3(-dimX, 0.0f, -dimZ), Body::MakeVec3(dimX, 0.0f, -dimZ)
+	};
+
+	// The attitude and height noise of the airframe, same draws as the simulation with the seed
+	// of the scenario (with the sensors on the controller sees the estimator instead):
+	RandomStream noiseRng;
+	noiseRng.Seed(scenario.Seed, RandomStream::Stream::SensorNoise);
+	const float attitudeNoise = scenario.EmulateSensors ? 0.0f : mQuad.AttitudeNoise;
+	const float heightNoise = mQuad.HeightNoise;
+
+	Real cost = 0.0f;
+	Real prevCommands[Mixer::k_MaxMotors] = {};
+	for (int frameIdx = 0; frameIdx < numFrames; ++frameIdx)
+	{
+		const Vec3 euler = Body::ToEuler(body.Orientation);
+		const FCSetPoints setPoints = mJob.Profile.SampleIdx(frameIdx);
+
+		FCQuadStateT<Real> state;
+		state.Height = body.Position.Y;
+		state.Pitch = euler.X;
+		state.Yaw = -euler.Y;	// Controller yaw, see Simulation
+		state.Roll = euler.Z;
+		state.DeltaTime = deltaTime;
+		state.Time = frameIdx * deltaTime;
+		if (heightNoise > 0.0f)
+		{
+			state.Height = state.Height + noiseRng.Uniform(-heightNoise, heightNoise);
+		}
+		if (attitudeNoise > 0.0f)
+		{
+			state.Pitch = state.Pitch + noiseRng.Uniform(-attitudeNoise, attitudeNoise);
+			state.Yaw = state.Yaw + noiseRng.Uniform(-attitudeNoise, attitudeNoise);
+			state.Roll = state.Roll + noiseRng.Uniform(-attitudeNoise, attitudeNoise);
+		}
+		FCSetPointsT<Real> target;
+		target.Thrust = setPoints.Thrust;
+		target.Yaw = setPoints.Yaw;
+		target.Pitch = setPoints.Pitch;
+		target.Roll = setPoints.Roll;
+		target.Height = setPoints.Height;
+
+		// The Unity controller only flies with thrust, it restarts its PIDs otherwise:
+		Real commands[Mixer::k_MaxMotors] = {};
+		if (!unity || setPoints.Thrust > 0.0f)
+		{
+			Real thrust, roll, pitch, yaw;
+			if (unity)
+			{
+				UnityFlyController::ComputeActions(pidSlots, state, target, thrust, roll, pitch, yaw);
+			}
+			else
+			{
+				QuadFlyController::ComputeActions(pidSlots, state, target, thrust, roll, pitch, yaw);
+			}
+			mMixer.Mix(thrust, roll, pitch, yaw, commands);
+		}
+		else
+		{
+			for (PIDT<Real>& pid : pids)
+			{
+				pid.Reset();
+			}
+		}
+
+		Real motorThrust[MotorModel::k_NumMotors];
+		Real yawTorque;
+		MotorModel::StepMotors(motor, mQuad.Motors.ThrustOffset, lagAlpha, commands, speed, voltage, motorThrust, yawTorque);
+
+		// Environment, Environment::Step without the gusts:
+		const Vec3 relVelocity = Body::MakeVec3(body.Velocity.X - wind.x, body.Velocity.Y - wind.y, body.Velocity.Z - wind.z);
+		Real drag = 0.0f;
+		if (env.Enabled[Environment::Model::LinearDrag])
+		{
+			drag += mQuad.LinearDrag;
+		}
+		if (env.Enabled[Environment::Model::QuadraticDrag])
+		{
+			drag += mQuad.QuadraticDrag * sqrtf(relVelocity.X * relVelocity.X + relVelocity.Y * relVelocity.Y + relVelocity.Z * relVelocity.Z);
+		}
+		body.AddForce(Body::MakeVec3(-drag * relVelocity.X, -drag * relVelocity.Y, -drag * relVelocity.Z));
+		Real thrustScale = 1.0f;
+		if (env.Enabled[Environment::Model::GroundEffect])
+		{
+			const Real z = fmaxf(body.Position.Y - env.GroundHeight, 1e-3f);
+			const Real ratio = fminf(env.RotorRadius / (4.0f * z), 0.6f);
+			thrustScale = 1.0f / (1.0f - ratio * ratio);
+		}
+
+		const typename Body::Quat frameOrientation = body.Orientation;
+		for (int m = 0; m < MotorModel::k_NumMotors; ++m)
+		{
+			body.AddLocalForceAtLocalPos(Body::MakeVec3(0.0f, motorThrust[m] * thrustScale, 0.0f), motorPos[m]);
+		}
+		body.AddTorque(Body::Rotate(frameOrientation, Body::MakeVec3(0.0f, yawTorque, 0.0f)));
+
+		if (frameIdx >= first && frameIdx < last)
+		{
+			const Real pitchError = (euler.X - setPoints.Pitch) * k_RadToDeg;
+			const Real rollError = (euler.Z - setPoints.Roll) * k_RadToDeg;
+			const Real yawError = (-euler.Y - setPoints.Yaw) * k_RadToDeg;
+			cost += pitchError * pitchError + rollError * rollError + yawError * yawError;
+			if (unity)
+			{
+				const Real heightError = body.Position.Y - setPoints.Height;
+				cost += HeightWeight * heightError * heightError;
+			}
+			Real effort = 0.0f;
+			for (int m = 0; m < MotorModel::k_NumMotors; ++m)
+			{
+				const Real change = commands[m] - prevCommands[m];
+				effort += change * change;
+			}
+			cost += EffortWeight * effort;
+		}
+		for (int m = 0; m < MotorModel::k_NumMotors; ++m)
+		{
+			prevCommands[m] = commands[m];
+		}
+
+		body.Step(deltaTime);
+	}
+	return cost / (float)std::max(last - first, 1);
+}
+
+float GainOptimizer::Track(const std::vector<float>& values, std::vector<float>* gradient)
+{
+	const float cost = Evaluate(values, gradient);
+	++mNumEvaluations;
+	if (std::isfinite(cost) && cost < mBestCost)
+	{
+		mBestCost = cost;
+		mBestValues = values;
+	}
+	return cost;
+}
+
+bool GainOptimizer::Run(Method::T method, int maxIterations)
+{
+	mHistory.clear();
+	mNumEvaluations = 0;
+	mBestValues = GetStartValues();
+	mBestCost = std::numeric_limits<float>::infinity();
+	if (method == Method::Adam)
+	{
+		RunAdam(maxIterations);
+	}
+	else
+	{
+		RunLBFGS(maxIterations);
+	}
+	return std::isfinite(mBestCost);
+}
+
+void GainOptimizer::RunAdam(int maxIterations)
+{
+	const float beta1 = 0.9f;
+	const float beta2 = 0.999f;
+	const float epsilon = 1e-8f;
+
+	std::vector<float> values = mBestValues;
+	std::vector<float> gradient;
+	std::vector<float> mean(values.size(), 0.0f);
+	std::vector<float> variance(values.size(), 0.0f);
+	float beta1Power = 1.0f;
+	float beta2Power = 1.0f;
+	for (int it = 0; it < maxIterations; ++it)
+	{
+		const float cost = Track(values, &gradient);
+		const float norm = MaxAbs(gradient);
+		mHistory.push_back({ mNumEvaluations, cost, norm });
+		if (!std::isfinite(cost) || norm < Tolerance)
+		{
+			break;
+		}
+
+		beta1Power *= beta1;
+		beta2Power *= beta2;
+		for (size_t p = 0; p < values.size(); ++p)
+		{
+			mean[p] = beta1 * mean[p] + (1.0f - beta1) * gradient[p];
+			variance[p] = beta2 * variance[p] + (1.0f - beta2) * gradient[p] * gradient[p];
+			const float meanHat = mean[p] / (1.0f - beta1Power);
+			const float varianceHat = variance[p] / (1.0f - beta2Power);
+			values[p] -= LearningRate * meanHat / (std::sqrt(varianceHat) + epsilon);
+		}
+	}
+}
+
+void GainOptimizer::RunLBFGS(int maxIterations)
+{
+	const int numParams = (int)mBestValues.size();
+	std::vector<float> values = mBestValues;
+	std::vector<float> gradient;
+	float cost = Track(values, &gradient);
+	mHistory.push_back({ mNumEvaluations, cost, MaxAbs(gradient) });
+	if (!std::isfinite(cost))
+	{
+		return;
+	}
+
+	std::vector<std::vector<float>> s, y;	// Oldest first
+	std::vector<float> rho;
+	std::vector<float> direction(numParams);
+	std::vector<float> next(numParams);
+	std::vector<float> nextGradient;
+	for (int it = 0; it < maxIterations && MaxAbs(gradient) >= Tolerance; ++it)
+	{
+		// Two loop recursion, direction = -H * gradient:
+		direction = gradient;
+		std::vector<float> alpha(s.size());
+		for (int k = (int)s.size() - 1; k >= 0; --k)
+		{
+			alpha[k] = rho[k] * Dot(s[k], direction);
+			for (int p = 0; p < numParams; ++p)
+			{
+				direction[p] -= alpha[k] * y[k][p];
+			}
+		}
+		const float gamma = s.empty() ? k_InitialStep / MaxAbs(gradient) : Dot(s.back(), y.back()) / Dot(y.back(), y.back());
+		for (int p = 0; p < numParams; ++p)
+		{
+			direction[p] *= gamma;
+		}
+		for (size_t k = 0; k < s.size(); ++k)
+		{
+			const float beta = rho[k] * Dot(y[k], direction);
+			for (int p = 0; p < numParams; ++p)
+			{
+				direction[p] += s[k][p] * (alpha[k] - beta);
+			}
+		}
+		for (int p = 0; p < numParams; ++p)
+		{
+			direction[p] = -direction[p];
+		}
+
+		// Not a descent direction (the curvature pairs went stale), restart on the gradient:
+		if (Dot(gradient, direction) >= 0.0f)
+		{
+			s.clear();
+			y.clear();
+			rho.clear();
+			for (int p = 0; p < numParams; ++p)
+			{
+				direction[p] = -gradient[p] * k_InitialStep / MaxAbs(gradient);
+			}
+		}
+		const float directionMax = MaxAbs(direction);
+		if (directionMax > k_MaxStep)
+		{
+			for (int p = 0; p < numParams; ++p)
+			{
+				direction[p] *= k_MaxStep / directionMax;
+			}
+		}
+		const float slope = Dot(gradient, direction);
+
+		// Backtracking line search (Armijo):
+		float step = 1.0f;
+		float nextCost = cost;
+		bool accepted = false;
+		for (int ls = 0; ls < k_MaxLineSearch && !accepted; ++ls, step *= 0.5f)
+		{
+			for (int p = 0; p < numParams; ++p)
+			{
+				next[p] = values[p] + step * direction[p];
+			}
+			nextCost = Track(next, &nextGradient);
+			accepted = std::isfinite(nextCost) && nextCost < cost && nextCost <= cost + 1e-4f * step * slope;
+		}
+		if (!accepted)
+		{
+			break;
+		}
+
+		std::vector<float> sk(numParams), yk(numParams);
+		for (int p = 0; p < numParams; ++p)
+		{
+			sk[p] = next[p] - values[p];
+			yk[p] = nextGradient[p] - gradient[p];
+		}
+		const float sy = Dot(sk, yk);
+		if (sy > 1e-10f)
+		{
+			s.push_back(sk);
+			y.push_back(yk);
+			rho.push_back(1.0f / sy);
+			if ((int)s.size() > History)
+			{
+				s.erase(s.begin());
+				y.erase(y.begin());
+				rho.erase(rho.begin());
+			}
+		}
+
+		values = next;
+		gradient = nextGradient;
+		cost = nextCost;
+		mHistory.push_back({ mNumEvaluations, cost, MaxAbs(gradient) });
+	}
+}
+
+const std::vector<float>& GainOptimizer::GetBestValues() const
+{
+	return mBestValues;
+}
+
+float GainOptimizer::GetBestCost() const
+{
+	return mBestCost;
+}
+
+const std::vector<GainOptimizer::Iteration>& GainOptimizer::GetHistory() const
+{
+	return mHistory;
+}
+
+GainSet GainOptimizer::ToGainSet(const std::vector<float>& values) const
+{
+	GainSet gainSet = mGains;
+	for (size_t p = 0; p < mParameters.size() && p < values.size(); ++p)
+	{
+		PIDGains& gains = gainSet.Gains[mParameters[p].Slot];
+		const float gain = std::exp(values[p]);
+		switch (mParameters[p].Gain)
+		{
+		case Term::KP:	gains.KP = gain; break;
+		case Term::KI:	gains.KI = gain; break;
+		default:		gains.KD = gain; break;
+		}
+	}
+	SealGainSet(gainSet);
+	return gainSet;
+}
\ No newline at end of file
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "Batch/BatchRunner.h"
+#include "Dual.h"
+#include "Dynamics/RigidBody.h"
+#include "Mixer.h"
+#include "Quad.h"
+
+#include <vector>
+
+// Tunes the PID gains of a batch job by gradient descent. The cost of a run is differentiated
+// with respect to every gain in a single pass: the rollout flies the controller law, mixer,
+// motors and rigid body templated on the scalar (PIDT, Mixer::Mix, ComputeActions,
+// MotorModel::StepMotors, RigidBody) with dual numbers. A cost and its gradient take one run,
+// the optimizers (Adam, L-BFGS) converge in tens of them where a grid over the gains takes
+// thousands.
+//
+// The rollout is the deterministic core of the simulation: no sensor emulation, no gusts, no
+// PWM quantization and no fail-safe, the non-smooth parts without a useful derivative. The
+// attitude and height noise of the airframe is replayed from the scenario seed, fixed draws
+// that keep the cost smooth, so that high gains pay for amplifying it. Wind, drag and ground
+// effect follow the scenario. The gains are optimized in log space (they stay positive and
+// the steps are relative), starting at MinGain for the ones that are 0. Check the result with
+// the full simulation (BatchRunner::RunJob).
+// The gradient is exact, but only useful while the run depends smoothly on the gains: once
+// the quad tumbles (or the Euler angles wrap) it no longer points anywhere sensible.
+//
+// Cost, mean over the frames of the scenario window, on the axes the controller flies:
+//   attitude error^2 (deg^2) + HeightWeight * height error^2 (m^2)
+//   + EffortWeight * sum of the squared motor command changes
+class GainOptimizer
+{
+public:
+	static const int k_MaxParams = GainSlot::COUNT * 3;	// KP, KI, KD of every slot
+	typedef Dual<k_MaxParams> Scalar;
+
+	struct Term
+	{
+		enum T
+		{
+			KP,
+			KI,
+			KD,
+			COUNT
+		};
+		static const char* ToStr(T t)
+		{
+			switch (t)
+			{
+			case KP:	return "KP";
+			case KI:	return "KI";
+			case KD:	return "KD";
+			default:	return "Invalid";
+			}
+		}
+	};
+
+	struct Method
+	{
+		enum T
+		{
+			Adam,
+			LBFGS,
+			COUNT
+		};
+		static const char* ToStr(T t)
+		{
+			switch (t)
+			{
+			case Adam:	return "Adam";
+			case LBFGS:	return "L-BFGS";
+			default:	return "Invalid";
+			}
+		}
+	};
+
+	struct Parameter
+	{
+		GainSlot::T Slot;
+		Term::T Gain;
+	};
+
+	struct Iteration
+	{
+		int Evaluations;	// Rollouts so far
+		float Cost;
+		float GradientNorm;	// Max abs, log space
+	};
+
+	GainOptimizer();
+
+	// Airframe, profile, controller and starting gains (the controller defaults if the job
+	// has none). Selects the default parameters of the controller.
+	void Init(const BatchJob& job);
+
+	// KP, KI and KD of the slots the controller flies with.
+	static std::vector<Parameter> GetDefaultParameters(Scenario::Controller::T controller);
+	void SetParameters(const std::vector<Parameter>& parameters);
+	const std::vector<Parameter>& GetParameters()const;
+
+	// Parameter values (log of the gains) of the current gain set.
+	std::vector<float> GetStartValues()const;
+
+	// Cost of the values and, if not null, its gradient (one rollout with dual numbers).
+	float Evaluate(const std::vector<float>& values, std::vector<float>* gradient)const;
+	// Central differences with float rollouts (2 per parameter), to verify Evaluate().
+	void FiniteDifferences(const std::vector<float>& values, float step, std::vector<float>& gradient)const;
+
+	// Optimizes from the start values, false if the cost is not finite there.
+	bool Run(Method::T method, int maxIterations);
+	const std::vector<float>& GetBestValues()const;
+	float GetBestCost()const;
+	const std::vector<Iteration>& GetHistory()const;
+
+	// The starting gain set with the values applied, sealed.
+	GainSet ToGainSet(const std::vector<float>& values)const;
+
+	float HeightWeight;
+	float EffortWeight;
+	float MinGain;			// Start of the gains that are 0
+	float LearningRate;		// Adam, log space
+	int History;			// L-BFGS correction pairs
+	float Tolerance;		// Stops when the gradient (max abs) is below
+
+private:
+	// Cost of a run with the gains of the parameters (not in log space).
+	template<typename Real>
+	Real Rollout(const Real* gains)const;
+
+	void RunAdam(int maxIterations);
+	void RunLBFGS(int maxIterations);
+	// Evaluates and keeps the best values.
+	float Track(const std::vector<float>& values, std::vector<float>* gradient);
+
+	BatchJob mJob;
+	GainSet mGains;
+	std::vector<Parameter> mParameters;
+	Quad mQuad;
+	RigidBody<float> mBody;		// Initial state and parameters of the body
+	Mixer mMixer;
+
+	std::vector<float> mBestValues;
+	float mBestCost;
+	std::vector<Iteration> mHistory;
+	int mNumEvaluations;
+};
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "PlotChannel.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+void PlotChannel::Clear()
+{
+	mSamples.clear();
+	mMin.clear();
+	mMax.clear();
+}
+
+void PlotChannel::Append(float value)
+{
+	mSamples.push_back(value);
+
+	// Every time a node gets its second child, its parent is complete:
+	int index = (int)mSamples.size() - 1;
+	int level = 0;
+	while (index & 1)
+	{
+		int parent = index >> 1;
+		float lo = std::min(NodeMin(level, index - 1), NodeMin(level, index));
+		float hi = std::max(NodeMax(level, index - 1), NodeMax(level, index));
+		if ((int)mMin.size() <= level)
+		{
+			mMin.emplace_back();
+			mMax.emplace_back();
+		}
+		mMin[level].push_back(lo);
+		mMax[level].push_back(hi);
+		index = parent;
+		++level;
+	}
+}
+
+int PlotChannel::GetNumSamples() const
+{
+	return (int)mSamples.size();
+}
+
+float PlotChannel::NodeMin(int level, int index) const
+{
+	return level == 0 ? mSamples[index] : mMin[level - 1][index];
+}
+
+float PlotChannel::NodeMax(int level, int index) const
+{
+	return level == 0 ? mSamples[index] : mMax[level - 1][index];
+}
+
+void PlotChannel::RangeMinMax(int begin, int end, float& outMin, float& outMax) const
+{
+	outMin = FLT_MAX;
+	outMax = -FLT_MAX;
+	begin = std::max(begin, 0);
+	end = std::min(end, (int)mSamples.size());
+
+	// Bottom up decomposition, all the nodes under 'end' are complete:
+	int level = 0;
+	while (begin < end)
+	{
+		if (begin & 1)
+		{
+			outMin = std::min(outMin, NodeMin(level, begin));
+			outMax = std::max(outMax, NodeMax(level, begin));
+			++begin;
+		}
+		if (end & 1)
+		{
+			--end;
+			outMin = std::min(outMin, NodeMin(level, end));
+			outMax = std::max(outMax, NodeMax(level, end));
+		}
+		begin >>= 1;
+		end >>= 1;
+		++level;
+	}
+}
+
+void PlotChannel::Query(double begin, double end, int numBuckets, float* outMin, float* outMax) const
+{
+	double width = (end - begin) / (double)numBuckets;
+	int level = width > 1.0 ? std::min((int)std::floor(std::log2(width)), (int)mMin.size()) : 0;
+	int nodeSize = 1 << level;
+	int numNodes = level == 0 ? (int)mSamples.size() : (int)mMin[level - 1].size();
+	int numSamples = (int)mSamples.size();
+
+	for (int b = 0; b < numBuckets; ++b)
+	{
+		double bucketBegin = begin + width * (double)b;
+		int first = (int)std::floor(bucketBegin);
+		int last = std::max((int)std::floor(bucketBegin + width), first + 1);
+		if (first >= numSamples || last <= 0)
+		{
+			outMin[b] = outMax[b] = NAN;
+			continue;
+		}
+
+		int firstNode = std::max(first, 0) / nodeSize;
+		int lastNode = (last + nodeSize - 1) / nodeSize;
+		if (lastNode <= numNodes)
+		{
+			// 1-3 nodes per bucket:
+			float lo = FLT_MAX, hi = -FLT_MAX;
+			for (int n = firstNode; n < lastNode; ++n)
+			{
+				lo = std::min(lo, NodeMin(level, n));
+				hi = std::max(hi, NodeMax(level, n));
+			}
+			outMin[b] = lo;
+			outMax[b] = hi;
+		}
+		else
+		{
+			// Tail not covered by complete nodes yet:
+			RangeMinMax(first, last, outMin[b], outMax[b]);
+		}
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+// Sample stream with a min/max pyramid: level L stores the min/max of 2^L consecutive samples.
+// Appending is amortized O(1) and only touches the completed parents, so it can be fed while
+// a run or a log is streaming in. Querying N buckets picks the level that matches the bucket
+// width, so the cost is O(N) regardless of the number of samples.
+class PlotChannel
+{
+public:
+	void Clear();
+	void Append(float value);
+	int GetNumSamples()const;
+
+	// Min/max of each of the numBuckets buckets that split [begin, end) (sample units).
+	// Buckets are snapped to the nodes of the chosen level, they can be slightly wider.
+	void Query(double begin, double end, int numBuckets, float* outMin, float* outMax)const;
+
+	// Exact min/max of the samples in [begin, end), O(log N).
+	void RangeMinMax(int begin, int end, float& outMin, float& outMax)const;
+
+private:
+	float NodeMin(int level, int index)const;
+	float NodeMax(int level, int index)const;
+
+	std::vector<float> mSamples;				// Level 0
+	std::vector<std::vector<float>> mMin;	// Levels 1..N (mMin[0] is level 1)
+	std::vector<std::vector<float>> mMax;
+};
\ No newline at end of file
@@ -0,0 +1,206 @@
+#include "PlotView.h"
+#include "Simulation.h"
+#include "Graphics/UI/IMGUI/imgui.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+
+PlotView::PlotView()
+	:Follow(false)
+	,mViewBegin(0.0)
+	,mViewEnd(1.0)
+	,mNumSamples(0)
+	,mDeltaTime(1.0f)
+{
+}
+
+void PlotView::ResetView()
+{
+	mViewBegin = 0.0;
+	mViewEnd = std::max(mNumSamples, 1);
+}
+
+void PlotView::SetExtent(int numSamples, float deltaTime)
+{
+	bool wasFullView = mViewBegin <= 0.0 && mViewEnd >= (double)mNumSamples;
+	int added = numSamples - mNumSamples;
+	mNumSamples = numSamples;
+	mDeltaTime = deltaTime;
+	if (wasFullView && !Follow)
+	{
+		ResetView();
+	}
+	else if (Follow && added != 0)
+	{
+		mViewBegin += added;
+		mViewEnd += added;
+	}
+}
+
+unsigned int PlotView::GetColor(int channelIdx)
+{
+	static const ImU32 k_Palette[] =
+	{
+		IM_COL32(255, 200, 90, 255),
+		IM_COL32(90, 180, 255, 255),
+		IM_COL32(120, 230, 120, 255),
+		IM_COL32(240, 100, 200, 255),
+		IM_COL32(230, 230, 230, 255),
+		IM_COL32(255, 110, 90, 255)
+	};
+	const int numColors = (int)(sizeof(k_Palette) / sizeof(k_Palette[0]));
+	return k_Palette[channelIdx % numColors];
+}
+
+void PlotView::Plot(const char* label, const PlotChannel& channel, float scaleMin, float scaleMax, const ImVec2& size)
+{
+	const PlotChannel* channels[1] = { &channel };
+	Plot(label, channels, 1, scaleMin, scaleMax, size);
+}
+
+void PlotView::Plot(const char* label, const PlotChannel* const* channels, int numChannels, float scaleMin, float scaleMax, const ImVec2& size)
+{
+	ImGui::InvisibleButton(label, size);
+	ImVec2 rectMin = ImGui::GetItemRectMin();
+	ImVec2 rectMax = ImGui::GetItemRectMax();
+	float width = rectMax.x - rectMin.x;
+	float height = rectMax.y - rectMin.y;
+	int numBuckets = std::max((int)width, 1);
+
+	// Zoom and pan (shared by all the plots of this view):
+	ImGuiIO& io = ImGui::GetIO();
+	double viewSize = mViewEnd - mViewBegin;
+	if (ImGui::IsItemHovered() && io.MouseWheel != 0.0f)
+	{
+		double pivot = mViewBegin + viewSize * (double)((io.MousePos.x - rectMin.x) / width);
+		double zoom = io.MouseWheel > 0.0f ? 0.8 : 1.25;
+		double newSize = std::max(viewSize * zoom, 8.0);
+		mViewBegin = pivot - (pivot - mViewBegin) * (newSize / viewSize);
+		mViewEnd = mViewBegin + newSize;
+	}
+	if (ImGui::IsItemActive() && io.MouseDelta.x != 0.0f)
+	{
+		double shift = -(double)io.MouseDelta.x * viewSize / (double)width;
+		mViewBegin += shift;
+		mViewEnd += shift;
+	}
+	if (ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(0))
+	{
+		ResetView();
+	}
+
+	const int numValues = numBuckets * numChannels;
+	mBucketMin.resize(numValues);
+	mBucketMax.resize(numValues);
+	for (int c = 0; c < numChannels; ++c)
+	{
+		channels[c]->Query(mViewBegin, mViewEnd, numBuckets, mBucketMin.data() + c * numBuckets, mBucketMax.data() + c * numBuckets);
+	}
+
+	if (scaleMin == scaleMax)
+	{
+		scaleMin = FLT_MAX;
+		scaleMax = -FLT_MAX;
+		for (int b = 0; b < numValues; ++b)
+		{
+			if (!std::isnan(mBucketMin[b]))
+			{
+				scaleMin = std::min(scaleMin, mBucketMin[b]);
+				scaleMax = std::max(scaleMax, mBucketMax[b]);
+			}
+		}
+		if (scaleMin > scaleMax)
+		{
+			scaleMin = 0.0f;
+			scaleMax = 1.0f;
+		}
+		if (scaleMin == scaleMax)
+		{
+			scaleMin -= 0.5f;
+			scaleMax += 0.5f;
+		}
+	}
+
+	// One vertical min-max line per column, joined to the previous column:
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+	drawList->AddRectFilled(rectMin, rectMax, IM_COL32(30, 30, 40, 255));
+	float scaleY = height / (scaleMax - scaleMin);
+	for (int c = 0; c < numChannels; ++c)
+	{
+		const ImU32 lineColor = GetColor(c);
+		const float* bucketMin = mBucketMin.data() + c * numBuckets;
+		const float* bucketMax = mBucketMax.data() + c * numBuckets;
+		float prevY = NAN;
+		for (int b = 0; b < numBuckets; ++b)
+		{
+			if (std::isnan(bucketMin[b]))
+			{
+				prevY = NAN;
+				continue;
+			}
+			float x = rectMin.x + (float)b;
+			float yMin = rectMax.y - (std::max(std::min(bucketMin[b], scaleMax), scaleMin) - scaleMin) * scaleY;
+			float yMax = rectMax.y - (std::max(std::min(bucketMax[b], scaleMax), scaleMin) - scaleMin) * scaleY;
+			if (!std::isnan(prevY))
+			{
+				drawList->AddLine(ImVec2(x - 1.0f, prevY), ImVec2(x, 0.5f * (yMin + yMax)), lineColor);
+			}
+			drawList->AddLine(ImVec2(x, yMin), ImVec2(x, yMax + 1.0f), lineColor);
+			prevY = 0.5f * (yMin + yMax);
+		}
+	}
+
+	char text[128];
+	snprintf(text, sizeof(text), "%s [%.2f, %.2f] %.2fs-%.2fs", label, scaleMin, scaleMax, mViewBegin * mDeltaTime, mViewEnd * mDeltaTime);
+	drawList->AddText(ImVec2(rectMin.x + 4.0f, rectMin.y + 2.0f), IM_COL32(255, 255, 255, 255), text);
+}
+
+void SimulationPlotData::Clear()
+{
+	for (int c = 0; c < Channel::COUNT; ++c)
+	{
+		mChannels[c].Clear();
+	}
+}
+
+void SimulationPlotData::Update(const SimulationResult& result)
+{
+	int numSamples = GetNumSamples();
+	if ((int)result.Frames.size() < numSamples)
+	{
+		Clear();
+		numSamples = 0;
+	}
+
+	for (int i = numSamples; i < (int)result.Frames.size(); ++i)
+	{
+		Append(result.Frames[i]);
+	}
+}
+
+void SimulationPlotData::Append(const SimulationFrame& frame)
+{
+	mChannels[Channel::Height].Append(frame.QuadPosition.y);
+	mChannels[Channel::Pitch].Append(glm::degrees(frame.QuadOrientation.x));
+	mChannels[Channel::Roll].Append(glm::degrees(frame.QuadOrientation.z));
+
+	const SimulationFrame::PIDState* pids[3] = { &frame.HeightPIDState, &frame.PitchPIDState, &frame.RollPIDState };
+	for (int p = 0; p < 3; ++p)
+	{
+		mChannels[Channel::HeightP + p * 3 + 0].Append(pids[p]->P);
+		mChannels[Channel::HeightP + p * 3 + 1].Append(pids[p]->I);
+		mChannels[Channel::HeightP + p * 3 + 2].Append(pids[p]->D);
+	}
+}
+
+const PlotChannel& SimulationPlotData::Get(Channel::T channel) const
+{
+	return mChannels[channel];
+}
+
+int SimulationPlotData::GetNumSamples() const
+{
+	return mChannels[0].GetNumSamples();
+}
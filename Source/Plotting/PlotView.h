@@ -0,0 +1,68 @@
+#pragma once
+
+#include "PlotChannel.h"
+
+#include <vector>
+
+struct ImVec2;
+struct SimulationFrame;
+struct SimulationResult;
+
+// Shared time window for a group of plots. Each plot only asks its channel for as many
+// min/max buckets as it has pixel columns. Mouse wheel zooms around the cursor, dragging pans
+// and double click resets the view. When following, the window sticks to the newest samples.
+class PlotView
+{
+public:
+	PlotView();
+	void ResetView();
+
+	// scaleMin == scaleMax auto scales to the visible samples.
+	void Plot(const char* label, const PlotChannel& channel, float scaleMin, float scaleMax, const ImVec2& size);
+	// Several channels overlaid on the same scale, each in its palette color (GetColor).
+	void Plot(const char* label, const PlotChannel* const* channels, int numChannels, float scaleMin, float scaleMax, const ImVec2& size);
+
+	static unsigned int GetColor(int channelIdx);	// ImU32
+
+	// Extent of the data (samples) and seconds per sample, used to clamp the view and for labels.
+	void SetExtent(int numSamples, float deltaTime);
+
+	bool Follow;
+
+private:
+	double mViewBegin;
+	double mViewEnd;
+	int mNumSamples;
+	float mDeltaTime;
+	std::vector<float> mBucketMin;
+	std::vector<float> mBucketMax;
+};
+
+// Plot channels built from simulation frames. Update() only appends the frames it hasn't seen,
+// call Clear() when a new run replaces the frames. Streams without a result Append() theirs.
+class SimulationPlotData
+{
+public:
+	struct Channel
+	{
+		enum T
+		{
+			Height,
+			Pitch,
+			Roll,
+			HeightP, HeightI, HeightD,
+			PitchP, PitchI, PitchD,
+			RollP, RollI, RollD,
+			COUNT
+		};
+	};
+
+	void Clear();
+	void Update(const SimulationResult& result);
+	void Append(const SimulationFrame& frame);
+	const PlotChannel& Get(Channel::T channel)const;
+	int GetNumSamples()const;
+
+private:
+	PlotChannel mChannels[Channel::COUNT];
+};
\ No newline at end of file
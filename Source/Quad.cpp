@@ -1,25 +1,121 @@
 #include "Quad.h"
 
-#include "Graphics/UI/IMGUI/imgui.h"
+#ifndef HEADLESS
+	#include "Graphics/UI/IMGUI/imgui.h"
+#endif
+#include "Core/Logging.h"
 
-Quad::Quad():
-	 Mass(0.081f)
-	,Width(0.16f)
-	,Height(0.05f)
-	,Depth(0.16f)
+#include <cstring>
+
+Quad::Quad()
 {
+	ApplyProfile(QuadProfile());
+	mProfilePath[0] = 0;
 }
 
 void Quad::RenderUI()
 {
+#ifndef HEADLESS
+	ImGui::Text("Profile: %s", mName[0] ? mName : "(none)");
 	ImGui::InputFloat("Mass", &Mass);
 	ImGui::InputFloat("Width", &Width);
 	ImGui::InputFloat("Height", &Height);
 	ImGui::InputFloat("Depth", &Depth);
+	ImGui::InputFloat("Arm Length", &ArmLength);
+	ImGui::InputFloat3("Inertia (0 = box)", &Inertia.x);
+	ImGui::InputFloat("Linear Drag", &LinearDrag);
+	ImGui::InputFloat("Quadratic Drag", &QuadraticDrag);
+	ImGui::InputFloat("Attitude Noise (rad)", &AttitudeNoise);
+	ImGui::InputFloat("Height Noise (m)", &HeightNoise);
+	if (ImGui::TreeNode("Motors"))
+	{
+		Motors.RenderUI();
+		ImGui::TreePop();
+	}
+	if (ImGui::TreeNode("Profile"))
+	{
+		ImGui::InputText("Path", mProfilePath, sizeof(mProfilePath));
+		if (ImGui::Button("Load"))
+		{
+			std::string error;
+			if (!LoadProfile(mProfilePath, &error))
+			{
+				ERR("Failed to load the quad profile: %s", error.c_str());
+			}
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Save") && !SaveProfile(mProfilePath))
+		{
+			ERR("Failed to save the quad profile: %s", mProfilePath);
+		}
+		ImGui::TreePop();
+	}
+#endif
 }
 
 void Quad::Reset()
 {
 	Position = glm::vec3(0.0f);
 	Orientation = glm::vec3(0.0f);
+	Motors.Reset();
+}
+
+void Quad::ApplyProfile(const QuadProfile& profile)
+{
+	memcpy(mName, profile.Name, sizeof(mName));
+	Mass = profile.Mass;
+	Width = profile.Width;
+	Height = profile.Height;
+	Depth = profile.Depth;
+	ArmLength = profile.ArmLength;
+	Inertia = glm::vec3(profile.Inertia[0], profile.Inertia[1], profile.Inertia[2]);
+	LinearDrag = profile.LinearDrag;
+	QuadraticDrag = profile.QuadraticDrag;
+	AttitudeNoise = profile.AttitudeNoise;
+	HeightNoise = profile.HeightNoise;
+	Motors.Motor = profile.Motor;
+	for (int m = 0; m < MotorModel::k_NumMotors; ++m)
+	{
+		Motors.ThrustOffset[m] = profile.ThrustOffset[m];
+	}
+}
+
+QuadProfile Quad::GetProfile() const
+{
+	QuadProfile profile;
+	memcpy(profile.Name, mName, sizeof(profile.Name));
+	profile.Mass = Mass;
+	profile.Width = Width;
+	profile.Height = Height;
+	profile.Depth = Depth;
+	profile.ArmLength = ArmLength;
+	profile.Inertia[0] = Inertia.x;
+	profile.Inertia[1] = Inertia.y;
+	profile.Inertia[2] = Inertia.z;
+	profile.LinearDrag = LinearDrag;
+	profile.QuadraticDrag = QuadraticDrag;
+	profile.AttitudeNoise = AttitudeNoise;
+	profile.HeightNoise = HeightNoise;
+	profile.Motor = Motors.Motor;
+	for (int m = 0; m < MotorModel::k_NumMotors; ++m)
+	{
+		profile.ThrustOffset[m] = Motors.ThrustOffset[m];
+	}
+	return profile;
+}
+
+bool Quad::SaveProfile(const std::string& path)const
+{
+	return QuadProfileIO::Save(path, GetProfile());
 }
+
+bool Quad::LoadProfile(const std::string& path, std::string* error)
+{
+	QuadProfile profile;
+	if (!QuadProfileIO::Load(path, profile, error))
+	{
+		return false;
+	}
+	ApplyProfile(profile);
+	return true;
+}
\ No newline at end of file
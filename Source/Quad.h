@@ -3,6 +3,11 @@
 #include "glm/glm.hpp"
 #include "glm/gtx/quaternion.hpp"
 
+#include "MotorModel.h"
+#include "QuadProfile.h"
+
+#include <string>
+
 class Quad
 {
 public:
@@ -10,12 +15,29 @@ public:
 	void RenderUI();
 	void Reset();
 
+	// Physical parameters from/to an airframe profile (see QuadProfile.h).
+	void ApplyProfile(const QuadProfile& profile);
+	QuadProfile GetProfile()const;
+	bool SaveProfile(const std::string& path)const;
+	bool LoadProfile(const std::string& path, std::string* error = nullptr);
+
 	float Mass;
 	float Width;
 	float Height;
 	float Depth;
+	float ArmLength;		// Center to motor, motors on the diagonals (X frame)
+	glm::vec3 Inertia;		// Mass space inertia diagonal (kg*m^2), zero derives it from the box
+	float LinearDrag;		// N/(m/s)
+	float QuadraticDrag;	// N/(m/s)^2
+	MotorModel Motors;
+	float AttitudeNoise;	// Sensor noise seen by the controller (rad)
+	float HeightNoise;		// m
 
 	// The simulation will drive this values
 	glm::vec3 Position;
 	glm::vec3 Orientation;
+
+private:
+	char mName[32];
+	char mProfilePath[256];
 };
\ No newline at end of file
@@ -12,12 +12,16 @@
 #include "Graphics/DebugDraw.h"
 #include "Core/Logging.h"
 
+#include <algorithm>
+
 QuadExplorerApp::QuadExplorerApp()
 	:mCurTime(0.0f)
 	,mLoopVisualization(true)
 	,mInterpolateFrames(true)
+	,mForkSnapshot(0)
 	,mOverrideSimFrameIndex(0)
 	,mVisualizationSpeed(1.0f)
+	,mActiveAirframe(-1)
 {
 }
 
@@ -39,6 +43,16 @@ void QuadExplorerApp::Init()
 	// Setup simulation and quad:
 	mSimulation.Init();
 	mSimulation.SetQuadTarget(&mQuad);
+	if (mResultCache.Open("../../Temp/ResultCache/", 256ull << 20))
+	{
+		mSimulation.Cache = &mResultCache;
+	}
+	else
+	{
+		ERR("Could not open the result cache, simulations will not be cached");
+	}
+	mAirframes.Open("../../Assets/Quads/");
+	ApplyAirframe(mAirframes.Find("Default.quad"));
 	mFlyController = new UnityFlyController;
 	mSimulation.SetFlightController(mFlyController);
 
@@ -66,6 +80,10 @@ void QuadExplorerApp::Init()
 	mSimCamera->AddComponent<World::TransformComponent>();
 	mSimCamera->AddComponent<World::CameraComponent>()->ConfigureProjection(aspect, 80.0f, 0.1f, 100.0f);
 	mSimCamera->Transform->SetPosition(-5.0f, 1.0f, 0.0f);
+
+	// Board serial port, read and decoded on its own thread:
+	mLiveView.Init(&mSerialCom);
+	mLivePlotView.Follow = true;
 }
 
 void QuadExplorerApp::Update()
@@ -76,22 +94,30 @@ void QuadExplorerApp::Update()
 	// https://docs.microsoft.com/es-es/windows/win32/bluetooth/bluetooth-start-page
 
 
-	// Query coms:
+	// Query coms (telemetry samples and text for the log):
+	mLiveView.Update();
+
+	// Hot reload of the airframes, only the active one invalidates the simulation:
 	{
-		char data[128];
-		int readBytes = mSerialCom.ReadBytes(data, 128);
-		if (readBytes > 0)
+		std::vector<int> changed;
+		if (mAirframes.Update(&changed) && std::find(changed.begin(), changed.end(), mActiveAirframe) != changed.end())
 		{
-			data[readBytes] = 0;
-			INFO(data);
+			ApplyAirframe(mActiveAirframe);
 		}
 	}
 
 	// Render main config UI (also Quad and Sim UI):
 	RenderUI();
+	mQuadActor->Transform->SetScale(mQuad.Width, mQuad.Height, mQuad.Depth);
 
 	// Process visualization:
-	if (mSimulation.HasResults())
+	if (mLiveView.IsLive())
+	{
+		const SimulationFrame& liveFrame = mLiveView.GetFrame();
+		mQuadActor->Transform->SetPosition(liveFrame.QuadPosition);
+		mQuadActor->Transform->SetRotation(liveFrame.QuadOrientation);
+	}
+	else if (mSimulation.HasResults())
 	{
 		// Get current simulation frame (either from time or index)
 		SimulationFrame simFrame;
@@ -120,19 +146,46 @@ void QuadExplorerApp::Update()
 	// Trigger scene update and renderer:
 	mScene.Update(DeltaTime);
 	mRenderer.Render(&mScene);
+	mLiveView.MarkDisplayed();
 }
 
 void QuadExplorerApp::Release()
 {
+	mLiveView.Release();
 	AppBase::Release();
 }
 
+void QuadExplorerApp::ApplyAirframe(int index)
+{
+	if (index < 0 || !mAirframes.GetEntry(index).Valid)
+	{
+		return;
+	}
+	mActiveAirframe = index;
+	mQuad.ApplyProfile(mAirframes.GetEntry(index).Profile);
+	mSimulation.ClearResults();
+	mPlotData.Clear();
+	mCurTime = 0.0f;
+	mOverrideSimFrameIndex = 0;
+}
+
 void QuadExplorerApp::RenderUI()
 {
 	bool t = 1;
 	ImGui::ShowDemoWindow(&t);
 
 	mSerialCom.RenderUI();
+	mLiveView.RenderUI();
+	mReplayView.RenderUI();
+	mSysIdView.RenderUI(mQuad);
+	mComparisonView.RenderUI(mSimulation);
+
+	if (mAnalysisView.RenderUI(mSimulation))
+	{
+		mPlotData.Clear();
+		mCurTime = 0.0f;
+		mOverrideSimFrameIndex = 0;
+	}
 
 	// Render all the UI to show and tweak values:
 	ImGui::Begin("Quad Explorer");
@@ -140,6 +193,8 @@ void QuadExplorerApp::RenderUI()
 		if (ImGui::Button("Run Simulation"))
 		{
 			mSimulation.RunSimulation();
+			mForkParent.Reset();
+			mPlotData.Clear();
 			mCurTime = 0.0f;
 			mOverrideSimFrameIndex = 0;
 		}
@@ -149,6 +204,32 @@ void QuadExplorerApp::RenderUI()
 			mCurTime = 0.0f;
 			mOverrideSimFrameIndex = 0;
 		}
+
+		// Branching experiments: change gains, set points... and continue the run from a snapshot
+		const std::vector<SimulationSnapshot>& snapshots = mSimulation.GetSnapshots();
+		if (!snapshots.empty())
+		{
+			mForkSnapshot = std::min(mForkSnapshot, (int)snapshots.size() - 1);
+			ImGui::SliderInt("Fork Snapshot", &mForkSnapshot, 0, (int)snapshots.size() - 1);
+			ImGui::SameLine();
+			ImGui::Text("%.2f s", snapshots[mForkSnapshot].Time);
+			if (ImGui::Button("Fork Simulation"))
+			{
+				const SimulationSnapshot snapshot = snapshots[mForkSnapshot];
+				mForkParent = mSimulation.GetSimulationResults();
+				if (mSimulation.ForkSimulation(mForkSnapshot))
+				{
+					mPlotData.Clear();
+					mCurTime = snapshot.Time;
+					mOverrideSimFrameIndex = snapshot.FrameIdx;
+				}
+			}
+			if (!mForkParent.Frames.empty())
+			{
+				const SimulationResult& result = mSimulation.GetSimulationResults();
+				ImGui::Text("%i of %i frames shared with the parent run", (int)result.Frames.GetNumShared(), (int)result.Frames.size());
+			}
+		}
 		ImGui::Checkbox("Loop Visualization", &mLoopVisualization);
 		if (mLoopVisualization)
 		{
@@ -163,111 +244,23 @@ void QuadExplorerApp::RenderUI()
 		ImGui::Checkbox("Interpolate Frames", &mInterpolateFrames);
 		ImGui::Separator();
 
-		bool simReady = mSimulation.HasResults();
-		if (simReady)
+		if (mLiveView.IsLive())
 		{
-			ImGui::Begin("Plotting");
-			if (ImGui::CollapsingHeader("General"))
-			{
-				// Plot height
-				ImGui::PlotLines("Height", [](void* data, int idx) 
-				{
-					const SimulationResult* results = (const SimulationResult*)data;
-					if (!results)
-					{
-						return 0.0f;
-					}
-					return results->Frames[idx].QuadPosition.y;
-				}, (void*)&mSimulation.GetSimulationResults(), mSimulation.GetNumFrames(), 0, 0, -1.0f, 5.0f, ImVec2(512, 128));
-
-				// Plot pitch
-				ImGui::PlotLines("Pitch", [](void* data, int idx)
-				{
-					const SimulationResult* results = (const SimulationResult*)data;
-					if (!results)
-					{
-						return 0.0f;
-					}
-					return glm::degrees(results->Frames[idx].QuadOrientation.x);
-				}, (void*)&mSimulation.GetSimulationResults(), mSimulation.GetNumFrames(), 0, 0,-60, 60.0f, ImVec2(512, 128));
-
-				// Plot roll
-				ImGui::PlotLines("Roll", [](void* data, int idx)
-				{
-					const SimulationResult* results = (const SimulationResult*)data;
-					if (!results)
-					{
-						return 0.0f;
-					}
-					return glm::degrees(results->Frames[idx].QuadOrientation.z);
-				}, (void*)&mSimulation.GetSimulationResults(), mSimulation.GetNumFrames(), 0, 0, -60.0f, 60.0f, ImVec2(512, 128));
-			}
-			if (ImGui::CollapsingHeader("PID"))
+			RenderPlots(mLiveView.GetPlotData(), mLiveView.GetSampleInterval(), mLivePlotView);
+		}
+		else if (mSimulation.HasResults())
+		{
+			mPlotData.Update(mSimulation.GetSimulationResults());
+			RenderPlots(mPlotData, mSimulation.GetSimulationResults().DeltaTime, mPlotView);
+		}
+
+		if (ImGui::CollapsingHeader("Airframes"))
+		{
+			int selected = mActiveAirframe;
+			if (mAirframes.RenderUI(selected))
 			{
-				struct PIDDATA
-				{
-					const SimulationResult* Results;
-					SimulationFrame::PIDType Type;
-				};
-
-				auto plotPID_P = [this](const char* label, PIDDATA data) {
-					ImGui::PlotLines(label, [](void* data, int idx)
-					{
-						const PIDDATA* pData = (const PIDDATA*)data;
-						if (!pData)
-						{
-							return 0.0f;
-						}
-						return pData->Results->Frames[idx].GetPIDState(pData->Type).P;
-					}, (void*)&data, mSimulation.GetNumFrames(), 0, 0, FLT_MAX, FLT_MAX, ImVec2(512, 128));
-				};
-				auto plotPID_I = [this](const char* label, PIDDATA data) {
-					ImGui::PlotLines(label, [](void* data, int idx)
-					{
-						const PIDDATA* pData = (const PIDDATA*)data;
-						if (!pData)
-						{
-							return 0.0f;
-						}
-						return pData->Results->Frames[idx].GetPIDState(pData->Type).I;
-					}, (void*)&data, mSimulation.GetNumFrames(), 0, 0, FLT_MAX, FLT_MAX, ImVec2(512, 128));
-				};
-				auto plotPID_D = [this](const char* label, PIDDATA data) {
-					ImGui::PlotLines(label, [](void* data, int idx)
-					{
-						const PIDDATA* pData = (const PIDDATA*)data;
-						if (!pData)
-						{
-							return 0.0f;
-						}
-						return pData->Results->Frames[idx].GetPIDState(pData->Type).D;
-					}, (void*)&data, mSimulation.GetNumFrames(), 0, 0, FLT_MAX, FLT_MAX, ImVec2(512, 128));
-				};
-
-				PIDDATA dat = { &mSimulation.GetSimulationResults(), SimulationFrame::PIDType::Height };
-				if (ImGui::CollapsingHeader("Height"))
-				{
-					plotPID_P("P", dat);
-					plotPID_I("I", dat);
-					plotPID_D("D", dat);
-				}
-				dat.Type = SimulationFrame::Pitch;
-				if (ImGui::CollapsingHeader("Pitch"))
-				{
-					plotPID_P("P", dat);
-					plotPID_I("I", dat);
-					plotPID_D("D", dat);
-				}
-				dat.Type = SimulationFrame::Roll;
-				if (ImGui::CollapsingHeader("Roll"))
-				{
-					plotPID_P("P", dat);
-					plotPID_I("I", dat);
-					plotPID_D("D", dat);
-				}
+				ApplyAirframe(selected);
 			}
-
-			ImGui::End();
 		}
 
 		// Display simulation UI (this will also show quad UI)
@@ -277,11 +270,55 @@ void QuadExplorerApp::RenderUI()
 		}
 		if (ImGui::CollapsingHeader("Fly Controller"))
 		{
+			mGainSetView.RenderUI(*mFlyController);
+			ImGui::Separator();
 			mFlyController->RenderUI();
 		}
 	}
 	ImGui::End();
 }
 
+void QuadExplorerApp::RenderPlots(const SimulationPlotData& plotData, float deltaTime, PlotView& plotView)
+{
+	ImGui::Begin("Plotting");
+	plotView.SetExtent(plotData.GetNumSamples(), deltaTime);
+	ImGui::Checkbox("Follow", &plotView.Follow);
+	ImGui::SameLine();
+	if (ImGui::Button("Reset View"))
+	{
+		plotView.ResetView();
+	}
+
+	const ImVec2 plotSize(512, 128);
+	if (ImGui::CollapsingHeader("General"))
+	{
+		plotView.Plot("Height", plotData.Get(SimulationPlotData::Channel::Height), -1.0f, 5.0f, plotSize);
+		plotView.Plot("Pitch", plotData.Get(SimulationPlotData::Channel::Pitch), -60.0f, 60.0f, plotSize);
+		plotView.Plot("Roll", plotData.Get(SimulationPlotData::Channel::Roll), -60.0f, 60.0f, plotSize);
+	}
+	if (ImGui::CollapsingHeader("PID"))
+	{
+		const char* pidNames[3] = { "Height", "Pitch", "Roll" };
+		const char* termNames[3] = { "P", "I", "D" };
+		ImGui::PushID("PID");
+		for (int p = 0; p < 3; ++p)
+		{
+			if (ImGui::CollapsingHeader(pidNames[p]))
+			{
+				ImGui::PushID(p);
+				for (int t = 0; t < 3; ++t)
+				{
+					SimulationPlotData::Channel::T channel = (SimulationPlotData::Channel::T)(SimulationPlotData::Channel::HeightP + p * 3 + t);
+					plotView.Plot(termNames[t], plotData.Get(channel), 0.0f, 0.0f, plotSize);
+				}
+				ImGui::PopID();
+			}
+		}
+		ImGui::PopID();
+	}
+
+	ImGui::End();
+}
+
 QuadExplorerApp app;
 ENTRY_POINT(app, "Quad Explorer App", false);
@@ -5,9 +5,18 @@
 #include "Graphics/TestRenderer.h"
 
 #include "Simulation.h"
+#include "ResultCache.h"
 #include "Quad.h"
+#include "QuadProfileLibrary.h"
 #include "UnityFlightController.h"
+#include "GainSetView.h"
 #include "Coms/SerialCom.h"
+#include "Live/LiveView.h"
+#include "Analysis/AnalysisView.h"
+#include "Analysis/ComparisonView.h"
+#include "Plotting/PlotView.h"
+#include "Replay/ReplayView.h"
+#include "SysId/SysIdView.h"
 
 namespace World
 {
@@ -30,12 +39,21 @@ public:
 	void RenderUI();
 
 private:
+	void ApplyAirframe(int index);
+	void RenderPlots(const SimulationPlotData& plotData, float deltaTime, PlotView& plotView);
+
 	World::SceneGraph mScene;
 	Graphics::TestRenderer mRenderer;
 
 	Simulation mSimulation;
+	ResultCache mResultCache;
+	SimulationResult mForkParent;	// Run the current result was forked from, shares its frames
+	int mForkSnapshot;
 	Quad mQuad;
+	QuadProfileLibrary mAirframes;
+	int mActiveAirframe;
 	UnityFlyController* mFlyController;
+	GainSetView mGainSetView;
 	float mCurTime;
 	float mVisualizationSpeed;
 	bool mLoopVisualization;
@@ -49,6 +67,26 @@ private:
 	Graphics::Model* mCubeModel;
 	Graphics::Model* mQuadModel;
 
+	// Plotting:
+	SimulationPlotData mPlotData;
+	PlotView mPlotView;
+
 	// Serial coms
 	SerialCom mSerialCom;
+
+	// Board telemetry stream, drives the visualization and the plots in live mode
+	LiveView mLiveView;
+	PlotView mLivePlotView;
+
+	// Frequency/step response analysis
+	AnalysisView mAnalysisView;
+
+	// Simulation runs against board logs
+	ComparisonView mComparisonView;
+
+	// Replay of board logs through candidate controllers
+	ReplayView mReplayView;
+
+	// Fits the quad parameters to board logs
+	SysIdView mSysIdView;
 };
\ No newline at end of file
@@ -0,0 +1,288 @@
+#include "QuadProfile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+QuadProfile::QuadProfile()
+	:Mass(0.081f)
+	,Width(0.16f)
+	,Height(0.05f)
+	,Depth(0.16f)
+	,ArmLength(0.1131f)
+	,LinearDrag(0.02f)
+	,QuadraticDrag(0.005f)
+	,AttitudeNoise(0.08f)
+	,HeightNoise(0.0f)
+{
+	Name[0] = 0;
+	Inertia[0] = Inertia[1] = Inertia[2] = 0.0f;
+
+	MotorModel defaults;
+	Motor = defaults.Motor;
+	for (int m = 0; m < MotorModel::k_NumMotors; ++m)
+	{
+		ThrustOffset[m] = defaults.ThrustOffset[m];
+	}
+}
+
+static bool GetSourceStamp(const std::string& path, int64_t& size, int64_t& time)
+{
+#ifdef _WIN32
+	struct _stat64 info;
+	if (_stat64(path.c_str(), &info) != 0)
+#else
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0)
+#endif
+	{
+		return false;
+	}
+	size = (int64_t)info.st_size;
+	time = (int64_t)info.st_mtime;
+	return true;
+}
+
+static bool WriteProfiles(const std::string& path, const QuadProfile* profiles, int numProfiles, int64_t sourceSize, int64_t sourceTime)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+	QuadProfileHeader header;
+	header.Magic = QuadProfileSet::k_Magic;
+	header.Version = QuadProfileSet::k_Version;
+	header.ProfileSize = sizeof(QuadProfile);
+	header.NumProfiles = (uint32_t)numProfiles;
+	header.SourceSize = sourceSize;
+	header.SourceTime = sourceTime;
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	ok = ok && (numProfiles == 0 || fwrite(profiles, sizeof(QuadProfile), numProfiles, file) == (size_t)numProfiles);
+	ok = fclose(file) == 0 && ok;
+	return ok;
+}
+
+static bool IsValidHeader(const QuadProfileHeader& header)
+{
+	return header.Magic == QuadProfileSet::k_Magic && header.Version == QuadProfileSet::k_Version && header.ProfileSize == sizeof(QuadProfile);
+}
+
+bool QuadProfileIO::Parse(const std::string& text, QuadProfile& result, std::string* error)
+{
+	// Parse into a copy so a bad profile leaves the result untouched:
+	QuadProfile profile = result;
+	std::istringstream lines(text);
+	std::string line;
+	int lineIdx = 0;
+	while (std::getline(lines, line))
+	{
+		++lineIdx;
+		std::istringstream tokens(line);
+		std::string key;
+		if (!(tokens >> key) || key[0] == '#')
+		{
+			continue;
+		}
+
+		bool ok = true;
+		if (key == "name")
+		{
+			std::string name;
+			std::getline(tokens >> std::ws, name);
+			ok = !name.empty();
+			snprintf(profile.Name, sizeof(profile.Name), "%s", name.c_str());
+		}
+		else if (key == "mass")						ok = (bool)(tokens >> profile.Mass);
+		else if (key == "size")						ok = (bool)(tokens >> profile.Width >> profile.Height >> profile.Depth);
+		else if (key == "arm")						ok = (bool)(tokens >> profile.ArmLength);
+		else if (key == "inertia")					ok = (bool)(tokens >> profile.Inertia[0] >> profile.Inertia[1] >> profile.Inertia[2]);
+		else if (key == "drag")						ok = (bool)(tokens >> profile.LinearDrag >> profile.QuadraticDrag);
+		else if (key == "noise.attitude")			ok = (bool)(tokens >> profile.AttitudeNoise);
+		else if (key == "noise.height")				ok = (bool)(tokens >> profile.HeightNoise);
+		else if (key == "motor.max_thrust")			ok = (bool)(tokens >> profile.Motor.MaxThrust);
+		else if (key == "motor.thrust_curve")		ok = (bool)(tokens >> profile.Motor.ThrustCurve);
+		else if (key == "motor.torque_coeff")		ok = (bool)(tokens >> profile.Motor.TorqueCoeff);
+		else if (key == "motor.time_constant")		ok = (bool)(tokens >> profile.Motor.TimeConstant);
+		else if (key == "motor.voltage")			ok = (bool)(tokens >> profile.Motor.NominalVoltage);
+		else if (key == "motor.resistance")			ok = (bool)(tokens >> profile.Motor.InternalResistance);
+		else if (key == "motor.max_current")		ok = (bool)(tokens >> profile.Motor.MaxCurrent);
+		else if (key == "motor.pwm_bits")			ok = (bool)(tokens >> profile.Motor.PWMBits);
+		else if (key == "motor.thrust_offset")
+		{
+			for (int m = 0; m < MotorModel::k_NumMotors && ok; ++m)
+			{
+				ok = (bool)(tokens >> profile.ThrustOffset[m]);
+			}
+		}
+		else
+		{
+			if (error)
+			{
+				*error = "Line " + std::to_string(lineIdx) + ": unknown key " + key;
+			}
+			return false;
+		}
+
+		if (!ok)
+		{
+			if (error)
+			{
+				*error = "Line " + std::to_string(lineIdx) + ": invalid value for " + key;
+			}
+			return false;
+		}
+	}
+	result = profile;
+	return true;
+}
+
+std::string QuadProfileIO::Format(const QuadProfile& profile)
+{
+	std::ostringstream text;
+	text.precision(7);
+	if (profile.Name[0])
+	{
+		text << "name " << profile.Name << "\n";
+	}
+	text << "mass " << profile.Mass << "\n";
+	text << "size " << profile.Width << " " << profile.Height << " " << profile.Depth << "\n";
+	text << "arm " << profile.ArmLength << "\n";
+	text << "inertia " << profile.Inertia[0] << " " << profile.Inertia[1] << " " << profile.Inertia[2] << "\n";
+	text << "drag " << profile.LinearDrag << " " << profile.QuadraticDrag << "\n";
+	text << "noise.attitude " << profile.AttitudeNoise << "\n";
+	text << "noise.height " << profile.HeightNoise << "\n";
+	text << "motor.max_thrust " << profile.Motor.MaxThrust << "\n";
+	text << "motor.thrust_curve " << profile.Motor.ThrustCurve << "\n";
+	text << "motor.torque_coeff " << profile.Motor.TorqueCoeff << "\n";
+	text << "motor.time_constant " << profile.Motor.TimeConstant << "\n";
+	text << "motor.voltage " << profile.Motor.NominalVoltage << "\n";
+	text << "motor.resistance " << profile.Motor.InternalResistance << "\n";
+	text << "motor.max_current " << profile.Motor.MaxCurrent << "\n";
+	text << "motor.pwm_bits " << profile.Motor.PWMBits << "\n";
+	text << "motor.thrust_offset";
+	for (int m = 0; m < MotorModel::k_NumMotors; ++m)
+	{
+		text << " " << profile.ThrustOffset[m];
+	}
+	text << "\n";
+	return text.str();
+}
+
+bool QuadProfileIO::Load(const std::string& path, QuadProfile& profile, std::string* error)
+{
+	int64_t sourceSize = 0;
+	int64_t sourceTime = 0;
+	if (!GetSourceStamp(path, sourceSize, sourceTime))
+	{
+		if (error)
+		{
+			*error = "Could not open " + path;
+		}
+		return false;
+	}
+
+	// Up to date cache, no parsing:
+	const std::string cachePath = path + ".bin";
+	{
+		std::ifstream cache(cachePath, std::ios::binary);
+		QuadProfileHeader header;
+		QuadProfile cached;
+		if (cache.read((char*)&header, sizeof(header)) && IsValidHeader(header) && header.NumProfiles == 1 &&
+			header.SourceSize == sourceSize && header.SourceTime == sourceTime && cache.read((char*)&cached, sizeof(cached)))
+		{
+			profile = cached;
+			return true;
+		}
+	}
+
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		if (error)
+		{
+			*error = "Could not open " + path;
+		}
+		return false;
+	}
+	std::stringstream text;
+	text << file.rdbuf();
+
+	QuadProfile parsed;
+	if (!Parse(text.str(), parsed, error))
+	{
+		return false;
+	}
+	if (!parsed.Name[0])
+	{
+		// Default to the file name:
+		size_t start = path.find_last_of("/\\");
+		start = start == std::string::npos ? 0 : start + 1;
+		std::string name = path.substr(start, path.find_last_of('.') - start);
+		snprintf(parsed.Name, sizeof(parsed.Name), "%s", name.c_str());
+	}
+	WriteProfiles(cachePath, &parsed, 1, sourceSize, sourceTime);
+	profile = parsed;
+	return true;
+}
+
+bool QuadProfileIO::Save(const std::string& path, const QuadProfile& profile)
+{
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		return false;
+	}
+	file << Format(profile);
+	return file.good();
+}
+
+QuadProfileSet::QuadProfileSet()
+	:mProfiles(nullptr)
+	,mNumProfiles(0)
+{
+}
+
+bool QuadProfileSet::Open(const std::string& path)
+{
+	Close();
+	if (!mFile.Open(path) || mFile.GetSize() < sizeof(QuadProfileHeader))
+	{
+		Close();
+		return false;
+	}
+	const QuadProfileHeader* header = (const QuadProfileHeader*)mFile.GetData();
+	size_t expected = sizeof(QuadProfileHeader) + (size_t)header->NumProfiles * sizeof(QuadProfile);
+	if (!IsValidHeader(*header) || mFile.GetSize() < expected)
+	{
+		Close();
+		return false;
+	}
+	mProfiles = (const QuadProfile*)((const char*)mFile.GetData() + sizeof(QuadProfileHeader));
+	mNumProfiles = (int)header->NumProfiles;
+	return true;
+}
+
+void QuadProfileSet::Close()
+{
+	mFile.Close();
+	mProfiles = nullptr;
+	mNumProfiles = 0;
+}
+
+int QuadProfileSet::GetNumProfiles() const
+{
+	return mNumProfiles;
+}
+
+const QuadProfile* QuadProfileSet::GetProfiles() const
+{
+	return mProfiles;
+}
+
+bool QuadProfileSet::Write(const std::string& path, const QuadProfile* profiles, int numProfiles)
+{
+	return WriteProfiles(path, profiles, numProfiles, 0, 0);
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "MotorModel.h"
+#include "IO/MappedFile.h"
+
+#include <stdint.h>
+#include <string>
+
+// Physical description of an airframe. Plain data so it is stored as is in the binary cache
+// and in profile sets.
+struct QuadProfile
+{
+	QuadProfile();
+
+	char Name[32];
+	float Mass;
+	float Width;				// Body box, used for the collision, the default inertia and the mesh
+	float Height;
+	float Depth;
+	float ArmLength;			// Center to motor, motors on the diagonals (X frame)
+	float Inertia[3];			// Mass space inertia diagonal (kg*m^2), zero derives it from the box
+	float LinearDrag;			// N/(m/s)
+	float QuadraticDrag;		// N/(m/s)^2
+	MotorModel::Params Motor;
+	float ThrustOffset[MotorModel::k_NumMotors];
+	float AttitudeNoise;		// Uniform noise added to the attitude seen by the controller (rad)
+	float HeightNoise;			// Uniform noise added to the height seen by the controller (m)
+};
+
+// Binary layout of caches and sets: header followed by NumProfiles packed QuadProfile. The
+// source stamp is the size and modification time of the text profile a cache was compiled from.
+struct QuadProfileHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t ProfileSize;
+	uint32_t NumProfiles;
+	int64_t SourceSize;
+	int64_t SourceTime;
+};
+
+// Text profiles are "key value..." lines (# starts a comment), missing keys keep their default:
+//   name, mass, size (w h d), arm, inertia (x y z), drag (linear quadratic), noise.attitude,
+//   noise.height, motor.max_thrust, motor.thrust_curve, motor.torque_coeff, motor.time_constant,
+//   motor.voltage, motor.resistance, motor.max_current, motor.pwm_bits, motor.thrust_offset (x4)
+namespace QuadProfileIO
+{
+	bool Parse(const std::string& text, QuadProfile& profile, std::string* error = nullptr);
+	std::string Format(const QuadProfile& profile);
+
+	// Loads a text profile through its binary cache (path + ".bin"). The cache is rebuilt when
+	// the text changed, a failure to write it is not an error.
+	bool Load(const std::string& path, QuadProfile& profile, std::string* error = nullptr);
+	bool Save(const std::string& path, const QuadProfile& profile);
+}
+
+// Memory mapped set of compiled profiles, batch runs iterate them without any parsing.
+class QuadProfileSet
+{
+public:
+	static const uint32_t k_Magic = 0x50444551; // "QEDP"
+	static const uint32_t k_Version = 1;
+
+	QuadProfileSet();
+	bool Open(const std::string& path);
+	void Close();
+	int GetNumProfiles()const;
+	const QuadProfile* GetProfiles()const;
+
+	static bool Write(const std::string& path, const QuadProfile* profiles, int numProfiles);
+
+private:
+	MappedFile mFile;
+	const QuadProfile* mProfiles;
+	int mNumProfiles;
+};
\ No newline at end of file
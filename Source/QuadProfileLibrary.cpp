@@ -0,0 +1,161 @@
+#include "QuadProfileLibrary.h"
+#include "IO/Directory.h"
+#include "Graphics/UI/IMGUI/imgui.h"
+#include "Core/Logging.h"
+
+#include <cstdio>
+#include <cstring>
+
+static const char* k_Extension = ".quad";
+
+QuadProfileLibrary::QuadProfileLibrary()
+{
+	strcpy(mSetPath, "Airframes.quadset");
+}
+
+bool QuadProfileLibrary::Open(const std::string& directory)
+{
+	mDirectory = directory;
+	mEntries.clear();
+
+	std::vector<std::string> names;
+	if (!Directory::ListFiles(directory, k_Extension, names))
+	{
+		return false;
+	}
+	for (const std::string& name : names)
+	{
+		Entry entry;
+		entry.FileName = name;
+		entry.Generation = 0;
+		entry.Valid = false;
+		Reload(entry);
+		mEntries.push_back(entry);
+	}
+
+	if (!mWatcher.Watch(directory))
+	{
+		INFO("Hot reload not available for %s", directory.c_str());
+	}
+	return true;
+}
+
+void QuadProfileLibrary::Reload(Entry& entry)
+{
+	std::string error;
+	QuadProfile profile;
+	bool valid = QuadProfileIO::Load(Directory::Join(mDirectory, entry.FileName), profile, &error);
+	if (valid)
+	{
+		entry.Profile = profile;
+	}
+	else if (!error.empty())
+	{
+		// Keep the last good profile while the file is being edited:
+		ERR("%s: %s", entry.FileName.c_str(), error.c_str());
+		valid = entry.Valid;
+	}
+	entry.Valid = valid;
+	entry.Generation++;
+}
+
+bool QuadProfileLibrary::Update(std::vector<int>* changed)
+{
+	if (changed)
+	{
+		changed->clear();
+	}
+
+	std::vector<std::string> files;
+	mWatcher.Poll(files);
+	bool anyChanged = false;
+	for (const std::string& file : files)
+	{
+		if (file.size() < strlen(k_Extension) || file.compare(file.size() - strlen(k_Extension), std::string::npos, k_Extension) != 0)
+		{
+			continue; // Binary caches and anything else in the directory
+		}
+
+		int index = Find(file);
+		if (index < 0)
+		{
+			Entry entry;
+			entry.FileName = file;
+			entry.Generation = 0;
+			entry.Valid = false;
+			mEntries.push_back(entry);
+			index = (int)mEntries.size() - 1;
+		}
+		Reload(mEntries[index]);
+		INFO("Reloaded airframe %s", file.c_str());
+		if (changed)
+		{
+			changed->push_back(index);
+		}
+		anyChanged = true;
+	}
+	return anyChanged;
+}
+
+int QuadProfileLibrary::GetNumProfiles() const
+{
+	return (int)mEntries.size();
+}
+
+const QuadProfileLibrary::Entry& QuadProfileLibrary::GetEntry(int index) const
+{
+	return mEntries[index];
+}
+
+int QuadProfileLibrary::Find(const std::string& fileName) const
+{
+	for (size_t i = 0; i < mEntries.size(); ++i)
+	{
+		if (mEntries[i].FileName == fileName)
+		{
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+bool QuadProfileLibrary::WriteSet(const std::string& path) const
+{
+	std::vector<QuadProfile> profiles;
+	for (const Entry& entry : mEntries)
+	{
+		if (entry.Valid)
+		{
+			profiles.push_back(entry.Profile);
+		}
+	}
+	return QuadProfileSet::Write(path, profiles.data(), (int)profiles.size());
+}
+
+bool QuadProfileLibrary::RenderUI(int& selected)
+{
+	bool changed = false;
+	ImGui::Text("Directory: %s", mDirectory.c_str());
+	for (size_t i = 0; i < mEntries.size(); ++i)
+	{
+		const Entry& entry = mEntries[i];
+		if (!entry.Valid)
+		{
+			continue;
+		}
+		char label[128];
+		snprintf(label, sizeof(label), "%s (%s)", entry.Profile.Name, entry.FileName.c_str());
+		if (ImGui::Selectable(label, selected == (int)i))
+		{
+			selected = (int)i;
+			changed = true;
+		}
+	}
+	ImGui::InputText("Set", mSetPath, sizeof(mSetPath));
+	ImGui::SameLine();
+	if (ImGui::Button("Write Set") && !WriteSet(mSetPath))
+	{
+		ERR("Failed to write the airframe set: %s", mSetPath);
+	}
+	return changed;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "QuadProfile.h"
+#include "IO/FileWatcher.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Airframe profiles of a directory (*.quad), loaded through their binary cache and reloaded
+// when the text changes on disk. Every reload bumps the generation of that entry only, so
+// whoever holds state derived from a profile invalidates it only when its own profile changed.
+// Entries keep their index for the lifetime of the library (deleted files are marked invalid).
+class QuadProfileLibrary
+{
+public:
+	struct Entry
+	{
+		std::string FileName;
+		QuadProfile Profile;
+		uint32_t Generation;
+		bool Valid;
+	};
+
+	QuadProfileLibrary();
+	bool Open(const std::string& directory);
+
+	// Reloads the changed profiles, returns true if any entry changed (indices in changed).
+	bool Update(std::vector<int>* changed = nullptr);
+
+	int GetNumProfiles()const;
+	const Entry& GetEntry(int index)const;
+	int Find(const std::string& fileName)const;
+
+	// Compiled set of all the valid profiles, see QuadProfileSet.
+	bool WriteSet(const std::string& path)const;
+
+	// Lists the profiles, returns true when one is selected.
+	bool RenderUI(int& selected);
+
+private:
+	void Reload(Entry& entry);
+
+	std::string mDirectory;
+	std::vector<Entry> mEntries;
+	FileWatcher mWatcher;
+	char mSetPath[256];
+};
\ No newline at end of file
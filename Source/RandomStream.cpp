@@ -0,0 +1,58 @@
+#include "RandomStream.h"
+
+#include <cmath>
+
+static const uint64_t k_Golden = 0x9E3779B97F4A7C15ull;
+
+static uint64_t Mix(uint64_t z)
+{
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+RandomStream::RandomStream()
+{
+	Seed(0, Stream::SensorNoise);
+}
+
+void RandomStream::Seed(uint32_t seed, Stream::T stream, uint32_t substream)
+{
+	mState = Mix(((uint64_t)seed << 8) ^ (uint64_t)stream ^ ((uint64_t)substream << 40));
+	mSpareNormal = 0.0f;
+	mHasSpareNormal = false;
+}
+
+uint32_t RandomStream::NextU32()
+{
+	mState += k_Golden;
+	return (uint32_t)(Mix(mState) >> 32);
+}
+
+float RandomStream::Uniform()
+{
+	// 24 bits, exactly representable so the result is never 1:
+	return (float)(NextU32() >> 8) * (1.0f / 16777216.0f);
+}
+
+float RandomStream::Uniform(float min, float max)
+{
+	return min + (max - min) * Uniform();
+}
+
+float RandomStream::Normal()
+{
+	// Box-Muller, the second value of each pair is kept for the next call:
+	if (mHasSpareNormal)
+	{
+		mHasSpareNormal = false;
+		return mSpareNormal;
+	}
+	float u = 1.0f - Uniform();	// (0,1], log(0) is not finite
+	float v = Uniform();
+	float radius = std::sqrt(-2.0f * std::log(u));
+	float angle = 6.28318530718f * v;
+	mSpareNormal = radius * std::sin(angle);
+	mHasSpareNormal = true;
+	return radius * std::cos(angle);
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+
+// Seeded random numbers for the simulation. Every consumer draws from its own stream derived
+// from the run seed, so adding or reordering consumers does not change what the others see.
+// SplitMix64 plus our own distributions: std::mt19937 is portable but the std distributions
+// are not, they differ between standard libraries.
+class RandomStream
+{
+public:
+	struct Stream
+	{
+		enum T
+		{
+			SensorNoise,
+			Gusts,
+			Imu,
+			Optimizer,
+			COUNT
+		};
+	};
+
+	RandomStream();
+	// The substream tells apart the consumers of one stream (the vehicles of a batch...).
+	void Seed(uint32_t seed, Stream::T stream, uint32_t substream = 0);
+
+	uint32_t NextU32();
+	float Uniform();					// [0,1)
+	float Uniform(float min, float max);
+	float Normal();						// Mean 0, standard deviation 1
+
+private:
+	uint64_t mState;
+	float mSpareNormal;
+	bool mHasSpareNormal;
+};
\ No newline at end of file
@@ -0,0 +1,318 @@
+#include "FlightLog.h"
+#include "Simulation.h"
+#include "GainSet.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+// Hex bytes until the first non hex digit or maxSize, returns the number of bytes.
+static uint32_t ReadHex(const char* text, uint8_t* out, uint32_t maxSize)
+{
+	uint32_t size = 0;
+	while (size < maxSize && isxdigit((unsigned char)text[2 * size]) && isxdigit((unsigned char)text[2 * size + 1]))
+	{
+		unsigned int byte = 0;
+		sscanf(text + 2 * size, "%2x", &byte);
+		out[size++] = (uint8_t)byte;
+	}
+	return size;
+}
+
+FlightLog::FlightLog()
+	:mHasBlackBoxReport(false)
+	,mRecords(nullptr)
+	,mNumRecords(0)
+{
+}
+
+bool FlightLog::Open(const std::string& path)
+{
+	Close();
+	if (!mFile.Open(path))
+	{
+		return false;
+	}
+
+	const FlightLogHeader* header = (const FlightLogHeader*)mFile.GetData();
+	if (mFile.GetSize() >= sizeof(FlightLogHeader) && header->Magic == k_Magic)
+	{
+		size_t expected = sizeof(FlightLogHeader) + (size_t)header->NumRecords * sizeof(FlightLogRecord);
+		if (header->Version != k_Version || header->RecordSize != sizeof(FlightLogRecord) || mFile.GetSize() < expected)
+		{
+			Close();
+			return false;
+		}
+		mRecords = (const FlightLogRecord*)((const char*)mFile.GetData() + sizeof(FlightLogHeader));
+		mNumRecords = (int)header->NumRecords;
+		return true;
+	}
+
+	// Text telemetry or dumps, the dump lines may have a prefix (capture timestamps):
+	mFile.Close();
+	std::ifstream file(path);
+	std::string line;
+	bool inDump = false;
+	int chunkIdx = 0;
+	while (std::getline(file, line))
+	{
+		const size_t stream = line.find("QTEL ");
+		if (stream != std::string::npos)
+		{
+			FlightSample sample;
+			if (ParseStreamLine(line.c_str() + stream + 5, sample))
+			{
+				mStream.push_back(sample);
+			}
+			continue;
+		}
+		const size_t recorder = line.find("QREC ");
+		const size_t blackBox = line.find("QBOX ");
+		if (recorder != std::string::npos || blackBox != std::string::npos)
+		{
+			const bool isBlackBox = recorder == std::string::npos;
+			ParseDumpLine(isBlackBox, line.c_str() + (isBlackBox ? blackBox : recorder) + 5, inDump, chunkIdx);
+			continue;
+		}
+		FlightLogRecord record;
+		if (ParseTelemetryLine(line.c_str(), record))
+		{
+			mParsed.push_back(record);
+		}
+	}
+
+	// A dump has the whole control loop, it wins over the telemetry lines:
+	if (!mRecorder.Samples.empty())
+	{
+		ToRecords(mRecorder.Samples, mParsed);
+	}
+	else if (!mBlackBox.Samples.empty())
+	{
+		ToRecords(mBlackBox.Samples, mParsed);
+	}
+	else if (!mStream.empty())
+	{
+		ToRecords(mStream, mParsed);
+	}
+	mRecords = mParsed.data();
+	mNumRecords = (int)mParsed.size();
+	return mNumRecords > 0;
+}
+
+void FlightLog::Close()
+{
+	mFile.Close();
+	mParsed.clear();
+	mRecorder = Dump();
+	mBlackBox = Dump();
+	mStream.clear();
+	mHasBlackBoxReport = false;
+	mRecords = nullptr;
+	mNumRecords = 0;
+}
+
+int FlightLog::GetNumRecords() const
+{
+	return mNumRecords;
+}
+
+const FlightLogRecord* FlightLog::GetRecords() const
+{
+	return mRecords;
+}
+
+bool FlightLog::Write(const std::string& path, const FlightLogRecord* records, int numRecords)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+	FlightLogHeader header = { k_Magic, k_Version, (uint32_t)sizeof(FlightLogRecord), (uint32_t)numRecords };
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	ok = ok && (numRecords == 0 || fwrite(records, sizeof(FlightLogRecord), numRecords, file) == (size_t)numRecords);
+	fclose(file);
+	return ok;
+}
+
+bool FlightLog::ParseTelemetryLine(const char* line, FlightLogRecord& record)
+{
+	memset(&record, 0, sizeof(record));
+	FCQuadState& s = record.State;
+	FCSetPoints& sp = record.SetPoints;
+	FCCommands& c = record.Commands;
+	int numRead = sscanf(line, "%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f",
+		&s.Time, &s.DeltaTime, &s.Height, &s.Pitch, &s.Yaw, &s.Roll,
+		&sp.Thrust, &sp.Yaw, &sp.Pitch, &sp.Roll,
+		&c.FrontLeftThr, &c.FrontRightThr, &c.RearLeftThr, &c.RearRightThr);
+
+	// The commands are optional:
+	return numRead == 10 || numRead == 14;
+}
+
+bool FlightLog::ParseStreamLine(const char* text, FlightSample& sample)
+{
+	uint8_t data[FlightRecorder::k_MaxSampleSize + 4];
+	const uint32_t size = ReadHex(text, data, sizeof(data));
+	if (size <= 4 || isxdigit((unsigned char)text[2 * size]))
+	{
+		return false;
+	}
+	uint32_t crc;
+	memcpy(&crc, data + size - 4, 4);
+	return crc == ComputeCrc32(data, size - 4) && FlightRecorder::UnpackSample(data, (int)size - 4, sample);
+}
+
+const FlightLog::Dump& FlightLog::GetRecorderDump() const
+{
+	return mRecorder;
+}
+
+const FlightLog::Dump& FlightLog::GetBlackBoxDump() const
+{
+	return mBlackBox;
+}
+
+bool FlightLog::GetBlackBoxReport(BlackBox::Report& report) const
+{
+	report = mBlackBoxReport;
+	return mHasBlackBoxReport;
+}
+
+SimulationFrame FlightLog::ToSimulationFrame(const FlightSample& sample)
+{
+	SimulationFrame frame = {};
+	frame.QuadOrientation = glm::vec3(sample.Pitch, -sample.Yaw, sample.Roll);
+	frame.PitchPIDState = { sample.PIDTerms[0][0], sample.PIDTerms[0][1], sample.PIDTerms[0][2] };
+	frame.RollPIDState = { sample.PIDTerms[1][0], sample.PIDTerms[1][1], sample.PIDTerms[1][2] };
+	frame.SetPoints.Thrust = sample.Thrust;
+	frame.SetPoints.Yaw = sample.YawSetPoint;
+	frame.SetPoints.Pitch = sample.PitchSetPoint;
+	frame.SetPoints.Roll = sample.RollSetPoint;
+	return frame;
+}
+
+void FlightLog::ToSimulationResult(const std::vector<FlightSample>& samples, float deltaTime, SimulationResult& result)
+{
+	result.Reset();
+	result.DeltaTime = deltaTime;
+	if (samples.empty() || deltaTime <= 0.0f)
+	{
+		return;
+	}
+
+	std::vector<SimulationFrame> frames(samples.size());
+	for (size_t i = 0; i < samples.size(); ++i)
+	{
+		frames[i] = ToSimulationFrame(samples[i]);
+	}
+
+	// Linear between the samples around each frame time:
+	const float duration = (float)(samples.back().TimeUs - samples[0].TimeUs) * 1e-6f;
+	const int numFrames = (int)(duration / deltaTime) + 1;
+	result.Frames.resize(numFrames);
+	size_t next = 1;
+	for (int f = 0; f < numFrames; ++f)
+	{
+		const uint32_t timeUs = samples[0].TimeUs + (uint32_t)((double)f * deltaTime * 1e6);
+		while (next < samples.size() && (int32_t)(samples[next].TimeUs - timeUs) < 0)
+		{
+			++next;
+		}
+		if (next >= samples.size())
+		{
+			result.Frames.Edit(f) = frames.back();
+			continue;
+		}
+		const float span = (float)(samples[next].TimeUs - samples[next - 1].TimeUs);
+		const float alpha = span > 0.0f ? (float)(int32_t)(timeUs - samples[next - 1].TimeUs) / span : 1.0f;
+		result.Frames.Edit(f) = SimulationFrame::Interpolate(frames[next - 1], frames[next], std::min(std::max(alpha, 0.0f), 1.0f));
+	}
+}
+
+void FlightLog::ParseDumpLine(bool blackBox, const char* text, bool& inDump, int& chunkIdx)
+{
+	// A new dump replaces the previous one of its kind, other versions are skipped:
+	Dump& dump = blackBox ? mBlackBox : mRecorder;
+	uint32_t version, blockSize, numBlocks, intervalUs;
+	char state[16];
+	const bool begin = blackBox ?
+		sscanf(text, "begin %u %15s %u", &version, state, &numBlocks) == 3 :
+		sscanf(text, "begin %u %u %u %u", &version, &blockSize, &numBlocks, &intervalUs) == 4;
+	if (begin)
+	{
+		inDump = blackBox ? version == BlackBox::k_Version : version == FlightRecorder::k_Version && blockSize == FlightRecorder::k_BlockSize;
+		if (inDump)
+		{
+			dump = Dump();
+			mHasBlackBoxReport = blackBox ? false : mHasBlackBoxReport;
+		}
+		chunkIdx = 0;
+		return;
+	}
+	if (strncmp(text, "end", 3) == 0)
+	{
+		inDump = false;
+		return;
+	}
+	if (!inDump)
+	{
+		return;
+	}
+
+	uint8_t chunk[FlightRecorder::k_BlockSize];
+	const uint32_t size = ReadHex(text, chunk, FlightRecorder::k_BlockSize);
+
+	// The black box report comes first:
+	if (blackBox && chunkIdx++ == 0)
+	{
+		mHasBlackBoxReport = BlackBox::ReadReport(chunk, size, mBlackBoxReport);
+		return;
+	}
+
+	// Every packed value takes at least a byte:
+	const int maxSamples = FlightRecorder::k_BlockSize / (1 + FlightRecorder::k_NumFields);
+	FlightSample samples[maxSamples];
+	const int numSamples = size == FlightRecorder::k_BlockSize ? FlightRecorder::DecodeBlock(chunk, samples, maxSamples) : -1;
+	if (numSamples < 0)
+	{
+		++dump.NumCorruptBlocks;
+		return;
+	}
+	dump.Samples.insert(dump.Samples.end(), samples, samples + numSamples);
+}
+
+void FlightLog::ToRecords(const std::vector<FlightSample>& samples, std::vector<FlightLogRecord>& records)
+{
+	records.resize(samples.size());
+	for (size_t i = 0; i < samples.size(); ++i)
+	{
+		const FlightSample& sample = samples[i];
+		FlightLogRecord& record = records[i];
+		memset(&record, 0, sizeof(record));
+		record.State.Time = (float)(sample.TimeUs - samples[0].TimeUs) * 1e-6f;
+		record.State.Pitch = sample.Pitch;
+		record.State.Yaw = sample.Yaw;
+		record.State.Roll = sample.Roll;
+		record.SetPoints.Thrust = sample.Thrust;
+		record.SetPoints.Yaw = sample.YawSetPoint;
+		record.SetPoints.Pitch = sample.PitchSetPoint;
+		record.SetPoints.Roll = sample.RollSetPoint;
+		record.Commands.FrontLeftThr = sample.Motors[0] / 255.0f;
+		record.Commands.FrontRightThr = sample.Motors[1] / 255.0f;
+		record.Commands.RearLeftThr = sample.Motors[2] / 255.0f;
+		record.Commands.RearRightThr = sample.Motors[3] / 255.0f;
+	}
+
+	// The controllers iterate with the time between samples, the first one gets the next:
+	for (size_t i = 1; i < records.size(); ++i)
+	{
+		records[i].State.DeltaTime = records[i].State.Time - records[i - 1].State.Time;
+	}
+	if (!records.empty())
+	{
+		records[0].State.DeltaTime = records.size() > 1 ? records[1].State.DeltaTime : 0.0f;
+	}
+}
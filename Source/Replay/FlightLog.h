@@ -0,0 +1,92 @@
+#pragma once
+
+#include "CommonFlyController.h"
+#include "FlightRecorder.h"
+#include "BlackBox.h"
+#include "IO/MappedFile.h"
+
+#include <string>
+#include <vector>
+
+// One control loop iteration as seen by the flight controller on the board.
+struct FlightLogRecord
+{
+	FCQuadState State;
+	FCSetPoints SetPoints;
+	FCCommands Commands;	// Commands produced on the board, zero if unknown
+};
+
+// Binary log layout: header followed by NumRecords packed FlightLogRecord.
+struct FlightLogHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t RecordSize;
+	uint32_t NumRecords;
+};
+
+struct SimulationFrame;
+struct SimulationResult;
+
+// Flight log. Binary logs are memory mapped (read only, can be shared between threads),
+// serial captures are parsed into memory: telemetry lines, the live telemetry stream and the
+// flight recorder and black box dumps (see StreamTelemetry, DumpRecorder and DumpBlackBox in
+// Board/src/main.cpp), the last dumps if the capture has several.
+class FlightLog
+{
+public:
+	static const uint32_t k_Magic = 0x474C4551; // "QELG"
+	static const uint32_t k_Version = 1;
+
+	FlightLog();
+
+	// Binary logs are detected by the header, anything else is parsed as telemetry text.
+	bool Open(const std::string& path);
+	void Close();
+	int GetNumRecords()const;
+	const FlightLogRecord* GetRecords()const;
+
+	static bool Write(const std::string& path, const FlightLogRecord* records, int numRecords);
+
+	// Samples of a dump in a serial capture, empty if there is none.
+	struct Dump
+	{
+		std::vector<FlightSample> Samples;
+		int NumCorruptBlocks;	// Their samples are missing
+	};
+
+	// The records are made from the flight recorder samples, or else the black box ones, or
+	// else the streamed ones: times from the first sample, no height.
+	const Dump& GetRecorderDump()const;
+	const Dump& GetBlackBoxDump()const;
+	// False if the capture has no black box dump or its report is corrupt.
+	bool GetBlackBoxReport(BlackBox::Report& report)const;
+
+	// Attitude, set points and the pitch and roll PID terms of a sample, the rest is zero.
+	static SimulationFrame ToSimulationFrame(const FlightSample& sample);
+
+	// Recorder samples resampled every deltaTime as simulation frames (ToSimulationFrame).
+	static void ToSimulationResult(const std::vector<FlightSample>& samples, float deltaTime, SimulationResult& result);
+
+	// Telemetry line from the serial port (comma separated, radians and meters):
+	//   time,dt,height,pitch,yaw,roll,thrust,spYaw,spPitch,spRoll,fl,fr,rl,rr
+	static bool ParseTelemetryLine(const char* line, FlightLogRecord& record);
+
+	// Text after the "QTEL " marker of a streamed sample, false if it is corrupt.
+	static bool ParseStreamLine(const char* text, FlightSample& sample);
+
+private:
+	// Text after the "QREC " or "QBOX " marker of a dump line, chunkIdx counts the data lines.
+	void ParseDumpLine(bool blackBox, const char* text, bool& inDump, int& chunkIdx);
+	static void ToRecords(const std::vector<FlightSample>& samples, std::vector<FlightLogRecord>& records);
+
+	MappedFile mFile;
+	std::vector<FlightLogRecord> mParsed;
+	Dump mRecorder;
+	Dump mBlackBox;
+	std::vector<FlightSample> mStream;
+	BlackBox::Report mBlackBoxReport;
+	bool mHasBlackBoxReport;
+	const FlightLogRecord* mRecords;
+	int mNumRecords;
+};
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "ReplayEngine.h"
+#include "Jobs/JobSystem.h"
+#include "CommonFlyController.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+void ReplayEngine::RunCandidate(const FlightLogRecord* records, int numRecords, const ReplayCandidate& candidate, ReplayTrace& trace)
+{
+	std::unique_ptr<BaseFlyController> controller(candidate.Create());
+	controller->Reset();
+
+	trace.Name = candidate.Name;
+	trace.Commands.resize(numRecords);
+	trace.Result.Frames.resize(numRecords);
+	trace.Result.DeltaTime = numRecords > 1 ? (records[numRecords - 1].State.Time - records[0].State.Time) / (float)(numRecords - 1) : 0.0f;
+
+	double sumSq = 0.0;
+	float maxDivergence = 0.0f;
+	for (int i = 0; i < numRecords; ++i)
+	{
+		const FlightLogRecord& record = records[i];
+		FCCommands commands = controller->Iterate(record.State, record.SetPoints);
+		trace.Commands[i] = commands;
+
+		SimulationFrame& frame = trace.Result.Frames.Edit(i);
+		frame = SimulationFrame();
+		frame.QuadPosition = glm::vec3(0.0f, record.State.Height, 0.0f);
+		frame.QuadOrientation = glm::vec3(record.State.Pitch, -record.State.Yaw, record.State.Roll);
+		frame.SetPoints = record.SetPoints;
+		controller->QuerySimState(&frame);
+
+		float diff[4] =
+		{
+			commands.FrontLeftThr - record.Commands.FrontLeftThr,
+			commands.FrontRightThr - record.Commands.FrontRightThr,
+			commands.RearLeftThr - record.Commands.RearLeftThr,
+			commands.RearRightThr - record.Commands.RearRightThr
+		};
+		for (int m = 0; m < 4; ++m)
+		{
+			sumSq += (double)diff[m] * (double)diff[m];
+			maxDivergence = std::max(maxDivergence, std::fabs(diff[m]));
+		}
+	}
+	trace.RmsDivergence = numRecords > 0 ? (float)std::sqrt(sumSq / (4.0 * numRecords)) : 0.0f;
+	trace.MaxDivergence = maxDivergence;
+}
+
+void ReplayEngine::Run(const FlightLogRecord* records, int numRecords, const std::vector<ReplayCandidate>& candidates, int numThreads, std::vector<ReplayTrace>& traces)
+{
+	traces.clear();
+	traces.resize(candidates.size());
+
+	JobSystem::Get().ParallelFor((int)candidates.size(), numThreads, [&](int c)
+	{
+		RunCandidate(records, numRecords, candidates[c], traces[c]);
+	}, 1);
+}
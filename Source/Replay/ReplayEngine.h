@@ -0,0 +1,39 @@
+#pragma once
+
+#include "FlightLog.h"
+#include "Simulation.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+class BaseFlyController;
+
+// A controller configuration to evaluate. Create() is called once on the worker thread that
+// runs the candidate, the engine owns (and deletes) the returned controller.
+struct ReplayCandidate
+{
+	std::string Name;
+	std::function<BaseFlyController*()> Create;
+};
+
+struct ReplayTrace
+{
+	std::string Name;
+	std::vector<FCCommands> Commands;
+	SimulationResult Result;	// Recorded attitude plus the PID terms of the candidate
+	float RmsDivergence;		// Against the commands recorded on the board
+	float MaxDivergence;
+};
+
+// Open loop replay of recorded states and set points through candidate controllers.
+// Candidates are independent: each one runs on its own worker, the records are shared read
+// only (they usually point into a memory mapped log).
+namespace ReplayEngine
+{
+	// Runs on the shared JobSystem, numThreads at once (<= 0 uses all of it).
+	void Run(const FlightLogRecord* records, int numRecords, const std::vector<ReplayCandidate>& candidates, int numThreads, std::vector<ReplayTrace>& traces);
+
+	// Single candidate, used by the workers.
+	void RunCandidate(const FlightLogRecord* records, int numRecords, const ReplayCandidate& candidate, ReplayTrace& trace);
+}
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "ReplayView.h"
+#include "QuadFlyController.h"
+#include "Graphics/UI/IMGUI/imgui.h"
+#include "Core/Logging.h"
+
+#include <cstdio>
+#include <cstring>
+
+static void SetGains(PID& pid, const float* gains)
+{
+	pid.KP = gains[0];
+	pid.KI = gains[1];
+	pid.KD = gains[2];
+}
+
+ReplayView::ReplayView()
+	:mNumThreads(0)
+	,mSelectedTrace(0)
+{
+	mLogPath[0] = 0;
+
+	// Start with the gains the board is flying with:
+	QuadFlyController defaults;
+	CandidateGains baseline = {};
+	strcpy(baseline.Name, "Baseline");
+	const PID* pids[3] = { &defaults.PitchPID, &defaults.RollPID, &defaults.YawPID };
+	float* gains[3] = { baseline.Pitch, baseline.Roll, baseline.Yaw };
+	for (int p = 0; p < 3; ++p)
+	{
+		gains[p][0] = pids[p]->KP;
+		gains[p][1] = pids[p]->KI;
+		gains[p][2] = pids[p]->KD;
+	}
+	mCandidates.push_back(baseline);
+}
+
+void ReplayView::RenderUI()
+{
+	ImGui::Begin("Replay");
+	{
+		ImGui::InputText("Log", mLogPath, sizeof(mLogPath));
+		ImGui::SameLine();
+		if (ImGui::Button("Open"))
+		{
+			if (!mLog.Open(mLogPath))
+			{
+				ERR("Could not open the flight log: %s", mLogPath);
+			}
+			mTraces.clear();
+			AddRecordedTraces();
+			mSelectedTrace = 0;
+			mPlotData.Clear();
+			mPlotView.ResetView();
+		}
+		ImGui::Text("Records: %i", mLog.GetNumRecords());
+		if (!mLog.GetRecorderDump().Samples.empty())
+		{
+			ImGui::Text("Flight recorder dump, %i corrupt blocks", mLog.GetRecorderDump().NumCorruptBlocks);
+		}
+		BlackBox::Report report;
+		if (mLog.GetBlackBoxReport(report))
+		{
+			ImGui::Text("Black box: %s at %.3f s, %i samples, %i corrupt blocks", HaltReason::ToStr((HaltReason::T)report.Reason), report.TriggerTimeUs * 1e-6f,
+				(int)mLog.GetBlackBoxDump().Samples.size(), mLog.GetBlackBoxDump().NumCorruptBlocks);
+			ImGui::Text("Loops: %u, %u/%u/%u us min/mean/max, %u overruns", report.NumLoops, report.LoopMinUs, report.LoopMeanUs, report.LoopMaxUs, report.NumOverruns);
+			ImGui::Text("Black box cost: %u us mean, %u us max", report.RecordMeanUs, report.RecordMaxUs);
+		}
+		ImGui::InputInt("Threads (0 = all)", &mNumThreads);
+
+		if (ImGui::CollapsingHeader("Candidates"))
+		{
+			for (size_t c = 0; c < mCandidates.size(); ++c)
+			{
+				CandidateGains& candidate = mCandidates[c];
+				ImGui::PushID((int)c);
+				ImGui::InputText("Name", candidate.Name, sizeof(candidate.Name));
+				ImGui::InputFloat3("Pitch KP/KI/KD", candidate.Pitch);
+				ImGui::InputFloat3("Roll KP/KI/KD", candidate.Roll);
+				ImGui::InputFloat3("Yaw KP/KI/KD", candidate.Yaw);
+				ImGui::Separator();
+				ImGui::PopID();
+			}
+			if (ImGui::Button("Add Candidate"))
+			{
+				CandidateGains copy = mCandidates.back();
+				snprintf(copy.Name, sizeof(copy.Name), "Candidate %i", (int)mCandidates.size());
+				mCandidates.push_back(copy);
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Remove Candidate") && mCandidates.size() > 1)
+			{
+				mCandidates.pop_back();
+			}
+		}
+
+		if (ImGui::Button("Run Replay") && mLog.GetNumRecords() > 0)
+		{
+			Run();
+		}
+
+		if (!mTraces.empty())
+		{
+			for (size_t t = 0; t < mTraces.size(); ++t)
+			{
+				char label[128];
+				snprintf(label, sizeof(label), "%s: RMS %.4f Max %.4f", mTraces[t].Name.c_str(), mTraces[t].RmsDivergence, mTraces[t].MaxDivergence);
+				if (ImGui::Selectable(label, mSelectedTrace == (int)t))
+				{
+					mSelectedTrace = (int)t;
+					mPlotData.Clear();
+				}
+			}
+
+			const ReplayTrace& trace = mTraces[mSelectedTrace];
+			mPlotData.Update(trace.Result);
+			mPlotView.SetExtent(mPlotData.GetNumSamples(), trace.Result.DeltaTime);
+			const ImVec2 plotSize(512, 96);
+			const char* names[6] = { "Pitch P", "Pitch I", "Pitch D", "Roll P", "Roll I", "Roll D" };
+			for (int c = 0; c < 6; ++c)
+			{
+				SimulationPlotData::Channel::T channel = (SimulationPlotData::Channel::T)(SimulationPlotData::Channel::PitchP + c);
+				mPlotView.Plot(names[c], mPlotData.Get(channel), 0.0f, 0.0f, plotSize);
+			}
+		}
+	}
+	ImGui::End();
+}
+
+void ReplayView::Run()
+{
+	std::vector<ReplayCandidate> candidates;
+	for (const CandidateGains& gains : mCandidates)
+	{
+		ReplayCandidate candidate;
+		candidate.Name = gains.Name;
+		candidate.Create = [gains]()
+		{
+			QuadFlyController* controller = new QuadFlyController;
+			SetGains(controller->PitchPID, gains.Pitch);
+			SetGains(controller->RollPID, gains.Roll);
+			SetGains(controller->YawPID, gains.Yaw);
+			return (BaseFlyController*)controller;
+		};
+		candidates.push_back(candidate);
+	}
+
+	ReplayEngine::Run(mLog.GetRecords(), mLog.GetNumRecords(), candidates, mNumThreads, mTraces);
+	AddRecordedTraces();
+	mSelectedTrace = 0;
+	mPlotData.Clear();
+	mPlotView.ResetView();
+}
+
+
+void ReplayView::AddRecordedTraces()
+{
+	// Same timebase as the replays:
+	const int numRecords = mLog.GetNumRecords();
+	const FlightLogRecord* records = mLog.GetRecords();
+	const float deltaTime = numRecords > 1 ? (records[numRecords - 1].State.Time - records[0].State.Time) / (float)(numRecords - 1) : 0.01f;
+
+	const FlightLog::Dump* dumps[2] = { &mLog.GetBlackBoxDump(), &mLog.GetRecorderDump() };
+	const char* names[2] = { "Board (black box)", "Board (recorded)" };
+	for (int d = 0; d < 2; ++d)
+	{
+		if (dumps[d]->Samples.empty())
+		{
+			continue;
+		}
+		ReplayTrace trace;
+		trace.Name = names[d];
+		trace.RmsDivergence = 0.0f;
+		trace.MaxDivergence = 0.0f;
+		FlightLog::ToSimulationResult(dumps[d]->Samples, deltaTime, trace.Result);
+		mTraces.insert(mTraces.begin(), trace);
+	}
+}
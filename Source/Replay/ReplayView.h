@@ -0,0 +1,39 @@
+#pragma once
+
+#include "FlightLog.h"
+#include "ReplayEngine.h"
+#include "Plotting/PlotView.h"
+
+#include <string>
+#include <vector>
+
+// Replay window: loads a board log and replays it through QuadFlyController candidates
+// with different gains, then shows the command divergence and the PID terms.
+class ReplayView
+{
+public:
+	ReplayView();
+	void RenderUI();
+
+private:
+	struct CandidateGains
+	{
+		char Name[32];
+		float Pitch[3];
+		float Roll[3];
+		float Yaw[3];
+	};
+
+	void Run();
+	// The PID terms the board recorded, first in the traces, if the log has dumps.
+	void AddRecordedTraces();
+
+	char mLogPath[256];
+	FlightLog mLog;
+	std::vector<CandidateGains> mCandidates;
+	std::vector<ReplayTrace> mTraces;
+	int mNumThreads;
+	int mSelectedTrace;
+	SimulationPlotData mPlotData;
+	PlotView mPlotView;
+};
\ No newline at end of file
@@ -0,0 +1,339 @@
+#include "ResultCache.h"
+#include "ResultFile.h"
+#include "Simulation.h"
+#include "IO/Directory.h"
+
+#ifndef HEADLESS
+	#include "Graphics/UI/IMGUI/imgui.h"
+#endif
+
+#include <algorithm>
+#include <cstdio>
+
+static const uint32_t k_IndexMagic = 0x49435251;	// "QRCI"
+static const uint32_t k_IndexVersion = 1;
+static const char* k_IndexName = "index.bin";
+
+struct CacheIndexHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint64_t NumEntries;
+	uint64_t Clock;
+};
+
+ResultCache::ResultCache()
+	:mMaxBytes(0)
+	,mSize(0)
+	,mClock(0)
+	,mNumHits(0)
+	,mNumMisses(0)
+	,mIndexDirty(false)
+{
+}
+
+ResultCache::~ResultCache()
+{
+	Close();
+}
+
+bool ResultCache::Open(const std::string& directory, uint64_t maxBytes)
+{
+	Close();
+	if (!Directory::Create(directory))
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mDirectory = directory;
+	mMaxBytes = maxBytes;
+
+	FILE* file = fopen(Directory::Join(mDirectory, k_IndexName).c_str(), "rb");
+	CacheIndexHeader header;
+	if (file && fread(&header, sizeof(header), 1, file) == 1 && header.Magic == k_IndexMagic && header.Version == k_IndexVersion)
+	{
+		mEntries.resize((size_t)header.NumEntries);
+		if (!mEntries.empty() && fread(mEntries.data(), sizeof(Entry), mEntries.size(), file) != mEntries.size())
+		{
+			mEntries.clear();
+		}
+		mClock = header.Clock;
+	}
+	if (file)
+	{
+		fclose(file);
+	}
+
+	// Drop the entries whose file is gone, and the files (or temporaries of an interrupted
+	// session) that are not in the index:
+	std::vector<std::string> names;
+	Directory::ListFiles(mDirectory, ".qcol", names);
+	mEntries.erase(std::remove_if(mEntries.begin(), mEntries.end(), [&](const Entry& entry)
+	{
+		return !std::binary_search(names.begin(), names.end(), GetEntryName(entry.Key));
+	}), mEntries.end());
+	std::vector<std::string> temporaries;
+	Directory::ListFiles(mDirectory, ".tmp", temporaries);
+	for (const std::string& name : names)
+	{
+		bool indexed = std::any_of(mEntries.begin(), mEntries.end(), [&](const Entry& entry) { return GetEntryName(entry.Key) == name; });
+		if (!indexed)
+		{
+			temporaries.push_back(name);
+		}
+	}
+	for (const std::string& name : temporaries)
+	{
+		remove(Directory::Join(mDirectory, name).c_str());
+	}
+
+	mSize = 0;
+	for (const Entry& entry : mEntries)
+	{
+		mSize += entry.Size;
+	}
+	Evict();
+	SaveIndex();
+	return true;
+}
+
+void ResultCache::Close()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (!mDirectory.empty() && mIndexDirty)
+	{
+		SaveIndex();
+	}
+	mDirectory.clear();
+	mEntries.clear();
+	mSize = 0;
+}
+
+bool ResultCache::IsOpen() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return !mDirectory.empty();
+}
+
+bool ResultCache::Find(uint64_t key, SimulationResult& result)
+{
+	uint64_t checksum = 0;
+	std::string path;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		int index = FindEntry(key);
+		if (index < 0)
+		{
+			++mNumMisses;
+			return false;
+		}
+		checksum = mEntries[index].Checksum;
+		path = GetEntryPath(key);
+	}
+
+	// Read outside the lock, other workers keep going:
+	bool valid = ResultFile::ReadColumns(path, result);
+	if (valid)
+	{
+		result.ComputeChecksums();
+		valid = result.GetChecksum() == checksum;
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	int index = FindEntry(key);
+	if (!valid)
+	{
+		// Corrupt or evicted meanwhile:
+		if (index >= 0)
+		{
+			RemoveEntry(index);
+			SaveIndex();
+		}
+		++mNumMisses;
+		result.Reset();
+		return false;
+	}
+	if (index >= 0)
+	{
+		mEntries[index].LastUse = ++mClock;
+		mIndexDirty = true;
+	}
+	++mNumHits;
+	return true;
+}
+
+void ResultCache::Store(uint64_t key, const SimulationResult& result)
+{
+	std::string path;
+	std::string tempPath;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mDirectory.empty() || FindEntry(key) >= 0)
+		{
+			return;
+		}
+		path = GetEntryPath(key);
+		tempPath = path + "." + std::to_string(++mClock) + ".tmp";
+	}
+
+	// Written aside and renamed, a reader never sees a partial file:
+	if (!ResultFile::WriteColumns(tempPath, result))
+	{
+		remove(tempPath.c_str());
+		return;
+	}
+	FILE* file = fopen(tempPath.c_str(), "rb");
+	uint64_t size = 0;
+	if (file)
+	{
+		fseek(file, 0, SEEK_END);
+		size = (uint64_t)ftell(file);
+		fclose(file);
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (mDirectory.empty() || FindEntry(key) >= 0)
+	{
+		// Closed or stored by another worker meanwhile:
+		remove(tempPath.c_str());
+		return;
+	}
+	remove(path.c_str());	// Stale file outside the index, rename does not overwrite on Windows
+	if (rename(tempPath.c_str(), path.c_str()) != 0)
+	{
+		remove(tempPath.c_str());
+		return;
+	}
+	Entry entry;
+	entry.Key = key;
+	entry.Size = size;
+	entry.LastUse = ++mClock;
+	entry.Checksum = result.GetChecksum();
+	mEntries.push_back(entry);
+	mSize += size;
+	Evict();
+	SaveIndex();
+}
+
+void ResultCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	while (!mEntries.empty())
+	{
+		RemoveEntry((int)mEntries.size() - 1);
+	}
+	if (!mDirectory.empty())
+	{
+		SaveIndex();
+	}
+}
+
+uint64_t ResultCache::GetSize() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mSize;
+}
+
+int ResultCache::GetNumEntries() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return (int)mEntries.size();
+}
+
+int ResultCache::GetNumHits() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mNumHits;
+}
+
+int ResultCache::GetNumMisses() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mNumMisses;
+}
+
+void ResultCache::RenderUI()
+{
+#ifndef HEADLESS
+	if (!IsOpen())
+	{
+		ImGui::Text("Result cache disabled");
+		return;
+	}
+	ImGui::Text("Entries: %i (%.1f of %.1f MB)", GetNumEntries(), (double)GetSize() / (1024.0 * 1024.0), (double)mMaxBytes / (1024.0 * 1024.0));
+	ImGui::Text("Hits: %i Misses: %i", GetNumHits(), GetNumMisses());
+	if (ImGui::Button("Clear Cache"))
+	{
+		Clear();
+	}
+#endif
+}
+
+std::string ResultCache::GetEntryName(uint64_t key)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.qcol", (unsigned long long)key);
+	return name;
+}
+
+std::string ResultCache::GetEntryPath(uint64_t key) const
+{
+	return Directory::Join(mDirectory, GetEntryName(key));
+}
+
+int ResultCache::FindEntry(uint64_t key) const
+{
+	for (size_t i = 0; i < mEntries.size(); ++i)
+	{
+		if (mEntries[i].Key == key)
+		{
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+void ResultCache::RemoveEntry(int index)
+{
+	remove(GetEntryPath(mEntries[index].Key).c_str());
+	mSize -= mEntries[index].Size;
+	mEntries[index] = mEntries.back();
+	mEntries.pop_back();
+}
+
+void ResultCache::Evict()
+{
+	while (mSize > mMaxBytes && !mEntries.empty())
+	{
+		auto oldest = std::min_element(mEntries.begin(), mEntries.end(), [](const Entry& a, const Entry& b)
+		{
+			return a.LastUse < b.LastUse;
+		});
+		RemoveEntry((int)(oldest - mEntries.begin()));
+	}
+}
+
+void ResultCache::SaveIndex()
+{
+	const std::string path = Directory::Join(mDirectory, k_IndexName);
+	const std::string tempPath = path + ".tmp";
+	FILE* file = fopen(tempPath.c_str(), "wb");
+	if (!file)
+	{
+		return;
+	}
+	CacheIndexHeader header;
+	header.Magic = k_IndexMagic;
+	header.Version = k_IndexVersion;
+	header.NumEntries = mEntries.size();
+	header.Clock = mClock;
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	ok = ok && (mEntries.empty() || fwrite(mEntries.data(), sizeof(Entry), mEntries.size(), file) == mEntries.size());
+	ok = fclose(file) == 0 && ok;
+	remove(path.c_str());
+	if (ok && rename(tempPath.c_str(), path.c_str()) == 0)
+	{
+		mIndexDirty = false;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct SimulationResult;
+
+// Content addressed store of deterministic simulation results. The key is a hash of every
+// input of a run (see Simulation::ComputeCacheKey), each entry is a columnar result file
+// (ResultFile.h) named after its key. Least recently used entries are evicted once the
+// files go over the size cap. The index (key, size, last use, checksum) lives next to the
+// files, so the cache survives across sessions and a moved or corrupt entry is just a miss.
+// Safe to share between threads.
+class ResultCache
+{
+public:
+	ResultCache();
+	~ResultCache();
+	ResultCache(const ResultCache&) = delete;
+	ResultCache& operator=(const ResultCache&) = delete;
+
+	// Creates the directory if needed and loads the index.
+	bool Open(const std::string& directory, uint64_t maxBytes);
+	void Close();
+	bool IsOpen()const;
+
+	// Loads a cached result, its frame checksums must match the stored ones.
+	bool Find(uint64_t key, SimulationResult& result);
+	void Store(uint64_t key, const SimulationResult& result);
+	void Clear();
+
+	uint64_t GetSize()const;
+	int GetNumEntries()const;
+	int GetNumHits()const;
+	int GetNumMisses()const;
+
+	void RenderUI();
+
+private:
+	struct Entry
+	{
+		uint64_t Key;
+		uint64_t Size;
+		uint64_t LastUse;	// Value of mClock on the last Find/Store
+		uint64_t Checksum;
+	};
+
+	static std::string GetEntryName(uint64_t key);
+	std::string GetEntryPath(uint64_t key)const;
+	int FindEntry(uint64_t key)const;
+	void RemoveEntry(int index);
+	void Evict();
+	void SaveIndex();
+
+	mutable std::mutex mMutex;
+	std::string mDirectory;
+	uint64_t mMaxBytes;
+	uint64_t mSize;
+	uint64_t mClock;
+	std::vector<Entry> mEntries;
+	int mNumHits;
+	int mNumMisses;
+	bool mIndexDirty;
+};
\ No newline at end of file
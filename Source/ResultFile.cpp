@@ -0,0 +1,181 @@
+#include "ResultFile.h"
+#include "IO/MappedFile.h"
+
+#include <cstdio>
+#include <cstring>
+
+// Angles in radians, same units as the simulation.
+static const char* k_ColumnNames[] =
+{
+	"time",
+	"pos_x", "pos_y", "pos_z",
+	"pitch", "yaw", "roll",
+	"force_x", "force_y", "force_z",
+	"sp_thrust", "sp_yaw", "sp_pitch", "sp_roll", "sp_height",
+	"height_p", "height_i", "height_d",
+	"pitch_p", "pitch_i", "pitch_d",
+	"roll_p", "roll_i", "roll_d"
+};
+static const int k_NumColumns = sizeof(k_ColumnNames) / sizeof(k_ColumnNames[0]);
+
+static void GetRow(const SimulationFrame& frame, float time, float* row)
+{
+	const float values[k_NumColumns] =
+	{
+		time,
+		frame.QuadPosition.x, frame.QuadPosition.y, frame.QuadPosition.z,
+		frame.QuadOrientation.x, frame.QuadOrientation.y, frame.QuadOrientation.z,
+		frame.WorldForce.x, frame.WorldForce.y, frame.WorldForce.z,
+		frame.SetPoints.Thrust, frame.SetPoints.Yaw, frame.SetPoints.Pitch, frame.SetPoints.Roll, frame.SetPoints.Height,
+		frame.HeightPIDState.P, frame.HeightPIDState.I, frame.HeightPIDState.D,
+		frame.PitchPIDState.P, frame.PitchPIDState.I, frame.PitchPIDState.D,
+		frame.RollPIDState.P, frame.RollPIDState.I, frame.RollPIDState.D
+	};
+	for (int c = 0; c < k_NumColumns; ++c)
+	{
+		row[c] = values[c];
+	}
+}
+
+// Inverse of GetRow, the time column is implicit in the frame index.
+static void SetRow(const float* row, SimulationFrame& frame)
+{
+	frame.QuadPosition = glm::vec3(row[1], row[2], row[3]);
+	frame.QuadOrientation = glm::vec3(row[4], row[5], row[6]);
+	frame.WorldForce = glm::vec3(row[7], row[8], row[9]);
+	frame.SetPoints.Thrust = row[10];
+	frame.SetPoints.Yaw = row[11];
+	frame.SetPoints.Pitch = row[12];
+	frame.SetPoints.Roll = row[13];
+	frame.SetPoints.Height = row[14];
+	frame.HeightPIDState = { row[15], row[16], row[17] };
+	frame.PitchPIDState = { row[18], row[19], row[20] };
+	frame.RollPIDState = { row[21], row[22], row[23] };
+}
+
+const std::vector<std::string>& ResultFile::GetColumnNames()
+{
+	static const std::vector<std::string> names(k_ColumnNames, k_ColumnNames + k_NumColumns);
+	return names;
+}
+
+bool ResultFile::WriteCsv(const std::string& path, const SimulationResult& result)
+{
+	FILE* file = fopen(path.c_str(), "w");
+	if (!file)
+	{
+		return false;
+	}
+	for (int c = 0; c < k_NumColumns; ++c)
+	{
+		fprintf(file, c == 0 ? "%s" : ",%s", k_ColumnNames[c]);
+	}
+	fprintf(file, "\n");
+
+	float row[k_NumColumns];
+	for (size_t i = 0; i < result.Frames.size(); ++i)
+	{
+		GetRow(result.Frames[i], (float)i * result.DeltaTime, row);
+		for (int c = 0; c < k_NumColumns; ++c)
+		{
+			fprintf(file, c == 0 ? "%.9g" : ",%.9g", row[c]);
+		}
+		fprintf(file, "\n");
+	}
+	return fclose(file) == 0;
+}
+
+bool ResultFile::WriteColumns(const std::string& path, const SimulationResult& result)
+{
+	const uint32_t numRows = (uint32_t)result.Frames.size();
+
+	// Transpose the frames:
+	std::vector<float> columns((size_t)k_NumColumns * numRows);
+	float row[k_NumColumns];
+	for (uint32_t i = 0; i < numRows; ++i)
+	{
+		GetRow(result.Frames[i], (float)i * result.DeltaTime, row);
+		for (int c = 0; c < k_NumColumns; ++c)
+		{
+			columns[(size_t)c * numRows + i] = row[c];
+		}
+	}
+
+	ColumnFileHeader header;
+	header.Magic = ColumnFileHeader::k_Magic;
+	header.Version = ColumnFileHeader::k_Version;
+	header.NumColumns = k_NumColumns;
+	header.NumRows = numRows;
+	header.DeltaTime = result.DeltaTime;
+	header.Reserved = 0;
+
+	ColumnDesc descs[k_NumColumns] = {};
+	uint64_t offset = sizeof(ColumnFileHeader) + sizeof(descs);
+	for (int c = 0; c < k_NumColumns; ++c)
+	{
+		snprintf(descs[c].Name, sizeof(descs[c].Name), "%s", k_ColumnNames[c]);
+		descs[c].Type = ColumnDesc::k_Float32;
+		descs[c].Offset = offset;
+		offset += (uint64_t)numRows * sizeof(float);
+	}
+
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	ok = ok && fwrite(descs, sizeof(descs), 1, file) == 1;
+	ok = ok && (columns.empty() || fwrite(columns.data(), sizeof(float), columns.size(), file) == columns.size());
+	ok = fclose(file) == 0 && ok;
+	return ok;
+}
+
+bool ResultFile::ReadColumns(const std::string& path, SimulationResult& result, std::string* error)
+{
+	MappedFile file;
+	if (!file.Open(path))
+	{
+		if (error)
+		{
+			*error = "Could not open " + path;
+		}
+		return false;
+	}
+
+	const uint8_t* data = (const uint8_t*)file.GetData();
+	const size_t size = file.GetSize();
+	const ColumnFileHeader* header = (const ColumnFileHeader*)data;
+	const ColumnDesc* descs = (const ColumnDesc*)(data + sizeof(ColumnFileHeader));
+	bool valid = size >= sizeof(ColumnFileHeader) && header->Magic == ColumnFileHeader::k_Magic && header->Version == ColumnFileHeader::k_Version &&
+		header->NumColumns == (uint32_t)k_NumColumns && size >= sizeof(ColumnFileHeader) + k_NumColumns * sizeof(ColumnDesc);
+	const uint32_t numRows = valid ? header->NumRows : 0;
+	for (int c = 0; c < k_NumColumns && valid; ++c)
+	{
+		valid = strncmp(descs[c].Name, k_ColumnNames[c], sizeof(descs[c].Name)) == 0 && descs[c].Type == ColumnDesc::k_Float32 &&
+			descs[c].Offset + (uint64_t)numRows * sizeof(float) <= size;
+	}
+	if (!valid)
+	{
+		if (error)
+		{
+			*error = path + " is not a result file of this version";
+		}
+		return false;
+	}
+
+	result.Reset();
+	result.DeltaTime = header->DeltaTime;
+	result.Frames.resize(numRows);
+	float row[k_NumColumns];
+	for (uint32_t i = 0; i < numRows; ++i)
+	{
+		for (int c = 0; c < k_NumColumns; ++c)
+		{
+			// memcpy, the columns have no alignment guarantee:
+			memcpy(&row[c], data + descs[c].Offset + (uint64_t)i * sizeof(float), sizeof(float));
+		}
+		SetRow(row, result.Frames.Edit(i));
+	}
+	return true;
+}
\ No newline at end of file
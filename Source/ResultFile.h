@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Simulation.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Columnar result file (.qcol): header, one descriptor per column and then each column as a
+// contiguous array of NumRows little endian floats, so a tool can map a single signal
+// without reading the rest. Columns are the same as the CSV ones.
+struct ColumnFileHeader
+{
+	static const uint32_t k_Magic = 0x4C4F4351;	// "QCOL"
+	static const uint32_t k_Version = 1;
+
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t NumColumns;
+	uint32_t NumRows;
+	float DeltaTime;
+	uint32_t Reserved;
+};
+
+struct ColumnDesc
+{
+	static const uint32_t k_Float32 = 0;
+
+	char Name[20];
+	uint32_t Type;
+	uint64_t Offset;	// From the start of the file
+};
+
+namespace ResultFile
+{
+	// Column names, in file order.
+	const std::vector<std::string>& GetColumnNames();
+
+	bool WriteCsv(const std::string& path, const SimulationResult& result);
+	bool WriteColumns(const std::string& path, const SimulationResult& result);
+
+	// Reads a columnar file back, the frames are bit identical to the written ones. Fails if
+	// the file is truncated or its columns are not the ones of this version.
+	bool ReadColumns(const std::string& path, SimulationResult& result, std::string* error = nullptr);
+}
\ No newline at end of file
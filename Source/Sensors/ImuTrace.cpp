@@ -0,0 +1,90 @@
+#include "ImuTrace.h"
+
+#include <cstdio>
+
+static const char* k_Header = "dt,new,ax,ay,az,gx,gy,gz";
+
+void ImuTrace::Clear()
+{
+	Entries.clear();
+}
+
+void ImuTrace::Add(float deltaTime, const float* accel, const float* gyro)
+{
+	// Before the first sample the values are the ones the estimator starts with:
+	Entry entry = {};
+	entry.Accel[2] = 1.0f;
+	if (!Entries.empty())
+	{
+		entry = Entries.back();
+	}
+	entry.DeltaTime = deltaTime;
+	entry.NewSample = accel && gyro;
+	for (int i = 0; i < 3; ++i)
+	{
+		entry.Accel[i] = accel ? accel[i] : entry.Accel[i];
+		entry.Gyro[i] = gyro ? gyro[i] : entry.Gyro[i];
+	}
+	Entries.push_back(entry);
+}
+
+bool ImuTrace::LoadFromFile(const std::string& path, std::string* error)
+{
+	FILE* file = fopen(path.c_str(), "r");
+	if (!file)
+	{
+		if (error)
+		{
+			*error = "Could not open " + path;
+		}
+		return false;
+	}
+
+	// Parse into a copy so a bad trace leaves this one untouched:
+	std::vector<Entry> entries;
+	char line[256];
+	int lineIdx = 0;
+	bool valid = true;
+	while (valid && fgets(line, sizeof(line), file))
+	{
+		++lineIdx;
+		if (lineIdx == 1)
+		{
+			valid = std::string(line).compare(0, std::string(k_Header).size(), k_Header) == 0;
+			continue;
+		}
+		Entry entry;
+		int newSample = 0;
+		valid = sscanf(line, "%g,%d,%g,%g,%g,%g,%g,%g", &entry.DeltaTime, &newSample,
+			&entry.Accel[0], &entry.Accel[1], &entry.Accel[2], &entry.Gyro[0], &entry.Gyro[1], &entry.Gyro[2]) == 8;
+		entry.NewSample = newSample != 0;
+		entries.push_back(entry);
+	}
+	fclose(file);
+	if (!valid || lineIdx == 0)
+	{
+		if (error)
+		{
+			*error = path + ":" + std::to_string(lineIdx) + ": invalid IMU trace line";
+		}
+		return false;
+	}
+	Entries.swap(entries);
+	return true;
+}
+
+bool ImuTrace::WriteToFile(const std::string& path) const
+{
+	FILE* file = fopen(path.c_str(), "w");
+	if (!file)
+	{
+		return false;
+	}
+	fprintf(file, "%s\n", k_Header);
+	for (const Entry& entry : Entries)
+	{
+		fprintf(file, "%.9g,%d,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g\n", entry.DeltaTime, entry.NewSample ? 1 : 0,
+			entry.Accel[0], entry.Accel[1], entry.Accel[2], entry.Gyro[0], entry.Gyro[1], entry.Gyro[2]);
+	}
+	return fclose(file) == 0;
+}
\ No newline at end of file
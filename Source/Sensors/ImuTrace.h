@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Inputs of the board attitude estimator over a run, one entry per AttitudeEstimator::Update
+// call, so the estimator can be replayed without the simulation (Tools/EstBench). CSV file,
+// a header line and then per entry:
+//
+//   dt,new,ax,ay,az,gx,gy,gz
+//
+// new is 0 if the loop had no new sample (the values are the last ones again). Floats are
+// written with 9 significant digits, a loaded trace is bit identical to the recorded one.
+struct ImuTrace
+{
+	struct Entry
+	{
+		float DeltaTime;	// s
+		bool NewSample;
+		float Accel[3];		// Raw, g
+		float Gyro[3];		// Raw, dps
+	};
+
+	void Clear();
+	// Same arguments as AttitudeEstimator::Update, nullptr repeats the last sample.
+	void Add(float deltaTime, const float* accel, const float* gyro);
+
+	bool LoadFromFile(const std::string& path, std::string* error = nullptr);
+	bool WriteToFile(const std::string& path)const;
+
+	std::vector<Entry> Entries;
+};
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include "SensorModel.h"
+
+#ifndef HEADLESS
+	#include "Graphics/UI/IMGUI/imgui.h"
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+static const float k_Gravity = 9.81f;
+static const float k_RadToDeg = 57.2957795f;
+
+SensorModel::SensorModel()
+	:SampleRate(119.0f)
+	,AccelRange(4.0f)
+	,GyroRange(2000.0f)
+	,AdcBits(16)
+	,Misalignment(0.01f, -0.005f, 0.008f)
+	// Turn-on biases cancelled by the board calibration (AttitudeEstimator offsets):
+	,AccelBias(-0.02f, -0.01f, 0.01f)
+	,GyroBias(1.0f, 0.3f, 0.5f)
+	,AccelBiasWalk(0.0005f)
+	,GyroBiasWalk(0.02f)
+	,AccelNoise(0.003f)
+	,GyroNoise(0.1f)
+	,AccelVibration(0.3f)
+	,GyroVibration(2.0f)
+	,mNumVehicles(0)
+	,mNumSamples(0)
+	,mMisalignment(1.0f, 0.0f, 0.0f, 0.0f)
+{
+	for (int s = 0; s < Stage::COUNT; ++s)
+	{
+		Enabled[s] = true;
+	}
+	Reset(0, 1);
+}
+
+void SensorModel::RenderUI()
+{
+#ifndef HEADLESS
+	for (int s = 0; s < Stage::COUNT; ++s)
+	{
+		ImGui::Checkbox(Stage::ToStr((Stage::T)s), &Enabled[s]);
+	}
+	ImGui::InputFloat("Sample Rate (Hz)", &SampleRate);
+	ImGui::InputFloat("Accel Range (g)", &AccelRange);
+	ImGui::InputFloat("Gyro Range (dps)", &GyroRange);
+	ImGui::SliderInt("ADC Bits", &AdcBits, 8, 16);
+	ImGui::InputFloat3("Misalignment (rad)", &Misalignment.x);
+	ImGui::InputFloat3("Accel Bias (g)", &AccelBias.x);
+	ImGui::InputFloat3("Gyro Bias (dps)", &GyroBias.x);
+	ImGui::InputFloat("Accel Bias Walk", &AccelBiasWalk);
+	ImGui::InputFloat("Gyro Bias Walk", &GyroBiasWalk);
+	ImGui::InputFloat("Accel Noise (g)", &AccelNoise);
+	ImGui::InputFloat("Gyro Noise (dps)", &GyroNoise);
+	ImGui::InputFloat("Accel Vibration (g)", &AccelVibration);
+	ImGui::InputFloat("Gyro Vibration (dps)", &GyroVibration);
+#endif
+}
+
+void SensorModel::Reset(uint32_t seed, int numVehicles)
+{
+	assert(numVehicles > 0);
+	mNumVehicles = numVehicles;
+	mNumSamples = 0;
+	mMisalignment = glm::quat(Misalignment);
+
+	mRng.resize(numVehicles);
+	for (int v = 0; v < numVehicles; ++v)
+	{
+		mRng[v].Seed(seed, RandomStream::Stream::Imu, (uint32_t)v);
+	}
+	const float turnOnBias[k_NumChannels] = { AccelBias.x, AccelBias.y, AccelBias.z, GyroBias.x, GyroBias.y, GyroBias.z };
+	for (int c = 0; c < k_NumChannels; ++c)
+	{
+		mBias[c].assign(numVehicles, turnOnBias[c]);
+		mChannels[c].resize(numVehicles);
+	}
+}
+
+SensorModel::Truth SensorModel::FromMotion(const glm::quat& prevOrientation, const glm::vec3& prevVelocity, const glm::quat& orientation, const glm::vec3& velocity, float deltaTime, float motorSpeed)
+{
+	// Body frame rotation over the step, shortest way, as a rotation vector:
+	const glm::quat delta = glm::inverse(prevOrientation) * orientation;
+	const float sign = delta.w < 0.0f ? -1.0f : 1.0f;
+	const glm::vec3 axis = glm::vec3(delta.x, delta.y, delta.z) * sign;
+	const float sinHalfAngle = glm::length(axis);
+	const float angle = 2.0f * std::atan2(sinHalfAngle, delta.w * sign);
+
+	Truth truth;
+	truth.Orientation = orientation;
+	truth.Acceleration = (velocity - prevVelocity) / deltaTime;
+	truth.AngularVelocity = sinHalfAngle > 0.0f ? axis * (angle / (sinHalfAngle * deltaTime)) : glm::vec3(0.0f);
+	truth.MotorSpeed = motorSpeed;
+	return truth;
+}
+
+int SensorModel::Step(float time, const Truth* truth, Sample* samples)
+{
+	// Samples are taken at k / SampleRate, the first one at 0:
+	const uint64_t numDue = (uint64_t)std::floor((double)time * (double)SampleRate) + 1;
+	if (numDue <= mNumSamples)
+	{
+		return 0;
+	}
+	const int numElapsed = (int)(numDue - mNumSamples);
+	mNumSamples = numDue;
+
+	// Truth to the sensor frame (x forward, y right, z up is body z, x, y) and units. The
+	// accelerometer measures the specific force, 1 g up at rest:
+	for (int v = 0; v < mNumVehicles; ++v)
+	{
+		const glm::quat toBody = glm::inverse(truth[v].Orientation);
+		const glm::vec3 force = toBody * (truth[v].Acceleration + glm::vec3(0.0f, k_Gravity, 0.0f)) * (1.0f / k_Gravity);
+		const glm::vec3 rate = truth[v].AngularVelocity * k_RadToDeg;
+		glm::vec3 accel(force.z, force.x, force.y);
+		glm::vec3 gyro(rate.z, rate.x, rate.y);
+		if (Enabled[Stage::Misalignment])
+		{
+			accel = mMisalignment * accel;
+			gyro = mMisalignment * gyro;
+		}
+		mChannels[0][v] = accel.x;
+		mChannels[1][v] = accel.y;
+		mChannels[2][v] = accel.z;
+		mChannels[3][v] = gyro.x;
+		mChannels[4][v] = gyro.y;
+		mChannels[5][v] = gyro.z;
+	}
+
+	// Per channel, in the same order for every vehicle so each stream sees the same draws:
+	const float period = 1.0f / SampleRate;
+	const float walkScale = std::sqrt((float)numElapsed * period);
+	const float lsb[2] = { AccelRange / (float)(1 << (AdcBits - 1)), GyroRange / (float)(1 << (AdcBits - 1)) };
+	const float range[2] = { AccelRange, GyroRange };
+	const float walk[2] = { AccelBiasWalk * walkScale, GyroBiasWalk * walkScale };
+	const float noise[2] = { Enabled[Stage::Noise] ? AccelNoise : 0.0f, Enabled[Stage::Noise] ? GyroNoise : 0.0f };
+	const float vibration[2] = { Enabled[Stage::Vibration] ? AccelVibration : 0.0f, Enabled[Stage::Vibration] ? GyroVibration : 0.0f };
+	const bool noisy = Enabled[Stage::Noise] || Enabled[Stage::Vibration];
+	for (int c = 0; c < k_NumChannels; ++c)
+	{
+		const int sensor = c / 3;
+		float* channel = mChannels[c].data();
+		float* bias = mBias[c].data();
+		if (Enabled[Stage::Bias])
+		{
+			for (int v = 0; v < mNumVehicles; ++v)
+			{
+				bias[v] += walk[sensor] * mRng[v].Normal();
+				channel[v] += bias[v];
+			}
+		}
+		if (noisy)
+		{
+			for (int v = 0; v < mNumVehicles; ++v)
+			{
+				const float vibrationRms = vibration[sensor] * truth[v].MotorSpeed;
+				channel[v] += std::sqrt(noise[sensor] * noise[sensor] + vibrationRms * vibrationRms) * mRng[v].Normal();
+			}
+		}
+		if (Enabled[Stage::Quantization])
+		{
+			const float maxValue = range[sensor] - lsb[sensor];
+			for (int v = 0; v < mNumVehicles; ++v)
+			{
+				const float clamped = std::min(std::max(channel[v], -range[sensor]), maxValue);
+				channel[v] = std::round(clamped / lsb[sensor]) * lsb[sensor];
+			}
+		}
+	}
+
+	for (int v = 0; v < mNumVehicles; ++v)
+	{
+		samples[v].Accel = glm::vec3(mChannels[0][v], mChannels[1][v], mChannels[2][v]);
+		samples[v].Gyro = glm::vec3(mChannels[3][v], mChannels[4][v], mChannels[5][v]);
+	}
+	return numElapsed;
+}
+
+SensorModel::State SensorModel::GetState() const
+{
+	State state;
+	state.NumSamples = mNumSamples;
+	state.Rng = mRng;
+	for (int c = 0; c < k_NumChannels; ++c)
+	{
+		state.Bias[c] = mBias[c];
+	}
+	return state;
+}
+
+void SensorModel::SetState(const State& state)
+{
+	assert((int)state.Rng.size() == mNumVehicles);
+	mNumSamples = state.NumSamples;
+	mRng = state.Rng;
+	for (int c = 0; c < k_NumChannels; ++c)
+	{
+		mBias[c] = state.Bias[c];
+	}
+}
\ No newline at end of file
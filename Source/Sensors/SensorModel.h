@@ -0,0 +1,116 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include "glm/gtx/quaternion.hpp"
+#include "RandomStream.h"
+
+#include <stdint.h>
+#include <vector>
+
+// LSM9DS1 accelerometer and gyroscope as the board reads them (Arduino_LSM9DS1 defaults:
+// 119 Hz output data rate, +-4 g, +-2000 dps, 16 bit). A sample goes through the stages in
+// order: axis misalignment, bias (turn-on plus random walk), white and vibration noise (the
+// latter scales with the rotor speed), then saturation and quantization by the ADC. Samples
+// are in the sensor frame and units the firmware sees: x forward, y right, z up, g and dps.
+//
+// Vehicles are processed in batches, one call per step for all of them and the channels
+// stored as structure of arrays. Every vehicle has its own random stream, so its samples do
+// not depend on the batch it runs in.
+class SensorModel
+{
+public:
+	struct Stage
+	{
+		enum T
+		{
+			Misalignment,
+			Bias,
+			Noise,
+			Vibration,
+			Quantization,
+			COUNT
+		};
+		static const char* ToStr(T t)
+		{
+			switch (t)
+			{
+			case Misalignment:	return "Misalignment";
+			case Bias:			return "Bias";
+			case Noise:			return "Noise";
+			case Vibration:		return "Vibration";
+			case Quantization:	return "Quantization";
+			default:			return "Invalid";
+			}
+		}
+	};
+
+	// Accel x y z, gyro x y z.
+	static const int k_NumChannels = 6;
+
+	// What the sensor measures, per vehicle.
+	struct Truth
+	{
+		glm::quat Orientation;		// Body to world
+		glm::vec3 Acceleration;		// World frame, without gravity (m/s^2)
+		glm::vec3 AngularVelocity;	// Body frame (rad/s)
+		float MotorSpeed;			// Mean normalized rotor speed [0,1], drives the vibration
+	};
+
+	// Truth from two consecutive states of the body deltaTime apart, the rates are the means
+	// over the step. Better than the velocities of the dynamics, those are changed after
+	// moving the body (ground contact), the differences are what actually moved it.
+	static Truth FromMotion(const glm::quat& prevOrientation, const glm::vec3& prevVelocity, const glm::quat& orientation, const glm::vec3& velocity, float deltaTime, float motorSpeed);
+
+	struct Sample
+	{
+		glm::vec3 Accel;	// g
+		glm::vec3 Gyro;		// dps
+	};
+
+	// Sample clock, random streams and biases, used by the simulation snapshots.
+	struct State
+	{
+		uint64_t NumSamples;
+		std::vector<RandomStream> Rng;
+		std::vector<float> Bias[k_NumChannels];
+	};
+
+	SensorModel();
+	void RenderUI();
+
+	// Restarts the sample clock at 0, the biases at their turn-on values and the random
+	// streams from the run seed (one substream per vehicle).
+	void Reset(uint32_t seed, int numVehicles);
+
+	// Takes the samples due at time (s) for every vehicle of the batch (numVehicles of Reset).
+	// Returns the number of sample periods elapsed since the previous sample, 0 if there is no
+	// new one (samples is untouched). The board has no FIFO, only the latest one is output.
+	int Step(float time, const Truth* truth, Sample* samples);
+
+	State GetState()const;
+	void SetState(const State& state);
+
+	bool Enabled[Stage::COUNT];
+
+	float SampleRate;			// Output data rate of both sensors (Hz)
+	float AccelRange;			// Full scale (g)
+	float GyroRange;			// Full scale (dps)
+	int AdcBits;				// Resolution over the +- full scale
+	glm::vec3 Misalignment;		// Rotation of the sensor axes against the board (rad, x y z)
+	glm::vec3 AccelBias;		// Turn-on bias (g)
+	glm::vec3 GyroBias;			// Turn-on bias (dps)
+	float AccelBiasWalk;		// Bias random walk (g/sqrt(s))
+	float GyroBiasWalk;			// Bias random walk (dps/sqrt(s))
+	float AccelNoise;			// White noise per sample (g RMS)
+	float GyroNoise;			// White noise per sample (dps RMS)
+	float AccelVibration;		// Extra noise at full rotor speed (g RMS)
+	float GyroVibration;		// Extra noise at full rotor speed (dps RMS)
+
+private:
+	int mNumVehicles;
+	uint64_t mNumSamples;
+	glm::quat mMisalignment;	// From Misalignment, cached on Reset
+	std::vector<RandomStream> mRng;
+	std::vector<float> mBias[k_NumChannels];
+	std::vector<float> mChannels[k_NumChannels];	// Work buffers of a step
+};
\ No newline at end of file
@@ -0,0 +1,257 @@
+#include "SetPointProfile.h"
+#include "Analysis/ResponseAnalysis.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+static const float k_Pi = 3.14159265358979f;
+
+const char* SetPointProfile::k_DefaultProfile =
+	"name Default\n"
+	"step thrust 1.5 * 1.0\n"
+	"step height 1.5 * 3.0\n"
+	"step roll   5.0 * -20.0\n";
+
+static float& ChannelValue(FCSetPoints& setPoints, SetPointProfile::Channel::T channel)
+{
+	switch (channel)
+	{
+	case SetPointProfile::Channel::Thrust:	return setPoints.Thrust;
+	case SetPointProfile::Channel::Yaw:		return setPoints.Yaw;
+	case SetPointProfile::Channel::Pitch:	return setPoints.Pitch;
+	case SetPointProfile::Channel::Roll:	return setPoints.Roll;
+	case SetPointProfile::Channel::Height:
+	default:								return setPoints.Height;
+	}
+}
+
+static bool IsAngle(SetPointProfile::Channel::T channel)
+{
+	return channel == SetPointProfile::Channel::Yaw || channel == SetPointProfile::Channel::Pitch || channel == SetPointProfile::Channel::Roll;
+}
+
+const char* SetPointProfile::Channel::ToStr(T t)
+{
+	switch (t)
+	{
+	case Thrust:	return "thrust";
+	case Yaw:		return "yaw";
+	case Pitch:		return "pitch";
+	case Roll:		return "roll";
+	case Height:	return "height";
+	default:		return "invalid";
+	}
+}
+
+bool SetPointProfile::Channel::FromStr(const std::string& str, T& t)
+{
+	for (int c = 0; c < COUNT; ++c)
+	{
+		if (str == ToStr((T)c))
+		{
+			t = (T)c;
+			return true;
+		}
+	}
+	return false;
+}
+
+SetPointProfile::SetPointProfile()
+	:mDeltaTime(0.0f)
+{
+	LoadFromString(k_DefaultProfile);
+}
+
+bool SetPointProfile::LoadFromFile(const std::string& path, std::string* error)
+{
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		if (error)
+		{
+			*error = "Could not open " + path;
+		}
+		return false;
+	}
+	std::stringstream text;
+	text << file.rdbuf();
+	return LoadFromString(text.str(), error);
+}
+
+bool SetPointProfile::LoadFromString(const std::string& text, std::string* error)
+{
+	std::string name = "Unnamed";
+	std::vector<Segment> segments;
+
+	std::istringstream lines(text);
+	std::string line;
+	int lineIdx = 0;
+	while (std::getline(lines, line))
+	{
+		++lineIdx;
+		std::istringstream tokens(line);
+		std::string type;
+		if (!(tokens >> type) || type[0] == '#')
+		{
+			continue;
+		}
+
+		if (type == "name")
+		{
+			std::getline(tokens >> std::ws, name);
+			continue;
+		}
+
+		Segment segment = {};
+		segment.Chan = Channel::Thrust;
+		bool valid = true;
+		int numParams = 0;
+		if (type == "step")			{ segment.Type = SegmentType::Step;  numParams = 1; }
+		else if (type == "ramp")	{ segment.Type = SegmentType::Ramp;  numParams = 2; }
+		else if (type == "sine")	{ segment.Type = SegmentType::Sine;  numParams = 3; }
+		else if (type == "chirp")	{ segment.Type = SegmentType::Chirp; numParams = 4; }
+		else if (type == "prbs")	{ segment.Type = SegmentType::PRBS;  numParams = 4; }
+		else if (type == "sticks")	{ segment.Type = SegmentType::Sticks; }
+		else						{ valid = false; }
+
+		if (valid && segment.Type != SegmentType::Sticks)
+		{
+			std::string channel, end;
+			valid = (tokens >> channel >> segment.Start >> end) && Channel::FromStr(channel, segment.Chan);
+			segment.End = end == "*" ? FLT_MAX : (float)atof(end.c_str());
+			for (int p = 0; valid && p < numParams; ++p)
+			{
+				valid = (bool)(tokens >> segment.Params[p]);
+			}
+			// Angles are in degrees in the file. Only offset and amplitude of sine/chirp/prbs are angles.
+			if (IsAngle(segment.Chan))
+			{
+				bool periodic = segment.Type == SegmentType::Sine || segment.Type == SegmentType::Chirp || segment.Type == SegmentType::PRBS;
+				int numAngleParams = periodic ? 2 : numParams;
+				for (int p = 0; p < numAngleParams; ++p)
+				{
+					segment.Params[p] *= k_Pi / 180.0f;
+				}
+			}
+		}
+		else if (valid)
+		{
+			std::string packed;
+			valid = (bool)(tokens >> segment.Start >> segment.Interval) && segment.Interval > 0.0f;
+			while (valid && tokens >> packed)
+			{
+				segment.Packed.push_back((uint32_t)strtoul(packed.c_str(), nullptr, 0));
+			}
+			segment.End = segment.Start + segment.Interval * (float)segment.Packed.size();
+		}
+
+		if (!valid)
+		{
+			if (error)
+			{
+				*error = "Invalid segment at line " + std::to_string(lineIdx) + ": " + line;
+			}
+			return false;
+		}
+		segments.push_back(segment);
+	}
+
+	mName = name;
+	mSegments.swap(segments);
+	mTable.clear();
+	return true;
+}
+
+void SetPointProfile::Compile(float deltaTime, float totalTime)
+{
+	int numSteps = (int)(totalTime / deltaTime);
+	mDeltaTime = deltaTime;
+	mTable.assign(numSteps > 0 ? numSteps : 0, FCSetPoints());
+
+	for (const Segment& segment : mSegments)
+	{
+		int first = (int)std::ceil(segment.Start / deltaTime - 1e-4f);
+		int last = segment.End >= FLT_MAX ? numSteps : (int)std::ceil(segment.End / deltaTime - 1e-4f);
+		first = first < 0 ? 0 : first;
+		last = last > numSteps ? numSteps : last;
+		float duration = segment.End >= FLT_MAX ? totalTime - segment.Start : segment.End - segment.Start;
+
+		std::vector<float> prbs;
+		if (segment.Type == SegmentType::PRBS && last > first)
+		{
+			int samplesPerBit = std::max((int)(segment.Params[2] / deltaTime + 0.5f), 1);
+			prbs = ResponseAnalysis::GeneratePRBS(last - first, 10, samplesPerBit, segment.Params[1], (uint32_t)segment.Params[3]);
+		}
+
+		for (int i = first; i < last; ++i)
+		{
+			float t = (float)i * deltaTime - segment.Start;
+			const float* p = segment.Params;
+			switch (segment.Type)
+			{
+			case SegmentType::Step:
+				ChannelValue(mTable[i], segment.Chan) = p[0];
+				break;
+			case SegmentType::Ramp:
+				ChannelValue(mTable[i], segment.Chan) = p[0] + (p[1] - p[0]) * (duration > 0.0f ? t / duration : 1.0f);
+				break;
+			case SegmentType::Sine:
+				ChannelValue(mTable[i], segment.Chan) = p[0] + p[1] * std::sin(2.0f * k_Pi * p[2] * t);
+				break;
+			case SegmentType::Chirp:
+			{
+				// Linear chirp, the phase is the integral of the frequency:
+				float rate = duration > 0.0f ? (p[3] - p[2]) / duration : 0.0f;
+				float phase = 2.0f * k_Pi * (p[2] * t + 0.5f * rate * t * t);
+				ChannelValue(mTable[i], segment.Chan) = p[0] + p[1] * std::sin(phase);
+				break;
+			}
+			case SegmentType::PRBS:
+				ChannelValue(mTable[i], segment.Chan) = p[0] + prbs[i - first];
+				break;
+			case SegmentType::Sticks:
+			{
+				size_t sample = (size_t)(t / segment.Interval);
+				sample = sample < segment.Packed.size() ? sample : segment.Packed.size() - 1;
+				int32_t throttle, yaw, pitch, roll;
+				UnpackControlCommands(segment.Packed[sample], &throttle, &yaw, &pitch, &roll);
+				FCSetPoints sticks = ControlCommandsToSetPoints(throttle, yaw, pitch, roll);
+				mTable[i].Thrust = sticks.Thrust;
+				mTable[i].Yaw = sticks.Yaw;
+				mTable[i].Pitch = sticks.Pitch;
+				mTable[i].Roll = sticks.Roll;
+				break;
+			}
+			}
+		}
+	}
+}
+
+FCSetPoints SetPointProfile::Sample(float time) const
+{
+	if (mTable.empty())
+	{
+		return FCSetPoints();
+	}
+	return SampleIdx((int)(time / mDeltaTime + 0.5f));
+}
+
+FCSetPoints SetPointProfile::SampleIdx(int index) const
+{
+	if (mTable.empty())
+	{
+		return FCSetPoints();
+	}
+	index = index < 0 ? 0 : index;
+	index = index >= (int)mTable.size() ? (int)mTable.size() - 1 : index;
+	return mTable[index];
+}
+
+const std::string& SetPointProfile::GetName() const
+{
+	return mName;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "CommonFlyController.h"
+
+#include <string>
+#include <vector>
+
+// Declarative set point profile. The text format has one segment per line:
+//
+//   name   <profile name>
+//   step   <channel> <start> <end> <value>
+//   ramp   <channel> <start> <end> <from> <to>
+//   sine   <channel> <start> <end> <offset> <amplitude> <freq Hz>
+//   chirp  <channel> <start> <end> <offset> <amplitude> <start freq Hz> <end freq Hz>
+//   prbs   <channel> <start> <end> <offset> <amplitude> <bit time> <seed>
+//   sticks <start> <interval> <packed> [<packed> ...]
+//
+// Channels: thrust, yaw, pitch, roll (degrees in the file) and height (meters). Times are
+// in seconds, '*' as the end time means the end of the run. Later segments override earlier
+// ones. 'sticks' replays commands recorded in the BLE packed format (hex or decimal) and
+// drives thrust, yaw, pitch and roll. Lines starting with '#' are comments.
+//
+// Compile() bakes the segments into a flat table at the simulation rate, so sampling is O(1).
+class SetPointProfile
+{
+public:
+	struct Channel
+	{
+		enum T
+		{
+			Thrust,
+			Yaw,
+			Pitch,
+			Roll,
+			Height,
+			COUNT
+		};
+		static const char* ToStr(T t);
+		static bool FromStr(const std::string& str, T& t);
+	};
+
+	SetPointProfile();
+	bool LoadFromFile(const std::string& path, std::string* error = nullptr);
+	bool LoadFromString(const std::string& text, std::string* error = nullptr);
+	void Compile(float deltaTime, float totalTime);
+	FCSetPoints Sample(float time)const;
+	FCSetPoints SampleIdx(int index)const;
+	const std::string& GetName()const;
+
+	// Ascend to 3m at 1.5s and roll -20 degrees at 5s.
+	static const char* k_DefaultProfile;
+
+private:
+	struct SegmentType
+	{
+		enum T
+		{
+			Step,
+			Ramp,
+			Sine,
+			Chirp,
+			PRBS,
+			Sticks
+		};
+	};
+	struct Segment
+	{
+		SegmentType::T Type;
+		Channel::T Chan;
+		float Start;
+		float End;
+		float Params[4];
+		float Interval;					// Sticks only
+		std::vector<uint32_t> Packed;	// Sticks only
+	};
+
+	std::string mName;
+	std::vector<Segment> mSegments;
+	std::vector<FCSetPoints> mTable;
+	float mDeltaTime;
+};
\ No newline at end of file
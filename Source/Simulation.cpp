@@ -3,26 +3,50 @@
 #include "Simulation.h"
 #include "Quad.h"
 #include "QuadFlyController.h"
-#include "Graphics/UI/IMGUI/imgui.h"
-#include "Graphics/World/PhysicsWorld.h"
+#include "GainSet.h"
+#include "ResultCache.h"
 #include "Core/Logging.h"
 
-#include "PxPhysicsAPI.h"
-#include "PxFiltering.h"
-#include "PxSceneDesc.h"
-#include "extensions/PxRigidBodyExt.h"
+#ifndef HEADLESS
+	#include "Graphics/UI/IMGUI/imgui.h"
+#endif
 
 #include "glm/ext.hpp"
 
-using namespace physx;
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <typeinfo>
+
+// Part of the cache key. The build defines SIM_CODE_VERSION as the commit (premake5.lua),
+// bump k_ResultVersion when the meaning of a result changes without a new commit.
+#ifndef SIM_CODE_VERSION
+	#define SIM_CODE_VERSION "dev"
+#endif
+static const uint32_t k_ResultVersion = 1;
 
 
 Simulation::Simulation()
 	:TotalSimTime(15.0f)
 	,DeltaTime(0.05f)
+#ifdef HEADLESS
+	,Backend(Dynamics::Backend::RigidBody)
+#else
+	,Backend(Dynamics::Backend::PhysX)
+#endif
+	,Seed(1)
+	,Deterministic(false)
+	,Cache(nullptr)
+	,SnapshotInterval(0.0f)
+	,EmulateSensors(false)
+	,RecordImu(nullptr)
+	,mPrevOrientation(1.0f, 0.0f, 0.0f, 0.0f)
+	,mPrevVelocity(0.0f)
 	,mQuadTarget(nullptr)
 	,mFlightController(nullptr)
 {
+	mProfilePath[0] = 0;
 }
 
 void Simulation::Init()
@@ -41,11 +65,82 @@ void Simulation::SetFlightController(BaseFlyController* fc)
 
 void Simulation::RenderUI()
 {
+#ifndef HEADLESS
+	if (ImGui::BeginCombo("Dynamics", Dynamics::Backend::ToStr(Backend)))
+	{
+		for (int b = 0; b < Dynamics::Backend::COUNT; ++b)
+		{
+			if (ImGui::Selectable(Dynamics::Backend::ToStr((Dynamics::Backend::T)b), b == Backend))
+			{
+				Backend = (Dynamics::Backend::T)b;
+			}
+		}
+		ImGui::EndCombo();
+	}
+	int seed = (int)Seed;
+	if (ImGui::InputInt("Seed", &seed))
+	{
+		Seed = (uint32_t)seed;
+	}
+	ImGui::Checkbox("Deterministic", &Deterministic);
+	if (Cache && ImGui::TreeNode("Result Cache"))
+	{
+		ImGui::Text("Only deterministic runs are cached");
+		Cache->RenderUI();
+		ImGui::TreePop();
+	}
+	if (ImGui::Button("Verify Determinism") && mQuadTarget && mFlightController)
+	{
+		int divergentFrame = VerifyDeterminism();
+		if (divergentFrame < 0)
+		{
+			INFO("Bit identical runs, checksum %016llx", (unsigned long long)mResult.GetChecksum());
+		}
+		else
+		{
+			ERR("The runs diverge at frame %i", divergentFrame);
+		}
+	}
+	ImGui::InputFloat("Snapshot Interval", &SnapshotInterval);
+	ImGui::Text("Snapshots: %i", (int)mSnapshots.size());
 	ImGui::InputFloat("Total Simulation Time", &TotalSimTime);
 	ImGui::InputFloat("Delta Time", &DeltaTime);
 	int numberSteps = TotalSimTime / DeltaTime;
 	ImGui::Text("Total Simulation Steps: %i", numberSteps);
 
+	if (ImGui::TreeNode("Set Point Profile"))
+	{
+		ImGui::Text("Profile: %s", Profile.GetName().c_str());
+		ImGui::InputText("Path", mProfilePath, sizeof(mProfilePath));
+		if (ImGui::Button("Load"))
+		{
+			std::string error;
+			if (!Profile.LoadFromFile(mProfilePath, &error))
+			{
+				ERR("Failed to load the set point profile: %s", error.c_str());
+			}
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Default"))
+		{
+			Profile.LoadFromString(SetPointProfile::k_DefaultProfile);
+		}
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Environment"))
+	{
+		Env.RenderUI();
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Sensors"))
+	{
+		ImGui::Checkbox("Emulate Sensors", &EmulateSensors);
+		Sensors.RenderUI();
+		ImGui::TreePop();
+	}
+
 	if (mQuadTarget)
 	{
 		if (ImGui::TreeNode("Quad"))
@@ -54,139 +149,364 @@ void Simulation::RenderUI()
 			ImGui::TreePop();
 		}
 	}
+#endif
 }
 
 void Simulation::RunSimulation()
 {
 	// Setup simulation:
 	int numSimFrames = TotalSimTime / DeltaTime;
+	BeginRun();
+	mSnapshots.clear();
+
+	// A deterministic run is a function of its inputs, an identical one may be cached. Not
+	// when measuring the cost of the environment models, that needs the actual run, and cached
+	// results have no snapshots to fork from nor IMU traces, so those runs only store.
+	const bool useCache = Cache && Deterministic && !Env.MeasureCost;
+	const uint64_t cacheKey = useCache ? ComputeCacheKey() : 0;
+	if (RecordImu)
+	{
+		RecordImu->Clear();
+	}
+	if (useCache && SnapshotInterval <= 0.0f && !RecordImu && Cache->Find(cacheKey, mResult))
+	{
+		return;
+	}
+
 	mResult.DeltaTime = DeltaTime;
 	mResult.Frames.clear();
 	mResult.Frames.resize(numSimFrames);
-	float curTime = 0.0f;
+	mResult.Checksums.clear();
+	std::unique_ptr<Dynamics> dynamics = CreateDynamics();
+	if (!dynamics)
+	{
+		mResult.Reset();
+		return;
+	}
+
+	SimulateFrames(*dynamics, 0, 0.0f);
+	mResult.ComputeChecksums();
+	if (useCache)
+	{
+		Cache->Store(cacheKey, mResult);
+	}
+
+	if (Env.MeasureCost)
+	{
+		for (int m = 0; m < Environment::Model::COUNT; ++m)
+		{
+			Environment::Model::T model = (Environment::Model::T)m;
+			INFO("%s: %.1f ns/step", Environment::Model::ToStr(model), Env.GetStepCost(model));
+		}
+	}
+}
+
+bool Simulation::ForkSimulation(int snapshotIdx)
+{
+	if (snapshotIdx < 0 || snapshotIdx >= (int)mSnapshots.size())
+	{
+		ERR("Invalid snapshot %i, the run has %i", snapshotIdx, (int)mSnapshots.size());
+		return false;
+	}
+	if (DeltaTime != mResult.DeltaTime)
+	{
+		ERR("A fork needs the delta time of its run (%f)", mResult.DeltaTime);
+		return false;
+	}
+	int numSimFrames = TotalSimTime / DeltaTime;
+	const SimulationSnapshot snapshot = mSnapshots[snapshotIdx];
+	if (snapshot.FrameIdx >= numSimFrames)
+	{
+		ERR("The snapshot is past the end of the simulation");
+		return false;
+	}
+
+	// Same setup as a run, then the state of the snapshot on top:
+	BeginRun();
+	std::unique_ptr<Dynamics> dynamics = CreateDynamics();
+	if (!dynamics)
+	{
+		return false;
+	}
+	RestoreSnapshot(snapshot, *dynamics);
+
+	// The frames and snapshots before the fork are still valid, the fork point is taken again:
+	mSnapshots.resize(snapshotIdx);
+	mResult.Frames.resize(numSimFrames);
+	SimulateFrames(*dynamics, snapshot.FrameIdx, snapshot.Time);
+	mResult.ComputeChecksums(snapshot.FrameIdx);
+	return true;
+}
+
+const std::vector<SimulationSnapshot>& Simulation::GetSnapshots() const
+{
+	return mSnapshots;
+}
+
+void Simulation::BeginRun()
+{
 	mQuadTarget->Reset();
 	mFlightController->Reset();
+	Env.Reset(Seed);
+	Profile.Compile(DeltaTime, TotalSimTime);
+	mNoiseRng.Seed(Seed, RandomStream::Stream::SensorNoise);
+	Sensors.Reset(Seed, 1);
+	mEstimator.Reset();
+}
 
-	// Setup the physx scene:
-	auto physx = World::PhysicsWorld::GetInstance()->GetPhyx();
-	PxSceneDesc sceneDesc = PxSceneDesc(physx->getTolerancesScale());
-	sceneDesc.gravity = PxVec3(0.0f, -9.81f, 0.0f);
-	sceneDesc.cpuDispatcher = World::PhysicsWorld::GetInstance()->GetPhyxCPUDispatcher();
-	sceneDesc.filterShader = PxDefaultSimulationFilterShader;
-	sceneDesc.solverType = PxSolverType::eTGS;
-	sceneDesc.flags.set(PxSceneFlag::eENABLE_CCD);
-	sceneDesc.bounceThresholdVelocity = 10.0f * 9.81f;
-	sceneDesc.ccdMaxPasses = 4;
-	PxScene* physxScene = physx->createScene(sceneDesc);
-
-	// Quad rigid body:
-	PxTransform quadInitialTransform;
-	quadInitialTransform.p = PxVec3(0.0f, 0.0f, 0.0f);
+std::unique_ptr<Dynamics> Simulation::CreateDynamics()
+{
+	std::unique_ptr<Dynamics> dynamics(Dynamics::Create(Backend));
+	if (!dynamics)
+	{
+		ERR("The %s backend is not available in this build", Dynamics::Backend::ToStr(Backend));
+		return dynamics;
+	}
 	glm::quat initialQuat = glm::quat(glm::vec3(glm::radians(20.0f),0.0f,0.0f));
-	quadInitialTransform.q = PxQuat(initialQuat.x, initialQuat.y, initialQuat.z, initialQuat.w);
-	auto rigidBody = physx->createRigidDynamic(quadInitialTransform);
-	rigidBody->setMass(mQuadTarget->Mass);
-
-	PxMaterial* quadMat = physx->createMaterial(0.5f, 0.5f, 0.0f);
-	PxShape* quadBox = physx->createShape(PxBoxGeometry(mQuadTarget->Width * 0.5f, mQuadTarget->Height * 0.5f, mQuadTarget->Depth * 0.5f), *quadMat);
-	rigidBody->attachShape(*quadBox);
-
-	float density = mQuadTarget->Mass / (mQuadTarget->Width * mQuadTarget->Height * mQuadTarget->Depth);
-	auto tensor = rigidBody->getMassSpaceInertiaTensor();
-	PxRigidBodyExt::updateMassAndInertia(*rigidBody, density);
-	tensor = rigidBody->getMassSpaceInertiaTensor();
-
-	physxScene->addActor(*rigidBody);
-
-	// Ground plane
-	auto plane = PxCreatePlane(*physx, PxPlane(0.0f, 1.0f, 0.0f, 0.2f), *quadMat);
-	physxScene->addActor(*plane);
-
-#if 1
-	float rnd1 = 0.01f;
-	float rnd2 = 0.0175f;
-	float rnd3 = 0.0233f;
-	float rnd4 = 0.0137f;
-#else
-	float rnd1 = 0.0f;
-	float rnd2 = 0.0f;
-	float rnd3 = 0.0f;
-	float rnd4 = 0.0f;
-#endif
+	dynamics->Init(*mQuadTarget, glm::vec3(0.0f), initialQuat, Env.GroundHeight, Deterministic);
+	mPrevOrientation = initialQuat;
+	mPrevVelocity = glm::vec3(0.0f);
+	return dynamics;
+}
+
+void Simulation::SimulateFrames(Dynamics& dynamics, int firstFrame, float curTime)
+{
+	const int numSimFrames = (int)mResult.Frames.size();
+	const int snapshotFrames = SnapshotInterval > 0.0f ? std::max((int)(SnapshotInterval / DeltaTime + 0.5f), 1) : 0;
 
 	// Run each simulation step:
-	for (int frameIdx = 0; frameIdx < numSimFrames; ++frameIdx)
+	for (int frameIdx = firstFrame; frameIdx < numSimFrames; ++frameIdx)
 	{
+		// The first frame is always taken, so a fork point can be forked again:
+		if (snapshotFrames > 0 && (frameIdx == firstFrame || frameIdx % snapshotFrames == 0))
+		{
+			TakeSnapshot(dynamics, frameIdx, curTime);
+		}
+
 		// Advance sim:
-		PxTransform curTransform = rigidBody->getGlobalPose();
-		mQuadTarget->Position = glm::vec3(curTransform.p.x, curTransform.p.y, curTransform.p.z);
-		mQuadTarget->Orientation = glm::eulerAngles(glm::quat(curTransform.q.w, curTransform.q.x, curTransform.q.y, curTransform.q.z));
+		glm::quat orientation = dynamics.GetOrientation();
+		mQuadTarget->Position = dynamics.GetPosition();
+		mQuadTarget->Orientation = glm::eulerAngles(orientation);
 
-		FCSetPoints setPoints;
+		FCSetPoints setPoints = Profile.SampleIdx(frameIdx);
 
 		// FC, run current iteration:
 		FCQuadState fcState;
 		fcState.DeltaTime = DeltaTime;
 		fcState.Height = mQuadTarget->Position.y;
 		fcState.Pitch = mQuadTarget->Orientation.x;
-		fcState.Yaw = mQuadTarget->Orientation.y;
+		// The board yaw grows turning left seen from above, the simulation yaw turning right:
+		fcState.Yaw = -mQuadTarget->Orientation.y;
 		fcState.Roll = mQuadTarget->Orientation.z;
 		fcState.Time = curTime;
 		// Add noise
 		{
-			fcState.Pitch += glm::linearRand(-0.08f, 0.08f);
-			fcState.Yaw += glm::linearRand(-0.08f, 0.08f);
-			fcState.Roll += glm::linearRand(-0.08f, 0.08f);
+			const float attitudeNoise = mQuadTarget->AttitudeNoise;
+			const float heightNoise = mQuadTarget->HeightNoise;
+			if (heightNoise > 0.0f)
+			{
+				fcState.Height += mNoiseRng.Uniform(-heightNoise, heightNoise);
+			}
+			if (!EmulateSensors)
+			{
+				fcState.Pitch += mNoiseRng.Uniform(-attitudeNoise, attitudeNoise);
+				fcState.Yaw += mNoiseRng.Uniform(-attitudeNoise, attitudeNoise);
+				fcState.Roll += mNoiseRng.Uniform(-attitudeNoise, attitudeNoise);
+			}
+		}
+
+		// Or the attitude the board would estimate, it runs once per frame:
+		const glm::vec3 velocity = dynamics.GetLinearVelocity();
+		if (EmulateSensors)
+		{
+			const MotorModel::State motors = mQuadTarget->Motors.GetState();
+			float motorSpeed = 0.0f;
+			for (int m = 0; m < MotorModel::k_NumMotors; ++m)
+			{
+				motorSpeed += motors.Speed[m] / (float)MotorModel::k_NumMotors;
+			}
+			const SensorModel::Truth truth = SensorModel::FromMotion(mPrevOrientation, mPrevVelocity, orientation, velocity, DeltaTime, motorSpeed);
+			SensorModel::Sample sample;
+			const bool newSample = Sensors.Step(curTime, &truth, &sample) > 0;
+			const float accel[3] = { sample.Accel.x, sample.Accel.y, sample.Accel.z };
+			const float gyro[3] = { sample.Gyro.x, sample.Gyro.y, sample.Gyro.z };
+			float yaw, pitch, roll;
+			mEstimator.Update(newSample ? accel : nullptr, newSample ? gyro : nullptr, DeltaTime, yaw, pitch, roll);
+			if (RecordImu)
+			{
+				RecordImu->Add(DeltaTime, newSample ? accel : nullptr, newSample ? gyro : nullptr);
+			}
+			fcState.Pitch = glm::radians(pitch);
+			fcState.Yaw = glm::radians(yaw);
+			fcState.Roll = glm::radians(roll);
 		}
+		mPrevOrientation = orientation;
+		mPrevVelocity = velocity;
 		FCCommands fcCommands = mFlightController->Iterate(fcState, setPoints);
 
-		// Apply quad commands
-		glm::mat4 quadToWorld;
-		quadToWorld = glm::rotate(quadToWorld, mQuadTarget->Orientation.x, glm::vec3(1.0f, 0.0f, 0.0f));
-		quadToWorld = glm::rotate(quadToWorld, mQuadTarget->Orientation.y, glm::vec3(0.0f, 1.0f, 0.0f));
-		quadToWorld = glm::rotate(quadToWorld, mQuadTarget->Orientation.z, glm::vec3(0.0f, 0.0f, 1.0f));
-		
 		// Thrust per motor:
-		float dimX = mQuadTarget->Width * 0.5f;
-		float dimZ = mQuadTarget->Depth * 0.5f;
-		float perMotorThrust = 0.3675f; // RaceStart 8250
-		float flThrust = glm::clamp(fcCommands.FrontLeftThr, 0.0f, 1.0f) * (perMotorThrust + rnd1);
-		PxRigidBodyExt::addLocalForceAtLocalPos(*rigidBody, PxVec3(0.0f, flThrust, 0.0f), PxVec3(-dimX, 0.0f, dimZ));
-
-		float rlThrust = glm::clamp(fcCommands.RearLeftThr,  0.0f, 1.0f) * (perMotorThrust + rnd2);
-		PxRigidBodyExt::addLocalForceAtLocalPos(*rigidBody, PxVec3(0.0f, rlThrust, 0.0f), PxVec3(-dimX, 0.0f, -dimZ));
-
-		float frThrust = glm::clamp(fcCommands.FrontRightThr,0.0f, 1.0f) * (perMotorThrust + rnd3);
-		PxRigidBodyExt::addLocalForceAtLocalPos(*rigidBody, PxVec3(0.0f, frThrust, 0.0f), PxVec3( dimX, 0.0f, dimZ));
-
-		float rrThrust = glm::clamp(fcCommands.RearRightThr, 0.0f, 1.0f) * (perMotorThrust + rnd4);
-		PxRigidBodyExt::addLocalForceAtLocalPos(*rigidBody, PxVec3(0.0f, rrThrust, 0.0f), PxVec3( dimX, 0.0f,-dimZ));
+		float dimX = mQuadTarget->ArmLength * 0.70710678f;
+		float dimZ = dimX;
+		float motorCommands[MotorModel::k_NumMotors] = 
+		{
+			fcCommands.FrontLeftThr, fcCommands.FrontRightThr, fcCommands.RearLeftThr, fcCommands.RearRightThr
+		};
+		float motorThrust[MotorModel::k_NumMotors];
+		float yawTorque = 0.0f;
+		mQuadTarget->Motors.Step(motorCommands, DeltaTime, motorThrust, yawTorque);
+
+		// Environment (drag, wind, gusts and ground effect):
+		glm::vec3 envForce;
+		float thrustScale = 1.0f;
+		Env.Step(*mQuadTarget, dynamics.GetLinearVelocity(), DeltaTime, envForce, thrustScale);
+		for (int m = 0; m < MotorModel::k_NumMotors; ++m)
+		{
+			motorThrust[m] *= thrustScale;
+		}
+		dynamics.AddForce(envForce);
 
-		// Local frame to world frame:
-		//glm::vec3 localForce = glm::vec3(0.0f, flThrust + rlThrust + frThrust + rrThrust, 0.0f);
-		//glm::vec3 worldForce =  glm::mat3(quadToWorld) * localForce;
+		dynamics.AddLocalForceAtLocalPos(glm::vec3(0.0f, motorThrust[0], 0.0f), glm::vec3(-dimX, 0.0f, dimZ));
+		dynamics.AddLocalForceAtLocalPos(glm::vec3(0.0f, motorThrust[1], 0.0f), glm::vec3( dimX, 0.0f, dimZ));
+		dynamics.AddLocalForceAtLocalPos(glm::vec3(0.0f, motorThrust[2], 0.0f), glm::vec3(-dimX, 0.0f, -dimZ));
+		dynamics.AddLocalForceAtLocalPos(glm::vec3(0.0f, motorThrust[3], 0.0f), glm::vec3( dimX, 0.0f,-dimZ));
+		dynamics.AddTorque(orientation * glm::vec3(0.0f, yawTorque, 0.0f));
 
 		// Query sim state, used for the 3D visualization:
-		SimulationFrame& frame = mResult.Frames[frameIdx];
+		SimulationFrame& frame = mResult.Frames.Edit(frameIdx);
 
 		frame.QuadOrientation = mQuadTarget->Orientation;
 		frame.QuadPosition = mQuadTarget->Position;
+		frame.SetPoints = setPoints;
 	
 		mFlightController->QuerySimState(&frame);
 
-		//frame.WorldForce = worldForce;
-
-		// Step the physx simulation:
-		physxScene->simulate(DeltaTime);
-		physxScene->fetchResults(true);
+		// Step the rigid body:
+		dynamics.Step(DeltaTime);
 
 		curTime += DeltaTime;
 	}
+}
+
+void Simulation::TakeSnapshot(const Dynamics& dynamics, int frameIdx, float curTime)
+{
+	mSnapshots.emplace_back();
+	SimulationSnapshot& snapshot = mSnapshots.back();
+	snapshot.FrameIdx = frameIdx;
+	snapshot.Time = curTime;
+	snapshot.Body = dynamics.GetState();
+	mFlightController->SaveState(snapshot.Controller);
+	snapshot.Motors = mQuadTarget->Motors.GetState();
+	snapshot.Env = Env.GetState();
+	snapshot.NoiseRng = mNoiseRng;
+	snapshot.Sensors = Sensors.GetState();
+	snapshot.Estimator = mEstimator.GetState();
+	snapshot.PrevOrientation = mPrevOrientation;
+	snapshot.PrevVelocity = mPrevVelocity;
+}
+
+void Simulation::RestoreSnapshot(const SimulationSnapshot& snapshot, Dynamics& dynamics)
+{
+	dynamics.SetState(snapshot.Body);
+	mFlightController->LoadState(snapshot.Controller);
+	mQuadTarget->Motors.SetState(snapshot.Motors);
+	Env.SetState(snapshot.Env);
+	mNoiseRng = snapshot.NoiseRng;
+	Sensors.SetState(snapshot.Sensors);
+	mEstimator.SetState(snapshot.Estimator);
+	mPrevOrientation = snapshot.PrevOrientation;
+	mPrevVelocity = snapshot.PrevVelocity;
+}
+
+// FNV-1a, also used by the frame checksums.
+static uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+	}
+	return hash;
+}
+
+template<typename T>
+static uint64_t HashValue(uint64_t hash, const T& value)
+{
+	return HashBytes(hash, &value, sizeof(T));
+}
+
+uint64_t Simulation::ComputeCacheKey()
+{
+	uint64_t hash = 0xCBF29CE484222325ull;
+	const char* codeVersion = SIM_CODE_VERSION;
+	hash = HashBytes(hash, codeVersion, strlen(codeVersion));
+	hash = HashValue(hash, k_ResultVersion);
+
+	hash = HashValue(hash, (int32_t)Backend);
+	hash = HashValue(hash, TotalSimTime);
+	hash = HashValue(hash, DeltaTime);
+	hash = HashValue(hash, Seed);
+
+	for (int m = 0; m < Environment::Model::COUNT; ++m)
+	{
+		hash = HashValue(hash, (uint8_t)Env.Enabled[m]);
+	}
+	hash = HashValue(hash, Env.GroundHeight);
+	hash = HashValue(hash, Env.RotorRadius);
+	hash = HashValue(hash, Env.WindVelocity);
+	hash = HashValue(hash, Env.GustIntensity);
+	hash = HashValue(hash, Env.GustLengthScale);
+
+	hash = HashValue(hash, (uint8_t)EmulateSensors);
+	if (EmulateSensors)
+	{
+		for (int s = 0; s < SensorModel::Stage::COUNT; ++s)
+		{
+			hash = HashValue(hash, (uint8_t)Sensors.Enabled[s]);
+		}
+		hash = HashValue(hash, Sensors.SampleRate);
+		hash = HashValue(hash, Sensors.AccelRange);
+		hash = HashValue(hash, Sensors.GyroRange);
+		hash = HashValue(hash, Sensors.AdcBits);
+		hash = HashValue(hash, Sensors.Misalignment);
+		hash = HashValue(hash, Sensors.AccelBias);
+		hash = HashValue(hash, Sensors.GyroBias);
+		hash = HashValue(hash, Sensors.AccelBiasWalk);
+		hash = HashValue(hash, Sensors.GyroBiasWalk);
+		hash = HashValue(hash, Sensors.AccelNoise);
+		hash = HashValue(hash, Sensors.GyroNoise);
+		hash = HashValue(hash, Sensors.AccelVibration);
+		hash = HashValue(hash, Sensors.GyroVibration);
+	}
 
-	// Cleanup:
-	plane->release();
-	rigidBody->release();
-	physxScene->release();
+	// The airframe name is just a label:
+	QuadProfile airframe = mQuadTarget->GetProfile();
+	memset(airframe.Name, 0, sizeof(airframe.Name));
+	hash = HashValue(hash, airframe);
+
+	const char* controllerType = typeid(*mFlightController).name();
+	hash = HashBytes(hash, controllerType, strlen(controllerType));
+	GainSet gainSet = {};
+	mFlightController->GetGainSet(gainSet);
+	hash = HashValue(hash, gainSet.Gains);
+	FCSnapshot settings;
+	memset(&settings, 0, sizeof(settings));
+	mFlightController->SaveSettings(settings);
+	hash = HashValue(hash, settings.Data);
+
+	const int numSimFrames = TotalSimTime / DeltaTime;
+	for (int i = 0; i < numSimFrames; ++i)
+	{
+		hash = HashValue(hash, Profile.SampleIdx(i));
+	}
+	return hash;
+}
+
+int Simulation::VerifyDeterminism()
+{
+	RunSimulation();
+	SimulationResult first = mResult;
+	RunSimulation();
+	return mResult.FindDivergence(first);
 }
 
 SimulationFrame Simulation::GetSimulationFrame(float simTime, bool interpolate)
@@ -225,6 +545,12 @@ bool Simulation::HasResults() const
 	return !mResult.Frames.empty();
 }
 
+void Simulation::ClearResults()
+{
+	mResult.Reset();
+	mSnapshots.clear();
+}
+
 int Simulation::GetNumFrames()
 {
 	if (HasResults())
@@ -238,6 +564,50 @@ void SimulationResult::Reset()
 {
 	DeltaTime = 0.0f;
 	Frames.clear();
+	Checksums.clear();
+}
+
+// Only floats, no padding bytes in the hashed structs:
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "Unexpected glm::vec3 layout");
+static_assert(sizeof(SimulationFrame::PIDState) == 3 * sizeof(float), "Unexpected PIDState layout");
+static_assert(sizeof(FCSetPoints) == 5 * sizeof(float), "Unexpected FCSetPoints layout");
+
+void SimulationResult::ComputeChecksums(int firstFrame)
+{
+	firstFrame = std::min(firstFrame, (int)Checksums.size());
+	uint64_t hash = firstFrame > 0 ? Checksums[firstFrame - 1] : 0xCBF29CE484222325ull;
+	Checksums.resize(Frames.size());
+	for (size_t i = firstFrame; i < Frames.size(); ++i)
+	{
+		// Field by field, the frame layout (padding) is not part of the checksum:
+		const SimulationFrame& frame = Frames[i];
+		hash = HashBytes(hash, &frame.QuadPosition, sizeof(frame.QuadPosition));
+		hash = HashBytes(hash, &frame.QuadOrientation, sizeof(frame.QuadOrientation));
+		hash = HashBytes(hash, &frame.WorldForce, sizeof(frame.WorldForce));
+		hash = HashBytes(hash, &frame.HeightPIDState, sizeof(frame.HeightPIDState));
+		hash = HashBytes(hash, &frame.PitchPIDState, sizeof(frame.PitchPIDState));
+		hash = HashBytes(hash, &frame.RollPIDState, sizeof(frame.RollPIDState));
+		hash = HashBytes(hash, &frame.SetPoints, sizeof(frame.SetPoints));
+		Checksums[i] = hash;
+	}
+}
+
+uint64_t SimulationResult::GetChecksum() const
+{
+	return Checksums.empty() ? 0 : Checksums.back();
+}
+
+int SimulationResult::FindDivergence(const SimulationResult& other) const
+{
+	size_t count = std::min(Checksums.size(), other.Checksums.size());
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (Checksums[i] != other.Checksums[i])
+		{
+			return (int)i;
+		}
+	}
+	return Checksums.size() == other.Checksums.size() && DeltaTime == other.DeltaTime ? -1 : (int)count;
 }
 
 const SimulationFrame::PIDState& SimulationFrame::GetPIDState(PIDType type)const
@@ -263,6 +633,7 @@ SimulationFrame SimulationFrame::Interpolate(const SimulationFrame& a, const Sim
 	newFrame.HeightPIDState = a.HeightPIDState;
 	newFrame.PitchPIDState = a.PitchPIDState;
 	newFrame.RollPIDState = a.RollPIDState;
+	newFrame.SetPoints = a.SetPoints;
 
 	return newFrame;
 }
@@ -3,10 +3,24 @@
 #include "glm/glm.hpp"
 #include "glm/gtx/quaternion.hpp"
 
+#include "Dynamics/Dynamics.h"
+#include "Environment.h"
+#include "MotorModel.h"
+#include "SetPointProfile.h"
+#include "RandomStream.h"
+#include "CowArray.h"
+#include "Sensors/SensorModel.h"
+#include "Sensors/ImuTrace.h"
+#include "AttitudeEstimator.h"
+#include "CommonFlyController.h"
+
+#include <stdint.h>
+#include <memory>
 #include <vector>
 
 class Quad;
 class BaseFlyController;
+class ResultCache;
 
 struct SimulationFrame
 {
@@ -25,18 +39,44 @@ struct SimulationFrame
 	const PIDState& GetPIDState(PIDType type)const;
 	static SimulationFrame Interpolate(const SimulationFrame& a, const SimulationFrame& b, float alpha);
 	glm::vec3 QuadPosition;
-	glm::vec3 QuadOrientation;
+	glm::vec3 QuadOrientation;	// Euler (pitch, yaw, roll), the controllers see the yaw negated
 	glm::vec3 WorldForce;
 	PIDState HeightPIDState;
 	PIDState PitchPIDState;
 	PIDState RollPIDState;
+	FCSetPoints SetPoints;
 };
 
 struct SimulationResult
 {
 	void Reset();
+
+	// Chained FNV-1a of the raw float bits, Checksums[i] covers the frames 0..i. Two runs are
+	// bit identical if the last checksums match, otherwise the first mismatch is the first
+	// divergent frame. The checksums before firstFrame are kept (used by the forks).
+	void ComputeChecksums(int firstFrame = 0);
+	uint64_t GetChecksum()const;	// Of the whole run, 0 if there are no checksums
+	int FindDivergence(const SimulationResult& other)const;	// -1 if bit identical
+
 	float DeltaTime;
-	std::vector<SimulationFrame> Frames;
+	CowArray<SimulationFrame> Frames;	// Copies share the frames, forks only own their tail
+	std::vector<uint64_t> Checksums;
+};
+
+// State of a run at the start of a frame, everything a fork needs to continue from there.
+struct SimulationSnapshot
+{
+	int FrameIdx;
+	float Time;
+	Dynamics::State Body;
+	FCSnapshot Controller;
+	MotorModel::State Motors;
+	Environment::State Env;
+	RandomStream NoiseRng;
+	SensorModel::State Sensors;
+	AttitudeEstimator::State Estimator;
+	glm::quat PrevOrientation;
+	glm::vec3 PrevVelocity;
 };
 
 class Simulation
@@ -48,17 +88,58 @@ public:
 	void SetFlightController(BaseFlyController* fc);
 	void RenderUI();
 	void RunSimulation();
+	// Continues the current run from one of its snapshots with the current settings (gains,
+	// set points, airframe...), the frames before the snapshot are shared with the previous
+	// result. The delta time must not change. Not cached, the key does not cover the history.
+	bool ForkSimulation(int snapshotIdx);
+	const std::vector<SimulationSnapshot>& GetSnapshots()const;
+	// Runs twice and compares the checksums. Returns the first divergent frame, -1 if both
+	// runs are bit identical. The second run is kept as the current result.
+	int VerifyDeterminism();
 	SimulationFrame GetSimulationFrame(float simTime, bool interpolate = true);
 	SimulationFrame GetSimulationFrameFromIdx(int index);
 	const SimulationResult& GetSimulationResults()const;
 	bool HasResults()const;
+	void ClearResults();
 	int GetNumFrames();
 
 	float TotalSimTime;
 	float DeltaTime;
+	Dynamics::Backend::T Backend;
+	uint32_t Seed;			// Every random stream of a run (noise, gusts) derives from it
+	bool Deterministic;		// Bit reproducible PhysX runs: single threaded with enhanced determinism
+	ResultCache* Cache;		// Deterministic runs are looked up and stored here, nullptr disables it
+	float SnapshotInterval;	// Seconds between the snapshots of a run, 0 disables them
+	// The controllers get the attitude the board estimator computes from emulated IMU samples,
+	// instead of the actual one plus the airframe attitude noise.
+	bool EmulateSensors;
+	// Gets the estimator inputs of the next runs with emulated sensors (cleared by every
+	// RunSimulation, forks append theirs), nullptr disables it.
+	ImuTrace* RecordImu;
+	Environment Env;
+	SensorModel Sensors;
+	SetPointProfile Profile;
 
 private:
+	// Hash of every input of a run: code version, backend, rates, seed, environment, sensors,
+	// airframe, controller type and gains and the compiled set points. Controller settings
+	// outside of the gain set are not part of it.
+	uint64_t ComputeCacheKey();
+
+	// Setup shared by the runs and the forks.
+	void BeginRun();
+	std::unique_ptr<Dynamics> CreateDynamics();	// nullptr if the backend is not available
+	void SimulateFrames(Dynamics& dynamics, int firstFrame, float curTime);
+	void TakeSnapshot(const Dynamics& dynamics, int frameIdx, float curTime);
+	void RestoreSnapshot(const SimulationSnapshot& snapshot, Dynamics& dynamics);
+
 	SimulationResult mResult;
+	std::vector<SimulationSnapshot> mSnapshots;
+	RandomStream mNoiseRng;	// Sensor noise, per simulation so runs can go in parallel
+	AttitudeEstimator mEstimator;
+	glm::quat mPrevOrientation;	// Of the previous frame, for the IMU emulation
+	glm::vec3 mPrevVelocity;
 	Quad* mQuadTarget;
 	BaseFlyController* mFlightController;
+	char mProfilePath[256];
 };
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "SysIdView.h"
+#include "Quad.h"
+#include "Graphics/UI/IMGUI/imgui.h"
+#include "Core/Logging.h"
+
+using namespace SystemIdentification;
+
+SysIdView::SysIdView()
+	:mHasResult(false)
+{
+	mLogPath[0] = 0;
+	mProfilePath[0] = 0;
+}
+
+void SysIdView::RenderUI(Quad& quad)
+{
+	ImGui::Begin("System Identification");
+	{
+		ImGui::InputText("Log", mLogPath, sizeof(mLogPath));
+		ImGui::SameLine();
+		if (ImGui::Button("Open"))
+		{
+			if (!mLog.Open(mLogPath))
+			{
+				ERR("Could not open the flight log: %s", mLogPath);
+			}
+		}
+		ImGui::Text("Records: %i", mLog.GetNumRecords());
+
+		if (ImGui::CollapsingHeader("Settings"))
+		{
+			for (int p = 0; p < Param::COUNT; ++p)
+			{
+				ImGui::Checkbox(Param::ToStr((Param::T)p), &mSettings.Fit[p]);
+			}
+			ImGui::InputInt("Segment Length", &mSettings.SegmentLength);
+			ImGui::InputInt("Max Iterations", &mSettings.MaxIterations);
+			ImGui::InputFloat("Tolerance", &mSettings.Tolerance);
+			ImGui::InputFloat("Height Weight (1/m)", &mSettings.HeightWeight);
+			ImGui::InputFloat("Angle Weight (1/rad)", &mSettings.AngleWeight);
+			ImGui::InputInt("Threads (0 = all)", &mSettings.NumThreads);
+		}
+
+		if (ImGui::Button("Fit") && mLog.GetNumRecords() > 0)
+		{
+			GetParams(quad, mInitialParams);
+			mHasResult = Fit(mLog.GetRecords(), mLog.GetNumRecords(), quad, mSettings, mResult);
+			if (!mHasResult)
+			{
+				ERR("System identification failed, the log has no usable segments");
+			}
+		}
+
+		if (mHasResult)
+		{
+			ImGui::Text("Segments: %i Iterations: %i %s", mResult.NumSegments, mResult.Iterations, mResult.Converged ? "(converged)" : "(not converged)");
+			ImGui::Text("Cost: %.5f -> %.5f", mResult.InitialCost, mResult.FinalCost);
+			ImGui::Text("RMS height: %.4f m RMS angle: %.4f rad", mResult.RmsHeight, mResult.RmsAngle);
+			for (int p = 0; p < Param::COUNT; ++p)
+			{
+				ImGui::Text("%-16s %.7g -> %.7g", Param::ToStr((Param::T)p), mInitialParams[p], mResult.Params[p]);
+			}
+
+			if (ImGui::Button("Apply to Quad"))
+			{
+				ApplyParams(mResult.Params, quad);
+			}
+			ImGui::InputText("Profile", mProfilePath, sizeof(mProfilePath));
+			ImGui::SameLine();
+			if (ImGui::Button("Save"))
+			{
+				Quad fitted = quad;
+				ApplyParams(mResult.Params, fitted);
+				if (!fitted.SaveProfile(mProfilePath))
+				{
+					ERR("Failed to save the quad profile: %s", mProfilePath);
+				}
+			}
+		}
+	}
+	ImGui::End();
+}
\ No newline at end of file
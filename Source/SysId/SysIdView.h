@@ -0,0 +1,24 @@
+#pragma once
+
+#include "SystemIdentification.h"
+#include "Replay/FlightLog.h"
+
+class Quad;
+
+// System identification window: fits the quad parameters to a board log, the result can be
+// applied to the simulated quad and saved as a quad profile.
+class SysIdView
+{
+public:
+	SysIdView();
+	void RenderUI(Quad& quad);
+
+private:
+	char mLogPath[256];
+	char mProfilePath[256];
+	FlightLog mLog;
+	SystemIdentification::Settings mSettings;
+	SystemIdentification::Result mResult;
+	float mInitialParams[SystemIdentification::Param::COUNT];
+	bool mHasResult;
+};
\ No newline at end of file
@@ -0,0 +1,469 @@
+#include "SystemIdentification.h"
+#include "Jobs/JobSystem.h"
+#include "Quad.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtx/quaternion.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace SystemIdentification;
+
+static const float k_Gravity = 9.81f;
+static const float k_Pi = 3.14159265358979f;
+static const double k_JacobianStep = 1e-3;	// Log space, ~0.1% of the parameter
+static const double k_MaxStep = 1.0;		// Log space, at most a factor e per iteration
+
+namespace
+{
+	// Sums of one evaluation over all the segments.
+	struct Cost
+	{
+		double Total;		// Weighted
+		double HeightSq;	// Unweighted
+		double AngleSq;
+		int NumSamples;
+	};
+
+	// Normal equations of a segment: J^T*J and J^T*r over the fitted parameters.
+	struct Normal
+	{
+		double JtJ[Param::COUNT][Param::COUNT];
+		double Jtr[Param::COUNT];
+	};
+
+	struct Problem
+	{
+		const FlightLogRecord* Records;
+		std::vector<int> Segments;	// First record of each segment
+		int SegmentLength;
+		int FitIdx[Param::COUNT];	// Parameter of each fitted slot
+		int NumFit;
+		const Quad* Initial;
+		const Settings* Config;
+	};
+}
+
+static float WrapAngle(float angle)
+{
+	angle = std::fmod(angle + k_Pi, 2.0f * k_Pi);
+	return (angle < 0.0f ? angle + 2.0f * k_Pi : angle) - k_Pi;
+}
+
+static void GetCommands(const FlightLogRecord& record, float* commands)
+{
+	commands[0] = record.Commands.FrontLeftThr;
+	commands[1] = record.Commands.FrontRightThr;
+	commands[2] = record.Commands.RearLeftThr;
+	commands[3] = record.Commands.RearRightThr;
+}
+
+static float GetDeltaTime(const FlightLogRecord& cur, const FlightLogRecord& next)
+{
+	float deltaTime = next.State.Time - cur.State.Time;
+	return deltaTime > 0.0f ? deltaTime : cur.State.DeltaTime;
+}
+
+// Small angle rotation (body frame of a) that takes a to b.
+static glm::vec3 RotationVector(const glm::quat& a, const glm::quat& b)
+{
+	glm::quat delta = glm::inverse(a) * b;
+	float sign = delta.w < 0.0f ? -1.0f : 1.0f;
+	return glm::vec3(delta.x, delta.y, delta.z) * (2.0f * sign);
+}
+
+// Integrates one segment with the recorded commands and writes 4 residuals per record
+// (height, pitch, yaw, roll) after the first one. Mirrors the forces of Simulation::RunSimulation
+// without the environment, segments are expected to be flown away from the ground.
+static void SimulateSegment(const Problem& problem, int first, const double* logParams, float* residuals, Cost* cost)
+{
+	const FlightLogRecord* records = problem.Records + first;
+	const Settings& settings = *problem.Config;
+
+	float params[Param::COUNT];
+	for (int p = 0; p < Param::COUNT; ++p)
+	{
+		params[p] = (float)std::exp(logParams[p]);
+	}
+	Quad model = *problem.Initial;
+	ApplyParams(params, model);
+
+	float commands[MotorModel::k_NumMotors];
+	GetCommands(records[0], commands);
+	model.Motors.Reset(commands);
+
+	// Initial state from the first three records, second order differences so a segment that
+	// starts accelerating does not bias the rates:
+	const FCQuadState& s0 = records[0].State;
+	const FCQuadState& s1 = records[1].State;
+	const FCQuadState& s2 = records[2].State;
+	float deltaTime0 = 0.5f * (GetDeltaTime(records[0], records[1]) + GetDeltaTime(records[1], records[2]));
+	// The logged yaw is the board one, negated from the simulation yaw:
+	glm::quat orientation = glm::quat(glm::vec3(s0.Pitch, -s0.Yaw, s0.Roll));
+	glm::vec3 rotation1 = RotationVector(orientation, glm::quat(glm::vec3(s1.Pitch, -s1.Yaw, s1.Roll)));
+	glm::vec3 rotation2 = RotationVector(orientation, glm::quat(glm::vec3(s2.Pitch, -s2.Yaw, s2.Roll)));
+	glm::vec3 angularVelocity = (4.0f * rotation1 - rotation2) / (2.0f * deltaTime0); // Body frame
+	glm::vec3 velocity = glm::vec3(0.0f, (4.0f * s1.Height - 3.0f * s0.Height - s2.Height) / (2.0f * deltaTime0), 0.0f);
+	float height = s0.Height;
+
+	const glm::vec3 inertia = model.Inertia;
+	const float dimX = model.ArmLength * 0.70710678f;
+	const float dimZ = dimX;
+
+	for (int i = 0; i + 1 < problem.SegmentLength; ++i)
+	{
+		float deltaTime = GetDeltaTime(records[i], records[i + 1]);
+		GetCommands(records[i], commands);
+		float thrust[MotorModel::k_NumMotors];
+		float yawTorque = 0.0f;
+		model.Motors.Step(commands, deltaTime, thrust, yawTorque);
+
+		// Motors at FL(-x,+z) FR(+x,+z) RL(-x,-z) RR(+x,-z) pushing along the body up axis:
+		glm::vec3 torque;
+		torque.x = dimZ * (thrust[2] + thrust[3] - thrust[0] - thrust[1]);
+		torque.y = yawTorque;
+		torque.z = dimX * (thrust[1] + thrust[3] - thrust[0] - thrust[2]);
+		float totalThrust = thrust[0] + thrust[1] + thrust[2] + thrust[3];
+
+		glm::vec3 gyroscopic = glm::cross(angularVelocity, inertia * angularVelocity);
+		angularVelocity += (torque - gyroscopic) / inertia * deltaTime;
+		orientation = glm::normalize(orientation + (orientation * glm::quat(0.0f, angularVelocity.x, angularVelocity.y, angularVelocity.z)) * (0.5f * deltaTime));
+
+		glm::vec3 force = orientation * glm::vec3(0.0f, totalThrust, 0.0f);
+		force -= model.LinearDrag * velocity;
+		force -= model.QuadraticDrag * glm::length(velocity) * velocity;
+		force.y -= model.Mass * k_Gravity;
+		velocity += force * (deltaTime / model.Mass);
+		height += velocity.y * deltaTime;
+
+		const FCQuadState& target = records[i + 1].State;
+		glm::vec3 angles = glm::eulerAngles(orientation);
+		float error[4] =
+		{
+			height - target.Height,
+			WrapAngle(angles.x - target.Pitch),
+			WrapAngle(-angles.y - target.Yaw),
+			WrapAngle(angles.z - target.Roll)
+		};
+		float* r = residuals + i * 4;
+		r[0] = error[0] * settings.HeightWeight;
+		r[1] = error[1] * settings.AngleWeight;
+		r[2] = error[2] * settings.AngleWeight;
+		r[3] = error[3] * settings.AngleWeight;
+		if (cost)
+		{
+			cost->Total += (double)r[0] * r[0] + (double)r[1] * r[1] + (double)r[2] * r[2] + (double)r[3] * r[3];
+			cost->HeightSq += (double)error[0] * error[0];
+			cost->AngleSq += (double)error[1] * error[1] + (double)error[2] * error[2] + (double)error[3] * error[3];
+			cost->NumSamples++;
+		}
+	}
+}
+
+// Cost of all the segments and, if normal is set, the normal equations from a forward
+// difference Jacobian. Segments are independent and evaluated in parallel, each one
+// accumulates into its own slot so the result does not depend on the scheduling.
+static Cost Evaluate(const Problem& problem, const double* logParams, Normal* normal)
+{
+	const int numSegments = (int)problem.Segments.size();
+	const int numResiduals = (problem.SegmentLength - 1) * 4;
+	std::vector<Cost> costs(numSegments);
+	std::vector<Normal> normals(normal ? numSegments : 0);
+
+	JobSystem::Get().ParallelFor(numSegments, problem.Config->NumThreads, [&](int s)
+	{
+		Cost& cost = costs[s];
+		cost = Cost();
+		std::vector<float> residuals(numResiduals);
+		SimulateSegment(problem, problem.Segments[s], logParams, residuals.data(), &cost);
+		if (!normal)
+		{
+			return;
+		}
+
+		// Jacobian columns of this segment:
+		std::vector<float> jacobian(numResiduals * problem.NumFit);
+		std::vector<float> perturbed(numResiduals);
+		double params[Param::COUNT];
+		std::copy(logParams, logParams + Param::COUNT, params);
+		for (int j = 0; j < problem.NumFit; ++j)
+		{
+			int p = problem.FitIdx[j];
+			params[p] = logParams[p] + k_JacobianStep;
+			SimulateSegment(problem, problem.Segments[s], params, perturbed.data(), nullptr);
+			params[p] = logParams[p];
+			for (int r = 0; r < numResiduals; ++r)
+			{
+				jacobian[r * problem.NumFit + j] = (float)((perturbed[r] - residuals[r]) / k_JacobianStep);
+			}
+		}
+
+		Normal& segNormal = normals[s];
+		segNormal = Normal();
+		for (int r = 0; r < numResiduals; ++r)
+		{
+			const float* row = &jacobian[r * problem.NumFit];
+			for (int a = 0; a < problem.NumFit; ++a)
+			{
+				segNormal.Jtr[a] += (double)row[a] * residuals[r];
+				for (int b = a; b < problem.NumFit; ++b)
+				{
+					segNormal.JtJ[a][b] += (double)row[a] * row[b];
+				}
+			}
+		}
+	});
+
+	Cost total = Cost();
+	for (const Cost& cost : costs)
+	{
+		total.Total += cost.Total;
+		total.HeightSq += cost.HeightSq;
+		total.AngleSq += cost.AngleSq;
+		total.NumSamples += cost.NumSamples;
+	}
+	if (normal)
+	{
+		*normal = Normal();
+		for (const Normal& segNormal : normals)
+		{
+			for (int a = 0; a < problem.NumFit; ++a)
+			{
+				normal->Jtr[a] += segNormal.Jtr[a];
+				for (int b = a; b < problem.NumFit; ++b)
+				{
+					normal->JtJ[a][b] += segNormal.JtJ[a][b];
+				}
+			}
+		}
+		for (int a = 0; a < problem.NumFit; ++a)
+		{
+			for (int b = 0; b < a; ++b)
+			{
+				normal->JtJ[a][b] = normal->JtJ[b][a];
+			}
+		}
+	}
+	return total;
+}
+
+// Gaussian elimination with partial pivoting, the system is tiny (n <= Param::COUNT).
+static bool Solve(double a[Param::COUNT][Param::COUNT], double* b, int n)
+{
+	for (int c = 0; c < n; ++c)
+	{
+		int pivot = c;
+		for (int r = c + 1; r < n; ++r)
+		{
+			if (std::fabs(a[r][c]) > std::fabs(a[pivot][c]))
+			{
+				pivot = r;
+			}
+		}
+		if (std::fabs(a[pivot][c]) < 1e-300)
+		{
+			return false;
+		}
+		if (pivot != c)
+		{
+			for (int k = 0; k < n; ++k)
+			{
+				std::swap(a[c][k], a[pivot][k]);
+			}
+			std::swap(b[c], b[pivot]);
+		}
+		for (int r = c + 1; r < n; ++r)
+		{
+			double f = a[r][c] / a[c][c];
+			for (int k = c; k < n; ++k)
+			{
+				a[r][k] -= f * a[c][k];
+			}
+			b[r] -= f * b[c];
+		}
+	}
+	for (int r = n - 1; r >= 0; --r)
+	{
+		for (int k = r + 1; k < n; ++k)
+		{
+			b[r] -= a[r][k] * b[k];
+		}
+		b[r] /= a[r][r];
+	}
+	return true;
+}
+
+const char* Param::ToStr(T t)
+{
+	switch (t)
+	{
+	case InertiaPitch:	return "Inertia Pitch";
+	case InertiaYaw:	return "Inertia Yaw";
+	case InertiaRoll:	return "Inertia Roll";
+	case MaxThrust:		return "Max Thrust";
+	case TimeConstant:	return "Time Constant";
+	case LinearDrag:	return "Linear Drag";
+	case QuadraticDrag:	return "Quadratic Drag";
+	default:			return "Invalid";
+	}
+}
+
+Settings::Settings()
+	:SegmentLength(50)
+	,MaxIterations(50)
+	,Tolerance(1e-5f)
+	,HeightWeight(1.0f)
+	,AngleWeight(1.0f)
+	,NumThreads(0)
+{
+	for (int p = 0; p < Param::COUNT; ++p)
+	{
+		Fit[p] = true;
+	}
+}
+
+void SystemIdentification::GetParams(const Quad& quad, float* params)
+{
+	glm::vec3 inertia = quad.Inertia;
+	if (inertia == glm::vec3(0.0f))
+	{
+		// Uniform box, same as PxRigidBodyExt::updateMassAndInertia:
+		float w2 = quad.Width * quad.Width;
+		float h2 = quad.Height * quad.Height;
+		float d2 = quad.Depth * quad.Depth;
+		inertia = glm::vec3(h2 + d2, w2 + d2, w2 + h2) * (quad.Mass / 12.0f);
+	}
+	params[Param::InertiaPitch] = inertia.x;
+	params[Param::InertiaYaw] = inertia.y;
+	params[Param::InertiaRoll] = inertia.z;
+	params[Param::MaxThrust] = quad.Motors.Motor.MaxThrust;
+	params[Param::TimeConstant] = quad.Motors.Motor.TimeConstant;
+	params[Param::LinearDrag] = quad.LinearDrag;
+	params[Param::QuadraticDrag] = quad.QuadraticDrag;
+}
+
+void SystemIdentification::ApplyParams(const float* params, Quad& quad)
+{
+	quad.Inertia = glm::vec3(params[Param::InertiaPitch], params[Param::InertiaYaw], params[Param::InertiaRoll]);
+	quad.Motors.Motor.MaxThrust = params[Param::MaxThrust];
+	quad.Motors.Motor.TimeConstant = params[Param::TimeConstant];
+	quad.LinearDrag = params[Param::LinearDrag];
+	quad.QuadraticDrag = params[Param::QuadraticDrag];
+}
+
+bool SystemIdentification::Fit(const FlightLogRecord* records, int numRecords, const Quad& quad, const Settings& settings, Result& result)
+{
+	result = Result();
+	GetParams(quad, result.Params);
+
+	Problem problem;
+	problem.Records = records;
+	problem.SegmentLength = std::max(settings.SegmentLength, 3);
+	problem.Initial = &quad;
+	problem.Config = &settings;
+	problem.NumFit = 0;
+	for (int p = 0; p < Param::COUNT; ++p)
+	{
+		if (settings.Fit[p])
+		{
+			problem.FitIdx[problem.NumFit++] = p;
+		}
+	}
+
+	// Segments with the motors stopped (or commands missing from the log) say nothing:
+	for (int first = 0; first + problem.SegmentLength <= numRecords; first += problem.SegmentLength)
+	{
+		bool valid = true;
+		for (int i = first; i < first + problem.SegmentLength && valid; ++i)
+		{
+			const FCCommands& commands = records[i].Commands;
+			valid = commands.FrontLeftThr + commands.FrontRightThr + commands.RearLeftThr + commands.RearRightThr > 0.0f;
+		}
+		if (valid)
+		{
+			problem.Segments.push_back(first);
+		}
+	}
+	result.NumSegments = (int)problem.Segments.size();
+	if (problem.Segments.empty())
+	{
+		return false;
+	}
+
+	double logParams[Param::COUNT];
+	for (int p = 0; p < Param::COUNT; ++p)
+	{
+		logParams[p] = std::log(std::max(result.Params[p], 1e-9f));
+	}
+
+	Normal normal;
+	Cost cost = Evaluate(problem, logParams, problem.NumFit > 0 ? &normal : nullptr);
+	result.InitialCost = (float)cost.Total;
+
+	double lambda = 1e-3;
+	for (int iteration = 0; iteration < settings.MaxIterations && problem.NumFit > 0; ++iteration)
+	{
+		result.Iterations = iteration + 1;
+
+		// Marquardt scaling, (J^T*J + lambda * diag(J^T*J)) * step = -J^T*r:
+		double a[Param::COUNT][Param::COUNT];
+		double step[Param::COUNT];
+		for (int i = 0; i < problem.NumFit; ++i)
+		{
+			for (int j = 0; j < problem.NumFit; ++j)
+			{
+				a[i][j] = normal.JtJ[i][j];
+			}
+			a[i][i] += lambda * (normal.JtJ[i][i] + 1e-12);
+			step[i] = -normal.Jtr[i];
+		}
+		if (!Solve(a, step, problem.NumFit))
+		{
+			lambda *= 10.0;
+			continue;
+		}
+
+		double candidate[Param::COUNT];
+		std::copy(logParams, logParams + Param::COUNT, candidate);
+		for (int i = 0; i < problem.NumFit; ++i)
+		{
+			candidate[problem.FitIdx[i]] += std::min(std::max(step[i], -k_MaxStep), k_MaxStep);
+		}
+
+		Cost candidateCost = Evaluate(problem, candidate, nullptr);
+		if (std::isfinite(candidateCost.Total) && candidateCost.Total < cost.Total)
+		{
+			double decrease = (cost.Total - candidateCost.Total) / std::max(cost.Total, 1e-30);
+			std::copy(candidate, candidate + Param::COUNT, logParams);
+			lambda = std::max(lambda * 0.1, 1e-9);
+			if (decrease < settings.Tolerance)
+			{
+				cost = candidateCost;
+				result.Converged = true;
+				break;
+			}
+			cost = Evaluate(problem, logParams, &normal);
+		}
+		else
+		{
+			lambda *= 10.0;
+			if (lambda > 1e10)
+			{
+				// No step along the gradient improves, this is a minimum:
+				result.Converged = true;
+				break;
+			}
+		}
+	}
+
+	for (int p = 0; p < Param::COUNT; ++p)
+	{
+		result.Params[p] = (float)std::exp(logParams[p]);
+	}
+	result.FinalCost = (float)cost.Total;
+	result.RmsHeight = cost.NumSamples > 0 ? (float)std::sqrt(cost.HeightSq / cost.NumSamples) : 0.0f;
+	result.RmsAngle = cost.NumSamples > 0 ? (float)std::sqrt(cost.AngleSq / (3.0 * cost.NumSamples)) : 0.0f;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Replay/FlightLog.h"
+
+class Quad;
+
+// Closed loop system identification: fits the physical parameters of a Quad to a board log.
+// The log is cut in short segments, each one starts from the recorded attitude and height
+// and is integrated open loop with the recorded motor commands (the loop was closed on the
+// board, so the excitation is whatever the pilot and the controller did). Levenberg-Marquardt
+// minimizes the height and attitude error of all the segments, the parameters are fitted in
+// log space so they stay positive.
+//
+// Yaw inertia and the motor torque coefficient only show up as a ratio, the torque coefficient
+// is kept and the yaw inertia absorbs the error. Mass, size and thrust curve are not fitted.
+namespace SystemIdentification
+{
+	struct Param
+	{
+		enum T
+		{
+			InertiaPitch,	// Body x (kg*m^2)
+			InertiaYaw,		// Body y (kg*m^2)
+			InertiaRoll,	// Body z (kg*m^2)
+			MaxThrust,		// N
+			TimeConstant,	// s
+			LinearDrag,		// N/(m/s)
+			QuadraticDrag,	// N/(m/s)^2
+			COUNT
+		};
+		static const char* ToStr(T t);
+	};
+
+	struct Settings
+	{
+		Settings();
+		bool Fit[Param::COUNT];	// Parameters left out keep the value of the quad
+		int SegmentLength;		// Records per segment, short enough to not diverge open loop
+		int MaxIterations;
+		float Tolerance;		// Stop when the relative cost decrease is below this
+		float HeightWeight;		// Residual weight per meter
+		float AngleWeight;		// Residual weight per radian
+		int NumThreads;			// Threads at once on the shared JobSystem, <= 0 uses all of it
+	};
+
+	struct Result
+	{
+		float Params[Param::COUNT];
+		float InitialCost;		// Sum of squared weighted residuals
+		float FinalCost;
+		float RmsHeight;		// m
+		float RmsAngle;			// rad
+		int NumSegments;
+		int Iterations;
+		bool Converged;
+	};
+
+	// Returns false if the log is too short or has no motor commands. The quad provides the
+	// initial guess and the fixed parameters.
+	bool Fit(const FlightLogRecord* records, int numRecords, const Quad& quad, const Settings& settings, Result& result);
+
+	// Current parameters of a quad (box inertia if it has none).
+	void GetParams(const Quad& quad, float* params);
+	void ApplyParams(const float* params, Quad& quad);
+}
\ No newline at end of file
@@ -1,9 +1,13 @@
 #include "UnityFlightController.h"
 
-#ifdef _WIN32 
+#include <string.h>
+
+#ifdef FC_SIM
 	#include "Simulation.h"
 	#include <cmath>
-	#include "Graphics/UI/IMGUI/imgui.h"
+	#ifdef FC_UI
+		#include "Graphics/UI/IMGUI/imgui.h"
+	#endif
 	#include "glm/glm.hpp"
 	#define DEG_TO_RAD  0.017453292519943295769236907684886f
 	#define RAD_TO_DEG  57.295779513082320876798154814105f
@@ -19,37 +23,43 @@ UnityFlyController::UnityFlyController()
 
 void UnityFlyController::RenderUI()
 {
-#ifdef _WIN32 
+#ifdef FC_UI
 	if (ImGui::TreeNode("Height PID"))
 	{
-		ImGui::InputFloat("Set Point", &HeightSetPoint);
 		HeightPID.RenderUI();
 		ImGui::TreePop();
 	}
 	if (ImGui::TreeNode("Pitch PID"))
 	{
-		ImGui::InputFloat("Set Point", &PitchSetPoint);
 		PitchPID.RenderUI();
 		ImGui::TreePop();
 	}
 	if (ImGui::TreeNode("Roll PID"))
 	{
-		ImGui::InputFloat("Set Point", &RollSetPoint);
 		RollPID.RenderUI();
 		ImGui::TreePop();
 	}
+	if (ImGui::TreeNode("Yaw PID"))
+	{
+		YawPID.RenderUI();
+		ImGui::TreePop();
+	}
+	if (ImGui::TreeNode("Mixer"))
+	{
+		MotorMixer.RenderUI();
+		ImGui::TreePop();
+	}
 #endif
 }
 
 void UnityFlyController::Reset()
 {
-	HeightSetPoint = 0.0f;
-	RollSetPoint = 0.0f;
-	mState = State::Initial;
+	mState = State::Idle;
 
 	HeightPID.Reset();
 	PitchPID.Reset();
 	RollPID.Reset();
+	YawPID.Reset();
 }
 
 FCCommands UnityFlyController::Iterate(const FCQuadState& state, const FCSetPoints& setPoints)
@@ -57,30 +67,29 @@ FCCommands UnityFlyController::Iterate(const FCQuadState& state, const FCSetPoin
 	FCCommands commands = {};
 	memset(&commands, 0, sizeof(FCCommands));
 
-	float HeightSetPoint = 0.0f;
-	float RollSetPoint = 0.0f;
-	float PitchSetPoint = 0.0f;
-
+	// The set points (profile or sticks) arm the controller with the thrust:
 	bool runPID = false;
 	switch (mState)
 	{
-	case State::Initial:
+	case State::Idle:
 	{
-		if (state.Time > 1.5f)
+		if (setPoints.Thrust > 0.0f)
 		{
-			mState = State::Ascend;
+			mState = State::Flight;
+			runPID = true;
 		}
 		break;
 	}
-	case State::Ascend:
+	case State::Flight:
 	{
-		//PitchSetPoint = 20.0f * DEG_TO_RAD;
-		if (state.Time > 5.0f)
+		if (setPoints.Thrust <= 0.0f)
+		{
+			Reset();
+		}
+		else
 		{
-			RollSetPoint = -20.0 * DEG_TO_RAD;
+			runPID = true;
 		}
-		runPID = true;
-		HeightSetPoint = 3.0f;
 		break;
 	}
 	default:
@@ -93,39 +102,10 @@ FCCommands UnityFlyController::Iterate(const FCQuadState& state, const FCSetPoin
 	// Get PID adjustments:
 	if (runPID)
 	{
-		// Height action
-		float heightAction = 0.0f;
-		if (runPID)
-		{
-			float heightError = HeightSetPoint - state.Height;
-			heightAction = HeightPID.Get(heightError, state.DeltaTime);
-		}
-
-		// Pitch PID
-		float pitchAction = 0.0f;
-		if (runPID)
-		{
-			float pitchError = PitchSetPoint - state.Pitch;
-			pitchAction = PitchPID.Get(pitchError, state.DeltaTime);
-		}
-
-		// Roll PID
-		float rollAction = 0.0f;
-		if (runPID)
-		{
-			float rollError = RollSetPoint - state.Roll;
-			rollAction = RollPID.Get(rollError, state.DeltaTime);
-		}
-
-		pitchAction = constrain(pitchAction, -1.0f, 1.0f);
-		rollAction = constrain(rollAction, -1.0f, 1.0f);
-		heightAction = constrain(heightAction, 0.0f, 0.9f);
-
-		commands.FrontLeftThr = heightAction - rollAction - pitchAction;
-		commands.RearLeftThr = heightAction - rollAction + pitchAction;
-
-		commands.FrontRightThr = heightAction + rollAction - pitchAction;
-		commands.RearRightThr = heightAction + rollAction + pitchAction;
+		PID* pids[GainSlot::COUNT] = { &HeightPID, &PitchPID, &RollPID, &YawPID };
+		float heightAction, rollAction, pitchAction, yawAction;
+		ComputeActions(pids, state, setPoints, heightAction, rollAction, pitchAction, yawAction);
+		commands = MotorMixer.Mix(heightAction, rollAction, pitchAction, yawAction);
 	}
 
 	return commands;
@@ -136,7 +116,23 @@ void UnityFlyController::Halt()
 	//mState = State::FailSafe;
 }
 
-#ifdef _WIN32 
+void UnityFlyController::SetGainSet(const GainSet& gainSet)
+{
+	HeightPID.SetGains(gainSet.Gains[GainSlot::Height]);
+	PitchPID.SetGains(gainSet.Gains[GainSlot::Pitch]);
+	RollPID.SetGains(gainSet.Gains[GainSlot::Roll]);
+	YawPID.SetGains(gainSet.Gains[GainSlot::Yaw]);
+}
+
+void UnityFlyController::GetGainSet(GainSet& gainSet) const
+{
+	gainSet.Gains[GainSlot::Height] = HeightPID.GetGains();
+	gainSet.Gains[GainSlot::Pitch] = PitchPID.GetGains();
+	gainSet.Gains[GainSlot::Roll] = RollPID.GetGains();
+	gainSet.Gains[GainSlot::Yaw] = YawPID.GetGains();
+}
+
+#ifdef FC_SIM
 void UnityFlyController::QuerySimState(SimulationFrame* simFrame)
 {
 	simFrame->HeightPIDState.P = HeightPID.LastP;
@@ -151,4 +147,36 @@ void UnityFlyController::QuerySimState(SimulationFrame* simFrame)
 	simFrame->RollPIDState.I = RollPID.LastI;
 	simFrame->RollPIDState.D = RollPID.LastD;
 }
-#endif
+
+void UnityFlyController::SaveState(FCSnapshot& snapshot) const
+{
+	static_assert(sizeof(SavedState) <= FCSnapshot::k_MaxSize, "Controller state does not fit in a snapshot");
+	SavedState saved;
+	saved.Mode = mState;
+	saved.HeightPID = HeightPID.GetState();
+	saved.PitchPID = PitchPID.GetState();
+	saved.RollPID = RollPID.GetState();
+	saved.YawPID = YawPID.GetState();
+	memcpy(snapshot.Data, &saved, sizeof(saved));
+}
+
+void UnityFlyController::LoadState(const FCSnapshot& snapshot)
+{
+	SavedState saved;
+	memcpy(&saved, snapshot.Data, sizeof(saved));
+	mState = saved.Mode;
+	HeightPID.SetState(saved.HeightPID);
+	PitchPID.SetState(saved.PitchPID);
+	RollPID.SetState(saved.RollPID);
+	YawPID.SetState(saved.YawPID);
+}
+
+void UnityFlyController::SaveSettings(FCSnapshot& settings) const
+{
+	static_assert(sizeof(SavedSettings) <= FCSnapshot::k_MaxSize, "Controller settings do not fit in a snapshot");
+	SavedSettings saved;
+	saved.Frame = (uint8_t)MotorMixer.GetFrame();
+	saved.AirMode = MotorMixer.AirMode ? 1 : 0;
+	memcpy(settings.Data, &saved, sizeof(saved));
+}
+#endif
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "CommonFlyController.h"
+#include "DefaultGainSet.h"
+#include "Mixer.h"
 
 class UnityFlyController : public BaseFlyController
 {
@@ -10,27 +12,57 @@ public:
 	void Reset() override;
 	FCCommands Iterate(const FCQuadState& state, const FCSetPoints& setPoints) override;
 	void Halt() override; 
+	void SetGainSet(const GainSet& gainSet) override;
+	void GetGainSet(GainSet& gainSet)const override;
 
-#ifdef _WIN32 
+#ifdef FC_SIM
 	void QuerySimState(SimulationFrame* simFrame) override;
+	void SaveState(FCSnapshot& snapshot)const override;
+	void LoadState(const FCSnapshot& snapshot) override;
+	void SaveSettings(FCSnapshot& settings)const override;
 #endif
 
-	float HeightSetPoint;
-	float PitchSetPoint;
-	float RollSetPoint;
-	PID HeightPID = PID(0.5f, 0.0f, 0.2f);
-	PID PitchPID = PID(0.121f, 0.0f, 0.016f);
-	PID RollPID = PID(0.121f, 0.0f, 0.016f);
+	// Flight law of Iterate(), see QuadFlyController::ComputeActions. The height PID gives the
+	// thrust, the yaw PID holds the yaw against the reaction torque of the motors.
+	template<typename Scalar>
+	static void ComputeActions(PIDT<Scalar>* const* pids, const FCQuadStateT<Scalar>& state, const FCSetPointsT<Scalar>& setPoints, Scalar& thrust, Scalar& roll, Scalar& pitch, Scalar& yaw)
+	{
+		thrust = pids[GainSlot::Height]->Get(setPoints.Height, state.Height, 0.0f, state.DeltaTime);
+		pitch = pids[GainSlot::Pitch]->Get(setPoints.Pitch, state.Pitch, 0.0f, state.DeltaTime);
+		roll = pids[GainSlot::Roll]->Get(setPoints.Roll, state.Roll, 0.0f, state.DeltaTime);
+		yaw = pids[GainSlot::Yaw]->Get(setPoints.Yaw, state.Yaw, 0.0f, state.DeltaTime);
+	}
+
+	PID HeightPID = PID(k_DefaultGainSet.Gains[GainSlot::Height]);
+	PID PitchPID = PID(k_DefaultGainSet.Gains[GainSlot::Pitch]);
+	PID RollPID = PID(k_DefaultGainSet.Gains[GainSlot::Roll]);
+	PID YawPID = PID(k_DefaultGainSet.Gains[GainSlot::Yaw]);
+	Mixer MotorMixer;
 
 private:
 	struct State
 	{
 		enum T
 		{
-			Initial,
-			Ascend,
-			Traverse
+			Idle,
+			Flight
 		};
 	};
 	State::T mState;   // State of the flight controller
+
+#ifdef FC_SIM
+	// Layout of the snapshot data:
+	struct SavedState
+	{
+		State::T Mode;
+		PID::State HeightPID, PitchPID, RollPID, YawPID;
+	};
+
+	// Layout of the settings data, no padding:
+	struct SavedSettings
+	{
+		uint8_t Frame;
+		uint8_t AirMode;
+	};
+#endif
 };
\ No newline at end of file
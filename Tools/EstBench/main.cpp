@@ -0,0 +1,181 @@
+// Attitude estimator benchmark and reference check, replays recorded IMU traces (quadsim
+// --imu-trace) through a fresh AttitudeEstimator:
+//   estbench [options] <trace.imu>
+// Exit code 0 if the outputs match the golden file (or there is none), 1 if they do not and
+// 2 on invalid arguments/inputs.
+
+#include "Sensors/ImuTrace.h"
+#include "AttitudeEstimator.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static const int k_ExitPassed = 0;
+static const int k_ExitFailed = 1;
+static const int k_ExitError = 2;
+
+struct Attitude
+{
+	float Yaw;
+	float Pitch;
+	float Roll;
+};
+
+static void PrintUsage()
+{
+	fprintf(stderr,
+		"Usage: estbench [options] <trace.imu>\n"
+		"  --iterations <n>     Replays of the trace for the timing (default 1000)\n"
+		"  --golden <file>      Compare the outputs with this reference (yaw,pitch,roll per entry)\n"
+		"  --tolerance <deg>    Largest difference allowed against the reference (default 1e-4)\n"
+		"  --write-golden <file> Write the outputs as the new reference\n");
+}
+
+static void Replay(const ImuTrace& trace, std::vector<Attitude>& outputs)
+{
+	AttitudeEstimator estimator;
+	for (size_t e = 0; e < trace.Entries.size(); ++e)
+	{
+		const ImuTrace::Entry& entry = trace.Entries[e];
+		Attitude& out = outputs[e];
+		estimator.Update(entry.NewSample ? entry.Accel : nullptr, entry.NewSample ? entry.Gyro : nullptr, entry.DeltaTime, out.Yaw, out.Pitch, out.Roll);
+	}
+}
+
+static bool LoadGolden(const std::string& path, std::vector<Attitude>& golden)
+{
+	FILE* file = fopen(path.c_str(), "r");
+	if (!file)
+	{
+		return false;
+	}
+	char line[256];
+	bool valid = fgets(line, sizeof(line), file) && strncmp(line, "yaw,pitch,roll", 14) == 0;
+	while (valid && fgets(line, sizeof(line), file))
+	{
+		Attitude attitude;
+		valid = sscanf(line, "%g,%g,%g", &attitude.Yaw, &attitude.Pitch, &attitude.Roll) == 3;
+		golden.push_back(attitude);
+	}
+	fclose(file);
+	return valid;
+}
+
+static bool WriteGolden(const std::string& path, const std::vector<Attitude>& outputs)
+{
+	FILE* file = fopen(path.c_str(), "w");
+	if (!file)
+	{
+		return false;
+	}
+	fprintf(file, "yaw,pitch,roll\n");
+	for (const Attitude& attitude : outputs)
+	{
+		fprintf(file, "%.9g,%.9g,%.9g\n", attitude.Yaw, attitude.Pitch, attitude.Roll);
+	}
+	return fclose(file) == 0;
+}
+
+int main(int argc, char** argv)
+{
+	std::string tracePath;
+	std::string goldenPath;
+	std::string writeGoldenPath;
+	int numIterations = 1000;
+	float tolerance = 1e-4f;
+	for (int a = 1; a < argc; ++a)
+	{
+		const char* arg = argv[a];
+		bool hasValue = a + 1 < argc;
+		if (strcmp(arg, "--iterations") == 0 && hasValue)			numIterations = atoi(argv[++a]);
+		else if (strcmp(arg, "--golden") == 0 && hasValue)			goldenPath = argv[++a];
+		else if (strcmp(arg, "--tolerance") == 0 && hasValue)		tolerance = (float)atof(argv[++a]);
+		else if (strcmp(arg, "--write-golden") == 0 && hasValue)	writeGoldenPath = argv[++a];
+		else if (arg[0] == '-' || !tracePath.empty())
+		{
+			PrintUsage();
+			return k_ExitError;
+		}
+		else
+		{
+			tracePath = arg;
+		}
+	}
+	if (tracePath.empty() || numIterations <= 0 || tolerance < 0.0f)
+	{
+		PrintUsage();
+		return k_ExitError;
+	}
+
+	ImuTrace trace;
+	std::string error;
+	if (!trace.LoadFromFile(tracePath, &error))
+	{
+		fprintf(stderr, "%s\n", error.c_str());
+		return k_ExitError;
+	}
+	std::vector<Attitude> golden;
+	if (!goldenPath.empty() && !LoadGolden(goldenPath, golden))
+	{
+		fprintf(stderr, "Could not read the golden outputs %s\n", goldenPath.c_str());
+		return k_ExitError;
+	}
+
+	// Every replay starts from a fresh estimator, the outputs of the last one are checked:
+	std::vector<Attitude> outputs(trace.Entries.size());
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < numIterations; ++i)
+	{
+		Replay(trace, outputs);
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	const double numUpdates = (double)numIterations * (double)trace.Entries.size();
+	printf("%d updates x %d: %.2f ns/update, %.1f M updates/s\n", (int)trace.Entries.size(), numIterations,
+		seconds * 1e9 / numUpdates, numUpdates / seconds * 1e-6);
+
+	if (!writeGoldenPath.empty())
+	{
+		if (!WriteGolden(writeGoldenPath, outputs))
+		{
+			fprintf(stderr, "Could not write %s\n", writeGoldenPath.c_str());
+			return k_ExitError;
+		}
+		printf("Wrote %s\n", writeGoldenPath.c_str());
+	}
+	if (goldenPath.empty())
+	{
+		return k_ExitPassed;
+	}
+
+	if (golden.size() != outputs.size())
+	{
+		printf("FAIL %d outputs, the reference has %d\n", (int)outputs.size(), (int)golden.size());
+		return k_ExitFailed;
+	}
+	float maxError = 0.0f;
+	int firstMismatch = -1;
+	for (size_t e = 0; e < outputs.size(); ++e)
+	{
+		const float diff = std::fmax(std::fabs(outputs[e].Yaw - golden[e].Yaw), std::fmax(std::fabs(outputs[e].Pitch - golden[e].Pitch), std::fabs(outputs[e].Roll - golden[e].Roll)));
+		// NaN never compares, it is a mismatch too:
+		if (!(diff <= tolerance) && firstMismatch < 0)
+		{
+			firstMismatch = (int)e;
+		}
+		maxError = std::fmax(maxError, diff);
+	}
+	if (firstMismatch >= 0)
+	{
+		const Attitude& out = outputs[firstMismatch];
+		const Attitude& ref = golden[firstMismatch];
+		printf("FAIL entry %d: %g %g %g, expected %g %g %g (max error %g deg)\n", firstMismatch, out.Yaw, out.Pitch, out.Roll, ref.Yaw, ref.Pitch, ref.Roll, maxError);
+		return k_ExitFailed;
+	}
+	printf("PASS max error %g deg\n", maxError);
+	return k_ExitPassed;
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+// Decodes the flight recorder and black box dumps of a board serial capture (see DumpRecorder
+// and DumpBlackBox in Board/src/main.cpp), the last ones if there are several:
+//   flightrec [options] <capture>
+// Writes <name>.qelg, the records as a binary flight log for the replay, and the samples
+// resampled as simulation frames for plotting: <name>.csv/.qcol from the recorder and
+// <name>_blackbox.csv/.qcol from the black box. Prints the black box report. Exit code 0 on
+// success, 1 if the capture has no dump or corrupt blocks (the files are still written) and 2
+// on invalid arguments/IO errors.
+
+#include "Replay/FlightLog.h"
+#include "ResultFile.h"
+#include "IO/Directory.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+static const int k_ExitPassed = 0;
+static const int k_ExitFailed = 1;
+static const int k_ExitError = 2;
+
+static void PrintUsage()
+{
+	fprintf(stderr,
+		"Usage: flightrec [options] <capture>\n"
+		"  --out <dir>          Existing output directory (default .)\n"
+		"  --name <name>        Output file names (default flight)\n"
+		"  --dt <s>             Frame interval of the resampled frames (default 0.01)\n");
+}
+
+int main(int argc, char** argv)
+{
+	std::string capturePath;
+	std::string outDir = ".";
+	std::string name = "flight";
+	float deltaTime = 0.01f;
+	for (int a = 1; a < argc; ++a)
+	{
+		const char* arg = argv[a];
+		bool hasValue = a + 1 < argc;
+		if (strcmp(arg, "--out") == 0 && hasValue)			outDir = argv[++a];
+		else if (strcmp(arg, "--name") == 0 && hasValue)	name = argv[++a];
+		else if (strcmp(arg, "--dt") == 0 && hasValue)		deltaTime = (float)atof(argv[++a]);
+		else if (arg[0] == '-' || !capturePath.empty())
+		{
+			PrintUsage();
+			return k_ExitError;
+		}
+		else
+		{
+			capturePath = arg;
+		}
+	}
+	if (capturePath.empty() || deltaTime <= 0.0f)
+	{
+		PrintUsage();
+		return k_ExitError;
+	}
+
+	FlightLog log;
+	log.Open(capturePath);
+	const FlightLog::Dump* dumps[2] = { &log.GetRecorderDump(), &log.GetBlackBoxDump() };
+	const char* suffixes[2] = { "", "_blackbox" };
+	const char* labels[2] = { "Recorder", "Black box" };
+	if (dumps[0]->Samples.empty() && dumps[1]->Samples.empty())
+	{
+		fprintf(stderr, "No flight recorder or black box dump in %s\n", capturePath.c_str());
+		return k_ExitFailed;
+	}
+
+	bool ioFailed = !FlightLog::Write(Directory::Join(outDir, name + ".qelg"), log.GetRecords(), log.GetNumRecords());
+	int numCorrupt = 0;
+	for (int d = 0; d < 2; ++d)
+	{
+		const std::vector<FlightSample>& samples = dumps[d]->Samples;
+		numCorrupt += dumps[d]->NumCorruptBlocks;
+		if (samples.empty())
+		{
+			continue;
+		}
+		SimulationResult result;
+		FlightLog::ToSimulationResult(samples, deltaTime, result);
+		ioFailed |= !ResultFile::WriteCsv(Directory::Join(outDir, name + suffixes[d] + ".csv"), result);
+		ioFailed |= !ResultFile::WriteColumns(Directory::Join(outDir, name + suffixes[d] + ".qcol"), result);
+
+		const float duration = (float)(samples.back().TimeUs - samples[0].TimeUs) * 1e-6f;
+		printf("%s: %d samples, %.3f s to %.3f s (%.2f s), %d frames, %d corrupt blocks\n", labels[d], (int)samples.size(),
+			samples[0].TimeUs * 1e-6f, samples.back().TimeUs * 1e-6f, duration, (int)result.Frames.size(), dumps[d]->NumCorruptBlocks);
+	}
+	if (ioFailed)
+	{
+		fprintf(stderr, "Could not write the decoded flight to %s\n", outDir.c_str());
+		return k_ExitError;
+	}
+
+	BlackBox::Report report;
+	if (log.GetBlackBoxReport(report))
+	{
+		printf("Black box: %s at %.3f s\n", HaltReason::ToStr((HaltReason::T)report.Reason), report.TriggerTimeUs * 1e-6f);
+		printf("  %u loops, %u/%u/%u us min/mean/max, %u over %u us\n", report.NumLoops, report.LoopMinUs, report.LoopMeanUs, report.LoopMaxUs,
+			report.NumOverruns, BlackBox::k_OverrunUs);
+		printf("  Black box cost per loop: %u us mean, %u us max\n", report.RecordMeanUs, report.RecordMaxUs);
+	}
+	else if (!dumps[1]->Samples.empty())
+	{
+		printf("Black box report missing or corrupt\n");
+		++numCorrupt;
+	}
+	return numCorrupt > 0 ? k_ExitFailed : k_ExitPassed;
+}
\ No newline at end of file
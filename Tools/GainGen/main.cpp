@@ -0,0 +1,35 @@
+// Emits the constexpr gain table the firmware builds with:
+//   GainGen <input.gainset> <output.h> [name]
+// The default name is k_DefaultGainSet (Board/lib/QuadFlyController/src/DefaultGainSet.h).
+
+#include "GainSetIO.h"
+
+#include <cstdio>
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		fprintf(stderr, "Usage: GainGen <input.gainset> <output.h> [name]\n");
+		return 1;
+	}
+
+	GainSet gainSet;
+	std::string error;
+	if (!GainSetIO::Load(argv[1], gainSet, &error))
+	{
+		fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	std::string source = argv[1];
+	size_t start = source.find_last_of("/\\");
+	source = start == std::string::npos ? source : source.substr(start + 1);
+	const char* name = argc > 3 ? argv[3] : "k_DefaultGainSet";
+	if (!GainSetIO::WriteHeader(argv[2], gainSet, name, source))
+	{
+		fprintf(stderr, "Could not write %s\n", argv[2]);
+		return 1;
+	}
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,287 @@
+// Gain tuning of a scenario, gradient based (see Source/Optimize/GainOptimizer.h) or CMA-ES
+// (Source/Optimize/EvolutionOptimizer.h):
+//   gainopt [options] <scenario> <output.gainset>
+// Starts from the scenario gains, prints the cost per iteration and flies the scenario with the
+// full simulation before and after, the expectations are checked on that run. Exit code 0 if
+// the optimized gains pass, 1 if they fail (or the gradient check does) and 2 on invalid
+// arguments/inputs.
+
+#include "Optimize/EvolutionOptimizer.h"
+#include "Optimize/GainOptimizer.h"
+#include "GainSetIO.h"
+#include "Jobs/JobSystem.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static const int k_ExitPassed = 0;
+static const int k_ExitFailed = 1;
+static const int k_ExitError = 2;
+
+static void PrintUsage()
+{
+	fprintf(stderr,
+		"Usage: gainopt [options] <scenario> <output.gainset>\n"
+		"  --airframe <file>    Fly with this airframe instead of the scenario one\n"
+		"  --method <m>         adam, lbfgs or cmaes (default lbfgs)\n"
+		"  --iterations <n>     Max iterations, generations with cmaes (default 30)\n"
+		"  --rate <r>           Adam learning rate, log space (default 0.1)\n"
+		"  --height <w>         Weight of the height error, m^2 against deg^2 (default 100)\n"
+		"  --effort <w>         Weight of the motor command changes (default 1000), PID output changes with cmaes (default 50)\n"
+		"  --check              Compare the gradient with central differences at the start gains, fails above the tolerance\n"
+		"  --check-tolerance <e> Relative error allowed per gain (default 0.02)\n"
+		"  --check-step <h>     Central difference step, log space (default 0.001)\n"
+		"CMA-ES:\n"
+		"  --population <n>     Candidates per generation (default 4 + 3 ln(parameters))\n"
+		"  --sigma <s>          Initial step size, log space (default 0.3)\n"
+		"  --seeds <n>          Run seeds of the disturbance set (default 4)\n"
+		"  --gusts <m/s>        Fly the disturbance set with gusts of this intensity\n"
+		"  --robust <w>         0 optimizes the mean over the seeds, 1 the worst (default 0.5)\n"
+		"  --fail <c>           Cost added when an expectation fails (default 100)\n"
+		"  --arm <file>         Also optimize the arm length, the airframe is written to the file\n"
+		"  --threads <n>        Worker threads (default all the hardware threads)\n"
+		"  --checkpoint <file>  Resume from the file if it exists, written after every generation\n");
+}
+
+// Evolution strategy run, writes the optimized gains (and airframe) into the job.
+static bool RunEvolution(EvolutionOptimizer& evolution, BatchJob& job, int maxGenerations, const std::string& checkpointPath, const std::string& armPath)
+{
+	evolution.Init(job);
+	evolution.SetParameters(EvolutionOptimizer::GetDefaultParameters(job.Scn.Control, !armPath.empty()));
+	const std::vector<EvolutionOptimizer::Parameter>& parameters = evolution.GetParameters();
+	const std::vector<float> start = evolution.GetStartValues();
+
+	std::string error;
+	FILE* checkpoint = checkpointPath.empty() ? nullptr : fopen(checkpointPath.c_str(), "r");
+	if (checkpoint)
+	{
+		fclose(checkpoint);
+		if (!evolution.LoadCheckpoint(checkpointPath, &error))
+		{
+			fprintf(stderr, "%s\n", error.c_str());
+			return false;
+		}
+		printf("Resumed at generation %i\n", evolution.GetGeneration());
+	}
+
+	std::vector<float> startCost;
+	evolution.Evaluate(std::vector<std::vector<float>>(1, start), startCost);
+	printf("Start cost %.5f\n", startCost[0]);
+
+	const int firstGeneration = (int)evolution.GetHistory().size();
+	const auto runStart = std::chrono::steady_clock::now();
+	if (!evolution.Run(maxGenerations, checkpointPath))
+	{
+		fprintf(stderr, "No candidate had a finite cost\n");
+		return false;
+	}
+	const double runMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - runStart).count();
+	const std::vector<EvolutionOptimizer::Generation>& history = evolution.GetHistory();
+	for (size_t g = firstGeneration; g < history.size(); ++g)
+	{
+		printf("%3i: best %10.5f  median %10.5f  sigma %8.5f  (%i candidates)\n", (int)g, history[g].BestCost, history[g].MedianCost, history[g].Sigma, history[g].Evaluations);
+	}
+	const int numRuns = history.empty() ? 0 : history.back().Evaluations * std::max(evolution.NumSeeds, 1);
+	printf("CMA-ES: cost %.5f after %i runs, %.1f ms\n", evolution.GetBestCost(), numRuns, runMs);
+
+	const std::vector<float>& best = evolution.GetBestValues();
+	for (size_t p = 0; p < parameters.size(); ++p)
+	{
+		printf("  %-14s  %.5f -> %.5f\n", EvolutionOptimizer::ToStr(parameters[p]).c_str(), EvolutionOptimizer::ToValue(start[p]), EvolutionOptimizer::ToValue(best[p]));
+	}
+
+	job = evolution.ToJob(best);
+	if (!armPath.empty() && !QuadProfileIO::Save(armPath, job.Airframe))
+	{
+		fprintf(stderr, "Could not write %s\n", armPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+// Forward mode gradient against central differences at the start gains, false if the relative
+// error of a gain is above the tolerance. The error of a gain is relative to the larger of its
+// two values, but at least a tenth of the largest component: the gains that barely change the
+// cost only carry the rounding and truncation error of the differences.
+static bool CheckGradient(GainOptimizer& optimizer, const BatchJob& job, float step, float tolerance)
+{
+	optimizer.Init(job);
+	const std::vector<GainOptimizer::Parameter>& parameters = optimizer.GetParameters();
+	const std::vector<float> start = optimizer.GetStartValues();
+
+	auto checkStart = std::chrono::steady_clock::now();
+	std::vector<float> autodiff, numeric;
+	const float cost = optimizer.Evaluate(start, &autodiff);
+	const double autodiffMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - checkStart).count();
+	checkStart = std::chrono::steady_clock::now();
+	optimizer.FiniteDifferences(start, step, numeric);
+	const double numericMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - checkStart).count();
+	printf("Gradient check, cost %.5f (autodiff %.1f ms, %i rollouts of central differences %.1f ms)\n", cost, autodiffMs, 2 * (int)start.size(), numericMs);
+
+	float largest = 0.0f;
+	for (size_t p = 0; p < parameters.size(); ++p)
+	{
+		largest = std::max(largest, std::max(std::fabs(autodiff[p]), std::fabs(numeric[p])));
+	}
+	bool passed = std::isfinite(cost);
+	for (size_t p = 0; p < parameters.size(); ++p)
+	{
+		const float scale = std::max(std::max(std::fabs(autodiff[p]), std::fabs(numeric[p])), 0.1f * largest);
+		const float error = scale > 0.0f ? std::fabs(autodiff[p] - numeric[p]) / scale : 0.0f;
+		const bool gainPassed = error <= tolerance;
+		printf("  %-6s %s  autodiff %12.6f  numeric %12.6f  rel error %.2e%s\n", GainSlot::ToStr(parameters[p].Slot), GainOptimizer::Term::ToStr(parameters[p].Gain), autodiff[p], numeric[p], error, gainPassed ? "" : "  FAIL");
+		passed = passed && gainPassed;
+	}
+	printf("Gradient check: %s (tolerance %.2e)\n", passed ? "PASS" : "FAIL", tolerance);
+	return passed;
+}
+
+// Gradient based run, writes the optimized gains into the job.
+static bool RunGradient(GainOptimizer& optimizer, BatchJob& job, GainOptimizer::Method::T method, int maxIterations)
+{
+	optimizer.Init(job);
+	const std::vector<GainOptimizer::Parameter>& parameters = optimizer.GetParameters();
+	const std::vector<float> start = optimizer.GetStartValues();
+
+	const auto runStart = std::chrono::steady_clock::now();
+	if (!optimizer.Run(method, maxIterations))
+	{
+		fprintf(stderr, "The cost is not finite with the start gains\n");
+		return false;
+	}
+	const double runMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - runStart).count();
+	for (size_t i = 0; i < optimizer.GetHistory().size(); ++i)
+	{
+		const GainOptimizer::Iteration& iteration = optimizer.GetHistory()[i];
+		printf("%3i: cost %10.5f  gradient %10.6f  (%i rollouts)\n", (int)i, iteration.Cost, iteration.GradientNorm, iteration.Evaluations);
+	}
+	const int numRollouts = optimizer.GetHistory().empty() ? 0 : optimizer.GetHistory().back().Evaluations;
+	printf("%s: cost %.5f in %i rollouts, %.1f ms\n", GainOptimizer::Method::ToStr(method), optimizer.GetBestCost(), numRollouts, runMs);
+
+	const std::vector<float>& best = optimizer.GetBestValues();
+	for (size_t p = 0; p < parameters.size(); ++p)
+	{
+		printf("  %-6s %s  %.5f -> %.5f\n", GainSlot::ToStr(parameters[p].Slot), GainOptimizer::Term::ToStr(parameters[p].Gain), std::exp(start[p]), std::exp(best[p]));
+	}
+
+	job.Gains = optimizer.ToGainSet(best);
+	job.HasGains = true;
+	return true;
+}
+
+static void PrintMetrics(const char* label, const BatchResult& result)
+{
+	printf("%s: %s", label, result.Passed ? "PASS" : "FAIL");
+	for (int m = 0; m < Scenario::Metric::COUNT; ++m)
+	{
+		printf(" %s=%.3f", Scenario::Metric::ToStr((Scenario::Metric::T)m), result.Metrics[m]);
+	}
+	printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> paths;
+	std::string airframePath;
+	std::string checkpointPath;
+	std::string armPath;
+	GainOptimizer::Method::T method = GainOptimizer::Method::LBFGS;
+	bool evolve = false;
+	int maxIterations = 30;
+	bool check = false;
+	float checkTolerance = 2e-2f;
+	float checkStep = 1e-3f;
+	GainOptimizer optimizer;
+	EvolutionOptimizer evolution;
+
+	for (int a = 1; a < argc; ++a)
+	{
+		const char* arg = argv[a];
+		bool hasValue = a + 1 < argc;
+		if (strcmp(arg, "--airframe") == 0 && hasValue)			airframePath = argv[++a];
+		else if (strcmp(arg, "--iterations") == 0 && hasValue)	maxIterations = atoi(argv[++a]);
+		else if (strcmp(arg, "--rate") == 0 && hasValue)		optimizer.LearningRate = (float)atof(argv[++a]);
+		else if (strcmp(arg, "--height") == 0 && hasValue)		optimizer.HeightWeight = evolution.HeightWeight = (float)atof(argv[++a]);
+		else if (strcmp(arg, "--effort") == 0 && hasValue)		optimizer.EffortWeight = evolution.EffortWeight = (float)atof(argv[++a]);
+		else if (strcmp(arg, "--check") == 0)					check = true;
+		else if (strcmp(arg, "--check-tolerance") == 0 && hasValue)	checkTolerance = (float)atof(argv[++a]);
+		else if (strcmp(arg, "--check-step") == 0 && hasValue)	checkStep = (float)atof(argv[++a]);
+		else if (strcmp(arg, "--population") == 0 && hasValue)	evolution.PopulationSize = atoi(argv[++a]);
+		else if (strcmp(arg, "--sigma") == 0 && hasValue)		evolution.Sigma = (float)atof(argv[++a]);
+		else if (strcmp(arg, "--seeds") == 0 && hasValue)		evolution.NumSeeds = atoi(argv[++a]);
+		else if (strcmp(arg, "--gusts") == 0 && hasValue)		evolution.GustIntensity = (float)atof(argv[++a]);
+		else if (strcmp(arg, "--robust") == 0 && hasValue)		evolution.RobustWeight = (float)atof(argv[++a]);
+		else if (strcmp(arg, "--fail") == 0 && hasValue)		evolution.FailPenalty = (float)atof(argv[++a]);
+		else if (strcmp(arg, "--arm") == 0 && hasValue)			armPath = argv[++a];
+		else if (strcmp(arg, "--threads") == 0 && hasValue)		evolution.NumThreads = atoi(argv[++a]);
+		else if (strcmp(arg, "--checkpoint") == 0 && hasValue)	checkpointPath = argv[++a];
+		else if (strcmp(arg, "--method") == 0 && hasValue)
+		{
+			const char* name = argv[++a];
+			if (strcmp(name, "adam") == 0)			method = GainOptimizer::Method::Adam;
+			else if (strcmp(name, "lbfgs") == 0)	method = GainOptimizer::Method::LBFGS;
+			else if (strcmp(name, "cmaes") == 0)	evolve = true;
+			else
+			{
+				PrintUsage();
+				return k_ExitError;
+			}
+		}
+		else if (arg[0] == '-')
+		{
+			PrintUsage();
+			return k_ExitError;
+		}
+		else
+		{
+			paths.push_back(arg);
+		}
+	}
+	if (paths.size() != 2 || maxIterations <= 0 || !(checkTolerance > 0.0f) || !(checkStep > 0.0f) || (evolve && check) || (!evolve && (!armPath.empty() || !checkpointPath.empty())))
+	{
+		PrintUsage();
+		return k_ExitError;
+	}
+
+	JobSystem::Settings jobSettings;
+	jobSettings.NumThreads = evolution.NumThreads;
+	JobSystem::Configure(jobSettings);
+
+	Scenario scenario;
+	BatchJob job;
+	std::string error;
+	if (!scenario.LoadFromFile(paths[0], &error) || !BatchRunner::PrepareJob(scenario, airframePath, job, &error))
+	{
+		fprintf(stderr, "%s: %s\n", paths[0].c_str(), error.c_str());
+		return k_ExitError;
+	}
+	BatchResult before;
+	BatchRunner::RunJob(job, before);
+	PrintMetrics("Start", before);
+
+	// No point optimizing along a gradient that does not match the simulation:
+	if (check && !CheckGradient(optimizer, job, checkStep, checkTolerance))
+	{
+		return k_ExitFailed;
+	}
+	const bool optimized = evolve ? RunEvolution(evolution, job, maxIterations, checkpointPath, armPath) : RunGradient(optimizer, job, method, maxIterations);
+	if (!optimized)
+	{
+		return k_ExitError;
+	}
+	BatchResult after;
+	BatchRunner::RunJob(job, after);
+	PrintMetrics("Optimized", after);
+
+	if (!GainSetIO::Save(paths[1], job.Gains))
+	{
+		fprintf(stderr, "Could not write %s\n", paths[1].c_str());
+		return k_ExitError;
+	}
+	return after.Passed ? k_ExitPassed : k_ExitFailed;
+}
\ No newline at end of file
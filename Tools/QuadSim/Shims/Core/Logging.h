@@ -0,0 +1,7 @@
+#pragma once
+
+// Headless builds do not link the engine, the log macros go to stderr instead.
+#include <cstdio>
+
+#define INFO(...) do { fprintf(stderr, __VA_ARGS__); fputc('\n', stderr); } while (0)
+#define ERR(...) do { fprintf(stderr, "Error: "); fprintf(stderr, __VA_ARGS__); fputc('\n', stderr); } while (0)
\ No newline at end of file
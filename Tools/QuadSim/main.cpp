@@ -0,0 +1,246 @@
+// Headless batch runner, flies scenarios with the rigid body backend:
+//   quadsim [options] <scenario>...
+// Every scenario runs once per --airframe (or with its own airframe if there is none).
+// Exit code 0 if every expectation passed, 1 if any failed (or a determinism check found
+// different results) and 2 on invalid arguments/inputs.
+
+#include "Batch/BatchRunner.h"
+#include "Batch/ResultWriter.h"
+#include "ResultFile.h"
+#include "ResultCache.h"
+#include "IO/Directory.h"
+#include "Jobs/JobSystem.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+
+static const int k_ExitPassed = 0;
+static const int k_ExitFailed = 1;
+static const int k_ExitError = 2;
+
+static void PrintUsage()
+{
+	fprintf(stderr,
+		"Usage: quadsim [options] <scenario>...\n"
+		"  --airframe <file>    Fly every scenario with this airframe, repeatable\n"
+		"  --jobs <n>           Simulations in parallel, 0 uses all the hardware threads (default 1)\n"
+		"  --pin                Pin the workers to the CPUs, ordered by NUMA node (Linux)\n"
+		"  --worker-stats       Print the tasks, steals and utilization of every worker\n"
+		"  --out <dir>          Existing output directory (default .)\n"
+		"  --format <f>         Per run files: csv, col, both or none (default both)\n"
+		"  --summary <file>     Summary JSON (default <out>/summary.json)\n"
+		"  --cache <dir>        Load runs with the same inputs from this result cache, store new ones\n"
+		"  --cache-size <MB>    Cache size cap (default 512)\n"
+		"  --check-determinism  Run everything again on one thread without the cache and compare\n"
+		"                       the frame checksums, also verifies the cached results\n"
+		"  --imu-trace          Also write the attitude estimator inputs of the runs with emulated\n"
+		"                       sensors (<run>.imu, see Tools/EstBench), those skip the cache lookups\n"
+		"  --quiet              Only report failures\n");
+}
+
+// Scenario and airframe names as a file name.
+static std::string RunFileName(const BatchResult& result)
+{
+	std::string name = result.ScenarioName + "_" + result.AirframeName;
+	for (char& c : name)
+	{
+		bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_';
+		c = valid ? c : '_';
+	}
+	return name;
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> scenarioPaths;
+	std::vector<std::string> airframePaths;
+	int numJobs = 1;
+	std::string outDir = ".";
+	std::string format = "both";
+	std::string summaryPath;
+	bool quiet = false;
+	bool imuTrace = false;
+	bool checkDeterminism = false;
+	bool pin = false;
+	bool workerStats = false;
+	std::string cacheDir;
+	int cacheSizeMB = 512;
+
+	for (int a = 1; a < argc; ++a)
+	{
+		const char* arg = argv[a];
+		bool hasValue = a + 1 < argc;
+		if (strcmp(arg, "--airframe") == 0 && hasValue)		airframePaths.push_back(argv[++a]);
+		else if (strcmp(arg, "--jobs") == 0 && hasValue)	numJobs = atoi(argv[++a]);
+		else if (strcmp(arg, "--out") == 0 && hasValue)		outDir = argv[++a];
+		else if (strcmp(arg, "--format") == 0 && hasValue)	format = argv[++a];
+		else if (strcmp(arg, "--summary") == 0 && hasValue)	summaryPath = argv[++a];
+		else if (strcmp(arg, "--cache") == 0 && hasValue)	cacheDir = argv[++a];
+		else if (strcmp(arg, "--cache-size") == 0 && hasValue)	cacheSizeMB = atoi(argv[++a]);
+		else if (strcmp(arg, "--imu-trace") == 0)			imuTrace = true;
+		else if (strcmp(arg, "--quiet") == 0)				quiet = true;
+		else if (strcmp(arg, "--check-determinism") == 0)	checkDeterminism = true;
+		else if (strcmp(arg, "--pin") == 0)					pin = true;
+		else if (strcmp(arg, "--worker-stats") == 0)		workerStats = true;
+		else if (arg[0] == '-')
+		{
+			PrintUsage();
+			return k_ExitError;
+		}
+		else
+		{
+			scenarioPaths.push_back(arg);
+		}
+	}
+	bool writeCsv = format == "csv" || format == "both";
+	bool writeColumns = format == "col" || format == "both";
+	if (scenarioPaths.empty() || numJobs < 0 || cacheSizeMB <= 0 || (!writeCsv && !writeColumns && format != "none"))
+	{
+		PrintUsage();
+		return k_ExitError;
+	}
+	if (summaryPath.empty())
+	{
+		summaryPath = Directory::Join(outDir, "summary.json");
+	}
+	if (airframePaths.empty())
+	{
+		airframePaths.push_back(std::string());
+	}
+
+	// Load everything up front, the runs do no IO:
+	std::vector<BatchJob> jobs;
+	for (const std::string& scenarioPath : scenarioPaths)
+	{
+		Scenario scenario;
+		std::string error;
+		if (!scenario.LoadFromFile(scenarioPath, &error))
+		{
+			fprintf(stderr, "%s\n", error.c_str());
+			return k_ExitError;
+		}
+		for (const std::string& airframePath : airframePaths)
+		{
+			jobs.push_back(BatchJob());
+			if (!BatchRunner::PrepareJob(scenario, airframePath, jobs.back(), &error))
+			{
+				fprintf(stderr, "%s: %s\n", scenarioPath.c_str(), error.c_str());
+				return k_ExitError;
+			}
+			jobs.back().RecordImu = imuTrace;
+		}
+	}
+
+	ResultCache cache;
+	if (!cacheDir.empty() && !cache.Open(cacheDir, (uint64_t)cacheSizeMB << 20))
+	{
+		fprintf(stderr, "Could not open the result cache %s\n", cacheDir.c_str());
+		return k_ExitError;
+	}
+
+	// The pool matches --jobs:
+	JobSystem::Settings jobSettings;
+	jobSettings.NumThreads = numJobs;
+	jobSettings.Pin = pin;
+	JobSystem::Configure(jobSettings);
+	JobSystem::Get().ResetStats();
+
+	std::vector<BatchResult> results;
+	BatchRunner::Run(jobs, numJobs, results, cache.IsOpen() ? &cache : nullptr);
+	std::vector<JobSystem::WorkerStats> stats;
+	JobSystem::Get().GetStats(stats);
+
+	// Same jobs sequentially and simulated, the results must not depend on the run, the
+	// thread count or whether they came from the cache:
+	int numDivergent = 0;
+	if (checkDeterminism)
+	{
+		std::vector<BatchResult> reference;
+		BatchRunner::Run(jobs, 1, reference);
+		for (size_t r = 0; r < results.size(); ++r)
+		{
+			int frame = results[r].Result.FindDivergence(reference[r].Result);
+			if (frame >= 0)
+			{
+				printf("NONDETERMINISTIC %s / %s, first divergent frame %d\n", results[r].ScenarioName.c_str(), results[r].AirframeName.c_str(), frame);
+				++numDivergent;
+			}
+		}
+	}
+
+	// Result files, names made unique if two runs share the scenario and airframe names:
+	std::vector<std::vector<std::string>> outputs(results.size());
+	std::set<std::string> usedNames;
+	bool ioFailed = false;
+	for (size_t r = 0; r < results.size(); ++r)
+	{
+		std::string name = RunFileName(results[r]);
+		for (int suffix = 2; !usedNames.insert(name).second; ++suffix)
+		{
+			name = RunFileName(results[r]) + "_" + std::to_string(suffix);
+		}
+		if (writeCsv)
+		{
+			outputs[r].push_back(name + ".csv");
+			ioFailed |= !ResultFile::WriteCsv(Directory::Join(outDir, outputs[r].back()), results[r].Result);
+		}
+		if (writeColumns)
+		{
+			outputs[r].push_back(name + ".qcol");
+			ioFailed |= !ResultFile::WriteColumns(Directory::Join(outDir, outputs[r].back()), results[r].Result);
+		}
+		if (!results[r].Imu.Entries.empty())
+		{
+			outputs[r].push_back(name + ".imu");
+			ioFailed |= !results[r].Imu.WriteToFile(Directory::Join(outDir, outputs[r].back()));
+		}
+	}
+	ioFailed |= !ResultWriter::WriteSummary(summaryPath, results, outputs);
+	if (ioFailed)
+	{
+		fprintf(stderr, "Could not write the results to %s\n", outDir.c_str());
+		return k_ExitError;
+	}
+
+	int numFailed = 0;
+	for (const BatchResult& result : results)
+	{
+		numFailed += result.Passed ? 0 : 1;
+		if (quiet && result.Passed)
+		{
+			continue;
+		}
+		printf("%s %s / %s (%.1f ms)\n", result.Passed ? "PASS" : "FAIL", result.ScenarioName.c_str(), result.AirframeName.c_str(), result.WallTimeMs);
+		for (size_t e = 0; e < result.Expectations.size(); ++e)
+		{
+			const Scenario::Expectation& expectation = result.Expectations[e];
+			if (!result.ExpectationPassed[e])
+			{
+				printf("  expected %s %s %g, got %g\n", Scenario::Metric::ToStr(expectation.Quantity), Scenario::Op::ToStr(expectation.Compare), expectation.Value, result.Metrics[expectation.Quantity]);
+			}
+		}
+	}
+	printf("%d passed, %d failed\n", (int)results.size() - numFailed, numFailed);
+	if (cache.IsOpen())
+	{
+		printf("Cache: %d hits, %d misses, %d entries, %.1f MB\n", cache.GetNumHits(), cache.GetNumMisses(), cache.GetNumEntries(), cache.GetSize() / (1024.0 * 1024.0));
+	}
+	if (checkDeterminism)
+	{
+		printf("%d of %d runs bit identical\n", (int)results.size() - numDivergent, (int)results.size());
+	}
+	if (workerStats)
+	{
+		for (size_t w = 0; w < stats.size(); ++w)
+		{
+			const JobSystem::WorkerStats& worker = stats[w];
+			const std::string name = w + 1 < stats.size() ? "Worker " + std::to_string(w) : "Caller";
+			printf("%-9s cpu %3d node %d: %6llu tasks, %5llu stolen, %9.1f ms busy, %5.1f%%\n", name.c_str(), worker.Cpu, worker.Node, (unsigned long long)worker.TasksRun, (unsigned long long)worker.TasksStolen, worker.BusyMs, worker.Utilization * 100.0);
+		}
+	}
+	return numFailed > 0 || numDivergent > 0 ? k_ExitFailed : k_ExitPassed;
+}
\ No newline at end of file
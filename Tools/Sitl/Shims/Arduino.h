@@ -0,0 +1,77 @@
+#pragma once
+
+// Minimal Arduino core for the SITL build: the subset Board/src/main.cpp and the controller
+// library use, backed by the simulated world (SitlHost.h) instead of the nRF52 hardware.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <cmath>
+#include <string>
+
+using std::abs;
+
+typedef uint8_t byte;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define LED_BUILTIN 13
+
+#define DEG_TO_RAD 0.017453292519943295769236907684886f
+#define RAD_TO_DEG 57.295779513082320876798154814105f
+#define constrain(x, low, high) ((x) < (low) ? (low) : ((x) > (high) ? (high) : (x)))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void analogWrite(int pin, int value);
+void digitalWrite(int pin, int value);
+
+class String
+{
+public:
+	String(const char* str = "") : mStr(str) {}
+	const char* c_str()const { return mStr.c_str(); }
+	unsigned int length()const { return (unsigned int)mStr.size(); }
+
+private:
+	std::string mStr;
+};
+
+// Lines go to the SITL log, the baud rate is ignored.
+class SerialPort
+{
+public:
+	void begin(unsigned long baud);
+	explicit operator bool()const { return true; }
+
+	void print(const char* text);
+	void print(const String& text);
+	void print(char c);
+	void print(int value);
+	void print(unsigned int value);
+	void print(long value);
+	void print(unsigned long value);
+	void print(double value, int digits = 2);
+
+	// Nothing is ever sent to the board.
+	int available();
+	int read();
+
+	void println();
+	template<typename T>
+	void println(const T& value)
+	{
+		print(value);
+		println();
+	}
+	void println(double value, int digits)
+	{
+		print(value, digits);
+		println();
+	}
+};
+
+extern SerialPort Serial;
\ No newline at end of file
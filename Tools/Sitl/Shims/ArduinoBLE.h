@@ -0,0 +1,133 @@
+#pragma once
+
+#include "Arduino.h"
+
+// ArduinoBLE for the SITL build: a single central that connects right away and writes the
+// characteristics when the world injects them (SitlBle::Write). Notifications and reads from
+// the central side are not simulated.
+
+enum BLEProperty
+{
+	BLERead = 0x02,
+	BLEWriteWithoutResponse = 0x04,
+	BLEWrite = 0x08,
+	BLENotify = 0x10
+};
+
+class BLECharacteristic
+{
+public:
+	BLECharacteristic(const char* uuid, uint8_t properties, int valueSize, bool fixedLength = false);
+	~BLECharacteristic();
+
+	const char* uuid()const;
+	int valueSize()const;
+	int valueLength()const;
+	const uint8_t* value()const;
+	int readValue(uint8_t* value, int length);
+	int writeValue(const uint8_t* value, int length);
+	int setValue(const uint8_t* value, int length);
+
+	// True once after each write from the central.
+	bool written();
+
+	// Called by SitlBle::Write.
+	void CentralWrite(const void* data, int size);
+
+protected:
+	static const int k_MaxValueSize = 512;
+
+	const char* mUuid;
+	uint8_t mValue[k_MaxValueSize];
+	int mValueSize;
+	int mValueLength;
+	bool mFixedLength;
+	bool mWritten;
+};
+
+// The board is 32 bit, unsigned long is 4 bytes there: the value size comes from T, the
+// reads convert to whatever integer the firmware passes.
+template<typename T, typename BoardT = T>
+class BLETypedCharacteristic : public BLECharacteristic
+{
+public:
+	BLETypedCharacteristic(const char* uuid, uint8_t properties)
+		:BLECharacteristic(uuid, properties, sizeof(BoardT), true)
+	{
+	}
+
+	int setValue(T value)
+	{
+		BoardT boardValue = (BoardT)value;
+		return BLECharacteristic::setValue((const uint8_t*)&boardValue, sizeof(boardValue));
+	}
+
+	template<typename U>
+	int readValue(U& value)
+	{
+		BoardT boardValue = BoardT();
+		memcpy(&boardValue, mValue, sizeof(boardValue));
+		value = (U)boardValue;
+		return sizeof(boardValue);
+	}
+	int readValue(uint8_t* value, int length)
+	{
+		return BLECharacteristic::readValue(value, length);
+	}
+
+	T value()const
+	{
+		BoardT boardValue = BoardT();
+		memcpy(&boardValue, mValue, sizeof(boardValue));
+		return (T)boardValue;
+	}
+};
+
+typedef BLETypedCharacteristic<byte> BLEByteCharacteristic;
+typedef BLETypedCharacteristic<unsigned long, uint32_t> BLEUnsignedLongCharacteristic;
+typedef BLETypedCharacteristic<float> BLEFloatCharacteristic;
+
+class BLEService
+{
+public:
+	BLEService(const char* uuid);
+	const char* uuid()const;
+	void addCharacteristic(BLECharacteristic& characteristic);
+
+private:
+	const char* mUuid;
+};
+
+class BLEDevice
+{
+public:
+	BLEDevice();
+	static BLEDevice Connected();	// The simulated central
+	explicit operator bool()const;
+	bool connected()const;
+	bool connect();
+	bool discoverAttributes();
+	bool hasLocalName()const;
+	String localName()const;
+	String address()const;
+
+private:
+	bool mValid;
+};
+
+class BLELocalDevice
+{
+public:
+	int begin();
+	void end();
+	String address()const;
+	bool setLocalName(const char* name);
+	bool setAdvertisedService(const BLEService& service);
+	void addService(BLEService& service);
+	int advertise();
+	void stopAdvertise();
+	BLEDevice central();
+	void poll(unsigned long timeout = 0);
+};
+
+extern BLELocalDevice BLE;
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Arduino.h"
+
+// LSM9DS1 as exposed by the Arduino library: accelerometer (g) and gyroscope (dps) at 119 Hz,
+// samples come from the simulated body. No magnetometer.
+class LSM9DS1Class
+{
+public:
+	int begin();
+	void end();
+
+	int accelerationAvailable();
+	int readAcceleration(float& x, float& y, float& z);
+	float accelerationSampleRate();
+
+	int gyroscopeAvailable();
+	int readGyroscope(float& x, float& y, float& z);
+	float gyroscopeSampleRate();
+
+	int magneticFieldAvailable();
+	int readMagneticField(float& x, float& y, float& z);
+};
+
+extern LSM9DS1Class IMU;
\ No newline at end of file
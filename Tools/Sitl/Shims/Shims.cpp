@@ -0,0 +1,406 @@
+#include "Arduino.h"
+#include "ArduinoBLE.h"
+#include "Arduino_LSM9DS1.h"
+#include "../SitlHost.h"
+
+#include <cstdio>
+#include <vector>
+
+// Time the firmware spends in each peripheral access, sets the loop rate of the simulated
+// board. Rough figures for the nano33ble: 100 kHz I2C to the LSM9DS1, the BLE stack polled
+// on every characteristic access.
+static const uint32_t k_ImuStatusUs = 60;	// Status register read
+static const uint32_t k_ImuReadUs = 180;	// Burst read of one 3 axis sample
+static const uint32_t k_BleUs = 40;
+static const uint32_t k_PinUs = 5;
+
+SerialPort Serial;
+LSM9DS1Class IMU;
+BLELocalDevice BLE;
+
+// Arduino core:
+
+unsigned long millis()
+{
+	return (unsigned long)(SitlHost::GetMicros() / 1000);
+}
+
+unsigned long micros()
+{
+	return (unsigned long)SitlHost::GetMicros();
+}
+
+void delay(unsigned long ms)
+{
+	SitlHost::Spend((uint32_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	SitlHost::Spend(us);
+}
+
+void analogWrite(int pin, int value)
+{
+	SitlHost::Spend(k_PinUs);
+	SitlHost::SetPinValue(pin, value);
+}
+
+void digitalWrite(int pin, int value)
+{
+	SitlHost::Spend(k_PinUs);
+	SitlHost::SetPinValue(pin, value ? 255 : 0);
+}
+
+void SerialPort::begin(unsigned long /*baud*/)
+{
+}
+
+void SerialPort::print(const char* text)
+{
+	SitlHost::Print(text);
+}
+
+void SerialPort::print(const String& text)
+{
+	SitlHost::Print(text.c_str());
+}
+
+void SerialPort::print(char c)
+{
+	char text[2] = { c, 0 };
+	SitlHost::Print(text);
+}
+
+void SerialPort::print(int value)
+{
+	print((long)value);
+}
+
+void SerialPort::print(unsigned int value)
+{
+	print((unsigned long)value);
+}
+
+void SerialPort::print(long value)
+{
+	char text[32];
+	snprintf(text, sizeof(text), "%ld", value);
+	SitlHost::Print(text);
+}
+
+void SerialPort::print(unsigned long value)
+{
+	char text[32];
+	snprintf(text, sizeof(text), "%lu", value);
+	SitlHost::Print(text);
+}
+
+void SerialPort::print(double value, int digits)
+{
+	char text[64];
+	snprintf(text, sizeof(text), "%.*f", digits, value);
+	SitlHost::Print(text);
+}
+
+void SerialPort::println()
+{
+	SitlHost::Print("\n");
+}
+
+int SerialPort::available()
+{
+	return 0;
+}
+
+int SerialPort::read()
+{
+	return -1;
+}
+
+// IMU:
+
+int LSM9DS1Class::begin()
+{
+	return 1;
+}
+
+void LSM9DS1Class::end()
+{
+}
+
+int LSM9DS1Class::accelerationAvailable()
+{
+	SitlHost::Spend(k_ImuStatusUs);
+	return SitlHost::IsAccelAvailable() ? 1 : 0;
+}
+
+int LSM9DS1Class::readAcceleration(float& x, float& y, float& z)
+{
+	SitlHost::Spend(k_ImuReadUs);
+	SitlHost::ReadAccel(x, y, z);
+	return 1;
+}
+
+float LSM9DS1Class::accelerationSampleRate()
+{
+	return 119.0f;
+}
+
+int LSM9DS1Class::gyroscopeAvailable()
+{
+	SitlHost::Spend(k_ImuStatusUs);
+	return SitlHost::IsGyroAvailable() ? 1 : 0;
+}
+
+int LSM9DS1Class::readGyroscope(float& x, float& y, float& z)
+{
+	SitlHost::Spend(k_ImuReadUs);
+	SitlHost::ReadGyro(x, y, z);
+	return 1;
+}
+
+float LSM9DS1Class::gyroscopeSampleRate()
+{
+	return 119.0f;
+}
+
+int LSM9DS1Class::magneticFieldAvailable()
+{
+	return 0;
+}
+
+int LSM9DS1Class::readMagneticField(float& x, float& y, float& z)
+{
+	x = 0.0f;
+	y = 0.0f;
+	z = 0.0f;
+	return 0;
+}
+
+// BLE:
+
+// Every characteristic the firmware declared, so the world can write them by UUID. Function
+// local so it exists before the firmware globals are constructed.
+static std::vector<BLECharacteristic*>& GetCharacteristics()
+{
+	static std::vector<BLECharacteristic*> characteristics;
+	return characteristics;
+}
+
+bool SitlBle::Write(const char* uuid, const void* data, int size)
+{
+	for (BLECharacteristic* characteristic : GetCharacteristics())
+	{
+		if (strcmp(characteristic->uuid(), uuid) == 0)
+		{
+			characteristic->CentralWrite(data, size);
+			return true;
+		}
+	}
+	return false;
+}
+
+BLECharacteristic::BLECharacteristic(const char* uuid, uint8_t /*properties*/, int valueSize, bool fixedLength)
+	:mUuid(uuid)
+	,mValueSize(valueSize < k_MaxValueSize ? valueSize : k_MaxValueSize)
+	,mValueLength(fixedLength ? mValueSize : 0)
+	,mFixedLength(fixedLength)
+	,mWritten(false)
+{
+	memset(mValue, 0, sizeof(mValue));
+	GetCharacteristics().push_back(this);
+}
+
+BLECharacteristic::~BLECharacteristic()
+{
+	std::vector<BLECharacteristic*>& characteristics = GetCharacteristics();
+	for (size_t i = 0; i < characteristics.size(); ++i)
+	{
+		if (characteristics[i] == this)
+		{
+			characteristics.erase(characteristics.begin() + i);
+			break;
+		}
+	}
+}
+
+const char* BLECharacteristic::uuid() const
+{
+	return mUuid;
+}
+
+int BLECharacteristic::valueSize() const
+{
+	return mValueSize;
+}
+
+int BLECharacteristic::valueLength() const
+{
+	return mValueLength;
+}
+
+const uint8_t* BLECharacteristic::value() const
+{
+	return mValue;
+}
+
+int BLECharacteristic::readValue(uint8_t* value, int length)
+{
+	SitlHost::Spend(k_BleUs);
+	length = length < mValueLength ? length : mValueLength;
+	memcpy(value, mValue, length);
+	return length;
+}
+
+int BLECharacteristic::writeValue(const uint8_t* value, int length)
+{
+	return setValue(value, length);
+}
+
+int BLECharacteristic::setValue(const uint8_t* value, int length)
+{
+	if (length > mValueSize || (mFixedLength && length != mValueSize))
+	{
+		return 0;
+	}
+	memcpy(mValue, value, length);
+	mValueLength = length;
+	return 1;
+}
+
+bool BLECharacteristic::written()
+{
+	SitlHost::Spend(k_BleUs);
+	bool written = mWritten;
+	mWritten = false;
+	return written;
+}
+
+void BLECharacteristic::CentralWrite(const void* data, int size)
+{
+	// Same as the stack: writes longer than the characteristic are dropped.
+	if (size > mValueSize || (mFixedLength && size != mValueSize))
+	{
+		return;
+	}
+	memcpy(mValue, data, size);
+	mValueLength = size;
+	mWritten = true;
+}
+
+BLEService::BLEService(const char* uuid)
+	:mUuid(uuid)
+{
+}
+
+const char* BLEService::uuid() const
+{
+	return mUuid;
+}
+
+void BLEService::addCharacteristic(BLECharacteristic& /*characteristic*/)
+{
+}
+
+BLEDevice::BLEDevice()
+	:mValid(false)
+{
+}
+
+BLEDevice BLEDevice::Connected()
+{
+	BLEDevice device;
+	device.mValid = true;
+	return device;
+}
+
+BLEDevice::operator bool() const
+{
+	return mValid;
+}
+
+bool BLEDevice::connected() const
+{
+	SitlHost::Spend(k_BleUs);
+	return mValid && SitlHost::IsCentralConnected();
+}
+
+bool BLEDevice::connect()
+{
+	return mValid;
+}
+
+bool BLEDevice::discoverAttributes()
+{
+	return mValid;
+}
+
+bool BLEDevice::hasLocalName() const
+{
+	return mValid;
+}
+
+String BLEDevice::localName() const
+{
+	return String("SITL Controller");
+}
+
+String BLEDevice::address() const
+{
+	return String("00:00:00:00:00:01");
+}
+
+int BLELocalDevice::begin()
+{
+	return 1;
+}
+
+void BLELocalDevice::end()
+{
+}
+
+String BLELocalDevice::address() const
+{
+	return String("00:00:00:00:00:02");
+}
+
+bool BLELocalDevice::setLocalName(const char* /*name*/)
+{
+	return true;
+}
+
+bool BLELocalDevice::setAdvertisedService(const BLEService& /*service*/)
+{
+	return true;
+}
+
+void BLELocalDevice::addService(BLEService& /*service*/)
+{
+}
+
+int BLELocalDevice::advertise()
+{
+	return 1;
+}
+
+void BLELocalDevice::stopAdvertise()
+{
+}
+
+BLEDevice BLELocalDevice::central()
+{
+	// The simulated central is there from the start:
+	SitlHost::Spend(k_BleUs);
+	BLEDevice device;
+	if (SitlHost::IsCentralConnected())
+	{
+		device = BLEDevice::Connected();
+	}
+	return device;
+}
+
+void BLELocalDevice::poll(unsigned long /*timeout*/)
+{
+	SitlHost::Spend(k_BleUs);
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+
+// Boundary between the firmware (Board/src/main.cpp and the controller library, built as
+// ARDUINO against the headers in Shims/) and the simulated world (SitlWorld, a host build).
+// The two sides never include each other's headers, they only meet through these calls.
+
+// Implemented by the world, called by the shims.
+namespace SitlHost
+{
+	// Virtual clock, owned by the world. Nothing advances it but the firmware spending time.
+	uint64_t GetMicros();
+
+	// CPU or bus time consumed by the firmware (a delay, an I2C transfer...). The world steps
+	// the physics up to the new time, this throws SitlStop once the run is over.
+	void Spend(uint32_t micros);
+
+	void SetPinValue(int pin, int value);	// analogWrite/digitalWrite
+
+	// IMU samples in the LSM9DS1 frame and units (g, dps). Available means a sample newer than
+	// the last one read, a read without a new one returns the last sample again.
+	bool IsAccelAvailable();
+	bool IsGyroAvailable();
+	void ReadAccel(float& x, float& y, float& z);
+	void ReadGyro(float& x, float& y, float& z);
+
+	bool IsCentralConnected();
+
+	void Print(const char* text);
+}
+
+// Implemented by the shims, called by the world.
+namespace SitlBle
+{
+	// Writes a characteristic as the central would, false if the firmware has no such UUID.
+	bool Write(const char* uuid, const void* data, int size);
+}
+
+// Thrown by SitlHost::Spend to unwind the firmware at the end of the run.
+struct SitlStop
+{
+};
\ No newline at end of file
@@ -0,0 +1,530 @@
+#include "SitlWorld.h"
+#include "SitlHost.h"
+#include "IO/Directory.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+// Firmware entry points (Board/src/main.cpp):
+void setup();
+void loop();
+
+static const uint64_t k_HaltUs = 500000;		// A loop() longer than this never returned
+
+// Motor pins of the firmware, in FCCommands order (FrontLeft, FrontRight, RearLeft, RearRight):
+static const int k_MotorPins[MotorModel::k_NumMotors] = { 3, 2, 4, 5 };
+
+static SitlWorld* s_World = nullptr;
+
+const char* SitlScript::EventType::ToStr(T t)
+{
+	switch (t)
+	{
+	case Command:		return "command";
+	case Stop:			return "stop";
+	case Gains:			return "gains";
+	case Disconnect:	return "disconnect";
+	default:			return "invalid";
+	}
+}
+
+static std::string ResolvePath(const std::string& baseDir, const std::string& path)
+{
+	bool absolute = !path.empty() && (path[0] == '/' || path[0] == '\\' || (path.size() > 1 && path[1] == ':'));
+	return absolute || baseDir.empty() ? path : Directory::Join(baseDir, path);
+}
+
+SitlScript::SitlScript()
+	:Name("Unnamed")
+	,TotalTime(10.0f)
+	,Seed(1)
+{
+}
+
+uint32_t SitlScript::PackCommands(int throttle, int yaw, int pitch, int roll)
+{
+	uint32_t packed = (uint32_t)(throttle & 0xFF);
+	packed |= (uint32_t)(abs(yaw) & 0x7F) << 8;
+	packed |= (uint32_t)(abs(pitch) & 0x7F) << 16;
+	packed |= (uint32_t)(abs(roll) & 0x7F) << 24;
+	packed |= (yaw < 0 ? 1u : 0u) << 15;
+	packed |= (pitch < 0 ? 1u : 0u) << 23;
+	packed |= (roll < 0 ? 1u : 0u) << 31;
+	return packed;
+}
+
+bool SitlScript::LoadFromFile(const std::string& path, std::string* error)
+{
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		if (error)
+		{
+			*error = "Could not open " + path;
+		}
+		return false;
+	}
+	size_t separator = path.find_last_of("/\\");
+	std::string baseDir = separator == std::string::npos ? std::string() : path.substr(0, separator);
+
+	// Parse into a copy so a bad script leaves this one untouched:
+	SitlScript script;
+	std::string line;
+	int lineIdx = 0;
+	while (std::getline(file, line))
+	{
+		++lineIdx;
+		std::istringstream tokens(line);
+		std::string key;
+		if (!(tokens >> key) || key[0] == '#')
+		{
+			continue;
+		}
+
+		bool ok = true;
+		std::string value;
+		if (key == "name")
+		{
+			std::getline(tokens >> std::ws, script.Name);
+			ok = !script.Name.empty();
+		}
+		else if (key == "airframe")
+		{
+			ok = (bool)(tokens >> value);
+			script.AirframePath = ResolvePath(baseDir, value);
+		}
+		else if (key == "time")	ok = (bool)(tokens >> script.TotalTime) && script.TotalTime > 0.0f;
+		else if (key == "seed")	ok = (bool)(tokens >> script.Seed);
+		else if (key == "at")
+		{
+			Event event;
+			event.Packed = 0;
+			ok = (bool)(tokens >> event.Time >> value) && event.Time >= 0.0f;
+			if (ok && value == EventType::ToStr(EventType::Command))
+			{
+				int throttle, yaw, pitch, roll;
+				event.Type = EventType::Command;
+				ok = (bool)(tokens >> throttle >> yaw >> pitch >> roll);
+				ok = ok && throttle >= 0 && throttle <= 255 && abs(yaw) <= 127 && abs(pitch) <= 127 && abs(roll) <= 127;
+				event.Packed = PackCommands(throttle, yaw, pitch, roll);
+			}
+			else if (ok && value == EventType::ToStr(EventType::Gains))
+			{
+				event.Type = EventType::Gains;
+				ok = (bool)(tokens >> value);
+				std::ifstream gains(ResolvePath(baseDir, value), std::ios::binary);
+				event.Data.assign(std::istreambuf_iterator<char>(gains), std::istreambuf_iterator<char>());
+				ok = ok && !event.Data.empty();
+			}
+			else if (ok && value == EventType::ToStr(EventType::Stop))
+			{
+				event.Type = EventType::Stop;
+			}
+			else if (ok && value == EventType::ToStr(EventType::Disconnect))
+			{
+				event.Type = EventType::Disconnect;
+			}
+			else
+			{
+				ok = false;
+			}
+			script.Events.push_back(event);
+		}
+		else
+		{
+			if (error)
+			{
+				*error = path + ": line " + std::to_string(lineIdx) + ": unknown key " + key;
+			}
+			return false;
+		}
+
+		if (!ok)
+		{
+			if (error)
+			{
+				*error = path + ": line " + std::to_string(lineIdx) + ": invalid value for " + key;
+			}
+			return false;
+		}
+	}
+
+	std::stable_sort(script.Events.begin(), script.Events.end(), [](const Event& a, const Event& b) { return a.Time < b.Time; });
+	*this = script;
+	return true;
+}
+
+SitlWorld::SitlWorld()
+	:PhysicsDeltaTime(0.001f)
+	,TraceInterval(0.01f)
+	,LoopCostUs(100)
+	,EchoSerial(true)
+	,mStats()
+	,mNowUs(0)
+	,mEndUs(0)
+	,mPhysicsUs(0)
+	,mPhysicsStepUs(1000)
+	,mLoopStartUs(0)
+	,mNextTraceUs(0)
+	,mNextEvent(0)
+	,mInLoop(false)
+	,mConnected(true)
+	,mPrevOrientation(1.0f, 0.0f, 0.0f, 0.0f)
+	,mPrevVelocity(0.0f)
+	,mAccel(0.0f, 0.0f, 1.0f)
+	,mGyro(0.0f)
+	,mImuSampleIdx(0)
+	,mAccelReadIdx(0)
+	,mGyroReadIdx(0)
+{
+	for (int m = 0; m < MotorModel::k_NumMotors; ++m)
+	{
+		mPwm[m] = 0;
+	}
+}
+
+SitlWorld::~SitlWorld()
+{
+	if (s_World == this)
+	{
+		s_World = nullptr;
+	}
+}
+
+void SitlWorld::Init(const SitlScript& script, const QuadProfile& airframe)
+{
+	mScript = script;
+	mQuad.ApplyProfile(airframe);
+	mQuad.Reset();
+	Env.Reset(script.Seed);
+	Sensors.Reset(script.Seed, 1);
+
+	// Resting level on the ground, same as before a flight:
+	mDynamics.Init(mQuad, glm::vec3(0.0f, Env.GroundHeight + mQuad.Height * 0.5f, 0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), Env.GroundHeight, true);
+
+	mStats = Stats();
+	mTrace.clear();
+	mSerialLine.clear();
+	mNowUs = 0;
+	mEndUs = (uint64_t)((double)script.TotalTime * 1e6);
+	mPhysicsUs = 0;
+	mPhysicsStepUs = std::max((uint64_t)((double)PhysicsDeltaTime * 1e6 + 0.5), (uint64_t)1);
+	mNextTraceUs = 0;
+	mNextEvent = 0;
+	mInLoop = false;
+	mConnected = true;
+	for (int m = 0; m < MotorModel::k_NumMotors; ++m)
+	{
+		mPwm[m] = 0;
+	}
+	mPrevOrientation = mDynamics.GetOrientation();
+	mPrevVelocity = glm::vec3(0.0f);
+	mAccel = glm::vec3(0.0f, 0.0f, 1.0f);
+	mGyro = glm::vec3(0.0f);
+	mImuSampleIdx = 0;
+	mAccelReadIdx = 0;
+	mGyroReadIdx = 0;
+}
+
+void SitlWorld::Run()
+{
+	s_World = this;
+	auto start = std::chrono::steady_clock::now();
+	try
+	{
+		ApplyEvents();
+		setup();
+		for (;;)
+		{
+			mInLoop = true;
+			mLoopStartUs = mNowUs;
+			++mStats.NumLoops;
+			Spend(LoopCostUs);
+			loop();
+			mInLoop = false;
+		}
+	}
+	catch (const SitlStop&)
+	{
+	}
+	mStats.WallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	mStats.VirtualTime = (float)(mNowUs * 1e-6);
+	if (mInLoop && mNowUs - mLoopStartUs > k_HaltUs)
+	{
+		mStats.Halted = true;
+		mStats.HaltTime = (float)(mLoopStartUs * 1e-6);
+	}
+	if (!mSerialLine.empty())
+	{
+		Print("\n");
+	}
+}
+
+const SitlWorld::Stats& SitlWorld::GetStats() const
+{
+	return mStats;
+}
+
+const std::vector<SitlWorld::Sample>& SitlWorld::GetTrace() const
+{
+	return mTrace;
+}
+
+bool SitlWorld::WriteTrace(const std::string& path) const
+{
+	FILE* file = fopen(path.c_str(), "w");
+	if (!file)
+	{
+		return false;
+	}
+	fprintf(file, "time,pos_x,pos_y,pos_z,pitch,yaw,roll,pwm_fl,pwm_fr,pwm_rl,pwm_rr\n");
+	for (const Sample& sample : mTrace)
+	{
+		fprintf(file, "%.6f,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%d,%d,%d,%d\n", sample.Time,
+			sample.Position.x, sample.Position.y, sample.Position.z,
+			sample.Orientation.x, sample.Orientation.y, sample.Orientation.z,
+			sample.Pwm[0], sample.Pwm[1], sample.Pwm[2], sample.Pwm[3]);
+	}
+	return fclose(file) == 0;
+}
+
+uint64_t SitlWorld::GetMicros() const
+{
+	return mNowUs;
+}
+
+void SitlWorld::Spend(uint32_t micros)
+{
+	mNowUs += micros;
+	while (mPhysicsUs + mPhysicsStepUs <= mNowUs)
+	{
+		StepPhysics();
+	}
+	ApplyEvents();
+	if (mNowUs >= mEndUs)
+	{
+		throw SitlStop();
+	}
+}
+
+void SitlWorld::SetPinValue(int pin, int value)
+{
+	for (int m = 0; m < MotorModel::k_NumMotors; ++m)
+	{
+		if (k_MotorPins[m] == pin)
+		{
+			mPwm[m] = std::min(std::max(value, 0), 255);
+		}
+	}
+}
+
+bool SitlWorld::IsAccelAvailable() const
+{
+	return mImuSampleIdx > mAccelReadIdx;
+}
+
+bool SitlWorld::IsGyroAvailable() const
+{
+	return mImuSampleIdx > mGyroReadIdx;
+}
+
+void SitlWorld::ReadAccel(float& x, float& y, float& z)
+{
+	mStats.NumImuSamples += IsAccelAvailable() ? 1 : 0;
+	mAccelReadIdx = mImuSampleIdx;
+	x = mAccel.x;
+	y = mAccel.y;
+	z = mAccel.z;
+}
+
+void SitlWorld::ReadGyro(float& x, float& y, float& z)
+{
+	mStats.NumImuSamples += IsGyroAvailable() ? 1 : 0;
+	mGyroReadIdx = mImuSampleIdx;
+	x = mGyro.x;
+	y = mGyro.y;
+	z = mGyro.z;
+}
+
+bool SitlWorld::IsCentralConnected() const
+{
+	return mConnected;
+}
+
+void SitlWorld::Print(const char* text)
+{
+	for (const char* c = text; *c; ++c)
+	{
+		if (*c != '\n')
+		{
+			mSerialLine += *c;
+			continue;
+		}
+		if (EchoSerial)
+		{
+			printf("[%8.3f] %s\n", mNowUs * 1e-6, mSerialLine.c_str());
+		}
+		mSerialLine.clear();
+	}
+}
+
+void SitlWorld::StepPhysics()
+{
+	const float deltaTime = (float)(mPhysicsStepUs * 1e-6);
+
+	glm::quat orientation = mDynamics.GetOrientation();
+	mQuad.Position = mDynamics.GetPosition();
+	mQuad.Orientation = glm::eulerAngles(orientation);
+
+	float motorCommands[MotorModel::k_NumMotors];
+	for (int m = 0; m < MotorModel::k_NumMotors; ++m)
+	{
+		motorCommands[m] = (float)mPwm[m] / 255.0f;
+	}
+	float motorThrust[MotorModel::k_NumMotors];
+	float yawTorque = 0.0f;
+	mQuad.Motors.Step(motorCommands, deltaTime, motorThrust, yawTorque);
+
+	// Same forces as Simulation::RunSimulation:
+	glm::vec3 envForce;
+	float thrustScale = 1.0f;
+	Env.Step(mQuad, mDynamics.GetLinearVelocity(), deltaTime, envForce, thrustScale);
+	mDynamics.AddForce(envForce);
+
+	float dimX = mQuad.ArmLength * 0.70710678f;
+	float dimZ = dimX;
+	mDynamics.AddLocalForceAtLocalPos(glm::vec3(0.0f, motorThrust[0] * thrustScale, 0.0f), glm::vec3(-dimX, 0.0f, dimZ));
+	mDynamics.AddLocalForceAtLocalPos(glm::vec3(0.0f, motorThrust[1] * thrustScale, 0.0f), glm::vec3( dimX, 0.0f, dimZ));
+	mDynamics.AddLocalForceAtLocalPos(glm::vec3(0.0f, motorThrust[2] * thrustScale, 0.0f), glm::vec3(-dimX, 0.0f, -dimZ));
+	mDynamics.AddLocalForceAtLocalPos(glm::vec3(0.0f, motorThrust[3] * thrustScale, 0.0f), glm::vec3( dimX, 0.0f,-dimZ));
+	mDynamics.AddTorque(orientation * glm::vec3(0.0f, yawTorque, 0.0f));
+	mDynamics.Step(deltaTime);
+	mPhysicsUs += mPhysicsStepUs;
+
+	SampleImu();
+
+	const glm::vec3 up = mDynamics.GetOrientation() * glm::vec3(0.0f, 1.0f, 0.0f);
+	mStats.MaxTilt = std::max(mStats.MaxTilt, std::acos(std::min(std::max(up.y, -1.0f), 1.0f)));
+
+	if (TraceInterval > 0.0f && mPhysicsUs >= mNextTraceUs)
+	{
+		mNextTraceUs += std::max((uint64_t)((double)TraceInterval * 1e6), (uint64_t)1);
+		Sample sample;
+		sample.Time = (float)(mPhysicsUs * 1e-6);
+		sample.Position = mDynamics.GetPosition();
+		sample.Orientation = glm::eulerAngles(mDynamics.GetOrientation());
+		for (int m = 0; m < MotorModel::k_NumMotors; ++m)
+		{
+			sample.Pwm[m] = (uint8_t)mPwm[m];
+		}
+		mTrace.push_back(sample);
+	}
+}
+
+void SitlWorld::SampleImu()
+{
+	const float deltaTime = (float)(mPhysicsStepUs * 1e-6);
+	const Dynamics::State state = mDynamics.GetState();
+	const MotorModel::State motors = mQuad.Motors.GetState();
+
+	float motorSpeed = 0.0f;
+	for (int m = 0; m < MotorModel::k_NumMotors; ++m)
+	{
+		motorSpeed += motors.Speed[m] / (float)MotorModel::k_NumMotors;
+	}
+	const SensorModel::Truth truth = SensorModel::FromMotion(mPrevOrientation, mPrevVelocity, state.Orientation, state.LinearVelocity, deltaTime, motorSpeed);
+	mPrevOrientation = state.Orientation;
+	mPrevVelocity = state.LinearVelocity;
+
+	SensorModel::Sample sample;
+	if (Sensors.Step((float)(mPhysicsUs * 1e-6), &truth, &sample) > 0)
+	{
+		++mImuSampleIdx;
+		mAccel = sample.Accel;
+		mGyro = sample.Gyro;
+	}
+}
+
+void SitlWorld::ApplyEvents()
+{
+	for (; mNextEvent < mScript.Events.size(); ++mNextEvent)
+	{
+		const SitlScript::Event& event = mScript.Events[mNextEvent];
+		if ((uint64_t)((double)event.Time * 1e6) > mNowUs)
+		{
+			break;
+		}
+		switch (event.Type)
+		{
+		case SitlScript::EventType::Command:
+			SitlBle::Write("2207", &event.Packed, sizeof(event.Packed));
+			break;
+		case SitlScript::EventType::Stop:
+		{
+			uint8_t stop = 1;
+			SitlBle::Write("2206", &stop, 1);
+			break;
+		}
+		case SitlScript::EventType::Gains:
+			SitlBle::Write("2208", event.Data.data(), (int)event.Data.size());
+			break;
+		case SitlScript::EventType::Disconnect:
+			mConnected = false;
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+// SitlHost, forwarded to the running world:
+
+uint64_t SitlHost::GetMicros()
+{
+	return s_World->GetMicros();
+}
+
+void SitlHost::Spend(uint32_t micros)
+{
+	s_World->Spend(micros);
+}
+
+void SitlHost::SetPinValue(int pin, int value)
+{
+	s_World->SetPinValue(pin, value);
+}
+
+bool SitlHost::IsAccelAvailable()
+{
+	return s_World->IsAccelAvailable();
+}
+
+bool SitlHost::IsGyroAvailable()
+{
+	return s_World->IsGyroAvailable();
+}
+
+void SitlHost::ReadAccel(float& x, float& y, float& z)
+{
+	s_World->ReadAccel(x, y, z);
+}
+
+void SitlHost::ReadGyro(float& x, float& y, float& z)
+{
+	s_World->ReadGyro(x, y, z);
+}
+
+bool SitlHost::IsCentralConnected()
+{
+	return s_World->IsCentralConnected();
+}
+
+void SitlHost::Print(const char* text)
+{
+	s_World->Print(text);
+}
\ No newline at end of file
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "Quad.h"
+#include "Environment.h"
+#include "Dynamics/RigidBodyDynamics.h"
+#include "Sensors/SensorModel.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// What the simulated controller app and the world do during a SITL run. Text format, one
+// key per line:
+//
+//   name     <run name>
+//   airframe <quad profile path>
+//   time     <total virtual time s>
+//   seed     <run seed>
+//   at <time> command <throttle 0,255> <yaw> <pitch> <roll>	Packed command write (-127,127)
+//   at <time> stop												Emergency stop write
+//   at <time> gains <gain set path>							Raw gain set write
+//   at <time> disconnect										The central goes away
+//
+// Paths are relative to the script, lines starting with '#' are comments.
+struct SitlScript
+{
+	struct EventType
+	{
+		enum T
+		{
+			Command,
+			Stop,
+			Gains,
+			Disconnect,
+			COUNT
+		};
+		static const char* ToStr(T t);
+	};
+
+	struct Event
+	{
+		float Time;
+		EventType::T Type;
+		uint32_t Packed;			// Command
+		std::vector<uint8_t> Data;	// Gains, raw .gainset bytes
+	};
+
+	SitlScript();
+	bool LoadFromFile(const std::string& path, std::string* error = nullptr);
+
+	// Same packing as the controller app, see UnpackControlCommands.
+	static uint32_t PackCommands(int throttle, int yaw, int pitch, int roll);
+
+	std::string Name;
+	std::string AirframePath;
+	float TotalTime;
+	uint32_t Seed;
+	std::vector<Event> Events;	// Sorted by time
+};
+
+// Lockstep software in the loop: the unmodified firmware (setup/loop of Board/src/main.cpp)
+// runs against the Arduino shims and this world owns the clock. Time only advances when the
+// firmware spends it (peripheral accesses, delays, a fixed cost per loop), and the physics
+// catches up on every advance, so a run is deterministic and goes as fast as the CPU allows.
+// The IMU is emulated by the SensorModel, the motor PWM drives the airframe motors and the script
+// events are written to the BLE characteristics when their time comes.
+// The firmware has global state, there can only be one world and one run per process.
+class SitlWorld
+{
+public:
+	struct Sample
+	{
+		float Time;
+		glm::vec3 Position;
+		glm::vec3 Orientation;	// Euler angles (pitch, yaw, roll), same as the simulation
+		uint8_t Pwm[MotorModel::k_NumMotors];
+	};
+
+	struct Stats
+	{
+		float VirtualTime;		// s
+		double WallTime;		// s
+		int NumLoops;
+		int NumImuSamples;		// Accel and gyro samples read by the firmware
+		float MaxTilt;			// rad
+		bool Halted;			// The firmware stopped returning from loop()
+		float HaltTime;
+	};
+
+	SitlWorld();
+	~SitlWorld();
+
+	void Init(const SitlScript& script, const QuadProfile& airframe);
+	void Run();
+
+	const Stats& GetStats()const;
+	const std::vector<Sample>& GetTrace()const;
+	bool WriteTrace(const std::string& path)const;
+
+	float PhysicsDeltaTime;		// s
+	float TraceInterval;		// s, 0 disables the trace
+	uint32_t LoopCostUs;		// Control code of one loop() besides the peripheral accesses
+	bool EchoSerial;			// Firmware Serial output to stdout
+	Environment Env;
+	SensorModel Sensors;
+
+	// SitlHost implementation:
+	uint64_t GetMicros()const;
+	void Spend(uint32_t micros);
+	void SetPinValue(int pin, int value);
+	bool IsAccelAvailable()const;
+	bool IsGyroAvailable()const;
+	void ReadAccel(float& x, float& y, float& z);
+	void ReadGyro(float& x, float& y, float& z);
+	bool IsCentralConnected()const;
+	void Print(const char* text);
+
+private:
+	void StepPhysics();
+	void SampleImu();
+	void ApplyEvents();
+
+	SitlScript mScript;
+	Quad mQuad;
+	RigidBodyDynamics mDynamics;
+	Stats mStats;
+	std::vector<Sample> mTrace;
+	std::string mSerialLine;
+
+	uint64_t mNowUs;
+	uint64_t mEndUs;
+	uint64_t mPhysicsUs;
+	uint64_t mPhysicsStepUs;
+	uint64_t mLoopStartUs;
+	uint64_t mNextTraceUs;
+	size_t mNextEvent;
+	bool mInLoop;
+	bool mConnected;
+	int mPwm[MotorModel::k_NumMotors];
+
+	// IMU, in the sensor frame:
+	glm::quat mPrevOrientation;
+	glm::vec3 mPrevVelocity;
+	glm::vec3 mAccel;			// g
+	glm::vec3 mGyro;			// dps
+	uint64_t mImuSampleIdx;		// Samples taken
+	uint64_t mAccelReadIdx;		// Last sample read by the firmware
+	uint64_t mGyroReadIdx;
+};
\ No newline at end of file
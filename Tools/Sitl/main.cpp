@@ -0,0 +1,108 @@
+// Software in the loop runner, flies the board firmware against the simulated world:
+//   sitl [options] <script>
+// The firmware runs unmodified in lockstep with the physics, on a virtual clock, as fast as
+// the host allows. Exit code 0 if the run finished, 1 if the firmware halted and 2 on invalid
+// arguments/inputs.
+
+#include "SitlWorld.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+static const int k_ExitFinished = 0;
+static const int k_ExitHalted = 1;
+static const int k_ExitError = 2;
+
+static void PrintUsage()
+{
+	fprintf(stderr,
+		"Usage: sitl [options] <script>\n"
+		"  --airframe <file>    Fly this airframe instead of the script one\n"
+		"  --time <s>           Virtual time to run, overrides the script\n"
+		"  --dt <s>             Physics step (default 0.001)\n"
+		"  --loop-cost <us>     Virtual time of one loop() besides the peripherals (default 100)\n"
+		"  --trace <file>       Write the pose and motor PWM every 10 ms as CSV\n"
+		"  --quiet              Do not echo the firmware serial output\n");
+}
+
+int main(int argc, char** argv)
+{
+	std::string scriptPath;
+	std::string airframePath;
+	std::string tracePath;
+	float totalTime = 0.0f;
+	float deltaTime = 0.001f;
+	int loopCost = 100;
+	bool quiet = false;
+
+	for (int a = 1; a < argc; ++a)
+	{
+		const char* arg = argv[a];
+		bool hasValue = a + 1 < argc;
+		if (strcmp(arg, "--airframe") == 0 && hasValue)			airframePath = argv[++a];
+		else if (strcmp(arg, "--time") == 0 && hasValue)		totalTime = (float)atof(argv[++a]);
+		else if (strcmp(arg, "--dt") == 0 && hasValue)			deltaTime = (float)atof(argv[++a]);
+		else if (strcmp(arg, "--loop-cost") == 0 && hasValue)	loopCost = atoi(argv[++a]);
+		else if (strcmp(arg, "--trace") == 0 && hasValue)		tracePath = argv[++a];
+		else if (strcmp(arg, "--quiet") == 0)					quiet = true;
+		else if (arg[0] == '-' || !scriptPath.empty())
+		{
+			PrintUsage();
+			return k_ExitError;
+		}
+		else
+		{
+			scriptPath = arg;
+		}
+	}
+	if (scriptPath.empty() || totalTime < 0.0f || deltaTime <= 0.0f || loopCost < 0)
+	{
+		PrintUsage();
+		return k_ExitError;
+	}
+
+	SitlScript script;
+	std::string error;
+	if (!script.LoadFromFile(scriptPath, &error))
+	{
+		fprintf(stderr, "%s\n", error.c_str());
+		return k_ExitError;
+	}
+	if (totalTime > 0.0f)
+	{
+		script.TotalTime = totalTime;
+	}
+	airframePath = airframePath.empty() ? script.AirframePath : airframePath;
+	QuadProfile airframe;
+	if (!airframePath.empty() && !QuadProfileIO::Load(airframePath, airframe, &error))
+	{
+		fprintf(stderr, "%s: %s\n", airframePath.c_str(), error.c_str());
+		return k_ExitError;
+	}
+
+	SitlWorld world;
+	world.PhysicsDeltaTime = deltaTime;
+	world.LoopCostUs = (uint32_t)loopCost;
+	world.TraceInterval = tracePath.empty() ? 0.0f : 0.01f;
+	world.EchoSerial = !quiet;
+	world.Init(script, airframe);
+	world.Run();
+
+	if (!tracePath.empty() && !world.WriteTrace(tracePath))
+	{
+		fprintf(stderr, "Could not write %s\n", tracePath.c_str());
+		return k_ExitError;
+	}
+
+	const SitlWorld::Stats& stats = world.GetStats();
+	printf("%s: %.2f s virtual in %.3f s wall, %.1fx real time\n", script.Name.c_str(), stats.VirtualTime, stats.WallTime, stats.WallTime > 0.0 ? stats.VirtualTime / stats.WallTime : 0.0);
+	printf("  %d loops (%.0f Hz), %d IMU samples read, max tilt %.1f deg\n", stats.NumLoops, stats.VirtualTime > 0.0f ? stats.NumLoops / stats.VirtualTime : 0.0f, stats.NumImuSamples, stats.MaxTilt * 57.2957795f);
+	if (stats.Halted)
+	{
+		printf("  HALTED at %.3f s\n", stats.HaltTime);
+		return k_ExitHalted;
+	}
+	return k_ExitFinished;
+}
\ No newline at end of file
@@ -1,3 +1,9 @@
+-- Commit the project files were generated from, part of the result cache keys (Source/ResultCache.h)
+local codeVersion = os.outputof("git rev-parse --short HEAD")
+if not codeVersion or codeVersion == "" then
+	codeVersion = "dev"
+end
+
 workspace "QuadExplorer"
 	configurations { "Debug", "Release"}
 	platforms "x64"
@@ -8,35 +14,10 @@ filter { "platforms:x64" }
 	includedirs 
 	{
 		"Source",
-		"Depen/AwesomeEngine/Source",
-		"Depen/AwesomeEngine/Assets/Shaders",
 		"Depen/AwesomeEngine/Depen/GLM",
-		"Depen/AwesomeEngine/Depen/PhysX/physx/include",
-		"Depen/AwesomeEngine/Depen/PhysX/pxshared/include",
 		"Board/lib/QuadFlyController/src"
 	}
-
-filter {"configurations:Debug"}
-	libdirs
-	{
-		"Depen/AwesomeEngine/Build/x64/Debug"
-	}
-	links
-	{
-		"Core",
-		"Graphics"
-	}
-
-filter {"configurations:Release"}
-	libdirs
-	{
-		"Depen/AwesomeEngine/Build/x64/Release"
-	}
-	links
-	{
-		"Core",
-		"Graphics"
-	}
+	defines { 'SIM_CODE_VERSION="' .. codeVersion .. '"' }
 
 
 project "QuadExplorerApp"
@@ -51,8 +32,19 @@ project "QuadExplorerApp"
 		"Board/lib/QuadFlyController/**.cpp",
 		"Board/lib/QuadFlyController/**.h"
 	}
+	includedirs
+	{
+		"Depen/AwesomeEngine/Source",
+		"Depen/AwesomeEngine/Assets/Shaders",
+		"Depen/AwesomeEngine/Depen/PhysX/physx/include",
+		"Depen/AwesomeEngine/Depen/PhysX/pxshared/include"
+	}
 	filter "configurations:Debug"
 		symbols "On"
+		libdirs
+		{
+			"Depen/AwesomeEngine/Build/x64/Debug"
+		}
 		links
 		{
 			"Graphics", "Core"
@@ -66,6 +58,10 @@ project "QuadExplorerApp"
 		}
 	filter "configurations:Release"
 		optimize "On"
+		libdirs
+		{
+			"Depen/AwesomeEngine/Build/x64/Release"
+		}
 		links
 		{
 			"Graphics", "Core"
@@ -76,4 +72,214 @@ project "QuadExplorerApp"
 			"copy %{wks.location}Depen\\AwesomeEngine\\Depen\\PhysX\\physX\\bin\\win.x86_64.vc141.mt\\release\\PhysXCommon_64.dll %{wks.location}Build\\%{cfg.platform}\\%{cfg.buildcfg}\\PhysXCommon_64.dll",
 			"copy %{wks.location}Depen\\AwesomeEngine\\Depen\\PhysX\\physX\\bin\\win.x86_64.vc141.mt\\release\\PhysX_64.dll %{wks.location}Build\\%{cfg.platform}\\%{cfg.buildcfg}\\PhysX_64.dll",
 			"copy %{wks.location}Depen\\AwesomeEngine\\Depen\\PhysX\\physX\\bin\\win.x86_64.vc141.mt\\release\\PhysXFoundation_64.dll %{wks.location}Build\\%{cfg.platform}\\%{cfg.buildcfg}\\PhysXFoundation_64.dll",
-		}
\ No newline at end of file
+		}
+
+project "GainGen"
+	kind "ConsoleApp"
+	language "C++"
+	location "Temp/VSFiles"
+	targetdir "Build/%{cfg.platform}/%{cfg.buildcfg}"
+	files
+	{
+		"Tools/GainGen/**.cpp",
+		"Source/GainSetIO.h",
+		"Source/GainSetIO.cpp",
+		"Board/lib/QuadFlyController/src/GainSet.h",
+		"Board/lib/QuadFlyController/src/GainSet.cpp",
+		"Board/lib/QuadFlyController/src/CommonFlyController.h"
+	}
+	filter "configurations:Debug"
+		symbols "On"
+	filter "configurations:Release"
+		optimize "On"
+
+-- Headless batch runner (no engine, no PhysX), also builds on Linux for CI.
+project "quadsim"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++14"
+	location "Temp/VSFiles"
+	targetdir "Build/%{cfg.platform}/%{cfg.buildcfg}"
+	defines { "HEADLESS" }
+	includedirs { "Tools/QuadSim/Shims" }
+	files
+	{
+		"Tools/QuadSim/**.cpp",
+		"Tools/QuadSim/**.h",
+		"Source/Batch/**.cpp",
+		"Source/Batch/**.h",
+		"Source/Jobs/**.cpp",
+		"Source/Jobs/**.h",
+		"Source/Dynamics/Dynamics.*",
+		"Source/Dynamics/RigidBody.h",
+		"Source/Dynamics/RigidBodyDynamics.*",
+		"Source/Analysis/FFT.*",
+		"Source/Analysis/ResponseAnalysis.*",
+		"Source/IO/Directory.*",
+		"Source/IO/MappedFile.*",
+		"Source/Environment.*",
+		"Source/GainSetIO.*",
+		"Source/MotorModel.*",
+		"Source/Quad.*",
+		"Source/QuadProfile.*",
+		"Source/RandomStream.*",
+		"Source/ResultCache.*",
+		"Source/ResultFile.*",
+		"Source/Sensors/**.cpp",
+		"Source/Sensors/**.h",
+		"Source/SetPointProfile.*",
+		"Source/Simulation.*",
+		"Source/UnityFlightController.*",
+		"Board/lib/QuadFlyController/**.cpp",
+		"Board/lib/QuadFlyController/**.h"
+	}
+	filter "system:linux"
+		links { "pthread" }
+	filter "configurations:Debug"
+		symbols "On"
+	filter "configurations:Release"
+		optimize "On"
+project "sitl"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++14"
+	location "Temp/VSFiles"
+	targetdir "Build/%{cfg.platform}/%{cfg.buildcfg}"
+	defines { "HEADLESS" }
+	includedirs { "Tools/Sitl", "Tools/Sitl/Shims", "Tools/QuadSim/Shims" }
+	files
+	{
+		"Tools/Sitl/**.cpp",
+		"Tools/Sitl/**.h",
+		"Source/Dynamics/Dynamics.*",
+		"Source/Dynamics/RigidBody.h",
+		"Source/Dynamics/RigidBodyDynamics.*",
+		"Source/IO/Directory.*",
+		"Source/IO/MappedFile.*",
+		"Source/Environment.*",
+		"Source/MotorModel.*",
+		"Source/Quad.*",
+		"Source/QuadProfile.*",
+		"Source/RandomStream.*",
+		"Source/Sensors/SensorModel.*",
+		"Board/src/main.cpp",
+		"Board/lib/QuadFlyController/**.cpp",
+		"Board/lib/QuadFlyController/**.h"
+	}
+	-- The firmware side is an Arduino build against the shims:
+	filter "files:Board/** or Tools/Sitl/Shims/**"
+		defines { "ARDUINO=100" }
+	filter "system:linux"
+		links { "pthread" }
+	filter "configurations:Debug"
+		symbols "On"
+	filter "configurations:Release"
+		optimize "On"
+
+-- Decodes the flight recorder dumps of board serial captures into flight logs and result files.
+project "flightrec"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++14"
+	location "Temp/VSFiles"
+	targetdir "Build/%{cfg.platform}/%{cfg.buildcfg}"
+	defines { "HEADLESS" }
+	includedirs { "Tools/QuadSim/Shims" }
+	files
+	{
+		"Tools/FlightRec/**.cpp",
+		"Source/Replay/FlightLog.*",
+		"Source/Analysis/FFT.*",
+		"Source/Analysis/ResponseAnalysis.*",
+		"Source/Dynamics/Dynamics.*",
+		"Source/Dynamics/RigidBody.h",
+		"Source/Dynamics/RigidBodyDynamics.*",
+		"Source/IO/Directory.*",
+		"Source/IO/MappedFile.*",
+		"Source/Environment.*",
+		"Source/MotorModel.*",
+		"Source/Quad.*",
+		"Source/QuadProfile.*",
+		"Source/RandomStream.*",
+		"Source/ResultCache.*",
+		"Source/ResultFile.*",
+		"Source/Sensors/**.cpp",
+		"Source/Sensors/**.h",
+		"Source/SetPointProfile.*",
+		"Source/Simulation.*",
+		"Board/lib/QuadFlyController/**.cpp",
+		"Board/lib/QuadFlyController/**.h"
+	}
+	filter "system:linux"
+		links { "pthread" }
+	filter "configurations:Debug"
+		symbols "On"
+	filter "configurations:Release"
+		optimize "On"
+
+-- Gradient based gain tuning of a scenario, dual number runs of the templated controller and dynamics.
+project "gainopt"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++14"
+	location "Temp/VSFiles"
+	targetdir "Build/%{cfg.platform}/%{cfg.buildcfg}"
+	defines { "HEADLESS" }
+	includedirs { "Tools/QuadSim/Shims" }
+	files
+	{
+		"Tools/GainOpt/**.cpp",
+		"Source/Optimize/**.cpp",
+		"Source/Optimize/**.h",
+		"Source/Batch/**.cpp",
+		"Source/Batch/**.h",
+		"Source/Jobs/**.cpp",
+		"Source/Jobs/**.h",
+		"Source/Dynamics/Dynamics.*",
+		"Source/Dynamics/RigidBody.h",
+		"Source/Dynamics/RigidBodyDynamics.*",
+		"Source/Analysis/FFT.*",
+		"Source/Analysis/ResponseAnalysis.*",
+		"Source/IO/Directory.*",
+		"Source/IO/MappedFile.*",
+		"Source/Environment.*",
+		"Source/GainSetIO.*",
+		"Source/MotorModel.*",
+		"Source/Quad.*",
+		"Source/QuadProfile.*",
+		"Source/RandomStream.*",
+		"Source/ResultCache.*",
+		"Source/ResultFile.*",
+		"Source/Sensors/**.cpp",
+		"Source/Sensors/**.h",
+		"Source/SetPointProfile.*",
+		"Source/Simulation.*",
+		"Source/UnityFlightController.*",
+		"Board/lib/QuadFlyController/**.cpp",
+		"Board/lib/QuadFlyController/**.h"
+	}
+	filter "system:linux"
+		links { "pthread" }
+	filter "configurations:Debug"
+		symbols "On"
+	filter "configurations:Release"
+		optimize "On"
+
+-- Attitude estimator benchmark and reference check on recorded IMU traces.
+project "estbench"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++14"
+	location "Temp/VSFiles"
+	targetdir "Build/%{cfg.platform}/%{cfg.buildcfg}"
+	files
+	{
+		"Tools/EstBench/**.cpp",
+		"Source/Sensors/ImuTrace.*",
+		"Board/lib/QuadFlyController/src/AttitudeEstimator.*",
+		"Board/lib/QuadFlyController/src/CommonFlyController.h"
+	}
+	filter "configurations:Debug"
+		symbols "On"
+	filter "configurations:Release"
+		optimize "On"